@@ -0,0 +1,248 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchAccessor.cpp
+//------------------------------------------------------------------------------
+
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+/**
+ * Dense block [-kHalfDim, kHalfDim)^3 spanning all eight quadrants.
+ */
+const i32 kHalfDim = 64;
+
+void
+fillVolume(volume_type &volume)
+{
+    for (i32 k = -kHalfDim; k < kHalfDim; ++k) {
+        for (i32 j = -kHalfDim; j < kHalfDim; ++j) {
+            for (i32 i = -kHalfDim; i < kHalfDim; ++i) {
+                volume.set(i, j, k, float(i + j + k));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchSequential()
+{
+    volume_type volume(2, 3, 0.0f);
+    fillVolume(volume);
+
+    double ops = 8.0 * kHalfDim * kHalfDim * kHalfDim;
+
+    // uncached
+    {
+        BenchmarkTimer timer;
+        double sum = 0.0;
+        for (i32 k = -kHalfDim; k < kHalfDim; ++k) {
+            for (i32 j = -kHalfDim; j < kHalfDim; ++j) {
+                for (i32 i = -kHalfDim; i < kHalfDim; ++i) {
+                    sum += volume.get(i, j, k);
+                }
+            }
+        }
+        BenchmarkRegistry::report("Volume::get", ops, timer.elapsed());
+        BenchmarkRegistry::consume(sum);
+    }
+
+    // cached
+    {
+        BenchmarkTimer timer;
+        volume_type::const_accessor acc = 
+            static_cast<const volume_type&>(volume).getAccessor();
+        double sum = 0.0;
+        for (i32 k = -kHalfDim; k < kHalfDim; ++k) {
+            for (i32 j = -kHalfDim; j < kHalfDim; ++j) {
+                for (i32 i = -kHalfDim; i < kHalfDim; ++i) {
+                    sum += acc.get(i, j, k);
+                }
+            }
+        }
+        BenchmarkRegistry::report("const_accessor::get", ops, timer.elapsed());
+        BenchmarkRegistry::consume(sum);
+    }
+
+    // uncached writes
+    {
+        volume_type target(2, 3, 0.0f);
+        BenchmarkTimer timer;
+        for (i32 k = -kHalfDim; k < kHalfDim; ++k) {
+            for (i32 j = -kHalfDim; j < kHalfDim; ++j) {
+                for (i32 i = -kHalfDim; i < kHalfDim; ++i) {
+                    target.set(i, j, k, 1.0f);
+                }
+            }
+        }
+        BenchmarkRegistry::report("Volume::set", ops, timer.elapsed());
+    }
+
+    // cached writes
+    {
+        volume_type target(2, 3, 0.0f);
+        BenchmarkTimer timer;
+        volume_type::accessor acc = target.getAccessor();
+        for (i32 k = -kHalfDim; k < kHalfDim; ++k) {
+            for (i32 j = -kHalfDim; j < kHalfDim; ++j) {
+                for (i32 i = -kHalfDim; i < kHalfDim; ++i) {
+                    acc.set(i, j, k, 1.0f);
+                }
+            }
+        }
+        BenchmarkRegistry::report("accessor::set", ops, timer.elapsed());
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchRandom()
+{
+    volume_type volume(2, 3, 0.0f);
+    fillVolume(volume);
+
+    // pre-generate the coordinates so both paths see the same sequence
+    const size_t count = 1 << 20;
+    std::vector<signed_index_vec> coords(count);
+    u32 seed = 1;
+    for (size_t n = 0; n < count; ++n) {
+        for (int c = 0; c < 3; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            coords[n][c] = i32((seed >> 8) % (2 * kHalfDim)) - kHalfDim;
+        }
+    }
+
+    // uncached
+    {
+        BenchmarkTimer timer;
+        double sum = 0.0;
+        for (size_t n = 0; n < count; ++n) {
+            sum += volume.get(coords[n]);
+        }
+        BenchmarkRegistry::report("Volume::get", count, timer.elapsed());
+        BenchmarkRegistry::consume(sum);
+    }
+
+    // cached, mostly misses
+    {
+        BenchmarkTimer timer;
+        volume_type::const_accessor acc = 
+            static_cast<const volume_type&>(volume).getAccessor();
+        double sum = 0.0;
+        for (size_t n = 0; n < count; ++n) {
+            sum += acc.get(coords[n]);
+        }
+        BenchmarkRegistry::report("const_accessor::get", count, 
+                                  timer.elapsed());
+        BenchmarkRegistry::consume(sum);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchStencil()
+{
+    volume_type volume(2, 3, 0.0f);
+    fillVolume(volume);
+
+    // 7 point laplacian over the interior
+    const i32 lo = -kHalfDim + 1;
+    const i32 hi = kHalfDim - 1;
+    double ops = 7.0 * (hi - lo) * (hi - lo) * (hi - lo);
+
+    // uncached
+    {
+        BenchmarkTimer timer;
+        double sum = 0.0;
+        for (i32 k = lo; k < hi; ++k) {
+            for (i32 j = lo; j < hi; ++j) {
+                for (i32 i = lo; i < hi; ++i) {
+                    sum += volume.get(i - 1, j, k) + volume.get(i + 1, j, k) +
+                           volume.get(i, j - 1, k) + volume.get(i, j + 1, k) +
+                           volume.get(i, j, k - 1) + volume.get(i, j, k + 1) -
+                           6.0f * volume.get(i, j, k);
+                }
+            }
+        }
+        BenchmarkRegistry::report("Volume::get", ops, timer.elapsed());
+        BenchmarkRegistry::consume(sum);
+    }
+
+    // cached
+    {
+        BenchmarkTimer timer;
+        volume_type::const_accessor acc = 
+            static_cast<const volume_type&>(volume).getAccessor();
+        double sum = 0.0;
+        for (i32 k = lo; k < hi; ++k) {
+            for (i32 j = lo; j < hi; ++j) {
+                for (i32 i = lo; i < hi; ++i) {
+                    sum += acc.get(i - 1, j, k) + acc.get(i + 1, j, k) +
+                           acc.get(i, j - 1, k) + acc.get(i, j + 1, k) +
+                           acc.get(i, j, k - 1) + acc.get(i, j, k + 1) -
+                           6.0f * acc.get(i, j, k);
+                }
+            }
+        }
+        BenchmarkRegistry::report("const_accessor::get", ops, 
+                                  timer.elapsed());
+        BenchmarkRegistry::consume(sum);
+    }
+}
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchSequential);
+BENCHMARK_REGISTRATION(benchRandom);
+BENCHMARK_REGISTRATION(benchStencil);
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,205 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchBSpline.cpp
+//------------------------------------------------------------------------------
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+#include <nkhive/interpolation/BSplineInterpolation.h>
+#include <nkhive/interpolation/BSplineSplat.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+/**
+ * Points are spread over [-kHalfDim, kHalfDim)^3 voxels.
+ */
+const i32 kHalfDim = 32;
+
+/**
+ * Number of points splatted and sampled per pass.
+ */
+const size_t kPoints = 1 << 16;
+
+//------------------------------------------------------------------------------
+
+/**
+ * Splats with the weights of every voxel evaluated on its own and written 
+ * through update(), the way a kernel is applied without the separable
+ * weights or blocks.
+ */
+template <i32 Degree>
+void
+splatPerVoxel(Volume<float> &volume, const vec3d &p, float val)
+{
+    typedef BSplineSamplingUtil<float, Degree> kernel_type;
+    const i32 taps = kernel_type::TAPS;
+    const double shift = (Degree % 2 == 0) ? 0.5 : 0.0;
+
+    vec3d offset = volume.kernelOffset();
+    vec3d u = p - offset + vec3d(shift);
+    vec3i min_indices(i32(floor(u.x)) - Degree / 2, 
+                      i32(floor(u.y)) - Degree / 2,
+                      i32(floor(u.z)) - Degree / 2);
+
+    std::plus<float> op;
+    for (i32 k = 0; k < taps; ++k) {
+        for (i32 j = 0; j < taps; ++j) {
+            for (i32 i = 0; i < taps; ++i) {
+                float wx[taps], wy[taps], wz[taps];
+                kernel_type::evaluate(float(u.x - floor(u.x)), wx);
+                kernel_type::evaluate(float(u.y - floor(u.y)), wy);
+                kernel_type::evaluate(float(u.z - floor(u.z)), wz);
+                volume.update(min_indices.x + i, min_indices.y + j, 
+                              min_indices.z + k, 
+                              val * wx[i] * wy[j] * wz[k], op);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <i32 Degree>
+void
+benchKernel(const char *name)
+{
+    typedef BSplineSplat<float, Degree, std::plus> splat_type;
+    typedef BSplineInterpolation<float, Degree>    interp_type;
+
+    std::vector<vec3d> pts(kPoints);
+    u32 seed = 41;
+    double range = 2.0 * kHalfDim - 6.0;
+    for (size_t n = 0; n < kPoints; ++n) {
+        for (i32 a = 0; a < 3; ++a) {
+            seed = seed * 1664525u + 1013904223u;
+            pts[n][a] = ((seed >> 8) % 10000) / 10000.0 * range - 
+                        (kHalfDim - 3.0);
+        }
+    }
+
+    char label[64];
+    Volume<float>::shared_ptr volume(new Volume<float>(3, 3, 0.0f));
+
+    BenchmarkTimer timer;
+    for (size_t n = 0; n < kPoints; ++n) {
+        splatPerVoxel<Degree>(*volume, pts[n], 1.0f);
+    }
+    sprintf(label, "%s splat per voxel", name);
+    BenchmarkRegistry::report(label, double(kPoints), timer.elapsed());
+
+    for (i32 use_table = 0; use_table < 2; ++use_table) {
+        splat_type splat(volume, use_table != 0);
+        timer.restart();
+        for (size_t n = 0; n < kPoints; ++n) {
+            splat.splat(pts[n].x, pts[n].y, pts[n].z, 1.0f);
+        }
+        sprintf(label, "%s splat%s", name, use_table ? " table" : "");
+        BenchmarkRegistry::report(label, double(kPoints), timer.elapsed());
+    }
+
+    double sum = 0.0;
+    const i32 taps = Degree + 1;
+    timer.restart();
+    for (size_t n = 0; n < kPoints; ++n) {
+        const vec3d &p = pts[n];
+        vec3d u = p - volume->kernelOffset() + 
+                  vec3d((Degree % 2 == 0) ? 0.5 : 0.0);
+        vec3i min_indices(i32(floor(u.x)) - Degree / 2, 
+                          i32(floor(u.y)) - Degree / 2,
+                          i32(floor(u.z)) - Degree / 2);
+        for (i32 k = 0; k < taps; ++k) {
+            for (i32 j = 0; j < taps; ++j) {
+                for (i32 i = 0; i < taps; ++i) {
+                    float wx[taps], wy[taps], wz[taps];
+                    BSplineSamplingUtil<float, Degree>::evaluate(
+                        float(u.x - floor(u.x)), wx);
+                    BSplineSamplingUtil<float, Degree>::evaluate(
+                        float(u.y - floor(u.y)), wy);
+                    BSplineSamplingUtil<float, Degree>::evaluate(
+                        float(u.z - floor(u.z)), wz);
+                    sum += wx[i] * wy[j] * wz[k] * 
+                           volume->get(min_indices.x + i, min_indices.y + j,
+                                       min_indices.z + k);
+                }
+            }
+        }
+    }
+    sprintf(label, "%s sample per voxel", name);
+    BenchmarkRegistry::report(label, double(kPoints), timer.elapsed());
+
+    for (i32 use_table = 0; use_table < 2; ++use_table) {
+        interp_type interp(volume, use_table != 0);
+        timer.restart();
+        for (size_t n = 0; n < kPoints; ++n) {
+            float result;
+            interp.interp(pts[n].x, pts[n].y, pts[n].z, result);
+            sum += result;
+        }
+        sprintf(label, "%s sample%s", name, use_table ? " table" : "");
+        BenchmarkRegistry::report(label, double(kPoints), timer.elapsed());
+    }
+    BenchmarkRegistry::consume(sum);
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchBSpline()
+{
+    benchKernel<2>("Quadratic");
+    benchKernel<3>("Cubic B-spline");
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchBSpline);
+
+//------------------------------------------------------------------------------
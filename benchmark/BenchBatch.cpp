@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchBatch.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <vector>
+
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+const int kSamples = 1 << 20;
+
+/**
+ * Accumulates samples, the usual splatting update.
+ */
+struct AccumulateOp
+{
+    float operator()(const float &a, const float &b) const { return a + b; }
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * Particles scattered around a handful of clusters in all quadrants, in 
+ * random order so consecutive samples rarely land in the same cell.
+ */
+void
+makeParticles(std::vector<signed_index_vec> &coords, 
+              std::vector<float> &values)
+{
+    u32 seed = 11;
+    coords.resize(kSamples);
+    values.resize(kSamples);
+    for (int n = 0; n < kSamples; ++n) {
+        seed = seed * 1664525u + 1013904223u;
+        i32 cluster = i32(seed >> 28) - 8;
+        seed = seed * 1664525u + 1013904223u;
+        coords[n] = signed_index_vec(cluster * 40 + i32(seed % 64u) - 32,
+                                     cluster * 25 + i32((seed >> 8) % 64u),
+                                     i32((seed >> 16) % 64u) - 32);
+        values[n] = float(seed & 0xff) / 255.0f;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchBatch()
+{
+    std::vector<signed_index_vec> coords;
+    std::vector<float> values;
+    makeParticles(coords, values);
+
+    {
+        volume_type volume(2, 3, 0.0f);
+        BenchmarkTimer timer;
+        for (int n = 0; n < kSamples; ++n) {
+            volume.update(coords[n], values[n], AccumulateOp());
+        }
+        double secs = timer.elapsed();
+        BenchmarkRegistry::report("Volume update per sample", kSamples, secs);
+        BenchmarkRegistry::consume(volume.get(1, 2, 3));
+    }
+
+    {
+        volume_type volume(2, 3, 0.0f);
+        volume_type::accessor acc = volume.getAccessor();
+        BenchmarkTimer timer;
+        for (int n = 0; n < kSamples; ++n) {
+            acc.update(coords[n], values[n], AccumulateOp());
+        }
+        double secs = timer.elapsed();
+        BenchmarkRegistry::report("Accessor update per sample", kSamples, 
+                                  secs);
+        BenchmarkRegistry::consume(volume.get(1, 2, 3));
+    }
+
+    const size_t counts[] = { 1, 2, 4 };
+    for (size_t n = 0; n < sizeof(counts) / sizeof(counts[0]); ++n) {
+        volume_type volume(2, 3, 0.0f);
+        BenchmarkTimer timer;
+        volume.updateBatch(&coords[0], &values[0], kSamples, AccumulateOp(), 
+                           counts[n]);
+        double secs = timer.elapsed();
+
+        char label[64];
+        sprintf(label, "Volume updateBatch %d threads", int(counts[n]));
+        BenchmarkRegistry::report(label, kSamples, secs);
+        BenchmarkRegistry::consume(volume.get(1, 2, 3));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchBatch);
+
+//------------------------------------------------------------------------------
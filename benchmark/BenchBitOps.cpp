@@ -0,0 +1,165 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// BenchBitOps.cpp
+//------------------------------------------------------------------------------
+
+#include <sstream>
+#include <vector>
+
+#include <nkhive/bitfields/BitField3D.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef BitField3D<index_type> bitfield_type;
+
+/**
+ * Cell sizes to run the bitfield benchmarks over.
+ */
+const index_type kLgSizes[]  = { 3, 4, 5 };
+const index_type kNumLgSizes = 3;
+
+std::string
+label(const char *name, index_type lg_size)
+{
+    std::ostringstream os;
+    os << name << " " << (1 << lg_size) << "^3";
+    return os.str();
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Word level popcount and bit scans, portable against the selected backend.
+ */
+void
+benchWordOps()
+{
+    const size_t count = 1 << 22;
+    std::vector<index_type> words(count);
+    u32 seed = 1;
+    for (size_t n = 0; n < count; ++n) {
+        seed = seed * 1664525u + 1013904223u;
+        words[n] = seed;
+    }
+
+    #define BENCH_WORD_OP(name, op)                                  \
+    {                                                                \
+        BenchmarkTimer timer;                                        \
+        index_type sum = 0;                                          \
+        for (size_t n = 0; n < count; ++n) {                         \
+            sum += op(words[n]);                                     \
+        }                                                            \
+        BenchmarkRegistry::report(name, count, timer.elapsed());     \
+        BenchmarkRegistry::consume(sum);                             \
+    }
+
+    BENCH_WORD_OP("getBitCountPortable", getBitCountPortable<index_type>);
+    BENCH_WORD_OP("getBitCount", getBitCount<index_type>);
+    BENCH_WORD_OP("getFirstSetBitIndexPortable", 
+                  getFirstSetBitIndexPortable<index_type>);
+    BENCH_WORD_OP("getFirstSetBitIndex", getFirstSetBitIndex<index_type>);
+    BENCH_WORD_OP("getLastSetBitIndexPortable", 
+                  getLastSetBitIndexPortable<index_type>);
+    BENCH_WORD_OP("getLastSetBitIndex", getLastSetBitIndex<index_type>);
+
+    #undef BENCH_WORD_OP
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Whole bitfield operations at the default cell sizes.
+ */
+void
+benchBitFieldOps()
+{
+    for (index_type s = 0; s < kNumLgSizes; ++s) {
+        index_type lg_size = kLgSizes[s];
+        index_type bits    = numBits3D(lg_size);
+
+        bitfield_type a(lg_size);
+        bitfield_type b(lg_size);
+        u32 seed = 1;
+        for (index_type i = 0; i < bits; ++i) {
+            seed = seed * 1664525u + 1013904223u;
+            if (seed & 0x100) { a.setBit(i); }
+            if (seed & 0x200) { b.setBit(i); }
+        }
+
+        // keep the total work roughly constant across sizes
+        const size_t count = (size_t(1) << 26) / bits;
+
+        #define BENCH_BITFIELD_OP(name, op)                              \
+        {                                                                \
+            BenchmarkTimer timer;                                        \
+            index_type sum = 0;                                          \
+            for (size_t n = 0; n < count; ++n) {                         \
+                op;                                                      \
+            }                                                            \
+            BenchmarkRegistry::report(label(name, lg_size).c_str(),      \
+                                      count, timer.elapsed());           \
+            BenchmarkRegistry::consume(sum);                             \
+        }
+
+        BENCH_BITFIELD_OP("count",   sum += a.count());
+        BENCH_BITFIELD_OP("isEmpty", sum += a.isEmpty());
+        BENCH_BITFIELD_OP("isFull",  sum += a.isFull());
+        BENCH_BITFIELD_OP("invertBits", a.invertBits(); sum += a.size());
+        BENCH_BITFIELD_OP("operator^=", a ^= b; sum += a.size());
+
+        #undef BENCH_BITFIELD_OP
+    }
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchWordOps);
+BENCHMARK_REGISTRATION(benchBitFieldOps);
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,120 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+
+//------------------------------------------------------------------------------
+// BenchCell.cpp
+//------------------------------------------------------------------------------
+
+#include <vector>
+
+#include <nkhive/volume/Cell.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Cell<float> cell_type;
+
+/**
+ * Random reads against a half populated 32^3 cell, before and after
+ * compression.
+ */
+void
+benchCompressedGet()
+{
+    const u8  lg_dim = 5;
+    const u32 dim    = 1 << lg_dim;
+
+    cell_type cell(lg_dim, 0.0f);
+    u32 seed = 1;
+    for (u32 k = 0; k < dim; ++k) {
+        for (u32 j = 0; j < dim; ++j) {
+            for (u32 i = 0; i < dim; ++i) {
+                seed = seed * 1664525u + 1013904223u;
+                if (seed & 0x100) {
+                    cell.set(i, j, k, float(i + j + k));
+                }
+            }
+        }
+    }
+
+    // pre-generate the indices so both paths see the same sequence
+    const size_t count = 1 << 20;
+    std::vector<u32> indices(count);
+    for (size_t n = 0; n < count; ++n) {
+        seed = seed * 1664525u + 1013904223u;
+        indices[n] = (seed >> 8) % (dim * dim * dim);
+    }
+
+    // uncompressed
+    {
+        BenchmarkTimer timer;
+        double sum = 0.0;
+        for (size_t n = 0; n < count; ++n) {
+            sum += cell.get(indices[n]);
+        }
+        BenchmarkRegistry::report("Cell::get", count, timer.elapsed());
+        BenchmarkRegistry::consume(sum);
+    }
+
+    // compressed, ranked through the bitfield
+    cell.compress();
+    {
+        BenchmarkTimer timer;
+        double sum = 0.0;
+        for (size_t n = 0; n < count; ++n) {
+            sum += cell.get(indices[n]);
+        }
+        BenchmarkRegistry::report("Cell::get compressed", count, 
+                                  timer.elapsed());
+        BenchmarkRegistry::consume(sum);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchCompressedGet);
+
+//------------------------------------------------------------------------------
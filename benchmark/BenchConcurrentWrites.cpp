@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchConcurrentWrites.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+const i32 kExtent = 128;
+
+/**
+ * Fills the slabs of the volume owned by the given thread. With shared set,
+ * slabs are a single voxel thick so every cell is written by several threads.
+ */
+void
+writeSlabs(volume_type *volume, int id, int threads, bool shared)
+{
+    const i32 thickness = shared ? 1 : kExtent / threads;
+
+    volume_type::accessor acc = volume->getAccessor();
+    for (i32 k = 0; k < kExtent; ++k) {
+        if ((k / thickness) % threads != id) continue;
+        for (i32 j = 0; j < kExtent; ++j) {
+            for (i32 i = 0; i < kExtent; ++i) {
+                acc.set(i, j, k, float(i + j + k));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchWrites(int threads, bool shared)
+{
+    volume_type volume(2, 3, 0.0f);
+
+    BenchmarkTimer timer;
+    if (threads == 0) {
+        writeSlabs(&volume, 0, 1, shared);
+    } else {
+        volume.beginConcurrentWrites();
+        boost::thread_group group;
+        for (int id = 0; id < threads; ++id) {
+            group.create_thread(
+                boost::bind(&writeSlabs, &volume, id, threads, shared));
+        }
+        group.join_all();
+        volume.endConcurrentWrites();
+    }
+    double secs = timer.elapsed();
+
+    char label[64];
+    if (threads == 0) {
+        sprintf(label, "Volume %s writes serial", 
+                shared ? "shared" : "disjoint");
+    } else {
+        sprintf(label, "Volume %s writes %d threads", 
+                shared ? "shared" : "disjoint", threads);
+    }
+    BenchmarkRegistry::report(label, kExtent * kExtent * kExtent, secs);
+    BenchmarkRegistry::consume(volume.get(1, 2, 3));
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchConcurrentWrites()
+{
+    // zero threads is the serial baseline outside of concurrent mode
+    const int counts[] = { 0, 1, 2, 4, 8 };
+    for (int shared = 0; shared < 2; ++shared) {
+        for (size_t n = 0; n < sizeof(counts) / sizeof(counts[0]); ++n) {
+            benchWrites(counts[n], shared != 0);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchConcurrentWrites);
+
+//------------------------------------------------------------------------------
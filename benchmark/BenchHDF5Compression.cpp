@@ -0,0 +1,189 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchHDF5Compression.cpp
+//------------------------------------------------------------------------------
+
+#include <cmath>
+#include <cstdio>
+#include <sys/stat.h>
+
+#include <nkhive/attributes/PrimitiveTypes.h>
+#include <nkhive/attributes/StringAttribute.h>
+#include <nkhive/io/VolumeFile.h>
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+const int   kDim      = 128;
+const int   kVoxels   = kDim * kDim * kDim;
+const char *kFileName = "benchHDF5Compression.hv";
+
+/**
+ * Smooth density field filling a box, like a simulation cache.
+ */
+void
+makeSmooth(volume_type &volume)
+{
+    for (int k = 0; k < kDim; ++k) {
+        for (int j = 0; j < kDim; ++j) {
+            for (int i = 0; i < kDim; ++i) {
+                float d = sinf(i * 0.05f) * cosf(j * 0.07f) + k * 0.01f;
+                volume.set(i - kDim / 2, j - kDim / 2, k - kDim / 2, d);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Same box with white noise, close to incompressible.
+ */
+void
+makeNoise(volume_type &volume)
+{
+    u32 seed = 5;
+    for (int k = 0; k < kDim; ++k) {
+        for (int j = 0; j < kDim; ++j) {
+            for (int i = 0; i < kDim; ++i) {
+                seed = seed * 1664525u + 1013904223u;
+                float d = float(seed >> 8) / float(1 << 24);
+                volume.set(i - kDim / 2, j - kDim / 2, k - kDim / 2, d);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Writes and reads the volume with the given filter, returns the file size.
+ */
+long
+benchFilter(volume_type &volume, HDF5Filter filter, i32 level, 
+            const char *field)
+{
+    char label[96];
+    volume.setCompression(filter, level);
+
+    remove(kFileName);
+    {
+        BenchmarkTimer timer;
+        VolumeFile file(kFileName, VoidFile::WRITE_TRUNC);
+        file.write(volume);
+        file.close();
+        sprintf(label, "%s write, %s %d", field, filterName(filter).c_str(),
+                int(level));
+        BenchmarkRegistry::report(label, kVoxels, timer.elapsed());
+    }
+
+    struct stat info;
+    stat(kFileName, &info);
+
+    {
+        BenchmarkTimer timer;
+        VolumeFile file(kFileName, VoidFile::READ_ONLY);
+        volume_type::shared_ptr read_volume = file.read<volume_type>();
+        file.close();
+        sprintf(label, "%s read, %s %d", field, filterName(filter).c_str(),
+                int(level));
+        BenchmarkRegistry::report(label, kVoxels, timer.elapsed());
+        BenchmarkRegistry::consume(read_volume->get(0, 0, 0));
+    }
+    remove(kFileName);
+
+    return long(info.st_size);
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchField(volume_type &volume, const char *field)
+{
+    const HDF5Filter filters[] = { HDF5_FILTER_DEFLATE, HDF5_FILTER_DEFLATE,
+                                   HDF5_FILTER_SHUFFLE_DEFLATE,
+                                   HDF5_FILTER_SHUFFLE_DEFLATE };
+    const i32        levels[]  = { 1, 6, 1, 6 };
+
+    long raw = benchFilter(volume, HDF5_FILTER_NONE, 0, field);
+    printf("  file size: %ld bytes\n", raw);
+
+    for (int n = 0; n < 4; ++n) {
+        long size = benchFilter(volume, filters[n], levels[n], field);
+        printf("  file size: %ld bytes, ratio %.2f\n", size, 
+               double(raw) / double(size));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchHDF5Compression()
+{
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+    Int32Attribute::registerAttributeType();
+
+    volume_type smooth(3, 3, 0.0f);
+    makeSmooth(smooth);
+    benchField(smooth, "smooth");
+
+    volume_type noise(3, 3, 0.0f);
+    makeNoise(noise);
+    benchField(noise, "noise");
+
+    Attribute::clearAttributeRegistry();
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchHDF5Compression);
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,138 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchHDF5Layout.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <sys/stat.h>
+
+#include <nkhive/attributes/StringAttribute.h>
+#include <nkhive/io/VolumeFile.h>
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+const int   kParticles = 1 << 14;
+const char *kFileName  = "benchHDF5Layout.hv";
+
+/**
+ * Particles scattered over a box, nearly every one lands in its own cell.
+ */
+void
+makeVolume(volume_type &volume)
+{
+    u32 seed = 11;
+    for (int n = 0; n < kParticles; ++n) {
+        seed = seed * 1664525u + 1013904223u;
+        i32 i = i32((seed >> 8) % 1024u) - 512;
+        seed = seed * 1664525u + 1013904223u;
+        i32 j = i32((seed >> 8) % 1024u) - 512;
+        seed = seed * 1664525u + 1013904223u;
+        i32 k = i32((seed >> 8) % 1024u) - 512;
+        volume.set(i, j, k, float(n));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchLayout(const volume_type &volume, HDF5Layout layout, const char *name)
+{
+    char label[64];
+
+    remove(kFileName);
+    {
+        BenchmarkTimer timer;
+        VolumeFile file(kFileName, VoidFile::WRITE_TRUNC);
+        file.write(volume, layout);
+        file.close();
+        sprintf(label, "hdf5 write, %s", name);
+        BenchmarkRegistry::report(label, kParticles, timer.elapsed());
+    }
+
+    struct stat info;
+    stat(kFileName, &info);
+
+    {
+        BenchmarkTimer timer;
+        VolumeFile file(kFileName, VoidFile::READ_ONLY);
+        volume_type::shared_ptr read_volume = file.read<volume_type>();
+        file.close();
+        sprintf(label, "hdf5 read, %s", name);
+        BenchmarkRegistry::report(label, kParticles, timer.elapsed());
+        BenchmarkRegistry::consume(read_volume->get(0, 0, 0));
+    }
+    remove(kFileName);
+
+    printf("  file size: %ld bytes\n", long(info.st_size));
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchHDF5Layout()
+{
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+
+    volume_type volume(2, 3, 0.0f);
+    makeVolume(volume);
+
+    benchLayout(volume, HDF5_LAYOUT_LEAF_GROUPS, "leaf groups");
+    benchLayout(volume, HDF5_LAYOUT_LEAF_TABLE, "leaf table");
+
+    Attribute::clearAttributeRegistry();
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchHDF5Layout);
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,145 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchInterpBatch.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <vector>
+
+#include <nkhive/interpolation/LinearInterpolation.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+/**
+ * Dense block [-kHalfDim, kHalfDim)^3 spanning all eight quadrants.
+ */
+const i32 kHalfDim = 48;
+
+/**
+ * Number of points sampled per pass.
+ */
+const size_t kPoints = 1 << 18;
+
+//------------------------------------------------------------------------------
+
+/**
+ * Scattered points anywhere in the block, or a coherent walk along x that 
+ * stays within a cell for several steps.
+ */
+void
+makePoints(bool coherent, std::vector<vec3d> &pts)
+{
+    pts.resize(kPoints);
+    u32 seed = 11;
+    double range = 2.0 * kHalfDim - 2.0;
+    for (size_t n = 0; n < kPoints; ++n) {
+        if (coherent && (n % 64) != 0) {
+            pts[n] = pts[n - 1] + vec3d(0.25, 0.0, 0.0);
+            if (pts[n].x > kHalfDim - 2.0) pts[n].x -= range;
+            continue;
+        }
+        for (i32 a = 0; a < 3; ++a) {
+            seed = seed * 1664525u + 1013904223u;
+            pts[n][a] = ((seed >> 8) % 10000) / 10000.0 * range - kHalfDim;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+benchInterp(const char *type, bool coherent)
+{
+    typename Volume<T>::shared_ptr volume(new Volume<T>(3, 3, T(0)));
+    for (i32 k = -kHalfDim; k < kHalfDim; ++k) {
+        for (i32 j = -kHalfDim; j < kHalfDim; ++j) {
+            for (i32 i = -kHalfDim; i < kHalfDim; ++i) {
+                volume->set(i, j, k, T(i + j + k));
+            }
+        }
+    }
+
+    std::vector<vec3d> pts;
+    makePoints(coherent, pts);
+    std::vector<T> out(kPoints);
+    LinearInterpolation<T> linear_interp(volume);
+    const char *pattern = coherent ? "coherent" : "scattered";
+    char label[64];
+
+    BenchmarkTimer timer;
+    for (size_t n = 0; n < kPoints; ++n) {
+        linear_interp.interp(pts[n].x, pts[n].y, pts[n].z, out[n]);
+    }
+    sprintf(label, "%s %s interp", type, pattern);
+    BenchmarkRegistry::report(label, double(kPoints), timer.elapsed());
+    BenchmarkRegistry::consume(double(out[kPoints / 2]));
+
+    BenchmarkTimer batch_timer;
+    linear_interp.interpBatch(&pts[0], &out[0], kPoints);
+    sprintf(label, "%s %s interpBatch", type, pattern);
+    BenchmarkRegistry::report(label, double(kPoints), batch_timer.elapsed());
+    BenchmarkRegistry::consume(double(out[kPoints / 2]));
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchInterpBatch()
+{
+    benchInterp<float>("float", false);
+    benchInterp<float>("float", true);
+    benchInterp<double>("double", false);
+    benchInterp<double>("double", true);
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchInterpBatch);
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,143 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchInterpGradient.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <vector>
+
+#include <nkhive/interpolation/CubicInterpolation.h>
+#include <nkhive/interpolation/LinearInterpolation.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+/**
+ * Dense block [-kHalfDim, kHalfDim)^3 spanning all eight quadrants.
+ */
+const i32 kHalfDim = 32;
+
+/**
+ * Number of points sampled per pass.
+ */
+const size_t kPoints = 1 << 16;
+
+//------------------------------------------------------------------------------
+
+/**
+ * Value and gradient through forward differences of interp(), four samples
+ * per point, against a single interpWithGradient().
+ */
+template <typename Interp>
+void
+benchSampler(const char *name)
+{
+    Volume<float>::shared_ptr volume(new Volume<float>(3, 3, 0.0f));
+    for (i32 k = -kHalfDim; k < kHalfDim; ++k) {
+        for (i32 j = -kHalfDim; j < kHalfDim; ++j) {
+            for (i32 i = -kHalfDim; i < kHalfDim; ++i) {
+                volume->set(i, j, k, float(i * j - k));
+            }
+        }
+    }
+
+    std::vector<vec3d> pts(kPoints);
+    u32 seed = 17;
+    double range = 2.0 * kHalfDim - 6.0;
+    for (size_t n = 0; n < kPoints; ++n) {
+        for (i32 a = 0; a < 3; ++a) {
+            seed = seed * 1664525u + 1013904223u;
+            pts[n][a] = ((seed >> 8) % 10000) / 10000.0 * range - 
+                        (kHalfDim - 3.0);
+        }
+    }
+
+    Interp interp(volume);
+    const double h = 1e-3;
+    double sum = 0.0;
+    char label[64];
+
+    BenchmarkTimer timer;
+    for (size_t n = 0; n < kPoints; ++n) {
+        const vec3d &p = pts[n];
+        float value, dx, dy, dz;
+        interp.interp(p.x, p.y, p.z, value);
+        interp.interp(p.x + h, p.y, p.z, dx);
+        interp.interp(p.x, p.y + h, p.z, dy);
+        interp.interp(p.x, p.y, p.z + h, dz);
+        sum += value + (dx + dy + dz - 3.0f * value) / h;
+    }
+    sprintf(label, "%s finite differences", name);
+    BenchmarkRegistry::report(label, double(kPoints), timer.elapsed());
+
+    BenchmarkTimer fused_timer;
+    for (size_t n = 0; n < kPoints; ++n) {
+        const vec3d &p = pts[n];
+        float value;
+        vec3f gradient;
+        interp.interpWithGradient(p.x, p.y, p.z, value, gradient);
+        sum += value + gradient.x + gradient.y + gradient.z;
+    }
+    sprintf(label, "%s interpWithGradient", name);
+    BenchmarkRegistry::report(label, double(kPoints), fused_timer.elapsed());
+    BenchmarkRegistry::consume(sum);
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchInterpGradient()
+{
+    benchSampler< LinearInterpolation<float> >("Linear");
+    benchSampler< CubicInterpolation<float> >("Cubic");
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchInterpGradient);
+
+//------------------------------------------------------------------------------
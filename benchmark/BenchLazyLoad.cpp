@@ -0,0 +1,173 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchLazyLoad.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+
+#include <nkhive/attributes/StringAttribute.h>
+#include <nkhive/io/VolumeFile.h>
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+const int   kParticles = 1 << 14;
+const int   kLookups   = 1 << 20;
+const char *kFileName  = "benchLazyLoad.hv";
+
+/**
+ * Particles scattered over a box, each splatting a small blob of distinct
+ * values so nearly every cell holds voxel data of its own.
+ */
+void
+makeVolume(volume_type &volume, i32 coords[][3])
+{
+    u32 seed = 11;
+    for (int n = 0; n < kParticles; ++n) {
+        for (int c = 0; c < 3; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            coords[n][c] = i32((seed >> 8) % 1024u) - 512;
+        }
+        for (i32 d = 0; d < 8; ++d) {
+            volume.set(coords[n][0] + (d & 1), coords[n][1] + (d >> 1 & 1),
+                       coords[n][2] + (d >> 2), float(n + d));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Looks up particles in runs of 64 along a random walk over a window of 
+ * the particles, the working set of a typical localized query.
+ */
+void
+benchLookups(const volume_type &volume, i32 coords[][3], int window,
+             const char *name)
+{
+    BenchmarkTimer timer;
+    float sum = 0.0f;
+    u32 seed = 7;
+    int particle = 0;
+    for (int n = 0; n < kLookups; ++n) {
+        if (n % 64 == 0) {
+            seed = seed * 1664525u + 1013904223u;
+            particle = int((seed >> 8) % u32(window));
+        }
+        const i32 *c = coords[particle];
+        sum += volume.get(c[0] + (n & 1), c[1], c[2]);
+    }
+    char label[64];
+    sprintf(label, "get, %s", name);
+    BenchmarkRegistry::report(label, kLookups, timer.elapsed());
+    BenchmarkRegistry::consume(sum);
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchLazyLoad()
+{
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+
+    static i32 coords[kParticles][3];
+    volume_type volume(2, 3, 0.0f);
+    makeVolume(volume, coords);
+
+    remove(kFileName);
+    {
+        VolumeFile file(kFileName, VoidFile::WRITE_TRUNC);
+        file.write(volume);
+        file.close();
+    }
+
+    {
+        BenchmarkTimer timer;
+        VolumeFile file(kFileName, VoidFile::READ_ONLY);
+        volume_type::shared_ptr read_volume = file.read<volume_type>();
+        file.close();
+        BenchmarkRegistry::report("eager read", kParticles, timer.elapsed());
+        benchLookups(*read_volume, coords, kParticles, "eager");
+        printf("  resident bytes: %d\n", read_volume->sizeOf());
+    }
+
+    // a budget of a tenth of the voxels, queries stay within a window
+    const size_t budget = kParticles / 10 * 512 * sizeof(float);
+    const int windows[] = { kParticles / 20, kParticles };
+    for (int w = 0; w < 2; ++w) {
+        BenchmarkTimer timer;
+        VolumeFile file(kFileName, VoidFile::READ_ONLY);
+        volume_type::shared_ptr lazy_volume = 
+            file.readLazy<volume_type>(budget);
+        file.close();
+        BenchmarkRegistry::report("lazy open", kParticles, timer.elapsed());
+
+        char name[64];
+        sprintf(name, "lazy, window %d", windows[w]);
+        benchLookups(*lazy_volume, coords, windows[w], name);
+
+        CellPagerStats stats = lazy_volume->getPagerStats();
+        printf("  resident bytes: %d, hits %llu, misses %llu, "
+               "evictions %llu\n", lazy_volume->sizeOf(),
+               (unsigned long long)stats.hits, 
+               (unsigned long long)stats.misses,
+               (unsigned long long)stats.evictions);
+    }
+    remove(kFileName);
+
+    Attribute::clearAttributeRegistry();
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchLazyLoad);
+
+//------------------------------------------------------------------------------
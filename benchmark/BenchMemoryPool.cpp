@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchMemoryPool.cpp
+//------------------------------------------------------------------------------
+
+#include <vector>
+
+#include <nkhive/volume/Cell.h>
+#include <nkhive/volume/Tree.h>
+#include <nkhive/memory/PoolAllocator.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef PoolAllocator<float>                        pool_alloc_type;
+typedef Tree<Cell<float> >                          heap_tree_type;
+typedef Tree<Cell<float, pool_alloc_type>, 
+             pool_alloc_type>                       pool_tree_type;
+
+/**
+ * Repeatedly populates and clears scattered cells, so that every pass 
+ * allocates and frees cells, cell data, bitfields and nodes.
+ */
+template <typename TreeType>
+void
+benchCellChurn(const char *label)
+{
+    const size_t count  = 1 << 14;
+    const size_t passes = 16;
+
+    // one voxel per cell, spread over a 512^3 region
+    std::vector<signed_index_vec> coords(count);
+    u32 seed = 1;
+    for (size_t n = 0; n < count; ++n) {
+        for (int c = 0; c < 3; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            coords[n][c] = i32((seed >> 8) % 512u) - 256;
+        }
+    }
+
+    TreeType tree(2, 3, 0.0f);
+
+    BenchmarkTimer timer;
+    for (size_t pass = 0; pass < passes; ++pass) {
+        for (size_t n = 0; n < count; ++n) {
+            const signed_index_vec &c = coords[n];
+            tree.set(c[0], c[1], c[2], float(pass + 1));
+        }
+        for (size_t n = 0; n < count; ++n) {
+            const signed_index_vec &c = coords[n];
+            tree.unset(c[0], c[1], c[2]);
+        }
+    }
+    BenchmarkRegistry::report(label, 2 * count * passes, timer.elapsed());
+    BenchmarkRegistry::consume(tree.get(0, 0, 0));
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchPooledCellChurn()
+{
+    benchCellChurn<heap_tree_type>("Tree set/unset churn heap");
+    benchCellChurn<pool_tree_type>("Tree set/unset churn pooled");
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchPooledCellChurn);
+
+//------------------------------------------------------------------------------
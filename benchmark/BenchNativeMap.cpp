@@ -0,0 +1,157 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchNativeMap.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <fstream>
+
+#include <nkhive/attributes/StringAttribute.h>
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+const int   kParticles = 1 << 14;
+const int   kLookups   = 1 << 20;
+const char *kFileName  = "benchNativeMap.nkv";
+
+/**
+ * Particles scattered over a box, each splatting a small blob of distinct
+ * values so nearly every cell holds voxel data of its own.
+ */
+void
+makeVolume(volume_type &volume, i32 coords[][3])
+{
+    u32 seed = 11;
+    for (int n = 0; n < kParticles; ++n) {
+        for (int c = 0; c < 3; ++c) {
+            seed = seed * 1664525u + 1013904223u;
+            coords[n][c] = i32((seed >> 8) % 1024u) - 512;
+        }
+        for (i32 d = 0; d < 8; ++d) {
+            volume.set(coords[n][0] + (d & 1), coords[n][1] + (d >> 1 & 1),
+                       coords[n][2] + (d >> 2), float(n + d));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchLookups(const volume_type &volume, i32 coords[][3], const char *name)
+{
+    BenchmarkTimer timer;
+    float sum = 0.0f;
+    for (int n = 0; n < kLookups; ++n) {
+        const i32 *c = coords[n % kParticles];
+        sum += volume.get(c[0], c[1], c[2]);
+    }
+    char label[64];
+    sprintf(label, "get, %s", name);
+    BenchmarkRegistry::report(label, kLookups, timer.elapsed());
+    BenchmarkRegistry::consume(sum);
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchNativeMap()
+{
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+
+    static i32 coords[kParticles][3];
+    volume_type volume(2, 3, 0.0f);
+    makeVolume(volume, coords);
+
+    // the stream format, read back through an istream
+    remove(kFileName);
+    {
+        std::ofstream os(kFileName, std::ios_base::binary);
+        volume.write(os);
+    }
+    {
+        BenchmarkTimer timer;
+        std::ifstream is(kFileName, std::ios_base::binary);
+        volume_type read_volume(2, 3, 0.0f);
+        read_volume.read(is);
+        BenchmarkRegistry::report("stream read", kParticles, timer.elapsed());
+        benchLookups(read_volume, coords, "stream read");
+    }
+
+    // the native format, mapped in place
+    remove(kFileName);
+    {
+        BenchmarkTimer timer;
+        std::ofstream os(kFileName, std::ios_base::binary);
+        volume.writeNative(os);
+        os.close();
+        BenchmarkRegistry::report("native write", kParticles, 
+                                  timer.elapsed());
+    }
+    {
+        BenchmarkTimer timer;
+        volume_type mapped_volume(2, 3, 0.0f);
+        mapped_volume.map(kFileName);
+        BenchmarkRegistry::report("native map", kParticles, timer.elapsed());
+        benchLookups(mapped_volume, coords, "native map");
+        printf("  resident bytes: %d mapped, %d in memory\n",
+               mapped_volume.sizeOf(), volume.sizeOf());
+    }
+    remove(kFileName);
+
+    Attribute::clearAttributeRegistry();
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchNativeMap);
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,152 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchParallelForEach.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <vector>
+
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+const i32 kExtent = 96;
+
+/**
+ * Sums the voxel values.
+ */
+struct SumVoxels
+{
+    SumVoxels() : 
+        sum(0.0) 
+    {
+    }
+
+    void operator()(const signed_index_vec&, const float &value)
+    {
+        sum += value;
+    }
+
+    double sum;
+};
+
+/**
+ * Scales the voxel values in place.
+ */
+struct ScaleVoxels
+{
+    void operator()(const signed_index_vec&, float &value)
+    {
+        value *= 0.5f;
+    }
+};
+
+//------------------------------------------------------------------------------
+
+void
+populate(volume_type &volume)
+{
+    volume_type::accessor acc = volume.getAccessor();
+    for (i32 k = -kExtent; k < kExtent; ++k) {
+        for (i32 j = -kExtent; j < kExtent; ++j) {
+            for (i32 i = -kExtent; i < kExtent; ++i) {
+                acc.set(i, j, k, float((i ^ j ^ k) & 0xff));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchParallelForEach()
+{
+    const size_t voxels = size_t(8) * kExtent * kExtent * kExtent;
+
+    volume_type volume(2, 3, 0.0f);
+    populate(volume);
+    const volume_type &const_volume = volume;
+
+    // serial baseline through the set iterator
+    BenchmarkTimer timer;
+    double sum = 0.0;
+    volume_type::set_iterator sit = volume.setIterator();
+    for ( ; sit(); ++sit) {
+        sum += *sit;
+    }
+    BenchmarkRegistry::report("Volume sum set_iterator", voxels, 
+                              timer.elapsed());
+    BenchmarkRegistry::consume(sum);
+
+    const size_t counts[] = { 1, 2, 4, 8 };
+    for (size_t n = 0; n < sizeof(counts) / sizeof(counts[0]); ++n) {
+        char label[64];
+
+        timer.restart();
+        std::vector<SumVoxels> sums = 
+            const_volume.parallelForEach(SumVoxels(), counts[n]);
+        sprintf(label, "Volume sum parallelForEach %d threads", 
+                int(counts[n]));
+        BenchmarkRegistry::report(label, voxels, timer.elapsed());
+        BenchmarkRegistry::consume(sums[0].sum);
+
+        timer.restart();
+        volume.parallelForEach(ScaleVoxels(), counts[n]);
+        sprintf(label, "Volume scale parallelForEach %d threads", 
+                int(counts[n]));
+        BenchmarkRegistry::report(label, voxels, timer.elapsed());
+    }
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchParallelForEach);
+
+//------------------------------------------------------------------------------
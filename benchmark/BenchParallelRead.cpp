@@ -0,0 +1,146 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchParallelRead.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <sstream>
+
+#include <nkhive/attributes/StringAttribute.h>
+#include <nkhive/io/VolumeFile.h>
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+const int   kParticles = 1 << 14;
+const char *kFileName  = "benchParallelRead.hv";
+
+/**
+ * Particles scattered over a box, each setting a small blob of distinct
+ * values so nearly every cell holds voxel data of its own.
+ */
+void
+makeVolume(volume_type &volume)
+{
+    u32 seed = 11;
+    for (int n = 0; n < kParticles; ++n) {
+        i32 c[3];
+        for (int a = 0; a < 3; ++a) {
+            seed = seed * 1664525u + 1013904223u;
+            c[a] = i32((seed >> 8) % 1024u) - 512;
+        }
+        for (i32 d = 0; d < 8; ++d) {
+            volume.set(c[0] + (d & 1), c[1] + (d >> 1 & 1), c[2] + (d >> 2),
+                       float(n + d));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchParallelRead()
+{
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+
+    volume_type volume(2, 3, 0.0f);
+    makeVolume(volume);
+
+    std::ostringstream os(std::ios_base::binary);
+    volume.write(os);
+    const std::string bytes = os.str();
+
+    const HDF5Layout layouts[] = { HDF5_LAYOUT_LEAF_TABLE, 
+                                   HDF5_LAYOUT_LEAF_GROUPS };
+    const char *layout_names[] = { "leaf table", "leaf groups" };
+    const size_t threads[] = { 1, 2, 4, 0 };
+    for (int l = 0; l < 2; ++l) {
+        remove(kFileName);
+        {
+            VolumeFile file(kFileName, VoidFile::WRITE_TRUNC);
+            file.write(volume, layouts[l]);
+            file.close();
+        }
+
+        for (int t = 0; t < 4; ++t) {
+            BenchmarkTimer timer;
+            VolumeFile file(kFileName, VoidFile::READ_ONLY);
+            volume_type::shared_ptr read_volume = 
+                file.read<volume_type>(0, threads[t]);
+            file.close();
+
+            char label[64];
+            sprintf(label, "hdf5 read, %s, %d threads", layout_names[l], 
+                    int(threads[t]));
+            BenchmarkRegistry::report(label, kParticles, timer.elapsed());
+        }
+    }
+    remove(kFileName);
+
+    for (int t = 0; t < 4; ++t) {
+        BenchmarkTimer timer;
+        std::istringstream is(bytes, std::ios_base::binary);
+        volume_type read_volume(2, 3, 0.0f);
+        read_volume.read(is, threads[t]);
+
+        char label[64];
+        sprintf(label, "stream read, %d threads", int(threads[t]));
+        BenchmarkRegistry::report(label, kParticles, timer.elapsed());
+    }
+
+    Attribute::clearAttributeRegistry();
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchParallelRead);
+
+//------------------------------------------------------------------------------
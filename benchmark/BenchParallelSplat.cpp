@@ -0,0 +1,134 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchParallelSplat.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <functional>
+#include <vector>
+#include <boost/thread/thread.hpp>
+
+#include <nkhive/interpolation/LinearSplat.h>
+#include <nkhive/interpolation/ParallelSplatter.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef LinearSplat<float, std::plus>   splat_type;
+
+/**
+ * Particles are spread over [-kHalfDim, kHalfDim)^3 voxels.
+ */
+const i32 kHalfDim = 48;
+
+/**
+ * Number of particles splatted per pass.
+ */
+const size_t kPoints = 1 << 20;
+
+//------------------------------------------------------------------------------
+
+/**
+ * Serial splatting against ParallelSplatter with 1, 2, 4, ... threads up to
+ * one per core.
+ */
+void
+benchParallelSplat()
+{
+    std::vector<vec3d> pts(kPoints);
+    std::vector<float> vals(kPoints);
+    u32 seed = 29;
+    for (size_t n = 0; n < kPoints; ++n) {
+        for (i32 a = 0; a < 3; ++a) {
+            seed = seed * 1664525u + 1013904223u;
+            pts[n][a] = ((seed >> 8) % 100000) / 100000.0 * 2.0 * kHalfDim - 
+                        kHalfDim;
+        }
+        vals[n] = float(n % 7) * 0.125f;
+    }
+
+    {
+        Volume<float>::shared_ptr volume(new Volume<float>(3, 3, 0.0f));
+        splat_type splat(volume);
+
+        BenchmarkTimer timer;
+        for (size_t n = 0; n < kPoints; ++n) {
+            splat.splat(pts[n].x, pts[n].y, pts[n].z, vals[n]);
+        }
+        BenchmarkRegistry::report("LinearSplat serial", double(kPoints), 
+                                  timer.elapsed());
+        BenchmarkRegistry::consume(volume->get(0, 0, 0));
+    }
+
+    size_t cores = boost::thread::hardware_concurrency();
+    if (cores == 0) cores = 1;
+
+    std::vector<size_t> counts;
+    for (size_t count = 1; count < cores; count *= 2) {
+        counts.push_back(count);
+    }
+    counts.push_back(cores);
+
+    for (size_t n = 0; n < counts.size(); ++n) {
+        Volume<float>::shared_ptr volume(new Volume<float>(3, 3, 0.0f));
+        ParallelSplatter<splat_type> splatter(volume, 0.0f, counts[n]);
+
+        BenchmarkTimer timer;
+        splatter.splat(&pts[0], &vals[0], kPoints);
+
+        char label[64];
+        sprintf(label, "ParallelSplatter %d threads", int(counts[n]));
+        BenchmarkRegistry::report(label, double(kPoints), timer.elapsed());
+        BenchmarkRegistry::consume(volume->get(0, 0, 0));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchParallelSplat);
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,135 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchPrune.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+/**
+ * Uniform block [0, kDim)^3 written voxel by voxel.
+ */
+const i32 kDim = 64;
+
+void
+fillVolume(volume_type &volume)
+{
+    for (i32 k = 0; k < kDim; ++k) {
+        for (i32 j = 0; j < kDim; ++j) {
+            for (i32 i = 0; i < kDim; ++i) {
+                volume.set(i, j, k, 1.0f);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Walks every set voxel, the cost later iteration and I/O pay.
+ */
+void
+iterate(const volume_type &volume, const char *label)
+{
+    double ops = double(kDim) * kDim * kDim;
+    BenchmarkTimer timer;
+    double sum = 0.0;
+    for (volume_type::set_iterator iter = volume.setIterator(); iter(); 
+         ++iter) {
+        sum += *iter;
+    }
+    BenchmarkRegistry::report(label, ops, timer.elapsed());
+    BenchmarkRegistry::consume(sum);
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchPrune()
+{
+    double ops = double(kDim) * kDim * kDim;
+
+    volume_type volume(2, 3, 0.0f);
+    {
+        BenchmarkTimer timer;
+        fillVolume(volume);
+        BenchmarkRegistry::report("set", ops, timer.elapsed());
+    }
+    int dense_size = volume.sizeOf();
+    iterate(volume, "iterate dense");
+
+    {
+        BenchmarkTimer timer;
+        volume.prune();
+        BenchmarkRegistry::report("prune", ops, timer.elapsed());
+    }
+    iterate(volume, "iterate pruned");
+
+    volume_type auto_volume(2, 3, 0.0f);
+    auto_volume.setAutoPrune(true);
+    {
+        BenchmarkTimer timer;
+        fillVolume(auto_volume);
+        BenchmarkRegistry::report("set with auto prune", ops, 
+                                  timer.elapsed());
+    }
+
+    printf("  memory: %d bytes dense, %d pruned, %d auto pruned\n", 
+           dense_size, volume.sizeOf(), auto_volume.sizeOf());
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchPrune);
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,141 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchSparseNodes.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <vector>
+
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+typedef Volume<float> volume_type;
+
+const int kParticles = 1 << 15;
+const int kLookups   = 1 << 20;
+
+/**
+ * Particles scattered over a large box, most nodes end up with a handful of
+ * set branches.
+ */
+void
+makeCloud(std::vector<signed_index_vec> &coords)
+{
+    u32 seed = 7;
+    coords.resize(kParticles);
+    for (int n = 0; n < kParticles; ++n) {
+        seed = seed * 1664525u + 1013904223u;
+        i32 i = i32(seed % 4096u) - 2048;
+        seed = seed * 1664525u + 1013904223u;
+        i32 j = i32(seed % 4096u) - 2048;
+        seed = seed * 1664525u + 1013904223u;
+        i32 k = i32(seed % 4096u) - 2048;
+        coords[n] = signed_index_vec(i, j, k);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Random lookups, half of them on set voxels.
+ */
+void
+lookup(const volume_type &volume, 
+       const std::vector<signed_index_vec> &coords, const char *label)
+{
+    BenchmarkTimer timer;
+    float sum = 0.0f;
+    u32 seed = 3;
+    for (int n = 0; n < kLookups; ++n) {
+        seed = seed * 1664525u + 1013904223u;
+        signed_index_vec c = coords[(seed >> 8) % kParticles];
+        if (seed & 1) c.x += 1;
+        sum += volume.get(c.x, c.y, c.z);
+    }
+    BenchmarkRegistry::report(label, kLookups, timer.elapsed());
+    BenchmarkRegistry::consume(sum);
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchSparseNodes()
+{
+    std::vector<signed_index_vec> coords;
+    makeCloud(coords);
+
+    const uint8_t factors[] = { 2, 3 };
+    for (size_t f = 0; f < sizeof(factors) / sizeof(factors[0]); ++f) {
+        volume_type volume(factors[f], 3, 0.0f);
+        for (int n = 0; n < kParticles; ++n) {
+            volume.set(coords[n], 1.0f);
+        }
+
+        char label[64];
+        sprintf(label, "get sparse nodes, lg branching %d", int(factors[f]));
+        lookup(volume, coords, label);
+        int sparse_size = volume.sizeOf();
+
+        // concurrent write mode keeps a slot for every branch.
+        volume.beginConcurrentWrites();
+        sprintf(label, "get dense nodes, lg branching %d", int(factors[f]));
+        lookup(volume, coords, label);
+        int dense_size = volume.sizeOf();
+        volume.endConcurrentWrites();
+
+        printf("  memory: %d bytes sparse, %d dense\n", sparse_size, 
+               dense_size);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchSparseNodes);
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,176 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BenchStencil.cpp
+//------------------------------------------------------------------------------
+
+#include <cstdio>
+#include <vector>
+
+#include <nkhive/volume/Volume.h>
+
+#include "Benchmark.h"
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+namespace {
+
+USING_NK_NS
+USING_NKHIVE_NS
+
+/**
+ * Dense block [-kHalfDim, kHalfDim)^3 spanning all eight quadrants.
+ */
+const i32 kHalfDim = 48;
+
+/**
+ * Number of random stencil centers gathered.
+ */
+const int kStencils = 1 << 17;
+
+//------------------------------------------------------------------------------
+
+/**
+ * Gathers a width^3 neighbourhood around random centers through a
+ * const accessor, the access pattern of the interpolators.
+ */
+template <typename V>
+void
+benchGather(const char *layout, i32 width)
+{
+    V volume(3, 3, 0.0f);
+    for (i32 k = -kHalfDim; k < kHalfDim; ++k) {
+        for (i32 j = -kHalfDim; j < kHalfDim; ++j) {
+            for (i32 i = -kHalfDim; i < kHalfDim; ++i) {
+                volume.set(i, j, k, float(i + j + k));
+            }
+        }
+    }
+
+    typename V::const_accessor acc = 
+        static_cast<const V&>(volume).getAccessor();
+
+    u32 seed = 7;
+    i32 range = 2 * kHalfDim - width;
+    BenchmarkTimer timer;
+    double sum = 0.0;
+    for (int n = 0; n < kStencils; ++n) {
+        seed = seed * 1664525u + 1013904223u;
+        i32 x = i32(seed % u32(range)) - kHalfDim;
+        i32 y = i32((seed >> 10) % u32(range)) - kHalfDim;
+        i32 z = i32((seed >> 20) % u32(range)) - kHalfDim;
+        for (i32 k = 0; k < width; ++k) {
+            for (i32 j = 0; j < width; ++j) {
+                for (i32 i = 0; i < width; ++i) {
+                    sum += acc.get(x + i, y + j, z + k);
+                }
+            }
+        }
+    }
+    double secs = timer.elapsed();
+
+    char label[64];
+    sprintf(label, "%s %dx%dx%d gather", layout, width, width, width);
+    BenchmarkRegistry::report(label, double(kStencils), secs);
+    BenchmarkRegistry::consume(sum);
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Same stencils gathered with Volume::getBlock(), one lookup per cell.
+ */
+template <typename V>
+void
+benchBlock(const char *layout, i32 width)
+{
+    V volume(3, 3, 0.0f);
+    for (i32 k = -kHalfDim; k < kHalfDim; ++k) {
+        for (i32 j = -kHalfDim; j < kHalfDim; ++j) {
+            for (i32 i = -kHalfDim; i < kHalfDim; ++i) {
+                volume.set(i, j, k, float(i + j + k));
+            }
+        }
+    }
+
+    std::vector<float> block(width * width * width);
+    u32 seed = 7;
+    i32 range = 2 * kHalfDim - width;
+    BenchmarkTimer timer;
+    double sum = 0.0;
+    for (int n = 0; n < kStencils; ++n) {
+        seed = seed * 1664525u + 1013904223u;
+        i32 x = i32(seed % u32(range)) - kHalfDim;
+        i32 y = i32((seed >> 10) % u32(range)) - kHalfDim;
+        i32 z = i32((seed >> 20) % u32(range)) - kHalfDim;
+        volume.getBlock(signed_index_vec(x, y, z), index_vec(width), 
+                        &block[0]);
+        for (size_t v = 0; v < block.size(); ++v) {
+            sum += block[v];
+        }
+    }
+    double secs = timer.elapsed();
+
+    char label[64];
+    sprintf(label, "%s %dx%dx%d getBlock", layout, width, width, width);
+    BenchmarkRegistry::report(label, double(kStencils), secs);
+    BenchmarkRegistry::consume(sum);
+}
+
+//------------------------------------------------------------------------------
+
+void
+benchStencil()
+{
+    benchGather< Volume<float> >("Row major", 2);
+    benchGather< Volume<float, MortonLayout> >("Morton", 2);
+    benchGather< Volume<float> >("Row major", 4);
+    benchGather< Volume<float, MortonLayout> >("Morton", 4);
+    benchBlock< Volume<float> >("Row major", 2);
+    benchBlock< Volume<float, MortonLayout> >("Morton", 2);
+    benchBlock< Volume<float> >("Row major", 4);
+    benchBlock< Volume<float, MortonLayout> >("Morton", 4);
+}
+
+//------------------------------------------------------------------------------
+
+} // namespace
+
+//------------------------------------------------------------------------------
+// registration
+//------------------------------------------------------------------------------
+
+BENCHMARK_REGISTRATION(benchStencil);
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Benchmark.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_BENCHMARK_BENCHMARK_H__
+#define __NKHIVE_BENCHMARK_BENCHMARK_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+#define BENCHMARK_CONCAT_(a, b) a##b
+#define BENCHMARK_CONCAT(a, b)  BENCHMARK_CONCAT_(a, b)
+
+/**
+ * Registers a free function 'void f()' to be run by the benchmark driver.
+ */
+#define BENCHMARK_REGISTRATION(function)                                     \
+    static BenchmarkRegistry::Registrar                                      \
+        BENCHMARK_CONCAT(s_benchmark_, __LINE__)(#function, &function)
+
+//------------------------------------------------------------------------------
+// class definitions
+//------------------------------------------------------------------------------
+
+/**
+ * Wall clock timer. Starts on construction.
+ */
+class BenchmarkTimer
+{
+
+public:
+
+    BenchmarkTimer() 
+    { 
+        restart(); 
+    }
+
+    void restart() 
+    { 
+        m_start = boost::posix_time::microsec_clock::universal_time(); 
+    }
+
+    /**
+     * Returns the seconds elapsed since the last restart.
+     */
+    double elapsed() const
+    {
+        boost::posix_time::time_duration d = 
+            boost::posix_time::microsec_clock::universal_time() - m_start;
+        return d.total_microseconds() * 1e-6;
+    }
+
+private:
+
+    boost::posix_time::ptime m_start;
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * Holds the registered benchmarks and prints their results in a common
+ * format.
+ */
+class BenchmarkRegistry
+{
+
+public:
+
+    typedef void (*function_type)();
+
+    struct Entry
+    {
+        const char    *name;
+        function_type  function;
+    };
+
+    /**
+     * Adds a benchmark at static initialization time.
+     */
+    struct Registrar
+    {
+        Registrar(const char *name, function_type function)
+        {
+            Entry entry = { name, function };
+            entries().push_back(entry);
+        }
+    };
+
+    static std::vector<Entry>& entries()
+    {
+        static std::vector<Entry> s_entries;
+        return s_entries;
+    }
+
+    /**
+     * Runs all benchmarks whose name contains the filter, all of them if
+     * the filter is NULL.
+     */
+    static void run(const char *filter)
+    {
+        for (size_t i = 0; i < entries().size(); ++i) {
+            if (filter && !strstr(entries()[i].name, filter)) continue;
+            printf("%s\n", entries()[i].name);
+            entries()[i].function();
+        }
+    }
+
+    /**
+     * Prints a single measurement.
+     */
+    static void report(const char *label, double ops, double seconds)
+    {
+        printf("  %-40s %12.0f ops %10.3f ms %10.2f ns/op\n", label, ops,
+               seconds * 1e3, ops > 0.0 ? seconds * 1e9 / ops : 0.0);
+    }
+
+    /**
+     * Consumes a result so the optimizer cannot discard the measured work.
+     */
+    template <typename T>
+    static void consume(const T &value)
+    {
+        static volatile double s_sink = 0.0;
+        s_sink = s_sink + double(value);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_BENCHMARK_BENCHMARK_H__
@@ -43,6 +43,7 @@
 #include <memory>
 
 #include <nkhive/Defs.h>
+#include <nkhive/memory/PoolAllocator.h>
 #include <nkbase/Types.h>
 
 //-----------------------------------------------------------------------------
@@ -51,7 +52,9 @@
 
 BEGIN_NKHIVE_NS
 
-template <typename T, typename A>
+class RowMajorLayout;
+
+template <typename T, typename A, typename L>
 class BitField3D;
 
 template <typename T>
@@ -81,10 +84,11 @@ typedef Bounds3D<index_type>        index_bounds;
 
 typedef BoundingBox<f64>            bounding_box;
 
-typedef std::allocator<index_type>  bitfield_alloc;
+typedef PoolAllocator<index_type>   bitfield_alloc;
 
 typedef BitField3D<index_type, 
-                   bitfield_alloc>  bitfield_type;
+                   bitfield_alloc,
+                   RowMajorLayout>  bitfield_type;
 
 //-----------------------------------------------------------------------------
 
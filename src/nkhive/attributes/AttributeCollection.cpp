@@ -310,12 +310,14 @@ AttributeCollection::read(HDF5Id volume_group_id)
 
     // iterate over all attributes
     HDF5Size attr_index = 0;
+    HDF5CallbackGuard guard(reinterpret_cast<void *>(this));
     H5Aiterate(user_attr_group.id(), 
                H5_INDEX_NAME, 
                H5_ITER_NATIVE, 
                &attr_index,
-               AttributeCollection::readAttribute,
-               reinterpret_cast<void *>(this));
+               hdf5Guarded<H5A_info_t, AttributeCollection::readAttribute>,
+               &guard);
+    guard.rethrow();
 
 }
 
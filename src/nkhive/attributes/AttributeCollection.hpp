@@ -93,7 +93,7 @@ AttributeCollection::findTypedAttribute(const String &n) const
     }
 
     if (iter->second->typeName() == T::staticTypeName()) {
-        return boost::static_pointer_cast<const T, Attribute>(iter->second);
+        return boost::static_pointer_cast<T, Attribute>(iter->second);
     }
     // else
     return typename T::shared_ptr();
@@ -47,12 +47,15 @@
 #include <iterator>  
 #include <memory>   
 #include <stdexcept> 
+#include <vector>
 
 #include <boost/typeof/typeof.hpp>
 
 #include <nkhive/Defs.h>
 #include <nkhive/Types.h>
 #include <nkhive/bitfields/BitOps.h> 
+#include <nkhive/bitfields/Layout.h>
+#include <nkhive/util/Atomic.h>
 #include <nkhive/io/hdf5/HDF5Util.h>
 #include <nkhive/io/hdf5/HDF5DataSet.h>
 
@@ -62,16 +65,16 @@
   
 BEGIN_NKHIVE_NS
 
-template <typename T, typename A> 
+template <typename T, typename A, typename L> 
 class BitField3D;
 
-template <typename T, typename A> 
+template <typename T, typename A, typename L> 
 std::istream& 
-operator>>(std::istream& o, const BitField3D<T, A>& bitfield);
+operator>>(std::istream& o, const BitField3D<T, A, L>& bitfield);
 
-template <typename T, typename A> 
+template <typename T, typename A, typename L> 
 std::ostream& 
-operator<<(std::ostream& o, const BitField3D<T, A>& bitfield);
+operator<<(std::ostream& o, const BitField3D<T, A, L>& bitfield);
 
 END_NKHIVE_NS
 
@@ -89,7 +92,8 @@ BEGIN_NKHIVE_NS
  *  Special iterator adapters are provided for efficient traversal of the 
  *  data coupled with the bitfield.
  */
-template < typename T, typename A = std::allocator<T> >
+template < typename T, typename A = std::allocator<T>, 
+           typename L = RowMajorLayout >
 class BitField3D 
 {
     
@@ -101,6 +105,7 @@ public:
 
     typedef A                                        allocator_type;
     typedef typename allocator_type::value_type      value_type;
+    typedef L                                        layout_type;
 
     typedef typename allocator_type::size_type       size_type;
     typedef typename allocator_type::difference_type difference_type;
@@ -178,6 +183,12 @@ public:
     void setBit(index_type x, index_type y, index_type z);
     void unsetBit(index_type x, index_type y, index_type z);
 
+    /**
+     * Sets a single bit with an atomic or, so several threads may set bits
+     * in the same block. The bitfield must not have a rank directory.
+     */
+    void setBitAtomic(index_type i);
+
     /**
      * Iterators used to traverse the bitfield, bit by bit.
      */
@@ -229,6 +240,17 @@ public:
      */
     index_type countRange(index_type i) const;
 
+    /**
+     * Keep a directory of the cumulative bit count before each block and a
+     * sample of the block holding every SELECT_SAMPLE-th set bit, making
+     * countRange() and getSetIndex() constant time. The directory comes
+     * from the bitfield's allocator. Modifying the bits through the 
+     * bitfield drops the directory.
+     */
+    void buildRankDirectory();
+    void clearRankDirectory();
+    bool hasRankDirectory() const;
+
     /**
      * Get bitfield's log2 3D cube dimensions.
      */
@@ -252,7 +274,15 @@ public:
     void swap(BitField3D &that);
 
     /**
-     * Read and write bitfield to/from input stream.
+     * Copies a bitfield of another layout, moving every bit to its index in
+     * this layout.
+     */
+    template <typename M>
+    void relayout(const BitField3D<T, A, M> &that);
+
+    /**
+     * Read and write bitfield to/from input stream. Bits are always stored
+     * in row major order.
      */
     void read(HDF5Id parent_id);
     void write(HDF5Id parent_id) const;
@@ -260,6 +290,13 @@ public:
     void read(std::istream &is);
     void write(std::ostream &os) const;
 
+    /**
+     * Read and write the row major blocks from/to a flat byte array, as used
+     * by the leaf table layout. Writing appends to the array.
+     */
+    void read(size_type lg_size, const u8 *bytes);
+    void write(std::vector<u8> &bytes) const;
+
     /**
      * Returns string representation of bitfield.
      */
@@ -270,6 +307,13 @@ public:
      */
     BitField3D& operator=(const BitField3D& that);
 
+    /**
+     * Bitwise operators. Both bitfields must be of the same size.
+     */
+    BitField3D& operator&=(const BitField3D& that);
+    BitField3D& operator|=(const BitField3D& that);
+    BitField3D& operator^=(const BitField3D& that);
+
     /**
      * Comparison operators.
      */
@@ -333,6 +377,13 @@ private:
     template <class FI, bool S>
     class status_iterator;
 
+    typedef typename A::template rebind<index_type>::other rank_allocator;
+
+    /**
+     * Set bits between select samples of the rank directory.
+     */
+    enum { SELECT_SAMPLE = 16 };
+
     //-------------------------------------------------------------------------
     // members
     //-------------------------------------------------------------------------
@@ -341,14 +392,16 @@ private:
     pointer        m_blocks;    // block pointer
     size_type      m_capacity;  // block count 
     size_type      m_lg_size;   // Log2 of bitfield size
+    index_type    *m_ranks;     // rank and select directory, optional
+    size_type      m_ranks_size;
 };
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::iterator
+// BitField3D<T, A, L>::iterator
 //-----------------------------------------------------------------------------
 
-template < typename T, typename A = std::allocator<T> >
-class BitField3D<T, A>::iterator 
+template < typename T, typename A, typename L >
+class BitField3D<T, A, L>::iterator 
 {
 
 public:
@@ -415,11 +468,11 @@ private:
 };
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::const_iterator
+// BitField3D<T, A, L>::const_iterator
 //-----------------------------------------------------------------------------
 
-template < typename T, typename A = std::allocator<T> >
-class BitField3D<T, A>::const_iterator 
+template < typename T, typename A, typename L >
+class BitField3D<T, A, L>::const_iterator 
 { 
 
 public:
@@ -484,11 +537,11 @@ private:
 };
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::block_iterator
+// BitField3D<T, A, L>::block_iterator
 //-----------------------------------------------------------------------------
 
-template < typename T, typename A = std::allocator<T> >
-class BitField3D<T, A>::block_iterator 
+template < typename T, typename A, typename L >
+class BitField3D<T, A, L>::block_iterator 
 {
 
 public:
@@ -554,12 +607,12 @@ private:
 };
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::status_iterator
+// BitField3D<T, A, L>::status_iterator
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A> 
+template <typename T, typename A, typename L> 
 template <class FI, bool S>
-class BitField3D<T, A>::status_iterator
+class BitField3D<T, A, L>::status_iterator
 {
 
 public:
@@ -574,9 +627,9 @@ public:
     typedef typename FI::pointer                 pointer;
     typedef typename FI::reference               reference;
     
-    typedef typename BitField3D<T, A>::size_type size_type;
-    typedef typename BitField3D<T, A>::pointer   block_pointer;
-    typedef typename BitField3D<T, A>::reference block_reference;
+    typedef typename BitField3D<T, A, L>::size_type size_type;
+    typedef typename BitField3D<T, A, L>::pointer   block_pointer;
+    typedef typename BitField3D<T, A, L>::reference block_reference;
 
     //-------------------------------------------------------------------------
     // public interface
@@ -636,12 +689,12 @@ private:
 };
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::set_iterator
+// BitField3D<T, A, L>::set_iterator
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A> 
+template <typename T, typename A, typename L> 
 template <class FI>
-class BitField3D<T, A>::set_iterator : public status_iterator<FI, 1>
+class BitField3D<T, A, L>::set_iterator : public status_iterator<FI, 1>
 {
 
 public:
@@ -665,12 +718,12 @@ public:
 };
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::unset_iterator
+// BitField3D<T, A, L>::unset_iterator
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A> 
+template <typename T, typename A, typename L> 
 template <class FI>
-class BitField3D<T, A>::unset_iterator : public status_iterator<FI, 0>
+class BitField3D<T, A, L>::unset_iterator : public status_iterator<FI, 0>
 {
 
 public:
@@ -694,11 +747,11 @@ public:
 };
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::window_iterator
+// BitField3D<T, A, L>::window_iterator
 //-----------------------------------------------------------------------------
 
-template < typename T, typename A = std::allocator<T> >
-class BitField3D<T, A>::window_iterator 
+template < typename T, typename A, typename L >
+class BitField3D<T, A, L>::window_iterator 
 { 
 
 public:
@@ -751,11 +804,18 @@ private:
     
     bool valid() const;
 
+    /**
+     * Computes the bitfield index of the current window position through the
+     * layout.
+     */
+    void updateIndex();
+
     //-------------------------------------------------------------------------
     // members
     //-------------------------------------------------------------------------
 
     pointer    m_blocks;  
+    size_type  m_lg_size;
     
     index_type m_begin;
     index_type m_end;
@@ -763,9 +823,8 @@ private:
     index_type m_wnd_index;
     index_type m_wnd_size;
 
-    index_type m_row_shift;
-    index_type m_page_shift;
-    index_type m_wnd_size_sqrd;
+    index_vec  m_min;     // coordinates of the window's first voxel
+    index_vec  m_wnd;     // position inside the window
 
 };
 
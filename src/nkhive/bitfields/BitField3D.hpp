@@ -39,26 +39,30 @@
 // class implementation 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::BitField3D(const allocator_type& a) :
+BitField3D<T, A, L>::BitField3D(const allocator_type& a) :
     m_allocator(a),
     m_blocks(NULL),
     m_capacity(0),
-    m_lg_size(0)
+    m_lg_size(0),
+    m_ranks(NULL),
+    m_ranks_size(0)
 {
     // nothing to see here
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::BitField3D(size_type lg_size, const allocator_type& a) :
+BitField3D<T, A, L>::BitField3D(size_type lg_size, const allocator_type& a) :
     m_allocator(a),
     m_blocks(NULL),
     m_capacity(0),
-    m_lg_size(lg_size)
+    m_lg_size(lg_size),
+    m_ranks(NULL),
+    m_ranks_size(0)
 {
     // figure out how many blocks are needed to represent the bits
     index_type bits         = numBits3D(m_lg_size);
@@ -72,74 +76,99 @@ BitField3D<T, A>::BitField3D(size_type lg_size, const allocator_type& a) :
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::BitField3D(const BitField3D& that) :
+BitField3D<T, A, L>::BitField3D(const BitField3D& that) :
     m_allocator(that.m_allocator),
     m_blocks(NULL),
     m_capacity(that.m_capacity),
-    m_lg_size(that.m_lg_size)
+    m_lg_size(that.m_lg_size),
+    m_ranks(NULL),
+    m_ranks_size(0)
 {
     allocate(&m_blocks, m_capacity);
     copy(m_blocks, that.m_blocks, m_capacity);
+
+    if (that.m_ranks) {
+        buildRankDirectory();
+    }
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::~BitField3D()
+BitField3D<T, A, L>::~BitField3D()
 {
     deallocate(m_blocks, m_capacity);
+    clearRankDirectory();
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline index_type
-BitField3D<T, A>::getIndex(index_type i, index_type j, index_type k) const
+BitField3D<T, A, L>::getIndex(index_type i, index_type j, index_type k) const
 {
-    index_type index = NKHIVE_NS::getIndex(i, j, k, m_lg_size);
+    index_type index = L::getIndex(i, j, k, m_lg_size);
     return index;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void
-BitField3D<T, A>::getCoordinates(
+BitField3D<T, A, L>::getCoordinates(
         index_type index, index_type& i, index_type& j, index_type& k) const
 {
-    NKHIVE_NS::getCoordinates(index, m_lg_size, i, j, k);
+    L::getCoordinates(index, m_lg_size, i, j, k);
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline index_type
-BitField3D<T, A>::getSetIndex(index_type si) const
-{
-    const_iterator i = begin();
-    const_iterator e = end();
-
-    ++si;
-    while (i != e) {
-        if (i.isSet() && !--si) {
-            break;
+BitField3D<T, A, L>::getSetIndex(index_type si) const
+{
+    assert(si < count());
+
+    index_type block = 0;
+    if (m_ranks) {
+        // start from the nonempty block holding the last sampled set bit, 
+        // fewer than SELECT_SAMPLE nonempty blocks lie between it and si
+        const index_type *blocks  = m_ranks + m_capacity + 1;
+        index_type num_samples    = (m_ranks[m_capacity] + SELECT_SAMPLE - 1) / 
+                                    SELECT_SAMPLE;
+        const index_type *samples = m_ranks + m_ranks_size - num_samples;
+
+        index_type n = samples[si / SELECT_SAMPLE];
+        while (m_ranks[blocks[n] + 1] <= si) {
+            ++n;
+        }
+        block = blocks[n];
+        si -= m_ranks[block];
+    } else {
+        index_type c;
+        while (si >= (c = getBitCount<T>(m_blocks[block]))) {
+            si -= c;
+            ++block;
         }
-        ++i;
     }
 
-    assert(!si);
+    // select the bit within the block, bits are numbered from the top so
+    // it is the (count - si)th set bit counted from the bottom
+    T v = m_blocks[block];
+    index_type bit = bitsof(T) - 1 - 
+                     getNthSetBitIndex<T>(v, getBitCount<T>(v) - 1 - si);
 
-    return i.getIndex();
+    return (block * bitsof(T)) + bit;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::isSet(index_type i) const
+BitField3D<T, A, L>::isSet(index_type i) const
 {
     index_type block = i / bitsof(T);
     index_type bit   = i % bitsof(T);
@@ -150,9 +179,9 @@ BitField3D<T, A>::isSet(index_type i) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::isSet(index_type i, index_type j, index_type k) const
+BitField3D<T, A, L>::isSet(index_type i, index_type j, index_type k) const
 {
     index_type index = getIndex(i, j, k);
     return isSet(index);
@@ -160,33 +189,59 @@ BitField3D<T, A>::isSet(index_type i, index_type j, index_type k) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::setBit(index_type i)
+BitField3D<T, A, L>::setBit(index_type i)
 {
     index_type block = i / bitsof(T);
     index_type bit   = i % bitsof(T);
 
     m_blocks[block] |= getBitMask(T, bit);
+
+    if (m_ranks) {
+        clearRankDirectory();
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline void 
+BitField3D<T, A, L>::setBitAtomic(index_type i)
+{
+    assert(!m_ranks);
+
+    index_type block = i / bitsof(T);
+    index_type bit   = i % bitsof(T);
+
+    // skip the locked instruction if the bit is already visible
+    T mask = getBitMask(T, bit);
+    if (!(atomicLoad(&m_blocks[block]) & mask)) {
+        atomicOr(&m_blocks[block], mask);
+    }
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::unsetBit(index_type i)
+BitField3D<T, A, L>::unsetBit(index_type i)
 {
     index_type block = i / bitsof(T);
     index_type bit   = i % bitsof(T);
 
     m_blocks[block] &= ~getBitMask(T, bit);
+
+    if (m_ranks) {
+        clearRankDirectory();
+    }
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::setBit(index_type i, index_type j, index_type k)
+BitField3D<T, A, L>::setBit(index_type i, index_type j, index_type k)
 {
     index_type index = getIndex(i, j, k);
     setBit(index);
@@ -194,9 +249,9 @@ BitField3D<T, A>::setBit(index_type i, index_type j, index_type k)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::unsetBit(index_type i, index_type j, index_type k)
+BitField3D<T, A, L>::unsetBit(index_type i, index_type j, index_type k)
 {
     index_type index = getIndex(i, j, k);
     unsetBit(index);
@@ -204,74 +259,74 @@ BitField3D<T, A>::unsetBit(index_type i, index_type j, index_type k)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::iterator 
-BitField3D<T, A>::begin()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::iterator 
+BitField3D<T, A, L>::begin()
 {
     return iterator(m_blocks, m_lg_size);
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::const_iterator 
-BitField3D<T, A>::begin() const
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::const_iterator 
+BitField3D<T, A, L>::begin() const
 {
     return const_iterator(m_blocks, m_lg_size);
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::iterator 
-BitField3D<T, A>::end()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::iterator 
+BitField3D<T, A, L>::end()
 {
     return iterator(m_blocks, m_lg_size, numBits3D(size()));
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::const_iterator 
-BitField3D<T, A>::end() const
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::const_iterator 
+BitField3D<T, A, L>::end() const
 {
     return const_iterator(m_blocks, m_lg_size, numBits3D(size()));
 }
 
 //-----------------------------------------------------------------------------
     
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <class FI>
-inline typename BitField3D<T, A>::template set_iterator<FI>
-BitField3D<T, A>::setIterator(FI iter) const
+inline typename BitField3D<T, A, L>::template set_iterator<FI>
+BitField3D<T, A, L>::setIterator(FI iter) const
 {
     return set_iterator<FI>(m_blocks, m_lg_size, 0, iter);
 }
 
 //-----------------------------------------------------------------------------
     
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <class FI>
-inline typename BitField3D<T, A>::template unset_iterator<FI>
-BitField3D<T, A>::unsetIterator(FI iter) const
+inline typename BitField3D<T, A, L>::template unset_iterator<FI>
+BitField3D<T, A, L>::unsetIterator(FI iter) const
 {
     return unset_iterator<FI>(m_blocks, m_lg_size, 0, iter);
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::window_iterator 
-BitField3D<T, A>::windowIterator(index_type b, index_type size) const 
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::window_iterator 
+BitField3D<T, A, L>::windowIterator(index_type b, index_type size) const 
 {
     return window_iterator(m_blocks, m_lg_size, size, b, 0);
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::isFull() const
+BitField3D<T, A, L>::isFull() const
 {
     index_type s     = numBits3D(size());
     index_type block = s / bitsof(T);
@@ -279,11 +334,14 @@ BitField3D<T, A>::isFull() const
 
     T filled = getBitMaskFilled(T);
 
-    // check blocks
+    // check blocks, reducing without branches so the loop vectorizes
+    T all = filled;
     for (index_type i = 0; i < block; ++i) {
-        if (m_blocks[i] != filled) {
-            return false;
-        }
+        all &= m_blocks[i];
+    }
+
+    if (all != filled) {
+        return false;
     }
 
     // check bits
@@ -296,9 +354,9 @@ BitField3D<T, A>::isFull() const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::isEmpty() const
+BitField3D<T, A, L>::isEmpty() const
 {
     index_type s     = numBits3D(size());
     index_type block = s / bitsof(T);
@@ -309,21 +367,20 @@ BitField3D<T, A>::isEmpty() const
     // loop over partial used block as well
     block += !!bit;
 
-    // check blocks
+    // check blocks, reducing without branches so the loop vectorizes
+    T any = empty;
     for (index_type i = 0; i < block; ++i) {
-        if (m_blocks[i] != empty) {
-            return false;
-        }
+        any |= m_blocks[i];
     }
 
-    return true;
+    return any == empty;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::fillBits()
+BitField3D<T, A, L>::fillBits()
 {
     index_type s     = numBits3D(size());
     index_type block = s / bitsof(T);
@@ -338,13 +395,15 @@ BitField3D<T, A>::fillBits()
     if (bit) {
         m_blocks[block] = getBitMaskFilled(T) & getBitMaskRange(T, bit);
     }
+
+    clearRankDirectory();
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::clearBits()
+BitField3D<T, A, L>::clearBits()
 {
     index_type s     = numBits3D(size());
     index_type block = s / bitsof(T);
@@ -357,13 +416,15 @@ BitField3D<T, A>::clearBits()
     for (index_type i = 0; i < block; ++i) {
         m_blocks[i] = 0;
     }
+
+    clearRankDirectory();
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::invertBits()
+BitField3D<T, A, L>::invertBits()
 {
     index_type s     = numBits3D(size());
     index_type block = s / bitsof(T);
@@ -378,13 +439,15 @@ BitField3D<T, A>::invertBits()
     if (bit) {
         m_blocks[block] = ~m_blocks[block] & getBitMaskRange(T, bit);
     }
+
+    clearRankDirectory();
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 bool
-BitField3D<T, A>::isSingleBitSet(index_type i) const 
+BitField3D<T, A, L>::isSingleBitSet(index_type i) const 
 {
     index_type block = i / bitsof(T);
     index_type bit   = i % bitsof(T);
@@ -403,18 +466,18 @@ BitField3D<T, A>::isSingleBitSet(index_type i) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 index_type
-BitField3D<T, A>::count() const
+BitField3D<T, A, L>::count() const
 {
     return countRange(numBits3D(size()));
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 index_type
-BitField3D<T, A>::countRange(index_type i) const 
+BitField3D<T, A, L>::countRange(index_type i) const 
 {
     assert(i <= numBits3D(size()));
 
@@ -423,8 +486,10 @@ BitField3D<T, A>::countRange(index_type i) const
     index_type count = 0;
 
     // count blocks
-    for (i = 0; i < block; ++i) {
-        count += getBitCount<T>(m_blocks[i]);
+    if (m_ranks) {
+        count = m_ranks[block];
+    } else {
+        count = getBitCount<T>(m_blocks, block);
     }
 
     // count partial block
@@ -437,18 +502,82 @@ BitField3D<T, A>::countRange(index_type i) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::size_type 
-BitField3D<T, A>::size() const
+template <typename T, typename A, typename L>
+void
+BitField3D<T, A, L>::buildRankDirectory()
+{
+    clearRankDirectory();
+
+    index_type count    = 0;
+    index_type nonempty = 0;
+    for (index_type i = 0; i < m_capacity; ++i) {
+        count += getBitCount<T>(m_blocks[i]);
+        nonempty += (m_blocks[i] != 0);
+    }
+    index_type num_samples = (count + SELECT_SAMPLE - 1) / SELECT_SAMPLE;
+
+    // the rank of every block plus one holding the total count, the 
+    // nonempty blocks in order, then the position in that list of the 
+    // block holding every SELECT_SAMPLE-th set bit
+    m_ranks_size = m_capacity + 1 + nonempty + num_samples;
+    m_ranks = rank_allocator(m_allocator).allocate(m_ranks_size);
+
+    index_type *blocks  = m_ranks + m_capacity + 1;
+    index_type *samples = blocks + nonempty;
+
+    count    = 0;
+    nonempty = 0;
+    for (index_type i = 0; i < m_capacity; ++i) {
+        m_ranks[i] = count;
+        index_type c = getBitCount<T>(m_blocks[i]);
+        if (c) {
+            index_type sample = (count + SELECT_SAMPLE - 1) / SELECT_SAMPLE;
+            for (; sample * SELECT_SAMPLE < count + c; ++sample) {
+                samples[sample] = nonempty;
+            }
+            blocks[nonempty++] = i;
+        }
+        count += c;
+    }
+    m_ranks[m_capacity] = count;
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline void
+BitField3D<T, A, L>::clearRankDirectory()
+{
+    if (m_ranks) {
+        rank_allocator(m_allocator).deallocate(m_ranks, m_ranks_size);
+    }
+    m_ranks      = NULL;
+    m_ranks_size = 0;
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline bool
+BitField3D<T, A, L>::hasRankDirectory() const
+{
+    return m_ranks != NULL;
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::size_type 
+BitField3D<T, A, L>::size() const
 {
     return m_lg_size;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::size_type 
-BitField3D<T, A>::capacity() const
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::size_type 
+BitField3D<T, A, L>::capacity() const
 {
     size_type capacity = m_capacity * bitsof(T);
     return capacity;
@@ -456,14 +585,17 @@ BitField3D<T, A>::capacity() const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::resize(size_type s)
+BitField3D<T, A, L>::resize(size_type s)
 {
     // is resize possible with current memory allocation
     index_type bits = numBits3D(s);
     bool realloc    = capacity() < bits;
 
+    // block layout changes, drop the directory
+    clearRankDirectory();
+
     // allocate new bitfield
     if (realloc) {
 
@@ -503,7 +635,7 @@ BitField3D<T, A>::resize(size_type s)
                 bool is_set = isSet(i, j, k);
                 unsetBit(i, j, k);
                 if (is_set) {
-                    index = NKHIVE_NS::getIndex(i, j, k, s);
+                    index = L::getIndex(i, j, k, s);
                     setBit(index);
                 }
 
@@ -518,7 +650,7 @@ BitField3D<T, A>::resize(size_type s)
             for (index = 0; index < bits; ++index) {
 
                 // get index into new bitifeld
-                NKHIVE_NS::getCoordinates(index, s, i, j, k);
+                L::getCoordinates(index, s, i, j, k);
 
                 // update bit status
                 if (isSet(i, j, k)) {
@@ -551,26 +683,63 @@ BitField3D<T, A>::resize(size_type s)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void
-BitField3D<T, A>::swap(BitField3D& that)
+BitField3D<T, A, L>::swap(BitField3D& that)
 {
     std::swap(m_allocator, that.m_allocator);
     std::swap(m_blocks, that.m_blocks);
     std::swap(m_capacity, that.m_capacity);
     std::swap(m_lg_size, that.m_lg_size);
+    std::swap(m_ranks, that.m_ranks);
+    std::swap(m_ranks_size, that.m_ranks_size);
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+template <typename M>
+inline void
+BitField3D<T, A, L>::relayout(const BitField3D<T, A, M> &that)
+{
+    if (!that.capacity()) {
+        BitField3D empty(m_allocator);
+        swap(empty);
+        return;
+    }
+
+    BitField3D copy(that.size(), m_allocator);
+
+    index_type i, j, k;
+    index_type bits = numBits3D(that.size());
+    for (index_type index = 0; index < bits; ++index) {
+        if (that.isSet(index)) {
+            M::getCoordinates(index, that.size(), i, j, k);
+            copy.setBit(i, j, k);
+        }
+    }
+
+    swap(copy);
 }
 
 //-----------------------------------------------------------------------------
     
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 void
-BitField3D<T, A>::read(std::istream &is) 
+BitField3D<T, A, L>::read(std::istream &is) 
 {
+    if (!L::kRowMajor) {
+        BitField3D<T, A, RowMajorLayout> row_major(m_allocator);
+        row_major.read(is);
+        relayout(row_major);
+        return;
+    }
+
     // delete existing data
     if (m_blocks) {
         deallocate(m_blocks, m_capacity);
     }
+    clearRankDirectory();
 
     // read in size
     is.read((char*)&m_lg_size, sizeof(size_type));
@@ -595,14 +764,22 @@ BitField3D<T, A>::read(std::istream &is)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 void
-BitField3D<T, A>::read(HDF5Id parent_id)
+BitField3D<T, A, L>::read(HDF5Id parent_id)
 {
+    if (!L::kRowMajor) {
+        BitField3D<T, A, RowMajorLayout> row_major(m_allocator);
+        row_major.read(parent_id);
+        relayout(row_major);
+        return;
+    }
+
     // delete existing data
     if (m_blocks) {
         deallocate(m_blocks, m_capacity);
     }
+    clearRankDirectory();
 
     // read in size
     HDF5DataSet bitfield_data_set;
@@ -636,10 +813,17 @@ BitField3D<T, A>::read(HDF5Id parent_id)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void
-BitField3D<T, A>::write(std::ostream &os) const 
+BitField3D<T, A, L>::write(std::ostream &os) const 
 {
+    if (!L::kRowMajor) {
+        BitField3D<T, A, RowMajorLayout> row_major(m_allocator);
+        row_major.relayout(*this);
+        row_major.write(os);
+        return;
+    }
+
     index_type s     = numBits3D(size());
     index_type block = s / bitsof(T);
     index_type bit   = s % bitsof(T);
@@ -656,10 +840,17 @@ BitField3D<T, A>::write(std::ostream &os) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void
-BitField3D<T, A>::write(HDF5Id parent_id) const 
+BitField3D<T, A, L>::write(HDF5Id parent_id) const 
 {
+    if (!L::kRowMajor) {
+        BitField3D<T, A, RowMajorLayout> row_major(m_allocator);
+        row_major.relayout(*this);
+        row_major.write(parent_id);
+        return;
+    }
+
     index_type s     = numBits3D(size());
     index_type block = s / bitsof(T);
     index_type bit   = s % bitsof(T);
@@ -689,9 +880,76 @@ BitField3D<T, A>::write(HDF5Id parent_id) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
+void
+BitField3D<T, A, L>::read(size_type lg_size, const u8 *bytes)
+{
+    if (!L::kRowMajor) {
+        BitField3D<T, A, RowMajorLayout> row_major(m_allocator);
+        row_major.read(lg_size, bytes);
+        relayout(row_major);
+        return;
+    }
+
+    // delete existing data
+    if (m_blocks) {
+        deallocate(m_blocks, m_capacity);
+    }
+    clearRankDirectory();
+
+    m_lg_size = lg_size;
+
+    // figure out how many blocks are needed to represent the bits
+    index_type bits         = numBits3D(m_lg_size);
+    index_type bit_capacity = roundPow2(bits, bitsof(T));
+    m_capacity              = bit_capacity / bitsof(T);
+
+    index_type block = bits / bitsof(T);
+    index_type bit   = bits % bitsof(T);
+
+    // compensate for partially filled blocks
+    if (bit) { ++block; }
+
+    // allocate space
+    allocate(&m_blocks, m_capacity);
+
+    // clear out bits
+    clear(m_blocks, m_capacity);
+
+    // copy in bitfield
+    memcpy(m_blocks, bytes, block * sizeof(T));
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline void
+BitField3D<T, A, L>::write(std::vector<u8> &bytes) const
+{
+    if (!L::kRowMajor) {
+        BitField3D<T, A, RowMajorLayout> row_major(m_allocator);
+        row_major.relayout(*this);
+        row_major.write(bytes);
+        return;
+    }
+
+    index_type s     = numBits3D(size());
+    index_type block = s / bitsof(T);
+    index_type bit   = s % bitsof(T);
+
+    // compensate for partially filled blocks
+    if (bit) { ++block; }
+
+    // append the bitfield
+    const u8 *begin = reinterpret_cast<const u8*>(m_blocks);
+    bytes.insert(bytes.end(), begin, begin + block * sizeof(T));
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
 inline std::string
-BitField3D<T, A>::toString()
+BitField3D<T, A, L>::toString()
 {
     std::string str = "";
 
@@ -724,14 +982,15 @@ BitField3D<T, A>::toString()
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline BitField3D<T, A>&
-BitField3D<T, A>::operator=(const BitField3D<T, A>& that)
+template <typename T, typename A, typename L>
+inline BitField3D<T, A, L>&
+BitField3D<T, A, L>::operator=(const BitField3D<T, A, L>& that)
 {
     // deallocate first and then copy.
     if (m_blocks) {
         deallocate(m_blocks, m_capacity);
     }
+    clearRankDirectory();
 
     m_allocator = that.m_allocator;
     m_blocks    = NULL;
@@ -741,14 +1000,75 @@ BitField3D<T, A>::operator=(const BitField3D<T, A>& that)
     allocate(&m_blocks, m_capacity);
     copy(m_blocks, that.m_blocks, m_capacity);
 
+    if (that.m_ranks) {
+        buildRankDirectory();
+    }
+
+    return *this;
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline BitField3D<T, A, L>&
+BitField3D<T, A, L>::operator&=(const BitField3D<T, A, L>& that)
+{
+    assert(size() == that.size());
+
+    index_type s     = numBits3D(size());
+    index_type block = (s + bitsof(T) - 1) / bitsof(T);
+
+    for (index_type i = 0; i < block; ++i) {
+        m_blocks[i] &= that.m_blocks[i];
+    }
+
+    clearRankDirectory();
+    return *this;
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline BitField3D<T, A, L>&
+BitField3D<T, A, L>::operator|=(const BitField3D<T, A, L>& that)
+{
+    assert(size() == that.size());
+
+    index_type s     = numBits3D(size());
+    index_type block = (s + bitsof(T) - 1) / bitsof(T);
+
+    for (index_type i = 0; i < block; ++i) {
+        m_blocks[i] |= that.m_blocks[i];
+    }
+
+    clearRankDirectory();
+    return *this;
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline BitField3D<T, A, L>&
+BitField3D<T, A, L>::operator^=(const BitField3D<T, A, L>& that)
+{
+    assert(size() == that.size());
+
+    index_type s     = numBits3D(size());
+    index_type block = (s + bitsof(T) - 1) / bitsof(T);
+
+    for (index_type i = 0; i < block; ++i) {
+        m_blocks[i] ^= that.m_blocks[i];
+    }
+
+    clearRankDirectory();
     return *this;
 }
 
 //-----------------------------------------------------------------------------
     
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool
-BitField3D<T, A>::operator==(const BitField3D<T, A>& that) const
+BitField3D<T, A, L>::operator==(const BitField3D<T, A, L>& that) const
 {
     // early out
     if (size() != that.size()) {
@@ -768,18 +1088,18 @@ BitField3D<T, A>::operator==(const BitField3D<T, A>& that) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool
-BitField3D<T, A>::operator!=(const BitField3D<T, A>& that) const
+BitField3D<T, A, L>::operator!=(const BitField3D<T, A, L>& that) const
 {
     return !(*this == that);
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline std::istream& 
-operator<<(std::istream& is, const BitField3D<T, A>& bitfield)
+operator<<(std::istream& is, const BitField3D<T, A, L>& bitfield)
 {
     bitfield.read(is);
     return is;
@@ -787,9 +1107,9 @@ operator<<(std::istream& is, const BitField3D<T, A>& bitfield)
 
 //-----------------------------------------------------------------------------
              
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline std::ostream& 
-operator<<(std::ostream& os, const BitField3D<T, A>& bitfield)
+operator<<(std::ostream& os, const BitField3D<T, A, L>& bitfield)
 {
     bitfield.write(os);
     return os;
@@ -797,21 +1117,22 @@ operator<<(std::ostream& os, const BitField3D<T, A>& bitfield)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline int
-BitField3D<T, A>::sizeOf() const
+BitField3D<T, A, L>::sizeOf() const
 {
     int sizeof_this   = sizeof(*this);
     int sizeof_blocks = sizeof(T) * m_capacity;
-    return sizeof_this + sizeof_blocks;
+    int sizeof_ranks  = sizeof(index_type) * m_ranks_size;
+    return sizeof_this + sizeof_blocks + sizeof_ranks;
 }
 
 //-----------------------------------------------------------------------------
              
 #if 0
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline std::ostream& 
-operator<<(std::stream& os, const BitField3D<T, A>& bitfield) const
+operator<<(std::stream& os, const BitField3D<T, A, L>& bitfield) const
 {
     os << "blocks: " << bitfield.m_blocks << std::endl;
     os << "capacity : " << bitfield.capacity() << std::endl;
@@ -824,9 +1145,9 @@ operator<<(std::stream& os, const BitField3D<T, A>& bitfield) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool
-BitField3D<T, A>::valid() const
+BitField3D<T, A, L>::valid() const
 {
     bool is_valid = !m_blocks || (NKHIVE_NS::numBits3D(size()) <= capacity());
     return is_valid;
@@ -834,27 +1155,27 @@ BitField3D<T, A>::valid() const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::block_iterator 
-BitField3D<T, A>::blockBegin()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::block_iterator 
+BitField3D<T, A, L>::blockBegin()
 {
     return block_iterator(m_blocks, m_blocks, m_blocks + m_capacity);
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::block_iterator 
-BitField3D<T, A>::blockEnd()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::block_iterator 
+BitField3D<T, A, L>::blockEnd()
 {
     return block_iterator(m_blocks, m_blocks + m_capacity, m_blocks + m_capacity);
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::copy(pointer dst, const_pointer src, size_type s)
+BitField3D<T, A, L>::copy(pointer dst, const_pointer src, size_type s)
 {
    assert(src);
    memcpy(dst, src, s * sizeof(T));
@@ -862,9 +1183,9 @@ BitField3D<T, A>::copy(pointer dst, const_pointer src, size_type s)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::clear(pointer p, size_type s)
+BitField3D<T, A, L>::clear(pointer p, size_type s)
 {
     assert(p);
     memset(p, 0, s * sizeof(T));
@@ -872,29 +1193,29 @@ BitField3D<T, A>::clear(pointer p, size_type s)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::allocate(pointer* p, size_type s)
+BitField3D<T, A, L>::allocate(pointer* p, size_type s)
 {
     *p = m_allocator.allocate(s);
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void 
-BitField3D<T, A>::deallocate(pointer p, size_type s)
+BitField3D<T, A, L>::deallocate(pointer p, size_type s)
 {
     m_allocator.deallocate(p, s);
 }
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::iterator
+// BitField3D<T, A, L>::iterator
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::iterator::iterator() :
+BitField3D<T, A, L>::iterator::iterator() :
     m_blocks(NULL),
     m_size(0),
     m_index(0)
@@ -903,9 +1224,9 @@ BitField3D<T, A>::iterator::iterator() :
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::iterator::iterator(pointer b, size_type s, size_type i) :
+BitField3D<T, A, L>::iterator::iterator(pointer b, size_type s, size_type i) :
     m_blocks(b),
     m_size(s),
     m_index(i)
@@ -914,9 +1235,9 @@ BitField3D<T, A>::iterator::iterator(pointer b, size_type s, size_type i) :
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::iterator::valid() const
+BitField3D<T, A, L>::iterator::valid() const
 {
     bool is_valid = (!m_blocks && !m_size && !m_index) || 
                     (m_index <= numBits3D(m_size));
@@ -925,18 +1246,18 @@ BitField3D<T, A>::iterator::valid() const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 index_type
-BitField3D<T, A>::iterator::getIndex() const
+BitField3D<T, A, L>::iterator::getIndex() const
 {
     return m_index;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 bool 
-BitField3D<T, A>::iterator::isSet() const 
+BitField3D<T, A, L>::iterator::isSet() const 
 {
     index_type block = m_index / bitsof(T);
     index_type bit   = m_index % bitsof(T);
@@ -947,9 +1268,9 @@ BitField3D<T, A>::iterator::isSet() const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 void 
-BitField3D<T, A>::iterator::setBit() 
+BitField3D<T, A, L>::iterator::setBit() 
 {
     index_type block = m_index / bitsof(T);
     index_type bit   = m_index % bitsof(T);
@@ -959,9 +1280,9 @@ BitField3D<T, A>::iterator::setBit()
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 void 
-BitField3D<T, A>::iterator::unsetBit() 
+BitField3D<T, A, L>::iterator::unsetBit() 
 {
     index_type block = m_index / bitsof(T);
     index_type bit   = m_index % bitsof(T);
@@ -971,9 +1292,9 @@ BitField3D<T, A>::iterator::unsetBit()
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::iterator& 
-BitField3D<T, A>::iterator::operator++()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::iterator& 
+BitField3D<T, A, L>::iterator::operator++()
 {
     ++m_index;
     assert(valid());
@@ -982,9 +1303,9 @@ BitField3D<T, A>::iterator::operator++()
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::iterator 
-BitField3D<T, A>::iterator::operator++(int)
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::iterator 
+BitField3D<T, A, L>::iterator::operator++(int)
 {
     iterator i = *this;
     ++(*this);
@@ -994,9 +1315,9 @@ BitField3D<T, A>::iterator::operator++(int)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::iterator& 
-BitField3D<T, A>::iterator::operator--()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::iterator& 
+BitField3D<T, A, L>::iterator::operator--()
 {
     --m_index;
     assert(valid());
@@ -1005,9 +1326,9 @@ BitField3D<T, A>::iterator::operator--()
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::iterator 
-BitField3D<T, A>::iterator::operator--(int)
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::iterator 
+BitField3D<T, A, L>::iterator::operator--(int)
 {
     iterator i = *this;
     --(*this);
@@ -1017,9 +1338,9 @@ BitField3D<T, A>::iterator::operator--(int)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::iterator::operator==(const iterator& that) const
+BitField3D<T, A, L>::iterator::operator==(const iterator& that) const
 {
     bool is_equal = (m_blocks == that.m_blocks) &&
                     (m_size   == that.m_size)   &&
@@ -1029,20 +1350,20 @@ BitField3D<T, A>::iterator::operator==(const iterator& that) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::iterator::operator!=(const iterator& that) const
+BitField3D<T, A, L>::iterator::operator!=(const iterator& that) const
 {
     return !(*this == that);
 }
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::const_iterator
+// BitField3D<T, A, L>::const_iterator
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::const_iterator::const_iterator() :
+BitField3D<T, A, L>::const_iterator::const_iterator() :
     m_blocks(NULL),
     m_size(0),
     m_index(0)
@@ -1051,9 +1372,9 @@ BitField3D<T, A>::const_iterator::const_iterator() :
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::const_iterator::const_iterator(pointer b, size_type s, size_type i) :
+BitField3D<T, A, L>::const_iterator::const_iterator(pointer b, size_type s, size_type i) :
     m_blocks(b),
     m_size(s),
     m_index(i)
@@ -1062,9 +1383,9 @@ BitField3D<T, A>::const_iterator::const_iterator(pointer b, size_type s, size_ty
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::const_iterator::valid() const
+BitField3D<T, A, L>::const_iterator::valid() const
 {
     bool is_valid = (!m_blocks && !m_size && !m_index) || 
                     (m_index <= numBits3D(m_size));
@@ -1073,18 +1394,18 @@ BitField3D<T, A>::const_iterator::valid() const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 index_type
-BitField3D<T, A>::const_iterator::getIndex() const
+BitField3D<T, A, L>::const_iterator::getIndex() const
 {
     return m_index;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 bool 
-BitField3D<T, A>::const_iterator::isSet() const 
+BitField3D<T, A, L>::const_iterator::isSet() const 
 {
     index_type block = m_index / bitsof(T);
     index_type bit   = m_index % bitsof(T);
@@ -1095,9 +1416,9 @@ BitField3D<T, A>::const_iterator::isSet() const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::const_iterator& 
-BitField3D<T, A>::const_iterator::operator++()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::const_iterator& 
+BitField3D<T, A, L>::const_iterator::operator++()
 {
     ++m_index;
     assert(valid());
@@ -1106,9 +1427,9 @@ BitField3D<T, A>::const_iterator::operator++()
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::const_iterator 
-BitField3D<T, A>::const_iterator::operator++(int)
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::const_iterator 
+BitField3D<T, A, L>::const_iterator::operator++(int)
 {
     const_iterator i = *this;
     ++(*this);
@@ -1118,9 +1439,9 @@ BitField3D<T, A>::const_iterator::operator++(int)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::const_iterator& 
-BitField3D<T, A>::const_iterator::operator--()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::const_iterator& 
+BitField3D<T, A, L>::const_iterator::operator--()
 {
     --m_index;
     assert(valid());
@@ -1129,9 +1450,9 @@ BitField3D<T, A>::const_iterator::operator--()
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::const_iterator 
-BitField3D<T, A>::const_iterator::operator--(int)
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::const_iterator 
+BitField3D<T, A, L>::const_iterator::operator--(int)
 {
     const_iterator i = *this;
     --(*this);
@@ -1141,9 +1462,10 @@ BitField3D<T, A>::const_iterator::operator--(int)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::const_iterator::operator==(const const_iterator& that) const
+BitField3D<T, A, L>::const_iterator::operator==(
+        const const_iterator& that) const
 {
     bool is_equal = (m_blocks == that.m_blocks) &&
                     (m_size   == that.m_size)   &&
@@ -1153,20 +1475,21 @@ BitField3D<T, A>::const_iterator::operator==(const const_iterator& that) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::const_iterator::operator!=(const const_iterator& that) const
+BitField3D<T, A, L>::const_iterator::operator!=(
+        const const_iterator& that) const
 {
     return !(*this == that);
 }
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::block_iterator
+// BitField3D<T, A, L>::block_iterator
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::block_iterator::block_iterator () :
+BitField3D<T, A, L>::block_iterator::block_iterator () :
     m_begin(NULL),
     m_ptr(NULL),
     m_end(NULL)
@@ -1175,9 +1498,9 @@ BitField3D<T, A>::block_iterator::block_iterator () :
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::block_iterator::block_iterator(pointer b, pointer p, pointer e) :
+BitField3D<T, A, L>::block_iterator::block_iterator(pointer b, pointer p, pointer e) :
     m_begin(b),
     m_ptr(p),
     m_end(e)
@@ -1186,9 +1509,9 @@ BitField3D<T, A>::block_iterator::block_iterator(pointer b, pointer p, pointer e
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::block_iterator::valid() const
+BitField3D<T, A, L>::block_iterator::valid() const
 {
     bool is_valid = (!m_begin && !m_ptr && !m_end) || 
                     ((m_begin <= m_ptr) && (m_ptr <= m_end));
@@ -1197,27 +1520,27 @@ BitField3D<T, A>::block_iterator::valid() const
 
 //-----------------------------------------------------------------------------
                 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::block_iterator::reference 
-BitField3D<T, A>::block_iterator::operator*() const
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::block_iterator::reference 
+BitField3D<T, A, L>::block_iterator::operator*() const
 {
     return *m_ptr;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::block_iterator::pointer 
-BitField3D<T, A>::block_iterator::operator->() const
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::block_iterator::pointer 
+BitField3D<T, A, L>::block_iterator::operator->() const
 {
     return &**this;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::block_iterator& 
-BitField3D<T, A>::block_iterator::operator++()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::block_iterator& 
+BitField3D<T, A, L>::block_iterator::operator++()
 {
     ++m_ptr;
     assert(valid());
@@ -1226,9 +1549,9 @@ BitField3D<T, A>::block_iterator::operator++()
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::block_iterator 
-BitField3D<T, A>::block_iterator::operator++(int)
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::block_iterator 
+BitField3D<T, A, L>::block_iterator::operator++(int)
 {
     block_iterator i = *this;
     ++(*this);
@@ -1238,9 +1561,9 @@ BitField3D<T, A>::block_iterator::operator++(int)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::block_iterator& 
-BitField3D<T, A>::block_iterator::operator--()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::block_iterator& 
+BitField3D<T, A, L>::block_iterator::operator--()
 {
     --m_ptr;
     assert(valid());
@@ -1249,9 +1572,9 @@ BitField3D<T, A>::block_iterator::operator--()
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::block_iterator 
-BitField3D<T, A>::block_iterator::operator--(int)
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::block_iterator 
+BitField3D<T, A, L>::block_iterator::operator--(int)
 {
     block_iterator i = *this;
     --(*this);
@@ -1261,9 +1584,10 @@ BitField3D<T, A>::block_iterator::operator--(int)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::block_iterator::operator==(const block_iterator& that) const
+BitField3D<T, A, L>::block_iterator::operator==(
+        const block_iterator& that) const
 {
     bool is_equal = (m_ptr == that.m_ptr);
     return is_equal;
@@ -1271,21 +1595,22 @@ BitField3D<T, A>::block_iterator::operator==(const block_iterator& that) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::block_iterator::operator!=(const block_iterator& that) const
+BitField3D<T, A, L>::block_iterator::operator!=(
+        const block_iterator& that) const
 {
     return !(*this == that);
 }
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::status_iterator
+// BitField3D<T, A, L>::status_iterator
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
 inline
-BitField3D<T, A>::status_iterator<FI, S>::status_iterator() :
+BitField3D<T, A, L>::status_iterator<FI, S>::status_iterator() :
     m_blocks(NULL),
     m_size(0),
     m_index(0),
@@ -1295,10 +1620,10 @@ BitField3D<T, A>::status_iterator<FI, S>::status_iterator() :
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
 inline
-BitField3D<T, A>::status_iterator<FI, S>::status_iterator(block_pointer b, 
+BitField3D<T, A, L>::status_iterator<FI, S>::status_iterator(block_pointer b, 
         size_type s, size_type i, FI fi) :
     m_blocks(b),
     m_size(s),
@@ -1317,32 +1642,32 @@ BitField3D<T, A>::status_iterator<FI, S>::status_iterator(block_pointer b,
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
 inline index_type
-BitField3D<T, A>::status_iterator<FI, S>::getIndex() const
+BitField3D<T, A, L>::status_iterator<FI, S>::getIndex() const
 {
     return m_index;
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
 inline void
-BitField3D<T, A>::status_iterator<FI, S>::getCoordinates(index_type &i, 
-                                                         index_type &j,
-                                                         index_type &k) const
+BitField3D<T, A, L>::status_iterator<FI, S>::getCoordinates(index_type &i, 
+                                                            index_type &j,
+                                                            index_type &k) const
 {
-    NKHIVE_NS::getCoordinates(m_index, m_size, i, j, k);
+    L::getCoordinates(m_index, m_size, i, j, k);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
 inline void
-BitField3D<T, A>::status_iterator<FI, S>::getCoordinates(
+BitField3D<T, A, L>::status_iterator<FI, S>::getCoordinates(
         index_vec &coords) const
 {
     getCoordinates(coords[0], coords[1], coords[2]);
@@ -1350,10 +1675,10 @@ BitField3D<T, A>::status_iterator<FI, S>::getCoordinates(
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
 inline bool 
-BitField3D<T, A>::status_iterator<FI, S>::valid() const
+BitField3D<T, A, L>::status_iterator<FI, S>::valid() const
 {
     bool is_valid = (!m_blocks && !m_size && !m_index) || 
                     (m_index <= numBits3D(m_size));
@@ -1362,30 +1687,30 @@ BitField3D<T, A>::status_iterator<FI, S>::valid() const
 
 //-----------------------------------------------------------------------------
                 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
-inline typename BitField3D<T, A>::template status_iterator<FI, S>::reference 
-BitField3D<T, A>::status_iterator<FI, S>::operator*() const
+inline typename BitField3D<T, A, L>::template status_iterator<FI, S>::reference 
+BitField3D<T, A, L>::status_iterator<FI, S>::operator*() const
 {
     return *m_iter;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
-inline typename BitField3D<T, A>::template status_iterator<FI, S>::pointer 
-BitField3D<T, A>::status_iterator<FI, S>::operator->() const
+inline typename BitField3D<T, A, L>::template status_iterator<FI, S>::pointer 
+BitField3D<T, A, L>::status_iterator<FI, S>::operator->() const
 {
     return &**this;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
-inline typename BitField3D<T, A>::template status_iterator<FI, S>& 
-BitField3D<T, A>::status_iterator<FI, S>::operator++()
+inline typename BitField3D<T, A, L>::template status_iterator<FI, S>& 
+BitField3D<T, A, L>::status_iterator<FI, S>::operator++()
 {
     //  this can be sped up by checking for empty blocks
     //  might be good to specialize this function for 0 and 1
@@ -1412,10 +1737,10 @@ BitField3D<T, A>::status_iterator<FI, S>::operator++()
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
-inline typename BitField3D<T, A>::template status_iterator<FI, S>
-BitField3D<T, A>::status_iterator<FI, S>::operator++(int)
+inline typename BitField3D<T, A, L>::template status_iterator<FI, S>
+BitField3D<T, A, L>::status_iterator<FI, S>::operator++(int)
 {
     status_iterator i = *this;
     ++(*this);
@@ -1425,20 +1750,20 @@ BitField3D<T, A>::status_iterator<FI, S>::operator++(int)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
 inline bool 
-BitField3D<T, A>::status_iterator<FI, S>::operator()() const
+BitField3D<T, A, L>::status_iterator<FI, S>::operator()() const
 {
     return (m_index < numBits3D(m_size));
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
 inline bool 
-BitField3D<T, A>::status_iterator<FI, S>::operator==(const status_iterator& that) const
+BitField3D<T, A, L>::status_iterator<FI, S>::operator==(const status_iterator& that) const
 {
     bool is_equal = (m_blocks == that.m_blocks) &&
                     (m_size   == that.m_size)   &&
@@ -1449,93 +1774,97 @@ BitField3D<T, A>::status_iterator<FI, S>::operator==(const status_iterator& that
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename FI, bool S>
 inline bool 
-BitField3D<T, A>::status_iterator<FI, S>::operator!=(const status_iterator& that) const
+BitField3D<T, A, L>::status_iterator<FI, S>::operator!=(const status_iterator& that) const
 {
     return !(*this == that);
 }
 
 //-----------------------------------------------------------------------------
-// BitField3D<T, A>::window_iterator
+// BitField3D<T, A, L>::window_iterator
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::window_iterator::window_iterator() :
+BitField3D<T, A, L>::window_iterator::window_iterator() :
     m_blocks(NULL),
+    m_lg_size(0),
     m_begin(0),
     m_end(0),
     m_index(0),
     m_wnd_index(0),
-    m_wnd_size(0)
+    m_wnd_size(0),
+    m_min(0, 0, 0),
+    m_wnd(0, 0, 0)
 {
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline
-BitField3D<T, A>::window_iterator::window_iterator(
+BitField3D<T, A, L>::window_iterator::window_iterator(
         pointer b, size_type s, size_type ws, size_type i, size_type wi) :
-    m_blocks(b)
+    m_blocks(b),
+    m_lg_size(s),
+    m_begin(i),
+    m_end(ws * ws * ws),
+    m_index(i),
+    m_wnd_index(wi),
+    m_wnd_size(ws)
 {    
-    // cache frequently referenced sizes
-    index_type size = 1 << s;
-    m_wnd_size      = ws;
-    m_wnd_size_sqrd = m_wnd_size * m_wnd_size;
-
-    // cache distance to shift between boundries
-    m_row_shift  = size - m_wnd_size;
-    m_page_shift = m_row_shift * size;
-
-    // cache indices
-    m_begin     = i;
-    m_wnd_index = wi;
+    // the window is walked in coordinates, the layout maps them to indices
+    L::getCoordinates(m_begin, m_lg_size, m_min.x, m_min.y, m_min.z);
 
     // compensate for window index
-    m_index = m_begin;
-    m_index += (wi % m_wnd_size);
-    m_index += (wi / m_wnd_size) * size;
-    m_index += (wi / m_wnd_size_sqrd) * (size * size);
-
-    // calculating the end index 
-    //  1) start at the initial position
-    //  2) move diagonally window size times
-    //  3) go to next row/page boundry
-    m_end = m_begin
-            + ((((size * size) + size + 1) * (m_wnd_size - 1)) + 1) 
-            + (m_row_shift + m_page_shift);
+    m_wnd.x = wi % m_wnd_size;
+    m_wnd.y = (wi / m_wnd_size) % m_wnd_size;
+    m_wnd.z = wi / (m_wnd_size * m_wnd_size);
+    updateIndex();
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::window_iterator::valid() const
+BitField3D<T, A, L>::window_iterator::valid() const
 {
     bool is_valid = (!m_blocks && !m_begin && !m_end &&
                      !m_wnd_size && !m_wnd_index) || 
-                    ((m_begin <= m_end) &&
-                     (m_wnd_index <= numBits3D(m_wnd_size)));
+                    (m_wnd_index <= m_end);
     return is_valid;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
+inline void
+BitField3D<T, A, L>::window_iterator::updateIndex()
+{
+    // past the end the index is left alone
+    if (m_wnd_index < m_end) {
+        m_index = L::getIndex(m_min.x + m_wnd.x, 
+                              m_min.y + m_wnd.y, 
+                              m_min.z + m_wnd.z, m_lg_size);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
 inline index_type
-BitField3D<T, A>::window_iterator::getIndex() const
+BitField3D<T, A, L>::window_iterator::getIndex() const
 {
     return m_index;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::window_iterator::isSet() const 
+BitField3D<T, A, L>::window_iterator::isSet() const 
 {
     index_type block = m_index / bitsof(T);
     index_type bit   = m_index % bitsof(T);
@@ -1546,26 +1875,30 @@ BitField3D<T, A>::window_iterator::isSet() const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::window_iterator& 
-BitField3D<T, A>::window_iterator::operator++()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::window_iterator& 
+BitField3D<T, A, L>::window_iterator::operator++()
 {
-    // increment both window and bitfield index
-    ++m_index; 
     ++m_wnd_index;
     
-    // compensate for row and page edges 
-    m_index += (m_wnd_index % m_wnd_size) == 0 ? m_row_shift : 0;
-    m_index += (m_wnd_index % m_wnd_size_sqrd) == 0 ? m_page_shift : 0;
+    // step along the row, wrapping to the next row and page
+    if (++m_wnd.x == m_wnd_size) {
+        m_wnd.x = 0;
+        if (++m_wnd.y == m_wnd_size) {
+            m_wnd.y = 0;
+            ++m_wnd.z;
+        }
+    }
 
+    updateIndex();
     return *this;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::window_iterator 
-BitField3D<T, A>::window_iterator::operator++(int)
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::window_iterator 
+BitField3D<T, A, L>::window_iterator::operator++(int)
 {
     window_iterator i = *this;
     ++(*this);
@@ -1575,27 +1908,31 @@ BitField3D<T, A>::window_iterator::operator++(int)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::window_iterator& 
-BitField3D<T, A>::window_iterator::operator--()
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::window_iterator& 
+BitField3D<T, A, L>::window_iterator::operator--()
 {
-    // increment both window and bitfield index
-    --m_index; 
     --m_wnd_index;
     
-    // compensate for row and page edges 
-    m_index -= (m_wnd_index % m_wnd_size) == 0 ? m_row_shift : 0;
-    m_index -= (m_wnd_index % m_wnd_size_sqrd) == 0 ? m_page_shift : 0;
+    // step back along the row, wrapping to the previous row and page
+    if (m_wnd.x-- == 0) {
+        m_wnd.x = m_wnd_size - 1;
+        if (m_wnd.y-- == 0) {
+            m_wnd.y = m_wnd_size - 1;
+            --m_wnd.z;
+        }
+    }
 
+    updateIndex();
     assert(valid());
     return *this;
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename BitField3D<T, A>::window_iterator 
-BitField3D<T, A>::window_iterator::operator--(int)
+template <typename T, typename A, typename L>
+inline typename BitField3D<T, A, L>::window_iterator 
+BitField3D<T, A, L>::window_iterator::operator--(int)
 {
     window_iterator i = *this;
     --(*this);
@@ -1605,18 +1942,19 @@ BitField3D<T, A>::window_iterator::operator--(int)
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::window_iterator::operator()() const
+BitField3D<T, A, L>::window_iterator::operator()() const
 {
-    return (m_index != m_end);
+    return (m_wnd_index != m_end);
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::window_iterator::operator==(const window_iterator& that) const
+BitField3D<T, A, L>::window_iterator::operator==(
+        const window_iterator& that) const
 {
     bool is_equal = (m_blocks    == that.m_blocks)   &&
                     (m_begin     == that.m_begin)    &&
@@ -1628,9 +1966,10 @@ BitField3D<T, A>::window_iterator::operator==(const window_iterator& that) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-BitField3D<T, A>::window_iterator::operator!=(const window_iterator& that) const
+BitField3D<T, A, L>::window_iterator::operator!=(
+        const window_iterator& that) const
 {
     return !(*this == that);
 }
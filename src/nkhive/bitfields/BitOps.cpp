@@ -39,37 +39,102 @@ BEGIN_NKHIVE_NS
 
 //------------------------------------------------------------------------------
 
-/**
- * NOTE: The following will work for numbers up to 128 bits
- */
-template <>
-index_type
-getBitCount(uint64_t v) 
-{
-    typedef uint64_t T;
-    T c;
-    v = v - ((v >> 1) & (T)~(T)0/3);                                // temp
-    v = (v & (T)~(T)0/15*3) + ((v >> 2) & (T)~(T)0/15*3);           // temp
-    v = (v + (v >> 4)) & (T)~(T)0/255*15;                           // temp
-    c = (T)(v * ((T)~(T)0/255)) >> (sizeof(v) - 1) * BITS_PER_BYTE; // count
-    return c;
-}
+const uint32_t kMortonSpread[256] = {
+    0x000000, 0x000001, 0x000008, 0x000009, 0x000040, 0x000041, 0x000048,
+    0x000049, 0x000200, 0x000201, 0x000208, 0x000209, 0x000240, 0x000241,
+    0x000248, 0x000249, 0x001000, 0x001001, 0x001008, 0x001009, 0x001040,
+    0x001041, 0x001048, 0x001049, 0x001200, 0x001201, 0x001208, 0x001209,
+    0x001240, 0x001241, 0x001248, 0x001249, 0x008000, 0x008001, 0x008008,
+    0x008009, 0x008040, 0x008041, 0x008048, 0x008049, 0x008200, 0x008201,
+    0x008208, 0x008209, 0x008240, 0x008241, 0x008248, 0x008249, 0x009000,
+    0x009001, 0x009008, 0x009009, 0x009040, 0x009041, 0x009048, 0x009049,
+    0x009200, 0x009201, 0x009208, 0x009209, 0x009240, 0x009241, 0x009248,
+    0x009249, 0x040000, 0x040001, 0x040008, 0x040009, 0x040040, 0x040041,
+    0x040048, 0x040049, 0x040200, 0x040201, 0x040208, 0x040209, 0x040240,
+    0x040241, 0x040248, 0x040249, 0x041000, 0x041001, 0x041008, 0x041009,
+    0x041040, 0x041041, 0x041048, 0x041049, 0x041200, 0x041201, 0x041208,
+    0x041209, 0x041240, 0x041241, 0x041248, 0x041249, 0x048000, 0x048001,
+    0x048008, 0x048009, 0x048040, 0x048041, 0x048048, 0x048049, 0x048200,
+    0x048201, 0x048208, 0x048209, 0x048240, 0x048241, 0x048248, 0x048249,
+    0x049000, 0x049001, 0x049008, 0x049009, 0x049040, 0x049041, 0x049048,
+    0x049049, 0x049200, 0x049201, 0x049208, 0x049209, 0x049240, 0x049241,
+    0x049248, 0x049249, 0x200000, 0x200001, 0x200008, 0x200009, 0x200040,
+    0x200041, 0x200048, 0x200049, 0x200200, 0x200201, 0x200208, 0x200209,
+    0x200240, 0x200241, 0x200248, 0x200249, 0x201000, 0x201001, 0x201008,
+    0x201009, 0x201040, 0x201041, 0x201048, 0x201049, 0x201200, 0x201201,
+    0x201208, 0x201209, 0x201240, 0x201241, 0x201248, 0x201249, 0x208000,
+    0x208001, 0x208008, 0x208009, 0x208040, 0x208041, 0x208048, 0x208049,
+    0x208200, 0x208201, 0x208208, 0x208209, 0x208240, 0x208241, 0x208248,
+    0x208249, 0x209000, 0x209001, 0x209008, 0x209009, 0x209040, 0x209041,
+    0x209048, 0x209049, 0x209200, 0x209201, 0x209208, 0x209209, 0x209240,
+    0x209241, 0x209248, 0x209249, 0x240000, 0x240001, 0x240008, 0x240009,
+    0x240040, 0x240041, 0x240048, 0x240049, 0x240200, 0x240201, 0x240208,
+    0x240209, 0x240240, 0x240241, 0x240248, 0x240249, 0x241000, 0x241001,
+    0x241008, 0x241009, 0x241040, 0x241041, 0x241048, 0x241049, 0x241200,
+    0x241201, 0x241208, 0x241209, 0x241240, 0x241241, 0x241248, 0x241249,
+    0x248000, 0x248001, 0x248008, 0x248009, 0x248040, 0x248041, 0x248048,
+    0x248049, 0x248200, 0x248201, 0x248208, 0x248209, 0x248240, 0x248241,
+    0x248248, 0x248249, 0x249000, 0x249001, 0x249008, 0x249009, 0x249040,
+    0x249041, 0x249048, 0x249049, 0x249200, 0x249201, 0x249208, 0x249209,
+    0x249240, 0x249241, 0x249248, 0x249249
+};
 
 //------------------------------------------------------------------------------
 
-/**
- * NOTE: The following ONLY works for numbers up to 32-bits.
- */
-template <typename T>
-inline index_type
-getBitCount(T v) 
-{
-    index_type c;
-    v = v - ((v >> 1) & 0x55555555); // reuse input as temporary
-    v = (v & 0x33333333) + ((v >> 2) & 0x33333333);     // temp
-    c = (((v + (v >> 4)) & 0xF0F0F0F) * 0x1010101) >> 24; // count
-    return c;
-}
+const uint16_t kMortonGather[512] = {
+    0x000, 0x001, 0x008, 0x009, 0x040, 0x041, 0x048, 0x049, 0x002, 0x003,
+    0x00a, 0x00b, 0x042, 0x043, 0x04a, 0x04b, 0x010, 0x011, 0x018, 0x019,
+    0x050, 0x051, 0x058, 0x059, 0x012, 0x013, 0x01a, 0x01b, 0x052, 0x053,
+    0x05a, 0x05b, 0x080, 0x081, 0x088, 0x089, 0x0c0, 0x0c1, 0x0c8, 0x0c9,
+    0x082, 0x083, 0x08a, 0x08b, 0x0c2, 0x0c3, 0x0ca, 0x0cb, 0x090, 0x091,
+    0x098, 0x099, 0x0d0, 0x0d1, 0x0d8, 0x0d9, 0x092, 0x093, 0x09a, 0x09b,
+    0x0d2, 0x0d3, 0x0da, 0x0db, 0x004, 0x005, 0x00c, 0x00d, 0x044, 0x045,
+    0x04c, 0x04d, 0x006, 0x007, 0x00e, 0x00f, 0x046, 0x047, 0x04e, 0x04f,
+    0x014, 0x015, 0x01c, 0x01d, 0x054, 0x055, 0x05c, 0x05d, 0x016, 0x017,
+    0x01e, 0x01f, 0x056, 0x057, 0x05e, 0x05f, 0x084, 0x085, 0x08c, 0x08d,
+    0x0c4, 0x0c5, 0x0cc, 0x0cd, 0x086, 0x087, 0x08e, 0x08f, 0x0c6, 0x0c7,
+    0x0ce, 0x0cf, 0x094, 0x095, 0x09c, 0x09d, 0x0d4, 0x0d5, 0x0dc, 0x0dd,
+    0x096, 0x097, 0x09e, 0x09f, 0x0d6, 0x0d7, 0x0de, 0x0df, 0x020, 0x021,
+    0x028, 0x029, 0x060, 0x061, 0x068, 0x069, 0x022, 0x023, 0x02a, 0x02b,
+    0x062, 0x063, 0x06a, 0x06b, 0x030, 0x031, 0x038, 0x039, 0x070, 0x071,
+    0x078, 0x079, 0x032, 0x033, 0x03a, 0x03b, 0x072, 0x073, 0x07a, 0x07b,
+    0x0a0, 0x0a1, 0x0a8, 0x0a9, 0x0e0, 0x0e1, 0x0e8, 0x0e9, 0x0a2, 0x0a3,
+    0x0aa, 0x0ab, 0x0e2, 0x0e3, 0x0ea, 0x0eb, 0x0b0, 0x0b1, 0x0b8, 0x0b9,
+    0x0f0, 0x0f1, 0x0f8, 0x0f9, 0x0b2, 0x0b3, 0x0ba, 0x0bb, 0x0f2, 0x0f3,
+    0x0fa, 0x0fb, 0x024, 0x025, 0x02c, 0x02d, 0x064, 0x065, 0x06c, 0x06d,
+    0x026, 0x027, 0x02e, 0x02f, 0x066, 0x067, 0x06e, 0x06f, 0x034, 0x035,
+    0x03c, 0x03d, 0x074, 0x075, 0x07c, 0x07d, 0x036, 0x037, 0x03e, 0x03f,
+    0x076, 0x077, 0x07e, 0x07f, 0x0a4, 0x0a5, 0x0ac, 0x0ad, 0x0e4, 0x0e5,
+    0x0ec, 0x0ed, 0x0a6, 0x0a7, 0x0ae, 0x0af, 0x0e6, 0x0e7, 0x0ee, 0x0ef,
+    0x0b4, 0x0b5, 0x0bc, 0x0bd, 0x0f4, 0x0f5, 0x0fc, 0x0fd, 0x0b6, 0x0b7,
+    0x0be, 0x0bf, 0x0f6, 0x0f7, 0x0fe, 0x0ff, 0x100, 0x101, 0x108, 0x109,
+    0x140, 0x141, 0x148, 0x149, 0x102, 0x103, 0x10a, 0x10b, 0x142, 0x143,
+    0x14a, 0x14b, 0x110, 0x111, 0x118, 0x119, 0x150, 0x151, 0x158, 0x159,
+    0x112, 0x113, 0x11a, 0x11b, 0x152, 0x153, 0x15a, 0x15b, 0x180, 0x181,
+    0x188, 0x189, 0x1c0, 0x1c1, 0x1c8, 0x1c9, 0x182, 0x183, 0x18a, 0x18b,
+    0x1c2, 0x1c3, 0x1ca, 0x1cb, 0x190, 0x191, 0x198, 0x199, 0x1d0, 0x1d1,
+    0x1d8, 0x1d9, 0x192, 0x193, 0x19a, 0x19b, 0x1d2, 0x1d3, 0x1da, 0x1db,
+    0x104, 0x105, 0x10c, 0x10d, 0x144, 0x145, 0x14c, 0x14d, 0x106, 0x107,
+    0x10e, 0x10f, 0x146, 0x147, 0x14e, 0x14f, 0x114, 0x115, 0x11c, 0x11d,
+    0x154, 0x155, 0x15c, 0x15d, 0x116, 0x117, 0x11e, 0x11f, 0x156, 0x157,
+    0x15e, 0x15f, 0x184, 0x185, 0x18c, 0x18d, 0x1c4, 0x1c5, 0x1cc, 0x1cd,
+    0x186, 0x187, 0x18e, 0x18f, 0x1c6, 0x1c7, 0x1ce, 0x1cf, 0x194, 0x195,
+    0x19c, 0x19d, 0x1d4, 0x1d5, 0x1dc, 0x1dd, 0x196, 0x197, 0x19e, 0x19f,
+    0x1d6, 0x1d7, 0x1de, 0x1df, 0x120, 0x121, 0x128, 0x129, 0x160, 0x161,
+    0x168, 0x169, 0x122, 0x123, 0x12a, 0x12b, 0x162, 0x163, 0x16a, 0x16b,
+    0x130, 0x131, 0x138, 0x139, 0x170, 0x171, 0x178, 0x179, 0x132, 0x133,
+    0x13a, 0x13b, 0x172, 0x173, 0x17a, 0x17b, 0x1a0, 0x1a1, 0x1a8, 0x1a9,
+    0x1e0, 0x1e1, 0x1e8, 0x1e9, 0x1a2, 0x1a3, 0x1aa, 0x1ab, 0x1e2, 0x1e3,
+    0x1ea, 0x1eb, 0x1b0, 0x1b1, 0x1b8, 0x1b9, 0x1f0, 0x1f1, 0x1f8, 0x1f9,
+    0x1b2, 0x1b3, 0x1ba, 0x1bb, 0x1f2, 0x1f3, 0x1fa, 0x1fb, 0x124, 0x125,
+    0x12c, 0x12d, 0x164, 0x165, 0x16c, 0x16d, 0x126, 0x127, 0x12e, 0x12f,
+    0x166, 0x167, 0x16e, 0x16f, 0x134, 0x135, 0x13c, 0x13d, 0x174, 0x175,
+    0x17c, 0x17d, 0x136, 0x137, 0x13e, 0x13f, 0x176, 0x177, 0x17e, 0x17f,
+    0x1a4, 0x1a5, 0x1ac, 0x1ad, 0x1e4, 0x1e5, 0x1ec, 0x1ed, 0x1a6, 0x1a7,
+    0x1ae, 0x1af, 0x1e6, 0x1e7, 0x1ee, 0x1ef, 0x1b4, 0x1b5, 0x1bc, 0x1bd,
+    0x1f4, 0x1f5, 0x1fc, 0x1fd, 0x1b6, 0x1b7, 0x1be, 0x1bf, 0x1f6, 0x1f7,
+    0x1fe, 0x1ff
+};
 
 //------------------------------------------------------------------------------
 
@@ -109,39 +174,6 @@ setMSB()
 
 //------------------------------------------------------------------------------
 
-/**
- * Note: This solution will only work for unsigned values of T.
- */
-template <typename T>
-inline index_type
-getFirstSetBitIndex(T v)
-{
-    index_type i = 0; 
-    if (v) {
-        for (i = 1; ~v & 1; v = v >> 1, ++i) {}
-    }
-    return i;
-}
-
-//------------------------------------------------------------------------------
-
-/**
- * Note: This solution will only work for unsigned values of T.
- */
-template <typename T>
-inline index_type
-getLastSetBitIndex(T v)
-{
-    index_type i = 0; 
-    T msb = setMSB<T>();
-    if (v) {
-        for (i = bitsof(T); ~v & msb; v = v << 1, --i) {}
-    }
-    return i;
-}
-
-//------------------------------------------------------------------------------
-
 template <>
 index_type
 isNegative(int32_t v)
@@ -234,20 +266,6 @@ abs(signed_index_vec sv)
 // Template instantiations
 //------------------------------------------------------------------------------
 
-template index_type getBitCount<uint8_t>(uint8_t v);
-template index_type getBitCount<uint16_t>(uint16_t v);
-template index_type getBitCount<uint32_t>(uint32_t v);
-
-template index_type getFirstSetBitIndex<uint8_t>(uint8_t v);
-template index_type getFirstSetBitIndex<uint16_t>(uint16_t v);
-template index_type getFirstSetBitIndex<uint32_t>(uint32_t v);
-template index_type getFirstSetBitIndex<uint64_t>(uint64_t v);
-
-template index_type getLastSetBitIndex<uint8_t>(uint8_t v);
-template index_type getLastSetBitIndex<uint16_t>(uint16_t v);
-template index_type getLastSetBitIndex<uint32_t>(uint32_t v);
-template index_type getLastSetBitIndex<uint64_t>(uint64_t v);
-
 template void getQuadrantOffsets<int32_t>(
         int32_t &i, int32_t &j, int32_t &k, uint8_t q);
 template void getQuadrantOffsets<int64_t>(
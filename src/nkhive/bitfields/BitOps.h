@@ -74,12 +74,28 @@
  */
 #define getBitMaskFilled(t) ((t)(~0))
 
+/**
+ * Bit scanning uses the compiler builtins when available, as does counting
+ * when the target has popcnt; the library call is slower than the portable
+ * count. Define NKHIVE_PORTABLE_BITOPS to force the portable implementations.
+ */
+#if defined(__GNUC__) && !defined(NKHIVE_PORTABLE_BITOPS)
+#define NKHIVE_BUILTIN_BITOPS
+#endif
+
 //-----------------------------------------------------------------------------
 // interface definition
 //-----------------------------------------------------------------------------
 
 BEGIN_NKHIVE_NS
 
+/**
+ * Morton lookup tables. kMortonSpread moves the 8 bits of an index to every
+ * third bit, kMortonGather packs 9 interleaved bits back into 3 bits per axis.
+ */
+extern const uint32_t kMortonSpread[256];
+extern const uint16_t kMortonGather[512];
+
 /**
  * Returns the number of bits needed to represent the given size in Log2 in 3D.
  * Essentially the number of bits needed for a cube of size: (2^lg_size)^3
@@ -110,6 +126,27 @@ void
 getCoordinates(index_type index, index_type lg_size, 
                index_type& i, index_type& j, index_type& k);
 
+/**
+ * Interleaves the low 21 bits of i, j, k into a Morton (Z-order) key, i 
+ * taking the lowest bit. Keys sort points along a space filling curve.
+ */
+uint64_t
+getMortonKey(index_type i, index_type j, index_type k);
+
+/**
+ * Creates a Morton (Z-order) index for a 3D cube coordinate of size lg_size,
+ * so neighbouring voxels share nearby indices. lg_size is at most 10.
+ */
+index_type
+getMortonIndex(index_type i, index_type j, index_type k, index_type lg_size);
+
+/**
+ * Computes the 3D cube coordinate of size lg_size from a Morton index.
+ */
+void
+getMortonCoordinates(index_type index, index_type lg_size, 
+                     index_type& i, index_type& j, index_type& k);
+
 /** 
  * Gets number of set bits in value;
  */
@@ -117,6 +154,13 @@ template <typename T>
 index_type
 getBitCount(T v);
 
+/** 
+ * Gets number of set bits in an array of n values.
+ */
+template <typename T>
+index_type
+getBitCount(const T *v, index_type n);
+
 /** 
  * Gets the index of the first bit set. The returned index in 1 based. 1 is the
  * position of the least significant bit. Returns 0 is the value does not have
@@ -136,6 +180,30 @@ template <typename T>
 index_type
 getLastSetBitIndex(T v);
 
+/**
+ * Get the index of the nth set bit, both 0 based. The value must have more
+ * than n bits set. Takes a fixed number of steps for a given type.
+ */
+template <typename T>
+index_type
+getNthSetBitIndex(T v, index_type n);
+
+/**
+ * Portable versions of the bit counting and scanning functions, used when no
+ * builtins are available.
+ */
+template <typename T>
+index_type
+getBitCountPortable(T v);
+
+template <typename T>
+index_type
+getFirstSetBitIndexPortable(T v);
+
+template <typename T>
+index_type
+getLastSetBitIndexPortable(T v);
+
 /**
  * Returns 1 if the given numeric type is negative, false otherwise.
  */
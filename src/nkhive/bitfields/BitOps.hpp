@@ -86,6 +86,70 @@ getCoordinates(index_type index, index_type lg_size,
 
 //------------------------------------------------------------------------------
 
+/**
+ * Spreads the low 21 bits of v out to every third bit.
+ */
+inline uint64_t
+spreadBits3(index_type v)
+{
+    uint64_t x = v & 0x1fffff;
+    x = (x | (x << 32)) & 0x001f00000000ffffULL;
+    x = (x | (x << 16)) & 0x001f0000ff0000ffULL;
+    x = (x | (x << 8))  & 0x100f00f00f00f00fULL;
+    x = (x | (x << 4))  & 0x10c30c30c30c30c3ULL;
+    x = (x | (x << 2))  & 0x1249249249249249ULL;
+    return x;
+}
+
+//------------------------------------------------------------------------------
+
+inline uint64_t
+getMortonKey(index_type i, index_type j, index_type k)
+{
+    return spreadBits3(i) | (spreadBits3(j) << 1) | (spreadBits3(k) << 2);
+}
+
+//------------------------------------------------------------------------------
+
+inline index_type
+getMortonIndex(index_type i, index_type j, index_type k, index_type lg_size)
+{
+    const index_type row = 1 << lg_size;
+    assert((lg_size <= 10) && (i < row) && (j < row) && (k < row));
+
+    index_type index = kMortonSpread[i & 0xff]        | 
+                       (kMortonSpread[j & 0xff] << 1) | 
+                       (kMortonSpread[k & 0xff] << 2);
+
+    // the two high bits of each axis only exist in cubes over 256 wide
+    if (lg_size > 8) {
+        index |= (kMortonSpread[i >> 8]        | 
+                  (kMortonSpread[j >> 8] << 1) | 
+                  (kMortonSpread[k >> 8] << 2)) << 24;
+    }
+    return index;
+}
+
+//------------------------------------------------------------------------------
+
+inline void
+getMortonCoordinates(index_type index, index_type lg_size, 
+                     index_type& i, index_type& j, index_type& k) 
+{
+    assert(index < numBits3D(lg_size));
+
+    // every 9 bits of the index hold 3 bits of each axis
+    i = j = k = 0;
+    for (index_type shift = 0; index; index >>= 9, shift += 3) {
+        const index_type bits = kMortonGather[index & 0x1ff];
+        i |= (bits & 0x07) << shift;
+        j |= ((bits >> 3) & 0x07) << shift;
+        k |= (bits >> 6) << shift;
+    }
+}
+
+//------------------------------------------------------------------------------
+
 inline bool
 isPow2(index_type v) 
 {
@@ -113,3 +177,148 @@ moduloLg(index_type i, index_type lg_divisor)
 }
 
 //------------------------------------------------------------------------------
+
+template <typename T>
+inline index_type
+getBitCount(T v) 
+{
+#if defined(NKHIVE_BUILTIN_BITOPS) && defined(__POPCNT__)
+    if (sizeof(T) > sizeof(unsigned int)) {
+        return __builtin_popcountll(v);
+    }
+    return __builtin_popcount(v);
+#else
+    return getBitCountPortable(v);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline index_type
+getBitCount(const T *v, index_type n) 
+{
+    // independent sums let the counts overlap
+    index_type c0 = 0, c1 = 0;
+    index_type i  = 0;
+    for (; i + 1 < n; i += 2) {
+        c0 += getBitCount<T>(v[i]);
+        c1 += getBitCount<T>(v[i + 1]);
+    }
+    if (i < n) {
+        c0 += getBitCount<T>(v[i]);
+    }
+    return c0 + c1;
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Note: This solution will only work for unsigned values of T.
+ */
+template <typename T>
+inline index_type
+getFirstSetBitIndex(T v)
+{
+#if defined(NKHIVE_BUILTIN_BITOPS)
+    return v ? __builtin_ctzll(v) + 1 : 0;
+#else
+    return getFirstSetBitIndexPortable(v);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Note: This solution will only work for unsigned values of T.
+ */
+template <typename T>
+inline index_type
+getLastSetBitIndex(T v)
+{
+#if defined(NKHIVE_BUILTIN_BITOPS)
+    return v ? bitsof(unsigned long long) - __builtin_clzll(v) : 0;
+#else
+    return getLastSetBitIndexPortable(v);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline index_type
+getNthSetBitIndex(T v, index_type n)
+{
+    // halve the range holding the bit down to a byte, counting the set bits
+    // of the lower half
+    index_type base = 0;
+    for (index_type width = bitsof(T) / 2; width >= 8; width /= 2) {
+        T low = T(v & T((T(1) << width) - 1));
+        index_type count = getBitCount<T>(low);
+        if (n >= count) {
+            n    -= count;
+            v     = T(v >> width);
+            base += width;
+        } else {
+            v = low;
+        }
+    }
+
+    // then drop the set bits below it within the byte
+    for (; n; --n) {
+        v = T(v & (v - 1));
+    }
+    return base + getFirstSetBitIndex<T>(v) - 1;
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * NOTE: The following will work for numbers up to 128 bits
+ */
+template <typename T>
+inline index_type
+getBitCountPortable(T v) 
+{
+    T c;
+    v = v - ((v >> 1) & (T)~(T)0/3);                                // temp
+    v = (v & (T)~(T)0/15*3) + ((v >> 2) & (T)~(T)0/15*3);           // temp
+    v = (v + (v >> 4)) & (T)~(T)0/255*15;                           // temp
+    c = (T)(v * ((T)~(T)0/255)) >> (sizeof(v) - 1) * BITS_PER_BYTE; // count
+    return c;
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Note: This solution will only work for unsigned values of T.
+ */
+template <typename T>
+inline index_type
+getFirstSetBitIndexPortable(T v)
+{
+    index_type i = 0; 
+    if (v) {
+        for (i = 1; ~v & 1; v = v >> 1, ++i) {}
+    }
+    return i;
+}
+
+//------------------------------------------------------------------------------
+
+/**
+ * Note: This solution will only work for unsigned values of T.
+ */
+template <typename T>
+inline index_type
+getLastSetBitIndexPortable(T v)
+{
+    index_type i = 0; 
+    T msb = (T)1 << (bitsof(T) - 1);
+    if (v) {
+        for (i = bitsof(T); ~v & msb; v = v << 1, --i) {}
+    }
+    return i;
+}
+
+//------------------------------------------------------------------------------
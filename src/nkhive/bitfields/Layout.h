@@ -0,0 +1,116 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Layout.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_BITFIELDS_LAYOUT_H__
+#define __NKHIVE_BITFIELDS_LAYOUT_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkhive/bitfields/BitOps.h>
+
+//------------------------------------------------------------------------------
+// class definitions
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Lays voxels out row by row, i varying fastest. Data is always stored in
+ * this layout on disk, whatever layout is used in memory.
+ */
+class RowMajorLayout
+{
+public:
+
+    /**
+     * Row major layouts need no conversion on read/write.
+     */
+    static const bool kRowMajor = true;
+
+    /**
+     * Maps coordinates of a cube of size 2^lg_size to an index and back.
+     */
+    static index_type getIndex(index_type i, index_type j, index_type k, 
+                               index_type lg_size);
+    static void getCoordinates(index_type index, index_type lg_size,
+                               index_type &i, index_type &j, index_type &k);
+
+    /**
+     * Converts an index of this layout to a row major index and back.
+     */
+    static index_type toRowMajor(index_type index, index_type lg_size);
+    static index_type fromRowMajor(index_type index, index_type lg_size);
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * Lays voxels out along a Z-order curve, so each aligned 2x2x2, 4x4x4, ... 
+ * block is contiguous. Stencils touch fewer cache lines than in row major.
+ */
+class MortonLayout
+{
+public:
+
+    static const bool kRowMajor = false;
+
+    static index_type getIndex(index_type i, index_type j, index_type k, 
+                               index_type lg_size);
+    static void getCoordinates(index_type index, index_type lg_size,
+                               index_type &i, index_type &j, index_type &k);
+
+    static index_type toRowMajor(index_type index, index_type lg_size);
+    static index_type fromRowMajor(index_type index, index_type lg_size);
+};
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/bitfields/Layout.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_BITFIELDS_LAYOUT_H__
@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Layout.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// RowMajorLayout
+//------------------------------------------------------------------------------
+
+inline index_type
+RowMajorLayout::getIndex(index_type i, index_type j, index_type k, 
+                         index_type lg_size)
+{
+    return NKHIVE_NS::getIndex(i, j, k, lg_size);
+}
+
+//------------------------------------------------------------------------------
+
+inline void
+RowMajorLayout::getCoordinates(index_type index, index_type lg_size,
+                               index_type &i, index_type &j, index_type &k)
+{
+    NKHIVE_NS::getCoordinates(index, lg_size, i, j, k);
+}
+
+//------------------------------------------------------------------------------
+
+inline index_type
+RowMajorLayout::toRowMajor(index_type index, index_type)
+{
+    return index;
+}
+
+//------------------------------------------------------------------------------
+
+inline index_type
+RowMajorLayout::fromRowMajor(index_type index, index_type)
+{
+    return index;
+}
+
+//------------------------------------------------------------------------------
+// MortonLayout
+//------------------------------------------------------------------------------
+
+inline index_type
+MortonLayout::getIndex(index_type i, index_type j, index_type k, 
+                       index_type lg_size)
+{
+    return getMortonIndex(i, j, k, lg_size);
+}
+
+//------------------------------------------------------------------------------
+
+inline void
+MortonLayout::getCoordinates(index_type index, index_type lg_size,
+                             index_type &i, index_type &j, index_type &k)
+{
+    getMortonCoordinates(index, lg_size, i, j, k);
+}
+
+//------------------------------------------------------------------------------
+
+inline index_type
+MortonLayout::toRowMajor(index_type index, index_type lg_size)
+{
+    index_type i, j, k;
+    getMortonCoordinates(index, lg_size, i, j, k);
+    return NKHIVE_NS::getIndex(i, j, k, lg_size);
+}
+
+//------------------------------------------------------------------------------
+
+inline index_type
+MortonLayout::fromRowMajor(index_type index, index_type lg_size)
+{
+    index_type i, j, k;
+    NKHIVE_NS::getCoordinates(index, lg_size, i, j, k);
+    return getMortonIndex(i, j, k, lg_size);
+}
+
+//------------------------------------------------------------------------------
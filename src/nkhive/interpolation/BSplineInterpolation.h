@@ -0,0 +1,158 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BSplineInterpolation.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_INTERPOLATION_BSPLINEINTERPOLATION_H__
+#define __NKHIVE_INTERPOLATION_BSPLINEINTERPOLATION_H__
+
+//-----------------------------------------------------------------------------
+// includes
+//-----------------------------------------------------------------------------
+
+#include <nkhive/volume/Volume.h>
+#include <nkhive/Types.h>
+#include <nkhive/interpolation/BSplineSamplingUtil.h>
+
+//-----------------------------------------------------------------------------
+// class definition
+//-----------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Samples the volume with the B-spline kernel of the given degree, the 
+ * gather matching BSplineSplat. The result is smoothed rather than passing
+ * through the voxel values. Coordinates are in voxel coordinates. Use 
+ * QuadraticInterpolation and CubicBSplineInterpolation.
+ */
+template <typename T, i32 Degree>
+class BSplineInterpolation
+{
+public:
+
+    //-------------------------------------------------------------------------
+    // typedefs
+    //-------------------------------------------------------------------------
+
+    typedef T                                      value_type;
+    typedef T&                                     reference;
+    typedef const T&                               const_reference;
+
+    typedef BSplineSamplingUtil<T, Degree>         kernel_type;
+    typedef typename kernel_type::calc_type        calc_type;
+
+    typedef typename Volume<T>::shared_ptr         volume_ptr;
+
+    enum { TAPS = kernel_type::TAPS };
+   
+    //-------------------------------------------------------------------------
+    // public interface
+    //-------------------------------------------------------------------------
+
+    /**
+     * default constructor
+     */
+    BSplineInterpolation();
+
+    /**
+     * parameterized constructor, with use_table the kernel weights are read 
+     * from a quantized table
+     */ 
+    BSplineInterpolation(volume_ptr volume, bool use_table = false);
+
+    /**
+     * copy constructor
+     */
+    BSplineInterpolation(const BSplineInterpolation &that);
+
+    /**
+     * Sample the value at voxel coordinates x, y, z from the (Degree + 1)^3
+     * voxels around it, read in a single pass over their cells.
+     */
+    void interp(double x, double y, double z, 
+                reference result) const;
+
+private:
+
+    //-------------------------------------------------------------------------
+    // members
+    //-------------------------------------------------------------------------
+
+    volume_ptr  m_volume;
+    kernel_type m_kernel;
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Quadratic B-spline sampling, 27 voxels.
+ */
+template <typename T>
+class QuadraticInterpolation : public BSplineInterpolation<T, 2>
+{
+public:
+    typedef typename BSplineInterpolation<T, 2>::volume_ptr volume_ptr;
+
+    QuadraticInterpolation();
+    QuadraticInterpolation(volume_ptr volume, bool use_table = false);
+};
+
+//-----------------------------------------------------------------------------
+
+/**
+ * Cubic B-spline sampling, 64 voxels.
+ */
+template <typename T>
+class CubicBSplineInterpolation : public BSplineInterpolation<T, 3>
+{
+public:
+    typedef typename BSplineInterpolation<T, 3>::volume_ptr volume_ptr;
+
+    CubicBSplineInterpolation();
+    CubicBSplineInterpolation(volume_ptr volume, bool use_table = false);
+};
+
+END_NKHIVE_NS
+
+//-----------------------------------------------------------------------------
+// class implementation
+//-----------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/interpolation/BSplineInterpolation.hpp>
+
+END_NKHIVE_NS
+
+#endif // __NKHIVE_INTERPOLATION_BSPLINEINTERPOLATION_H__
@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//-----------------------------------------------------------------------------
+// BSplineInterpolation.hpp
+//-----------------------------------------------------------------------------
+
+// no includes allowed
+
+//-----------------------------------------------------------------------------
+// class implementation
+//-----------------------------------------------------------------------------
+
+template <typename T, i32 Degree>
+inline
+BSplineInterpolation<T, Degree>::BSplineInterpolation() :
+    m_volume(),
+    m_kernel()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, i32 Degree>
+inline
+BSplineInterpolation<T, Degree>::BSplineInterpolation(volume_ptr volume,
+                                                      bool use_table) :
+    m_volume(volume),
+    m_kernel(use_table)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, i32 Degree>
+inline
+BSplineInterpolation<T, Degree>::BSplineInterpolation(
+                                        const BSplineInterpolation &that) :
+    m_volume(that.m_volume),
+    m_kernel(that.m_kernel)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, i32 Degree>
+inline void
+BSplineInterpolation<T, Degree>::interp(double x, double y, double z,
+                                        reference result) const
+{
+    vec3d voxel_coords(x, y, z);
+
+    // per axis weights, once for every axis rather than every voxel
+    vec3i min_indices;
+    calc_type weights[3][TAPS];
+    m_kernel.computeWeights(voxel_coords, m_volume->kernelOffset(), 
+                            min_indices, weights);
+
+    // gather the neighbourhood x fastest, one lookup per cell
+    T block[TAPS * TAPS * TAPS];
+    m_volume->getBlock(min_indices, index_vec(TAPS), block);
+
+    // reduce along x, then y, then z
+    const T *in = block;
+    calc_type interim_result(0);
+    for (i32 k = 0; k < TAPS; ++k) {
+        calc_type value_y(0);
+        for (i32 j = 0; j < TAPS; ++j) {
+            calc_type value_x(0);
+            for (i32 i = 0; i < TAPS; ++i) {
+                value_x += weights[0][i] * calc_type(*in++);
+            }
+            value_y += weights[1][j] * value_x;
+        }
+        interim_result += weights[2][k] * value_y;
+    }
+
+    result = T(interim_result);
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+inline
+QuadraticInterpolation<T>::QuadraticInterpolation() :
+    BSplineInterpolation<T, 2>()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+inline
+QuadraticInterpolation<T>::QuadraticInterpolation(volume_ptr volume,
+                                                  bool use_table) :
+    BSplineInterpolation<T, 2>(volume, use_table)
+{
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+inline
+CubicBSplineInterpolation<T>::CubicBSplineInterpolation() :
+    BSplineInterpolation<T, 3>()
+{
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+inline
+CubicBSplineInterpolation<T>::CubicBSplineInterpolation(volume_ptr volume,
+                                                        bool use_table) :
+    BSplineInterpolation<T, 3>(volume, use_table)
+{
+}
+
+//-----------------------------------------------------------------------------
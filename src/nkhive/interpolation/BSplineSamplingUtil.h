@@ -0,0 +1,150 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BSplineSamplingUtil.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_INTERPOLATION_BSPLINESAMPLINGUTIL_H__
+#define __NKHIVE_INTERPOLATION_BSPLINESAMPLINGUTIL_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <cmath>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/** 
+ * Weights of the uniform B-spline kernel of the given degree, 2 (quadratic,
+ * 3 taps per axis) or 3 (cubic, 4 taps per axis). The kernel is separable, 
+ * so the weights are computed once per axis and a voxel's weight is the 
+ * product of its three axis weights. The per axis weights can be read from 
+ * a table quantizing the position between voxels instead of evaluating the
+ * polynomials.
+ */
+template <typename T, i32 Degree>
+class BSplineSamplingUtil
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+
+    typedef typename CalcType<T>::calc_type        calc_type;
+
+    /**
+     * Voxels covered along each axis, and table rows per voxel of position.
+     */
+    enum { TAPS = Degree + 1 };
+    enum { TABLE_RESOLUTION = 256 };
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    /**
+     * Constructors and destructors.
+     */
+    BSplineSamplingUtil(bool use_table = false);
+    ~BSplineSamplingUtil();
+
+    /**
+     * Returns true if weights are read from the quantized table.
+     */
+    bool usesTable() const;
+
+    /**
+     * Computes the first voxel index covered along each axis and the TAPS 
+     * weights of the voxels from there on, for a point in voxel coordinates.
+     */
+    void computeWeights(const vec3d &voxel_coords, 
+                        const vec3d &kernel_offset,
+                        vec3i &min_indices,
+                        calc_type weights[3][TAPS]) const;
+
+    /**
+     * Evaluates the kernel weights at t in [0, 1), the position of the 
+     * sample past the voxel the first weight is relative to.
+     */
+    static void evaluate(calc_type t, calc_type weights[TAPS]);
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal typedefs.
+    //--------------------------------------------------------------------------
+
+    typedef boost::shared_ptr< const std::vector<calc_type> > table_ptr;
+
+    //--------------------------------------------------------------------------
+    // internal methods.
+    //--------------------------------------------------------------------------
+
+    /**
+     * Builds the table of TABLE_RESOLUTION + 1 rows of weights.
+     */
+    static table_ptr createTable();
+
+    //--------------------------------------------------------------------------
+    // members.
+    //--------------------------------------------------------------------------
+
+    table_ptr m_table;
+};
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/interpolation/BSplineSamplingUtil.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_INTERPOLATION_BSPLINESAMPLINGUTIL_H__
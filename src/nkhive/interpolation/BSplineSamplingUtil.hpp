@@ -0,0 +1,139 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BSplineSamplingUtil.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// interface implementation
+//------------------------------------------------------------------------------
+
+template <typename T, i32 Degree>
+inline
+BSplineSamplingUtil<T, Degree>::BSplineSamplingUtil(bool use_table) :
+    m_table()
+{
+    if (use_table) {
+        m_table = createTable();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, i32 Degree>
+inline
+BSplineSamplingUtil<T, Degree>::~BSplineSamplingUtil()
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, i32 Degree>
+inline bool
+BSplineSamplingUtil<T, Degree>::usesTable() const
+{
+    return m_table.get() != 0;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, i32 Degree>
+inline void
+BSplineSamplingUtil<T, Degree>::computeWeights(const vec3d &voxel_coords, 
+                                               const vec3d &kernel_offset,
+                                               vec3i &min_indices,
+                                               calc_type 
+                                                   weights[3][TAPS]) const
+{
+    // odd degrees span the voxels around the point's cell, even degrees
+    // are centered on the nearest voxel
+    const double shift = (Degree % 2 == 0) ? 0.5 : 0.0;
+
+    for (i32 axis = 0; axis < 3; ++axis) {
+        double u = voxel_coords[axis] - kernel_offset[axis] + shift;
+        double base = floor(u);
+        min_indices[axis] = i32(base) - Degree / 2;
+
+        calc_type t = calc_type(u - base);
+        if (m_table) {
+            size_t row = size_t(t * calc_type(TABLE_RESOLUTION) + 
+                                calc_type(0.5));
+            const calc_type *row_weights = &(*m_table)[row * TAPS];
+            for (i32 tap = 0; tap < TAPS; ++tap) {
+                weights[axis][tap] = row_weights[tap];
+            }
+        } else {
+            evaluate(t, weights[axis]);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, i32 Degree>
+inline void
+BSplineSamplingUtil<T, Degree>::evaluate(calc_type t, 
+                                         calc_type weights[TAPS])
+{
+    // Cox-de Boor recursion on uniform knots, raising the degree in place
+    weights[0] = calc_type(1);
+    for (i32 k = 1; k <= Degree; ++k) {
+        calc_type inv_k = calc_type(1) / calc_type(k);
+        weights[k] = t * weights[k - 1] * inv_k;
+        for (i32 j = k - 1; j > 0; --j) {
+            weights[j] = ((t + calc_type(k - j)) * weights[j - 1] + 
+                          (calc_type(j + 1) - t) * weights[j]) * inv_k;
+        }
+        weights[0] = (calc_type(1) - t) * weights[0] * inv_k;
+    }
+}
+
+//------------------------------------------------------------------------------
+// internal methods
+//------------------------------------------------------------------------------
+
+template <typename T, i32 Degree>
+inline typename BSplineSamplingUtil<T, Degree>::table_ptr
+BSplineSamplingUtil<T, Degree>::createTable()
+{
+    std::vector<calc_type> *table = 
+        new std::vector<calc_type>((TABLE_RESOLUTION + 1) * TAPS);
+    for (i32 row = 0; row <= TABLE_RESOLUTION; ++row) {
+        evaluate(calc_type(row) / calc_type(TABLE_RESOLUTION), 
+                 &(*table)[row * TAPS]);
+    }
+    return table_ptr(table);
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,149 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BSplineSplat.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_INTERPOLATION_BSPLINESPLAT_H__
+#define __NKHIVE_INTERPOLATION_BSPLINESPLAT_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <nkbase/BinaryOps.h>
+#include <nkhive/volume/Volume.h>
+#include <nkhive/Types.h>
+#include <nkhive/interpolation/BSplineSamplingUtil.h>
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Splats values with the B-spline kernel of the given degree, writing the
+ * (Degree + 1)^3 voxels around the point as one block through the SetPolicy
+ * like LinearSplat. Use QuadraticSplat and CubicBSplineSplat.
+ */
+template <typename T, i32 Degree, template<typename> class SetPolicy = set_op>
+class BSplineSplat
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+    
+    typedef T                                                  value_type;
+    typedef T&                                                 reference;
+    typedef const T&                                           const_reference;
+    typedef BSplineSamplingUtil<T, Degree>                     kernel_type;
+    typedef typename kernel_type::calc_type                    calc_type;
+    typedef typename Volume<T>::shared_ptr                     volume_ptr;
+    typedef SetPolicy<T>                                       set_policy;
+
+    enum { TAPS = kernel_type::TAPS };
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    /**
+     * Constructors and destructors. With use_table the kernel weights are 
+     * read from a quantized table, see BSplineSamplingUtil.
+     */
+    BSplineSplat(volume_ptr v, bool use_table = false);
+    ~BSplineSplat();
+
+    /**
+     * Splats a value at a given point, each voxel the kernel covers gets the
+     * value scaled by its weight. Assumes that x, y, z are in voxel 
+     * coordinates. 
+     */
+    void splat(double x, double y, double z, const_reference val) const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    // members.
+    //--------------------------------------------------------------------------
+
+    volume_ptr  m_volume;
+    kernel_type m_kernel;
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * Quadratic B-spline splat, 27 voxels.
+ */
+template <typename T, template<typename> class SetPolicy = set_op>
+class QuadraticSplat : public BSplineSplat<T, 2, SetPolicy>
+{
+public:
+    typedef typename BSplineSplat<T, 2, SetPolicy>::volume_ptr volume_ptr;
+
+    QuadraticSplat(volume_ptr v, bool use_table = false);
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * Cubic B-spline splat, 64 voxels.
+ */
+template <typename T, template<typename> class SetPolicy = set_op>
+class CubicBSplineSplat : public BSplineSplat<T, 3, SetPolicy>
+{
+public:
+    typedef typename BSplineSplat<T, 3, SetPolicy>::volume_ptr volume_ptr;
+
+    CubicBSplineSplat(volume_ptr v, bool use_table = false);
+};
+
+END_NKHIVE_NS
+
+//-----------------------------------------------------------------------------
+// class implementation
+//-----------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS 
+
+#include <nkhive/interpolation/BSplineSplat.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_INTERPOLATION_BSPLINESPLAT_H__
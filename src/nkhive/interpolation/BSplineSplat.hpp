@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// BSplineSplat.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+
+template <typename T, i32 Degree, template<typename> class SetPolicy>
+inline
+BSplineSplat<T, Degree, SetPolicy>::BSplineSplat(volume_ptr v, 
+                                                 bool use_table) :
+    m_volume(v),
+    m_kernel(use_table)
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, i32 Degree, template<typename> class SetPolicy>
+inline
+BSplineSplat<T, Degree, SetPolicy>::~BSplineSplat()
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, i32 Degree, template<typename> class SetPolicy>
+inline void
+BSplineSplat<T, Degree, SetPolicy>::splat(double x, double y, double z, 
+                                          const_reference val) const
+{
+    vec3d voxel_coords(x, y, z);
+
+    // per axis weights, once for every axis rather than every voxel
+    vec3i min_indices;
+    calc_type weights[3][TAPS];
+    m_kernel.computeWeights(voxel_coords, m_volume->kernelOffset(), 
+                            min_indices, weights);
+
+    // weight the value into a block laid out x fastest
+    T block[TAPS * TAPS * TAPS];
+    T *out = block;
+    for (i32 k = 0; k < TAPS; ++k) {
+        for (i32 j = 0; j < TAPS; ++j) {
+            calc_type weight_yz = weights[1][j] * weights[2][k];
+            for (i32 i = 0; i < TAPS; ++i) {
+                *out++ = val * (weights[0][i] * weight_yz);
+            }
+        }
+    }
+
+    // and splat it back in a single pass over the cells it overlaps
+    SetPolicy<T> set_op;
+    m_volume->updateBlock(min_indices, index_vec(TAPS), block, set_op);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, template<typename> class SetPolicy>
+inline
+QuadraticSplat<T, SetPolicy>::QuadraticSplat(volume_ptr v, bool use_table) :
+    BSplineSplat<T, 2, SetPolicy>(v, use_table)
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, template<typename> class SetPolicy>
+inline
+CubicBSplineSplat<T, SetPolicy>::CubicBSplineSplat(volume_ptr v, 
+                                                   bool use_table) :
+    BSplineSplat<T, 3, SetPolicy>(v, use_table)
+{
+}
+
+//------------------------------------------------------------------------------
@@ -100,6 +100,13 @@ public:
     void interp(double x, double y, double z, 
                 reference result) const;
 
+    /**
+     * evaluate at a point along with the gradient with respect to the local
+     * coordinates, scaled by the volume resolution, from the same 64 voxels
+     */
+    void interpWithGradient(double x, double y, double z, 
+                            reference result, calc_vec_type &gradient) const;
+
 private:
 
     //-------------------------------------------------------------------------
@@ -119,6 +126,13 @@ private:
                              const vec3i &max_indices, 
                              calc_type interpolants[64]) const;
 
+    /**
+     * weights of the 4 interpolants at t, as used by interp_hermite, and 
+     * their derivatives with respect to t
+     */
+    void computeWeights(const calc_type &t, calc_type weights[4], 
+                        calc_type derivatives[4]) const;
+
     /**
      * cubic interpolation in 1 dimension
      */
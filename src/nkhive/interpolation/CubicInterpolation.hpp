@@ -112,10 +112,115 @@ CubicInterpolation<T>::interp(double x, double y, double z,
     result = T(interp_result);
 }
 
+//-----------------------------------------------------------------------------
+
+template < typename T >
+inline void
+CubicInterpolation<T>::interpWithGradient(double x, double y, double z, 
+                                          reference result,
+                                          calc_vec_type &gradient) const
+{
+    vec3d local_coords(x, y, z);
+    vec3d voxel_coords;
+    vec3i voxel_indices;
+
+    // got from local coordinate system to voxel coordinate system
+    m_volume->localToVoxel(local_coords, voxel_coords);
+
+    // obtain indices from voxel coordinates
+    m_volume->voxelToIndex(voxel_coords, voxel_indices);
+
+    // get the voxelindices to interpolate from
+    vec3i min_indices, max_indices;
+    getIndexBounds(voxel_coords, voxel_indices, min_indices, max_indices);
+
+    // collect the 64 values shared by the value and the gradient
+    calc_type interpolants[64];
+    collectInterpolants(min_indices, max_indices, interpolants);
+
+    // per axis weights at the same parameterized coordinates as interp(), 
+    // and the scale taking derivatives in t to derivatives in local space
+    calc_type weights[3][4];
+    calc_type derivatives[3][4];
+    vec3d res = m_volume->res();
+    calc_vec_type scale;
+    for (i32 i = 0; i < 3; ++i) {
+        double span = max_indices[i] - min_indices[i] - 2.0;
+        calc_type t = (voxel_coords[i] - (min_indices[i] + 1.5)) / span;
+        computeWeights(t, weights[i], derivatives[i]);
+        scale[i] = res[i] / span;
+    }
+
+    // reduce along x, then y, then z, carrying the partial derivatives 
+    // of the axes already reduced
+    index_type lg_size = 2;
+    calc_type value_z[4], dx_z[4], dy_z[4];
+    for (i32 z_i = 0; z_i < 4; ++z_i) {
+        value_z[z_i] = dx_z[z_i] = dy_z[z_i] = calc_type(0);
+        for (i32 y_i = 0; y_i < 4; ++y_i) {
+            calc_type value_x(0), dx_x(0);
+            for (i32 x_i = 0; x_i < 4; ++x_i) {
+                calc_type p = interpolants[getIndex(x_i, y_i, z_i, lg_size)];
+                value_x += weights[0][x_i] * p;
+                dx_x    += derivatives[0][x_i] * p;
+            }
+            value_z[z_i] += weights[1][y_i] * value_x;
+            dx_z[z_i]    += weights[1][y_i] * dx_x;
+            dy_z[z_i]    += derivatives[1][y_i] * value_x;
+        }
+    }
+
+    calc_type interp_result(0);
+    calc_vec_type interp_gradient(calc_type(0));
+    for (i32 z_i = 0; z_i < 4; ++z_i) {
+        interp_result      += weights[2][z_i] * value_z[z_i];
+        interp_gradient[0] += weights[2][z_i] * dx_z[z_i];
+        interp_gradient[1] += weights[2][z_i] * dy_z[z_i];
+        interp_gradient[2] += derivatives[2][z_i] * value_z[z_i];
+    }
+
+    result = T(interp_result);
+    gradient = interp_gradient * scale;
+}
+
 //-----------------------------------------------------------------------------
 // internal methods
 //-----------------------------------------------------------------------------
 
+template < typename T >
+inline void
+CubicInterpolation<T>::computeWeights(const calc_type &t, 
+                                      calc_type weights[4],
+                                      calc_type derivatives[4]) const
+{
+    // hermite basis, the tangents are central differences of the 
+    // interpolants so each basis function spreads over them
+    calc_type t2 = t * t;
+    calc_type t3 = t2 * t;
+
+    calc_type h00 = (2.0 * t3) - (3.0 * t2) + 1.0;
+    calc_type h10 = t3 - (2.0 * t2) + t;
+    calc_type h01 = (3.0 * t2) - (2.0 * t3);
+    calc_type h11 = t3 - t2;
+
+    weights[0] = -0.5 * h10;
+    weights[1] = h00 - 0.5 * h11;
+    weights[2] = h01 + 0.5 * h10;
+    weights[3] = 0.5 * h11;
+
+    calc_type d00 = (6.0 * t2) - (6.0 * t);
+    calc_type d10 = (3.0 * t2) - (4.0 * t) + 1.0;
+    calc_type d01 = (6.0 * t) - (6.0 * t2);
+    calc_type d11 = (3.0 * t2) - (2.0 * t);
+
+    derivatives[0] = -0.5 * d10;
+    derivatives[1] = d00 - 0.5 * d11;
+    derivatives[2] = d01 + 0.5 * d10;
+    derivatives[3] = 0.5 * d11;
+}
+
+//-----------------------------------------------------------------------------
+
 template < typename T >
 inline void
 CubicInterpolation<T>::getIndexBounds(const vec3d &voxel_coords, 
@@ -143,14 +248,12 @@ CubicInterpolation<T>::collectInterpolants(const vec3i &min_indices,
                                            const vec3i &,
                                            calc_type interpolants[64]) const
 {
-    // fill 64 interpolate values from a 4x4x4 subvolume
+    // fill 64 interpolate values from a 4x4x4 subvolume, the block is laid
+    // out x fastest like getCoordinates() with a lg size of 2
+    T block[64];
+    m_volume->getBlock(min_indices, index_vec(4), block);
     for (i32 i = 0; i < 64; ++i) {
-        index_type v_i, v_j, v_k;
-        getCoordinates(i, 2, v_i, v_j, v_k);
-
-        interpolants[i] = m_volume->get(v_i + min_indices[0], 
-                                        v_j + min_indices[1], 
-                                        v_k + min_indices[2]); 
+        interpolants[i] = block[i];
     }
 }
 
@@ -40,6 +40,11 @@
 // includes
 //-----------------------------------------------------------------------------
 
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include <nkhive/bitfields/BitOps.h>
 #include <nkhive/volume/Volume.h>
 #include <nkhive/Types.h>
 #include <nkhive/interpolation/LinearSamplingUtil.h>
@@ -104,12 +109,61 @@ public:
     void interp(double x, double y, double z, 
                 reference result) const;
 
+    /**
+     * Interpolate the value at voxel coordinates x, y, z along with its
+     * gradient with respect to voxel coordinates, from the same 8 voxels.
+     */
+    void interpWithGradient(double x, double y, double z, 
+                            reference result, calc_vec_type &gradient) const;
+
+    /**
+     * Interpolate n points at voxel coordinates pts into out. Results match
+     * interp() point for point, the points are visited cell by cell.
+     */
+    void interpBatch(const vec3d *pts, value_type *out, size_t n) const;
+
+    /**
+     * Same as above with the coordinates given as separate x, y, z arrays.
+     */
+    void interpBatch(const double *x, const double *y, const double *z,
+                     value_type *out, size_t n) const;
+
 private:
 
+    //-------------------------------------------------------------------------
+    // typedefs
+    //-------------------------------------------------------------------------
+
+    typedef std::pair<uint64_t, size_t>            point_key;
+
     //-------------------------------------------------------------------------
     // internal methods
     //-------------------------------------------------------------------------
 
+    /**
+     * Shared batch path, coordinate n of each axis is at x[n * stride].
+     */
+    void interpStrided(const double *x, const double *y, const double *z,
+                       size_t stride, value_type *out, size_t n) const;
+
+    /**
+     * Orders the points by the morton key of their base voxel, so points
+     * in the same cell are adjacent, unless they already are coherent. 
+     * Order holds one entry per point.
+     */
+    void sortPoints(const double *x, const double *y, const double *z,
+                    size_t stride, const vec3d &kernel_offset, 
+                    std::vector<point_key> &order) const;
+
+    //-------------------------------------------------------------------------
+    // constants
+    //-------------------------------------------------------------------------
+
+    /**
+     * Number of points gathered and blended together per block.
+     */
+    static const size_t kBlockSize = 64;
+
     //-------------------------------------------------------------------------
     // members
     //-------------------------------------------------------------------------
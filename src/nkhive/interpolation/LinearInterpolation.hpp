@@ -105,3 +105,229 @@ LinearInterpolation<T>::interp(double x, double y, double z,
 }
 
 //------------------------------------------------------------------------------
+
+template < typename T >
+inline void
+LinearInterpolation<T>::interpWithGradient(double x, double y, double z,
+                                           reference result, 
+                                           calc_vec_type &gradient) const
+{
+    vec3d voxel_coords(x, y, z);
+    vec3i voxel_indices;
+
+    // obtain indices from voxel coordinates
+    m_volume->voxelToIndex(voxel_coords, voxel_indices);
+
+    // get the index to voxel mapping offset
+    vec3d kernel_offset = m_volume->kernelOffset();
+
+    // get the voxelindices to interpolate from
+    vec3i min_indices, max_indices;
+    LinearSamplingUtil<T>::getIndexBounds(voxel_indices,
+                                          min_indices, max_indices);
+
+    // collect the 8 values shared by the value and the gradient
+    T interpolants[VOXEL_NEIGHBORS];
+    LinearSamplingUtil<T>::collectInterpolants(min_indices, max_indices,
+                                               m_volume, interpolants);
+   
+    // calc interpolation weights and their derivatives
+    calc_type weights[VOXEL_NEIGHBORS];
+    LinearSamplingUtil<T>::computeWeights(voxel_coords, kernel_offset, 
+                                          min_indices, weights);
+    calc_vec_type grads[VOXEL_NEIGHBORS];
+    LinearSamplingUtil<T>::computeWeightGradients(voxel_coords, kernel_offset,
+                                                  min_indices, grads);
+
+    // interpolate value and gradient
+    calc_type interim_result(0);
+    calc_vec_type interim_gradient(calc_type(0));
+    for (i32 i = 0; i < VOXEL_NEIGHBORS; ++i) {
+        interim_result += interpolants[i] * weights[i];
+        interim_gradient += grads[i] * calc_type(interpolants[i]);
+    }
+
+    result = interim_result;
+    gradient = interim_gradient;
+}
+
+//------------------------------------------------------------------------------
+
+template < typename T >
+inline void
+LinearInterpolation<T>::interpBatch(const vec3d *pts, value_type *out, 
+                                    size_t n) const
+{
+    if (n == 0) return;
+    const size_t stride = sizeof(vec3d) / sizeof(double);
+    interpStrided(&pts[0].x, &pts[0].y, &pts[0].z, stride, out, n);
+}
+
+//------------------------------------------------------------------------------
+
+template < typename T >
+inline void
+LinearInterpolation<T>::interpBatch(const double *x, const double *y, 
+                                    const double *z, value_type *out, 
+                                    size_t n) const
+{
+    if (n == 0) return;
+    interpStrided(x, y, z, 1, out, n);
+}
+
+//------------------------------------------------------------------------------
+
+template < typename T >
+inline void
+LinearInterpolation<T>::interpStrided(const double *x, const double *y, 
+                                      const double *z, size_t stride, 
+                                      value_type *out, size_t n) const
+{
+    const Volume<T> &volume = *m_volume;
+    typename Volume<T>::const_accessor acc = volume.getAccessor();
+    vec3d kernel_offset = volume.kernelOffset();
+
+    std::vector<point_key> order(n);
+    sortPoints(x, y, z, stride, kernel_offset, order);
+
+    // per block scratch, one row per axis or corner so the weight and blend
+    // loops run over contiguous arrays
+    i32 min_indices[3][kBlockSize];
+    calc_type w[3][kBlockSize];
+    calc_type w_1_minus[3][kBlockSize];
+    T interpolants[VOXEL_NEIGHBORS][kBlockSize];
+    calc_type results[kBlockSize];
+
+    const double *coords[3] = { x, y, z };
+    for (size_t begin = 0; begin < n; begin += kBlockSize) {
+        size_t count = (n - begin < kBlockSize) ? n - begin : kBlockSize;
+
+        // base voxel and fractional offset, as voxelToIndex and 
+        // computeWeights do them
+        for (i32 a = 0; a < 3; ++a) {
+            for (size_t b = 0; b < count; ++b) {
+                double c = coords[a][order[begin + b].second * stride];
+                i32 m = i32(floor(c - kernel_offset[a]));
+                min_indices[a][b] = m;
+                w[a][b] = calc_type(c - (m + kernel_offset[a]));
+                w_1_minus[a][b] = calc_type(1.0) - w[a][b];
+            }
+        }
+
+        // gather, sorted points mostly hit the accessor's cached cell, the
+        // block is x fastest while the corners are x slowest
+        for (size_t b = 0; b < count; ++b) {
+            T block[VOXEL_NEIGHBORS];
+            acc.getBlock(signed_index_vec(min_indices[0][b], 
+                                          min_indices[1][b], 
+                                          min_indices[2][b]),
+                         index_vec(2), block);
+            for (i32 v = 0; v < VOXEL_NEIGHBORS; ++v) {
+                interpolants[v][b] = 
+                    block[((v >> 2) & 1) | (v & 2) | ((v & 1) << 2)];
+            }
+        }
+
+        // weight and blend a corner at a time, same order as interp(), the 
+        // inner loops are branch free and vectorize for float and double
+        std::fill(results, results + count, calc_type(0));
+        for (i32 v = 0; v < VOXEL_NEIGHBORS; ++v) {
+            const calc_type *wx = (v & 4) ? w[0] : w_1_minus[0];
+            const calc_type *wy = (v & 2) ? w[1] : w_1_minus[1];
+            const calc_type *wz = (v & 1) ? w[2] : w_1_minus[2];
+            const T *values = interpolants[v];
+            for (size_t b = 0; b < count; ++b) {
+                calc_type weight = wx[b] * wy[b] * wz[b];
+                results[b] += calc_type(values[b]) * weight;
+            }
+        }
+
+        for (size_t b = 0; b < count; ++b) {
+            out[order[begin + b].second] = results[b];
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template < typename T >
+inline void
+LinearInterpolation<T>::sortPoints(const double *x, const double *y, 
+                                   const double *z, size_t stride, 
+                                   const vec3d &kernel_offset,
+                                   std::vector<point_key> &order) const
+{
+    size_t n = order.size();
+
+    // base voxel of each point and their bounds, keys are taken relative to
+    // the low corner so they need only as many bits as the points span
+    std::vector<signed_index_vec> bases(n);
+    signed_index_vec lo, hi;
+    for (size_t p = 0; p < n; ++p) {
+        size_t s = p * stride;
+        signed_index_vec &base = bases[p];
+        base.x = i32(floor(x[s] - kernel_offset[0]));
+        base.y = i32(floor(y[s] - kernel_offset[1]));
+        base.z = i32(floor(z[s] - kernel_offset[2]));
+        for (i32 a = 0; a < 3; ++a) {
+            lo[a] = (p == 0) ? base[a] : std::min(lo[a], base[a]);
+            hi[a] = (p == 0) ? base[a] : std::max(hi[a], base[a]);
+        }
+    }
+
+    // 21 bits per axis at most, points further out share keys which costs
+    // locality but nothing else
+    index_type extent = std::max(index_type(hi.x - lo.x), 
+                                 std::max(index_type(hi.y - lo.y), 
+                                          index_type(hi.z - lo.z)));
+    index_type bits = std::min<index_type>(getLastSetBitIndex(extent), 21);
+    const index_type mask = (1 << bits) - 1;
+
+    // Input that is in order, or already walks from voxel to neighbouring
+    // voxel, is left as is.
+    bool sorted = true;
+    size_t neighbours = 0;
+    for (size_t p = 0; p < n; ++p) {
+        const signed_index_vec &base = bases[p];
+        uint64_t key = getMortonKey(index_type(base.x - lo.x) & mask, 
+                                    index_type(base.y - lo.y) & mask, 
+                                    index_type(base.z - lo.z) & mask);
+        order[p] = point_key(key, p);
+        if (p == 0) continue;
+
+        const signed_index_vec &prev = bases[p - 1];
+        if (key < order[p - 1].first) sorted = false;
+        if (std::abs(base.x - prev.x) <= 1 && std::abs(base.y - prev.y) <= 1 &&
+            std::abs(base.z - prev.z) <= 1) {
+            ++neighbours;
+        }
+    }
+    if (sorted || (2 * neighbours >= n)) return;
+
+    // Least significant digit first, each pass is a stable counting sort.
+    const index_type lg_radix = 11;
+    const size_t radix = size_t(1) << lg_radix;
+    std::vector<point_key> scratch(n);
+    std::vector<size_t> offsets(radix);
+    for (index_type shift = 0; shift < 3 * bits; shift += lg_radix) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (size_t p = 0; p < n; ++p) {
+            ++offsets[(order[p].first >> shift) & (radix - 1)];
+        }
+
+        size_t total = 0;
+        for (size_t d = 0; d < radix; ++d) {
+            size_t digit_count = offsets[d];
+            offsets[d] = total;
+            total += digit_count;
+        }
+
+        for (size_t p = 0; p < n; ++p) {
+            size_t digit = (order[p].first >> shift) & (radix - 1);
+            scratch[offsets[digit]++] = order[p];
+        }
+        order.swap(scratch);
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -98,6 +98,15 @@ public:
                                const vec3i &min_indices,
                                calc_type weights[VOXEL_NEIGHBORS]);
 
+    /**
+     * Compute the derivatives of the weights with respect to the voxel
+     * coordinates.
+     */
+    static void computeWeightGradients(const vec3d &voxel_coords, 
+                                       const vec3d &kernel_offset,
+                                       const vec3i &min_indices,
+                                       calc_vec_type grads[VOXEL_NEIGHBORS]);
+
     /**
      * Update the volume with value splatted across interpolants
      */
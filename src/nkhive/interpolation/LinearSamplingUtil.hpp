@@ -43,6 +43,9 @@
 #define Y_SIGN(i) i & 2
 #define Z_SIGN(i) i & 1
 
+// index of a corner within a 2x2x2 block laid out x fastest
+#define BLOCK_INDEX(i) ((((i) >> 2) & 1) | ((i) & 2) | (((i) & 1) << 2))
+
 //------------------------------------------------------------------------------
 // interface implementation
 //------------------------------------------------------------------------------
@@ -63,20 +66,20 @@ LinearSamplingUtil<T>::getIndexBounds(const vec3i &voxel_indices,
 template < typename T >
 inline void
 LinearSamplingUtil<T>::collectInterpolants(const vec3i &min_indices, 
-                                           const vec3i &max_indices,
+                                           const vec3i &,
                                            volume_ptr volume,
                                            T interpolants[VOXEL_NEIGHBORS])
 {
+    // gather the 2x2x2 block, x fastest, in one pass over its cells
+    T block[VOXEL_NEIGHBORS];
+    volume->getBlock(min_indices, index_vec(2), block);
+
     // fill interpolant array using bit indices
     // 000 (index 0) is -x, -y, -z voxel value
     // 111 (index 7) is +x, +y, +z voxel value 
     for (i32 i = 0; i < VOXEL_NEIGHBORS; ++i) {
-        interpolants[i] = volume->get(
-            X_SIGN(i) ? max_indices[0] : min_indices[0],
-            Y_SIGN(i) ? max_indices[1] : min_indices[1],
-            Z_SIGN(i) ? max_indices[2] : min_indices[2]);
+        interpolants[i] = block[BLOCK_INDEX(i)];
     }
-
 }
 
 //------------------------------------------------------------------------------
@@ -108,24 +111,58 @@ LinearSamplingUtil<T>::computeWeights(const vec3d &voxel_coords,
 
 //------------------------------------------------------------------------------
 
+template < typename T >
+inline void
+LinearSamplingUtil<T>::computeWeightGradients(const vec3d &voxel_coords, 
+                                              const vec3d &kernel_offset,
+                                              const vec3i &min_indices,
+                                              calc_vec_type 
+                                                  grads[VOXEL_NEIGHBORS])
+{
+    // same normalized voxel coordinates as computeWeights
+    calc_vec_type w(voxel_coords[0] - (min_indices[0] + kernel_offset[0]),
+                    voxel_coords[1] - (min_indices[1] + kernel_offset[1]),
+                    voxel_coords[2] - (min_indices[2] + kernel_offset[2]));
+
+    calc_vec_type w_1_minus(calc_type(1.0) - w[0],
+                            calc_type(1.0) - w[1],
+                            calc_type(1.0) - w[2]);
+
+    // each factor w differentiates to 1 and each 1 - w to -1
+    for (i32 i = 0; i < VOXEL_NEIGHBORS; ++i) {
+        calc_vec_type f(X_SIGN(i) ? w[0] : w_1_minus[0],
+                        Y_SIGN(i) ? w[1] : w_1_minus[1],
+                        Z_SIGN(i) ? w[2] : w_1_minus[2]);
+        calc_vec_type d(X_SIGN(i) ? calc_type(1) : calc_type(-1),
+                        Y_SIGN(i) ? calc_type(1) : calc_type(-1),
+                        Z_SIGN(i) ? calc_type(1) : calc_type(-1));
+
+        grads[i] = calc_vec_type(d[0] * f[1] * f[2], 
+                                 f[0] * d[1] * f[2], 
+                                 f[0] * f[1] * d[2]);
+    }
+}
+
+//------------------------------------------------------------------------------
+
 template <typename T>
 template<template <typename> class SetPolicy>
 inline void
 LinearSamplingUtil<T>::updateValues(const vec3i &min_indices, 
-                                    const vec3i &max_indices,
+                                    const vec3i &,
                                     calc_type weights[VOXEL_NEIGHBORS],
                                     volume_ptr volume,
                                     const_reference val,
                                     SetPolicy<T> set_op)
 {
     // update the volume with val, weighting it by the
-    // given weights
+    // given weights, as a single 2x2x2 block
+    T block[VOXEL_NEIGHBORS];
     for (i32 i = 0; i < VOXEL_NEIGHBORS; ++i) {
-        volume->update(X_SIGN(i) ? max_indices[0] : min_indices[0], 
-                       Y_SIGN(i) ? max_indices[1] : min_indices[1], 
-                       Z_SIGN(i) ? max_indices[2] : min_indices[2], 
-                       val * weights[i], set_op);
+        block[BLOCK_INDEX(i)] = val * weights[i];
     }
+
+    volume->updateBlock(min_indices, index_vec(2), block, set_op);
 }
 
 //------------------------------------------------------------------------------
@@ -135,5 +172,6 @@ LinearSamplingUtil<T>::updateValues(const vec3i &min_indices,
 #undef X_SIGN
 #undef Y_SIGN
 #undef Z_SIGN
+#undef BLOCK_INDEX
 
 //------------------------------------------------------------------------------
@@ -70,6 +70,7 @@ public:
     typedef const T&                                       const_reference;
     typedef typename LinearSamplingUtil<T>::calc_type      calc_type;
     typedef typename Volume<T>::shared_ptr                 volume_ptr;
+    typedef SetPolicy<T>                                   set_policy;
 
     //--------------------------------------------------------------------------
     // public interface
@@ -68,6 +68,7 @@ public:
     typedef T&                                     reference;
     typedef const T&                               const_reference;
     typedef typename Volume<T>::shared_ptr         volume_ptr;
+    typedef SetPolicy<T>                           set_policy;
 
     //--------------------------------------------------------------------------
     // public interface
@@ -61,7 +61,8 @@ NearestNeighborSplat<T, SetPolicy>::splat(double x, double y, double z,
     signed_index_type j = (signed_index_type)floor(y);
     signed_index_type k = (signed_index_type)floor(z);
 
-    m_volume->update(i, j, k, val, SetPolicy<T>());
+    m_volume->updateBlock(signed_index_vec(i, j, k), index_vec(1), &val,
+                          SetPolicy<T>());
 }
 
 //------------------------------------------------------------------------------
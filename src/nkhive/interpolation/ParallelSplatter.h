@@ -0,0 +1,170 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// ParallelSplatter.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_INTERPOLATION_PARALLELSPLATTER_H__
+#define __NKHIVE_INTERPOLATION_PARALLELSPLATTER_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <vector>
+#include <boost/bind.hpp>
+
+#include <nkbase/Exceptions.h>
+
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkhive/util/WorkerGroup.h>
+#include <nkhive/volume/Volume.h>
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Splats a batch of particles with a splat kernel (LinearSplat, 
+ * NearestNeighborSplat) on several threads. Each thread splats a contiguous
+ * range of the particles into a private volume with the kernel's SetPolicy, 
+ * the partial volumes are then merged into the target in thread order with 
+ * a parallel Volume::updateBatch(). For associative policies the result 
+ * matches splatting the particles in order on one thread.
+ */
+template <typename Splat>
+class ParallelSplatter
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+
+    typedef typename Splat::value_type                  value_type;
+    typedef typename Splat::const_reference             const_reference;
+    typedef typename Splat::volume_ptr                  volume_ptr;
+    typedef typename Splat::set_policy                  set_policy;
+    typedef typename volume_ptr::element_type           volume_type;
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    /**
+     * Identity is the value the policy leaves unchanged when combined with,
+     * 0 for sums, the partial volumes start out with it. A thread count of 0
+     * uses one thread per core.
+     */
+    ParallelSplatter(volume_ptr volume, 
+                     const_reference identity = value_type(), 
+                     size_t num_threads = 0);
+
+    /**
+     * Splats vals[n] at pts[n] for every n below count. The points are in 
+     * voxel coordinates.
+     */
+    void splat(const vec3d *pts, const value_type *vals, size_t count);
+
+    /**
+     * Number of splatting threads used.
+     */
+    size_t numThreads() const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal typedefs
+    //--------------------------------------------------------------------------
+
+    /**
+     * Collects the set voxels of a partial volume.
+     */
+    struct Gather
+    {
+        void operator()(const signed_index_vec &coords, const_reference value)
+        {
+            m_coords.push_back(coords);
+            m_values.push_back(value);
+        }
+
+        std::vector<signed_index_vec>   m_coords;
+        std::vector<value_type>         m_values;
+    };
+
+    /**
+     * Fewest particles worth handing to a thread of their own.
+     */
+    enum { POINTS_PER_THREAD = 1024 };
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Thread body, splats its range of the particles into its partial 
+     * volume and gathers the voxels it set.
+     */
+    void work(const vec3d *pts, const value_type *vals, size_t thread);
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    volume_ptr                  m_volume;
+    value_type                  m_identity;
+    WorkerGroup                 m_workers;
+    std::vector<volume_ptr>     m_partials;
+    std::vector<Gather>         m_gathers;
+    size_t                      m_count;
+};
+
+END_NKHIVE_NS
+
+//-----------------------------------------------------------------------------
+// class implementation
+//-----------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/interpolation/ParallelSplatter.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_INTERPOLATION_PARALLELSPLATTER_H__
@@ -0,0 +1,153 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// ParallelSplatter.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+template <typename Splat>
+inline
+ParallelSplatter<Splat>::ParallelSplatter(volume_ptr volume, 
+                                          const_reference identity,
+                                          size_t num_threads) :
+    m_volume(volume),
+    m_identity(identity),
+    m_workers(num_threads),
+    m_partials(),
+    m_gathers(),
+    m_count(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename Splat>
+inline void
+ParallelSplatter<Splat>::splat(const vec3d *pts, const value_type *vals, 
+                               size_t count)
+{
+    size_t num_threads = std::min<size_t>(m_workers.numThreads(), 
+        (count + POINTS_PER_THREAD - 1) / POINTS_PER_THREAD);
+
+    // Too few particles to pay for the partial volumes.
+    if (num_threads <= 1) {
+        Splat splat(m_volume);
+        for (size_t n = 0; n < count; ++n) {
+            splat.splat(pts[n].x, pts[n].y, pts[n].z, vals[n]);
+        }
+        return;
+    }
+
+    // Every tree allocates from its own pool, so the threads don't share
+    // any memory while splatting.
+    m_partials.clear();
+    for (size_t t = 0; t < num_threads; ++t) {
+        m_partials.push_back(volume_ptr(
+            new volume_type(m_volume->getLgBranchingFactor(),
+                            m_volume->getLgCellDim(), m_identity,
+                            m_volume->res(), m_volume->kernelOffset())));
+    }
+    m_gathers.assign(num_threads, Gather());
+    m_count = count;
+
+    m_workers.run(num_threads, num_threads, 
+                  boost::bind(&ParallelSplatter::work, this, pts, vals, _1));
+    m_partials.clear();
+
+    if (m_workers.failed()) {
+        m_gathers.clear();
+        THROW(Iex::LogicExc, "Parallel splat failed: " << m_workers.error());
+    }
+
+    // Partial results of later particles go last, updateBatch() keeps the
+    // writes to each voxel in that order.
+    size_t total = 0;
+    for (size_t t = 0; t < num_threads; ++t) {
+        total += m_gathers[t].m_coords.size();
+    }
+    std::vector<signed_index_vec> coords;
+    std::vector<value_type> values;
+    coords.reserve(total);
+    values.reserve(total);
+    for (size_t t = 0; t < num_threads; ++t) {
+        Gather &gather = m_gathers[t];
+        coords.insert(coords.end(), gather.m_coords.begin(), 
+                      gather.m_coords.end());
+        values.insert(values.end(), gather.m_values.begin(), 
+                      gather.m_values.end());
+    }
+    m_gathers.clear();
+
+    if (total > 0) {
+        m_volume->updateBatch(&coords[0], &values[0], total, set_policy(),
+                              num_threads);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename Splat>
+inline size_t
+ParallelSplatter<Splat>::numThreads() const
+{
+    return m_workers.numThreads();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename Splat>
+inline void
+ParallelSplatter<Splat>::work(const vec3d *pts, const value_type *vals,
+                              size_t thread)
+{
+    const size_t num_threads = m_partials.size();
+    const size_t begin       = m_count * thread / num_threads;
+    const size_t end         = m_count * (thread + 1) / num_threads;
+
+    volume_ptr partial = m_partials[thread];
+    Splat splat(partial);
+    for (size_t n = begin; n < end; ++n) {
+        splat.splat(pts[n].x, pts[n].y, pts[n].z, vals[n]);
+    }
+
+    const volume_type &result = *partial;
+    std::vector<Gather> gathers = result.parallelForEach(Gather(), 1);
+    m_gathers[thread].m_coords.swap(gathers[0].m_coords);
+    m_gathers[thread].m_values.swap(gathers[0].m_values);
+}
+
+//------------------------------------------------------------------------------
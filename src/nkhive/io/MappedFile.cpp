@@ -0,0 +1,109 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// MappedFile.cpp
+//------------------------------------------------------------------------------
+
+#include <nkhive/io/MappedFile.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <nkbase/Exceptions.h>
+
+BEGIN_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// interface implementation
+//------------------------------------------------------------------------------
+
+MappedFile::MappedFile(const String &file_path) :
+    m_data(NULL),
+    m_size(0)
+{
+    int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        THROW(Iex::IoExc, "Could not open " << file_path.c_str());
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        THROW(Iex::IoExc, "Could not stat " << file_path.c_str());
+    }
+    m_size = info.st_size;
+
+    // private and writable, stray writes get copied pages
+    void *data = MAP_FAILED;
+    if (m_size > 0) {
+        data = mmap(NULL, m_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+
+    // the mapping keeps the file referenced
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        THROW(Iex::IoExc, "Could not map " << file_path.c_str());
+    }
+    m_data = static_cast<u8*>(data);
+}
+
+//------------------------------------------------------------------------------
+
+MappedFile::~MappedFile()
+{
+    if (m_data) {
+        munmap(m_data, m_size);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+const u8*
+MappedFile::data() const
+{
+    return m_data;
+}
+
+//------------------------------------------------------------------------------
+
+size_t
+MappedFile::size() const
+{
+    return m_size;
+}
+
+//------------------------------------------------------------------------------
+
+END_NKHIVE_NS
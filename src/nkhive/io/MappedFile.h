@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// MappedFile.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_IO_MAPPEDFILE_H__
+#define __NKHIVE_IO_MAPPEDFILE_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <boost/shared_ptr.hpp>
+
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkbase/String.h>
+
+//------------------------------------------------------------------------------
+// interface
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Read only view of a whole file through mmap. The mapping is private, pages
+ * written through it are copied by the kernel and never reach the file.
+ */
+class MappedFile
+{
+
+public:
+
+    typedef boost::shared_ptr<MappedFile> shared_ptr;
+
+    //--------------------------------------------------------------------------
+    // constructors/destructors
+    //--------------------------------------------------------------------------
+
+    explicit MappedFile(const String &file_path);
+    ~MappedFile();
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    const u8* data() const;
+    size_t size() const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Not copyable, the mapping is shared through shared_ptr.
+     */
+    MappedFile(const MappedFile &that);
+    MappedFile& operator=(const MappedFile &that);
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    u8     *m_data;
+    size_t  m_size;
+};
+
+END_NKHIVE_NS
+
+#endif // __NKHIVE_IO_MAPPEDFILE_H__
@@ -0,0 +1,192 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// MappedLeafTable.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_IO_MAPPEDLEAFTABLE_H__
+#define __NKHIVE_IO_MAPPEDLEAFTABLE_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+#include <nkbase/Exceptions.h>
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkhive/bitfields/BitOps.h>
+#include <nkhive/io/MappedFile.h>
+#include <nkhive/io/hdf5/HDF5LeafTable.h>
+#include <nkhive/io/hdf5/HDF5Util.h>
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Native format version and the alignment of its sections.
+ */
+const u32 kNativeVersion   = 2;
+const u64 kNativeAlignment = 4096;
+
+/**
+ * Header at the start of a native file. The leaf records, bitfield bytes,
+ * voxels and volume metadata follow in page aligned sections. Values are
+ * stored in the byte order of the writing machine.
+ */
+struct NativeHeader
+{
+    char magic[8];            // "nkhive\0\0"
+    u32  version;
+    u32  value_size;          // sizeof the voxel type
+    u32  record_size;         // sizeof a leaf record
+    u8   lg_branching_factor;
+    u8   lg_cell_dim;
+    u8   value_class;         // H5T_class_t of the voxel type
+    u8   value_sign;          // H5T_sign_t of integer voxel types
+    u64  leaf_count;
+    u64  records_offset;
+    u64  bitfields_offset;
+    u64  bitfields_bytes;
+    u64  voxels_offset;
+    u64  voxel_count;
+    u64  metadata_offset;
+    u64  metadata_bytes;
+    u8   default_value[16];   // first value_size bytes are used
+};
+
+//------------------------------------------------------------------------------
+// interface
+//------------------------------------------------------------------------------
+
+/**
+ * Leaf table served straight from a mapped native file. Records, bitfields
+ * and voxels point into the mapping, nothing is copied.
+ */
+template <typename T>
+class MappedLeafTable
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // types
+    //--------------------------------------------------------------------------
+
+    typedef typename HDF5LeafTable<T>::Record Record;
+
+    //--------------------------------------------------------------------------
+    // constructors/destructors
+    //--------------------------------------------------------------------------
+
+    /**
+     * Validates the header and section bounds, throws Iex::IoExc if the file
+     * is not a native file of this voxel type.
+     */
+    explicit MappedLeafTable(const MappedFile::shared_ptr &file);
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    size_t size() const;
+    const Record& operator[](size_t leaf) const;
+
+    const u8* bitfields() const;
+    const T* voxels() const;
+
+    const NativeHeader& header() const;
+    T defaultValue() const;
+
+    /**
+     * Volume metadata stored with the tree, empty if none.
+     */
+    std::string metadata() const;
+
+    const MappedFile::shared_ptr& file() const;
+
+    /**
+     * Writes a native file holding the given leaf table.
+     */
+    static void write(std::ostream &os, const HDF5LeafTable<T> &table,
+                      const T &default_value, u8 lg_branching_factor,
+                      u8 lg_cell_dim, const std::string &metadata);
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Tags the voxel type by its HDF5 type class and sign, telling apart 
+     * types of the same size.
+     */
+    static void valueType(u8 &value_class, u8 &value_sign);
+
+    /**
+     * Rounds an offset up to the section alignment.
+     */
+    static u64 align(u64 offset);
+
+    /**
+     * Writes zeros up to the given offset.
+     */
+    static void pad(std::ostream &os, u64 from, u64 to);
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    MappedFile::shared_ptr m_file;
+    const NativeHeader    *m_header;
+    const Record          *m_records;
+    const u8              *m_bitfields;
+    const T               *m_voxels;
+};
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+#include <nkhive/io/MappedLeafTable.hpp>
+
+END_NKHIVE_NS
+
+#endif // __NKHIVE_IO_MAPPEDLEAFTABLE_H__
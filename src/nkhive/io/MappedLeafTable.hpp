@@ -0,0 +1,276 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// MappedLeafTable.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline
+MappedLeafTable<T>::MappedLeafTable(const MappedFile::shared_ptr &file) :
+    m_file(file),
+    m_header(NULL),
+    m_records(NULL),
+    m_bitfields(NULL),
+    m_voxels(NULL)
+{
+    const u8 *data = m_file->data();
+    u64 size = m_file->size();
+
+    if (size < sizeof(NativeHeader) || 
+        memcmp(data, "nkhive\0\0", 8) != 0) {
+        THROW(Iex::IoExc, "MappedLeafTable - Not a native nkhive file");
+    }
+
+    m_header = reinterpret_cast<const NativeHeader*>(data);
+    if (m_header->version != kNativeVersion) {
+        THROW(Iex::IoExc, "MappedLeafTable - Unknown version " 
+                          << m_header->version);
+    }
+    u8 value_class, value_sign;
+    valueType(value_class, value_sign);
+    if (m_header->value_size != sizeof(T) || 
+        m_header->value_class != value_class ||
+        m_header->value_sign != value_sign ||
+        m_header->record_size != sizeof(Record)) {
+        THROW(Iex::IoExc, "MappedLeafTable - Voxel type does not match");
+    }
+
+    // every section has to lie within the file
+    if (m_header->records_offset + 
+            m_header->leaf_count * sizeof(Record) > size ||
+        m_header->bitfields_offset + m_header->bitfields_bytes > size ||
+        m_header->voxels_offset + m_header->voxel_count * sizeof(T) > size ||
+        m_header->metadata_offset + m_header->metadata_bytes > size) {
+        THROW(Iex::IoExc, "MappedLeafTable - File is truncated");
+    }
+
+    m_records   = reinterpret_cast<const Record*>(
+                      data + m_header->records_offset);
+    m_bitfields = data + m_header->bitfields_offset;
+    m_voxels    = reinterpret_cast<const T*>(data + m_header->voxels_offset);
+
+    // and so does every leaf
+    for (size_t n = 0; n < size_t(m_header->leaf_count); ++n) {
+        const Record &record = m_records[n];
+        if (record.type != LEAF_TYPE_CELL) continue;
+
+        u64 bitfield_bytes = HDF5LeafTable<T>::bitFieldBytes(record);
+        if (record.bitfield_offset + bitfield_bytes > 
+                m_header->bitfields_bytes ||
+            record.voxel_offset + record.voxel_count > 
+                m_header->voxel_count) {
+            THROW(Iex::IoExc, "MappedLeafTable - Leaf " << n 
+                              << " is out of range");
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline size_t
+MappedLeafTable<T>::size() const
+{
+    return m_header->leaf_count;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const typename MappedLeafTable<T>::Record&
+MappedLeafTable<T>::operator[](size_t leaf) const
+{
+    assert(leaf < size());
+    return m_records[leaf];
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const u8*
+MappedLeafTable<T>::bitfields() const
+{
+    return m_bitfields;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const T*
+MappedLeafTable<T>::voxels() const
+{
+    return m_voxels;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const NativeHeader&
+MappedLeafTable<T>::header() const
+{
+    return *m_header;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline T
+MappedLeafTable<T>::defaultValue() const
+{
+    T value;
+    memcpy(&value, m_header->default_value, sizeof(T));
+    return value;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline std::string
+MappedLeafTable<T>::metadata() const
+{
+    const char *begin = reinterpret_cast<const char*>(
+        m_file->data() + m_header->metadata_offset);
+    return std::string(begin, begin + m_header->metadata_bytes);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const MappedFile::shared_ptr&
+MappedLeafTable<T>::file() const
+{
+    return m_file;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+MappedLeafTable<T>::write(std::ostream &os, const HDF5LeafTable<T> &table,
+                          const T &default_value, u8 lg_branching_factor,
+                          u8 lg_cell_dim, const std::string &metadata)
+{
+    if (sizeof(T) > sizeof(NativeHeader().default_value)) {
+        THROW(Iex::ArgExc, "MappedLeafTable - Voxel type is too large");
+    }
+
+    // lay the sections out one after the other
+    NativeHeader header;
+    memset(&header, 0, sizeof(NativeHeader));
+    memcpy(header.magic, "nkhive\0\0", 8);
+    header.version             = kNativeVersion;
+    header.value_size          = sizeof(T);
+    valueType(header.value_class, header.value_sign);
+    header.record_size         = sizeof(Record);
+    header.lg_branching_factor = lg_branching_factor;
+    header.lg_cell_dim         = lg_cell_dim;
+    header.leaf_count          = table.size();
+    header.records_offset      = align(sizeof(NativeHeader));
+    header.bitfields_offset    = align(header.records_offset + 
+                                       table.size() * sizeof(Record));
+    header.bitfields_bytes     = table.bitfields().size();
+    header.voxels_offset       = align(header.bitfields_offset + 
+                                       header.bitfields_bytes);
+    header.voxel_count         = table.voxels().size();
+    header.metadata_offset     = align(header.voxels_offset + 
+                                       header.voxel_count * sizeof(T));
+    header.metadata_bytes      = metadata.size();
+    memcpy(header.default_value, &default_value, sizeof(T));
+
+    u64 offset = sizeof(NativeHeader);
+    os.write(reinterpret_cast<const char*>(&header), sizeof(NativeHeader));
+
+    pad(os, offset, header.records_offset);
+    if (table.size()) {
+        os.write(reinterpret_cast<const char*>(&table[0]), 
+                 table.size() * sizeof(Record));
+    }
+
+    offset = header.records_offset + table.size() * sizeof(Record);
+    pad(os, offset, header.bitfields_offset);
+    if (header.bitfields_bytes) {
+        os.write(reinterpret_cast<const char*>(&table.bitfields()[0]),
+                 header.bitfields_bytes);
+    }
+
+    offset = header.bitfields_offset + header.bitfields_bytes;
+    pad(os, offset, header.voxels_offset);
+    if (header.voxel_count) {
+        os.write(reinterpret_cast<const char*>(&table.voxels()[0]),
+                 header.voxel_count * sizeof(T));
+    }
+
+    offset = header.voxels_offset + header.voxel_count * sizeof(T);
+    pad(os, offset, header.metadata_offset);
+    os.write(metadata.data(), metadata.size());
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+MappedLeafTable<T>::valueType(u8 &value_class, u8 &value_sign)
+{
+    HDF5Id type_id = TypeToHDF5Type<T>::type();
+    H5T_class_t type_class = H5Tget_class(type_id);
+
+    // only integers have a sign, asking any other type fails
+    value_class = u8(type_class);
+    value_sign  = (type_class == H5T_INTEGER) ? u8(H5Tget_sign(type_id)) : 0;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline u64
+MappedLeafTable<T>::align(u64 offset)
+{
+    return (offset + kNativeAlignment - 1) & ~(kNativeAlignment - 1);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+MappedLeafTable<T>::pad(std::ostream &os, u64 from, u64 to)
+{
+    static const char zeros[kNativeAlignment] = { 0 };
+    os.write(zeros, to - from);
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,275 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// StreamLeafIndex.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_IO_STREAMLEAFINDEX_H__
+#define __NKHIVE_IO_STREAMLEAFINDEX_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#include <nkbase/Exceptions.h>
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkhive/io/hdf5/HDF5Util.h>
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Tree stream version. Version 1 is the older recursive dump of the nodes,
+ * which starts without a header.
+ */
+const u32 kStreamVersion = 2;
+
+/**
+ * Header at the start of an indexed tree stream. The bytes of the leaves
+ * follow one after the other, then the table of contents holding a record
+ * per leaf. Offsets are in bytes from the start of the header.
+ */
+struct StreamHeader
+{
+    char magic[8];            // "nkhvtree"
+    u32  version;
+    u32  value_size;          // sizeof the voxel type
+    u32  record_size;         // sizeof a leaf record
+    u8   lg_branching_factor;
+    u8   lg_cell_dim;
+    u8   pad[2];
+    u64  leaf_count;
+    u64  toc_offset;
+    u8   default_value[16];   // first value_size bytes are used
+};
+
+//------------------------------------------------------------------------------
+// interface
+//------------------------------------------------------------------------------
+
+/**
+ * Stream buffer reading the bytes of a leaf in place.
+ */
+class LeafStreamBuf : public std::streambuf
+{
+
+public:
+
+    LeafStreamBuf(const char *data, size_t size)
+    {
+        char *begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * Table of contents of an indexed tree stream, along with the bytes of the
+ * leaves read from it. Cells are stored as written by Cell::write(), fill 
+ * nodes only have their record.
+ */
+template <typename T>
+class StreamLeafIndex
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // types
+    //--------------------------------------------------------------------------
+
+    struct Record
+    {
+        u8         quadrant;
+        u8         type;            // LeafType
+        u8         pad[2];
+        index_type level;           // level of a fill node
+        index_type offset[3];
+        T          fill_value;      // value of a fill node
+        u64        position;        // of the leaf bytes
+        u64        size;            // in bytes
+    };
+
+    //--------------------------------------------------------------------------
+    // constructors/destructors
+    //--------------------------------------------------------------------------
+
+    StreamLeafIndex();
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    /**
+     * Reads the header, the bytes of all leaves and the table of contents 
+     * one after the other, without seeking. Throws Iex::IoExc if the stream
+     * does not hold an indexed tree of this voxel type.
+     */
+    void read(std::istream &is);
+
+    /**
+     * Partial reads. readRecords() reads the header and the table of 
+     * contents only, seeking over the leaves. readLeaves() then keeps the 
+     * given leaves, in ascending order, and reads just their bytes. Leaves
+     * stored next to each other share a read. Both leave the stream past
+     * the tree.
+     */
+    void readRecords(std::istream &is);
+    void readLeaves(std::istream &is, const std::vector<size_t> &leaves);
+
+    size_t size() const;
+    const Record& operator[](size_t leaf) const;
+
+    /**
+     * Bytes of a leaf that has been read, record.size long.
+     */
+    const char* leafBytes(size_t leaf) const;
+
+    const StreamHeader& header() const;
+    T defaultValue() const;
+
+    /**
+     * Returns true if the stream holds an indexed tree at its position, 
+     * which is left unchanged.
+     */
+    static bool isIndexed(std::istream &is);
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Read and validate the header and the table of contents.
+     */
+    void readHeader(std::istream &is);
+    void readToc(std::istream &is);
+
+    /**
+     * Throws if the bytes of a record lie outside of the given range.
+     */
+    void checkRecord(size_t leaf, u64 begin, u64 end) const;
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    StreamHeader        m_header;
+    std::vector<Record> m_records;
+    std::vector<char>   m_bytes;
+    std::streampos      m_start;
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * Writes an indexed tree stream. The bytes of each leaf are written to 
+ * stream() between beginLeaf() and endLeaf(), finish() appends the table of
+ * contents and completes the header. The stream has to tell its position.
+ */
+template <typename T>
+class StreamLeafWriter
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // types
+    //--------------------------------------------------------------------------
+
+    typedef typename StreamLeafIndex<T>::Record Record;
+
+    //--------------------------------------------------------------------------
+    // constructors/destructors
+    //--------------------------------------------------------------------------
+
+    /**
+     * Writes a header to be completed by finish().
+     */
+    StreamLeafWriter(std::ostream &os, const T &default_value,
+                     u8 lg_branching_factor, u8 lg_cell_dim);
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    std::ostream& stream();
+
+    void beginLeaf(LeafType type, index_type level, size_t quadrant, 
+                   const index_vec &offset, const T &fill_value);
+    void endLeaf();
+
+    void finish();
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Bytes written since the start of the header.
+     */
+    u64 position();
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    std::ostream        &m_os;
+    std::streampos       m_start;
+    StreamHeader         m_header;
+    std::vector<Record>  m_records;
+};
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+#include <nkhive/io/StreamLeafIndex.hpp>
+
+END_NKHIVE_NS
+
+#endif // __NKHIVE_IO_STREAMLEAFINDEX_H__
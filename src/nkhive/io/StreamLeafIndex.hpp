@@ -0,0 +1,379 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// StreamLeafIndex.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// StreamLeafIndex implementation
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline
+StreamLeafIndex<T>::StreamLeafIndex() :
+    m_start(0)
+{
+    memset(&m_header, 0, sizeof(StreamHeader));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+StreamLeafIndex<T>::read(std::istream &is)
+{
+    readHeader(is);
+
+    // the leaves lie between the header and the table of contents
+    m_bytes.resize(m_header.toc_offset - sizeof(StreamHeader));
+    if (!m_bytes.empty()) {
+        is.read(&m_bytes[0], m_bytes.size());
+    }
+    readToc(is);
+
+    for (size_t n = 0; n < m_records.size(); ++n) {
+        checkRecord(n, sizeof(StreamHeader), m_header.toc_offset);
+        m_records[n].position -= sizeof(StreamHeader);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+StreamLeafIndex<T>::readRecords(std::istream &is)
+{
+    m_start = is.tellg();
+    if (m_start == std::streampos(-1)) {
+        THROW(Iex::IoExc, "StreamLeafIndex - Stream is not seekable");
+    }
+
+    readHeader(is);
+    is.seekg(m_start + std::streamoff(m_header.toc_offset));
+    readToc(is);
+
+    m_bytes.clear();
+    for (size_t n = 0; n < m_records.size(); ++n) {
+        checkRecord(n, sizeof(StreamHeader), m_header.toc_offset);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+StreamLeafIndex<T>::readLeaves(std::istream &is, 
+                               const std::vector<size_t> &leaves)
+{
+    std::vector<Record> records;
+    records.reserve(leaves.size());
+
+    u64 bytes = 0;
+    for (size_t n = 0; n < leaves.size(); ++n) {
+        records.push_back((*this)[leaves[n]]);
+        bytes += records.back().size;
+    }
+    m_bytes.resize(bytes);
+
+    // read runs of leaves stored next to each other at once
+    u64 offset = 0;
+    size_t n = 0;
+    while (n < records.size()) {
+        u64 begin = records[n].position;
+        u64 end   = begin;
+        size_t last = n;
+        while (last < records.size() && records[last].position == end) {
+            records[last].position = offset + (end - begin);
+            end += records[last].size;
+            ++last;
+        }
+
+        if (end > begin) {
+            is.seekg(m_start + std::streamoff(begin));
+            is.read(&m_bytes[offset], end - begin);
+            if (!is) {
+                THROW(Iex::IoExc, "StreamLeafIndex - Stream is truncated");
+            }
+        }
+        offset += end - begin;
+        n = last;
+    }
+
+    // leave the stream past the tree
+    is.seekg(m_start + std::streamoff(m_header.toc_offset + 
+                                      m_header.leaf_count * sizeof(Record)));
+    m_records.swap(records);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline size_t
+StreamLeafIndex<T>::size() const
+{
+    return m_records.size();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const typename StreamLeafIndex<T>::Record&
+StreamLeafIndex<T>::operator[](size_t leaf) const
+{
+    assert(leaf < size());
+    return m_records[leaf];
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const char*
+StreamLeafIndex<T>::leafBytes(size_t leaf) const
+{
+    const Record &record = (*this)[leaf];
+    return record.size ? &m_bytes[record.position] : NULL;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const StreamHeader&
+StreamLeafIndex<T>::header() const
+{
+    return m_header;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline T
+StreamLeafIndex<T>::defaultValue() const
+{
+    T value;
+    memcpy(&value, m_header.default_value, sizeof(T));
+    return value;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline bool
+StreamLeafIndex<T>::isIndexed(std::istream &is)
+{
+    char magic[8];
+
+    std::streampos start = is.tellg();
+    if (start != std::streampos(-1)) {
+        is.read(magic, sizeof(magic));
+        bool indexed = is.gcount() == sizeof(magic) && 
+                       memcmp(magic, "nkhvtree", 8) == 0;
+        is.clear();
+        is.seekg(start);
+        return indexed;
+    }
+
+    // without seeking, look ahead within the buffered input only. Streams 
+    // too short to tell are taken to be of the current version
+    std::streambuf *buf = is.rdbuf();
+    if (is.peek() == std::char_traits<char>::eof()) return true;
+    if (buf->in_avail() < std::streamsize(sizeof(magic))) return true;
+
+    buf->sgetn(magic, sizeof(magic));
+    for (size_t n = sizeof(magic); n > 0; --n) {
+        buf->sungetc();
+    }
+    return memcmp(magic, "nkhvtree", 8) == 0;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+StreamLeafIndex<T>::readHeader(std::istream &is)
+{
+    is.read(reinterpret_cast<char*>(&m_header), sizeof(StreamHeader));
+    if (!is || memcmp(m_header.magic, "nkhvtree", 8) != 0) {
+        THROW(Iex::IoExc, "StreamLeafIndex - Not an indexed tree stream");
+    }
+    if (m_header.version != kStreamVersion) {
+        THROW(Iex::IoExc, "StreamLeafIndex - Unknown version " 
+                          << m_header.version);
+    }
+    if (m_header.value_size != sizeof(T) || 
+        m_header.record_size != sizeof(Record)) {
+        THROW(Iex::IoExc, "StreamLeafIndex - Voxel type does not match");
+    }
+    if (m_header.toc_offset < sizeof(StreamHeader)) {
+        THROW(Iex::IoExc, "StreamLeafIndex - Invalid table of contents");
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+StreamLeafIndex<T>::readToc(std::istream &is)
+{
+    m_records.resize(m_header.leaf_count);
+    if (!m_records.empty()) {
+        is.read(reinterpret_cast<char*>(&m_records[0]), 
+                m_records.size() * sizeof(Record));
+    }
+    if (!is) {
+        THROW(Iex::IoExc, "StreamLeafIndex - Stream is truncated");
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+StreamLeafIndex<T>::checkRecord(size_t leaf, u64 begin, u64 end) const
+{
+    const Record &record = m_records[leaf];
+    if ((record.type != LEAF_TYPE_CELL && record.size != 0) ||
+        record.position < begin || record.position > end || 
+        record.size > end - record.position) {
+        THROW(Iex::IoExc, "StreamLeafIndex - Leaf " << leaf 
+                          << " is out of range");
+    }
+}
+
+//------------------------------------------------------------------------------
+// StreamLeafWriter implementation
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline
+StreamLeafWriter<T>::StreamLeafWriter(std::ostream &os, 
+                                      const T &default_value,
+                                      u8 lg_branching_factor,
+                                      u8 lg_cell_dim) :
+    m_os(os),
+    m_start(os.tellp())
+{
+    if (sizeof(T) > sizeof(StreamHeader().default_value)) {
+        THROW(Iex::ArgExc, "StreamLeafWriter - Voxel type is too large");
+    }
+    if (m_start == std::streampos(-1)) {
+        THROW(Iex::IoExc, "StreamLeafWriter - Stream is not seekable");
+    }
+
+    memset(&m_header, 0, sizeof(StreamHeader));
+    memcpy(m_header.magic, "nkhvtree", 8);
+    m_header.version             = kStreamVersion;
+    m_header.value_size          = sizeof(T);
+    m_header.record_size         = sizeof(Record);
+    m_header.lg_branching_factor = lg_branching_factor;
+    m_header.lg_cell_dim         = lg_cell_dim;
+    memcpy(m_header.default_value, &default_value, sizeof(T));
+
+    // the counts are filled in by finish()
+    m_os.write(reinterpret_cast<const char*>(&m_header), 
+               sizeof(StreamHeader));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline std::ostream&
+StreamLeafWriter<T>::stream()
+{
+    return m_os;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+StreamLeafWriter<T>::beginLeaf(LeafType type, index_type level, 
+                               size_t quadrant, const index_vec &offset,
+                               const T &fill_value)
+{
+    Record record = Record();
+    record.quadrant   = quadrant;
+    record.type       = type;
+    record.level      = level;
+    record.offset[0]  = offset[0];
+    record.offset[1]  = offset[1];
+    record.offset[2]  = offset[2];
+    record.fill_value = fill_value;
+    record.position   = position();
+    m_records.push_back(record);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+StreamLeafWriter<T>::endLeaf()
+{
+    Record &record = m_records.back();
+    record.size = position() - record.position;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+StreamLeafWriter<T>::finish()
+{
+    m_header.leaf_count = m_records.size();
+    m_header.toc_offset = position();
+
+    if (!m_records.empty()) {
+        m_os.write(reinterpret_cast<const char*>(&m_records[0]), 
+                   m_records.size() * sizeof(Record));
+    }
+
+    // patch the header and move back past the table of contents
+    std::streampos end = m_os.tellp();
+    m_os.seekp(m_start);
+    m_os.write(reinterpret_cast<const char*>(&m_header), 
+               sizeof(StreamHeader));
+    m_os.seekp(end);
+
+    if (!m_os) {
+        THROW(Iex::IoExc, "StreamLeafWriter - Failed to write the stream");
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline u64
+StreamLeafWriter<T>::position()
+{
+    return u64(m_os.tellp() - m_start);
+}
@@ -84,10 +84,28 @@ public:
     ~VolumeFile();
 
     /**
-     * Read volume from HDF5 file
+     * Read volume from HDF5 file. Cells are decoded on num_threads threads
+     * (0 for one per core).
      */
-    template <typename V> typename V::shared_ptr read(String &name);
-    template <typename V> typename V::shared_ptr read(u32 index = 0);
+    template <typename V> 
+    typename V::shared_ptr read(String &name, size_t num_threads = 1);
+    template <typename V> 
+    typename V::shared_ptr read(u32 index = 0, size_t num_threads = 1);
+
+    /**
+     * Read only the part of the named volume intersecting roi, see 
+     * Volume::read(). The leaves outside of it are not loaded.
+     */
+    template <typename V> 
+    typename V::shared_ptr read(String &name, 
+                                const signed_index_bounds &roi);
+
+    /**
+     * Read volume with its voxels paged in on access, see 
+     * Volume::readLazy().
+     */
+    template <typename V> 
+    typename V::shared_ptr readLazy(size_t memory_budget, u32 index = 0);
 
     /**
      * Determine number of volumes in file
@@ -97,13 +115,25 @@ public:
     /**
      * Read volume from stream.
      */
-    template <typename V> typename V::shared_ptr read(std::istream &is);
+    template <typename V> 
+    typename V::shared_ptr read(std::istream &is, size_t num_threads = 1);
     
 
     /**
-     * Write volume to HDF5 file
+     * Write volume to HDF5 file. Leaf groups is the older, slower layout.
+     * The leaves of the leaf table are encoded on num_threads threads (0 for
+     * one per core).
+     */
+    template <typename V> 
+    void write(const V &volume, HDF5Layout layout = HDF5_LAYOUT_LEAF_TABLE,
+               size_t num_threads = 1);
+
+    /**
+     * Save volume over its copy in the file, rewriting only the leaves
+     * modified since it was read or last saved this way, see 
+     * Volume::writeIncremental(). The file has to be opened READ_WRITE.
      */
-    template <typename V> void write(const V &volume);
+    template <typename V> void writeIncremental(V &volume);
 
     /**
      * Write volume to stream.
@@ -120,15 +150,17 @@ protected:
      * Helper for reading a volume
      */
     template <typename V>
-    typename V::shared_ptr readInternal(String &volume_name);
+    typename V::shared_ptr readInternal(String &volume_name, 
+                                        size_t num_threads);
     template <typename V>
-    typename V::shared_ptr readInternal(u32 index = 0);
+    typename V::shared_ptr readInternal(u32 index, size_t num_threads);
 
     /**
      * Helper for writing out a volume
      */
     template <typename V>
-    void writeInternal(const V &volume);
+    void writeInternal(const V &volume, HDF5Layout layout, 
+                       size_t num_threads);
 
     //-------------------------------------------------------------------------
     // friends
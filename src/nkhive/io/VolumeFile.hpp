@@ -65,16 +65,16 @@ VolumeFile::~VolumeFile()
 
 template <typename V>
 inline typename V::shared_ptr
-VolumeFile::read(String &volume_name)
+VolumeFile::read(String &volume_name, size_t num_threads)
 {
-    return readInternal<V>(volume_name); 
+    return readInternal<V>(volume_name, num_threads); 
 }
 
 //------------------------------------------------------------------------------
 
 template <typename V>
 inline typename V::shared_ptr
-VolumeFile::read(std::istream &is) 
+VolumeFile::read(std::istream &is, size_t num_threads) 
 {
     // read void header  
     VoidFile::read(is);
@@ -90,7 +90,7 @@ VolumeFile::read(std::istream &is)
 
     // read in the volume
     typename V::shared_ptr volume(new V());
-    volume->read(is);
+    volume->read(is, num_threads);
 
     return volume;
 }
@@ -116,9 +116,41 @@ VolumeFile::write(std::ostream &os, const V &volume)
 
 template <typename V>
 inline typename V::shared_ptr
-VolumeFile::read(u32 index)
+VolumeFile::read(u32 index, size_t num_threads)
 {
-    return readInternal<V>(index); 
+    return readInternal<V>(index, num_threads); 
+}
+
+//------------------------------------------------------------------------------
+
+template <typename V>
+inline typename V::shared_ptr
+VolumeFile::read(String &name, const signed_index_bounds &roi)
+{
+    // read void header
+    VoidFile::read();
+
+    // read in the intersecting part of the volume
+    typename V::shared_ptr volume(new V());
+    volume->read(m_id, name, roi);
+
+    return volume;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename V>
+inline typename V::shared_ptr
+VolumeFile::readLazy(size_t memory_budget, u32 index)
+{
+    // read void header
+    VoidFile::read();
+
+    // read in the leaf index of the volume
+    typename V::shared_ptr volume(new V());
+    volume->readLazy(m_id, memory_budget, index);
+
+    return volume;
 }
 
 //------------------------------------------------------------------------------
@@ -136,23 +168,36 @@ VolumeFile::numVolumes() const
 
 template <typename V>
 inline void 
-VolumeFile::write(const V& volume)
+VolumeFile::write(const V& volume, HDF5Layout layout, size_t num_threads)
+{
+    writeInternal(volume, layout, num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename V>
+inline void 
+VolumeFile::writeIncremental(V &volume)
 {
-    writeInternal(volume); 
+    // write out void header  
+    VoidFile::write();
+
+    // save the modified leaves of the volume
+    volume.writeIncremental(m_id);
 }
 
 //------------------------------------------------------------------------------
 
 template <typename V>
 inline typename V::shared_ptr
-VolumeFile::readInternal(String &volume_name) 
+VolumeFile::readInternal(String &volume_name, size_t num_threads) 
 {
     // read void header
     VoidFile::read();
 
     // read in the volume
     typename V::shared_ptr volume(new V());
-    volume->read(m_id, volume_name);
+    volume->read(m_id, volume_name, num_threads);
 
     return volume;
 }
@@ -161,14 +206,14 @@ VolumeFile::readInternal(String &volume_name)
 
 template <typename V>
 inline typename V::shared_ptr
-VolumeFile::readInternal(u32 index) 
+VolumeFile::readInternal(u32 index, size_t num_threads) 
 {
     // read void header
     VoidFile::read();
 
     // read in the volume
     typename V::shared_ptr volume(new V());
-    volume->read(m_id, index);
+    volume->read(m_id, index, num_threads);
 
     return volume;
 }
@@ -177,13 +222,14 @@ VolumeFile::readInternal(u32 index)
 
 template <typename V>
 inline void 
-VolumeFile::writeInternal(const V& volume)
+VolumeFile::writeInternal(const V& volume, HDF5Layout layout, 
+                          size_t num_threads)
 {
     // write out void header  
     VoidFile::write();
 
     // write out the volume
-    volume.write(m_id);
+    volume.write(m_id, layout, num_threads);
 }
 
 //------------------------------------------------------------------------------
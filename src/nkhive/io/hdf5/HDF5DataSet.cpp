@@ -39,6 +39,7 @@
 
 #include <nkbase/Exceptions.h>
 #include <nkhive/io/hdf5/HDF5DataSet.h>
+#include <nkhive/io/hdf5/HDF5DataSpace.h>
 
 BEGIN_NKHIVE_NS
 
@@ -64,10 +65,10 @@ HDF5DataSet::~HDF5DataSet()
 
 void
 HDF5DataSet::create(HDF5Id location_id, const String &name,
-                    HDF5Id type_id, HDF5Id space_id)
+                    HDF5Id type_id, HDF5Id space_id, HDF5Id create_props_id)
 {
     m_id = H5Dcreate(location_id, name.c_str(), type_id, space_id,
-                     H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+                     H5P_DEFAULT, create_props_id, H5P_DEFAULT);
 }
 
 //------------------------------------------------------------------------------
@@ -113,4 +114,31 @@ HDF5DataSet::read(HDF5Id mem_type_id, void *data) const
 
 //------------------------------------------------------------------------------
 
+void
+HDF5DataSet::read(HDF5Id mem_type_id, HDF5Size offset, HDF5Size count,
+                  void *data) const
+{
+    HDF5DataSpace file_space;
+    file_space.open(m_id);
+
+    HDF5Err res = H5Sselect_hyperslab(file_space.id(), H5S_SELECT_SET, 
+                                      &offset, NULL, &count, NULL);
+    if (res < 0) {
+        THROW(Iex::IoExc, "Could not select range of data set with id " 
+                          << m_id);
+    }
+
+    HDF5DataSpace mem_space;
+    mem_space.createSimple(1, &count, NULL);
+
+    res = H5Dread(m_id, mem_type_id, mem_space.id(), file_space.id(), 
+                  H5P_DEFAULT, data); 
+
+    if (res < 0) {
+        THROW(Iex::IoExc, "Could not read data set with id " << m_id);
+    }
+}
+
+//------------------------------------------------------------------------------
+
 END_NKHIVE_NS
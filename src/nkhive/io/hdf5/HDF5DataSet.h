@@ -66,11 +66,18 @@ public:
     //--------------------------------------------------------------------------
     
     void create(HDF5Id location_id, const String &name,
-                HDF5Id type_id, HDF5Id space_id);
+                HDF5Id type_id, HDF5Id space_id, 
+                HDF5Id create_props_id = H5P_DEFAULT);
 
     void open(HDF5Id location_id, const String &name);
 
     void read(HDF5Id mem_type_id, void *data) const;
+
+    /**
+     * Reads count elements from offset of a one dimensional data set.
+     */
+    void read(HDF5Id mem_type_id, HDF5Size offset, HDF5Size count,
+              void *data) const;
     void write(HDF5Id mem_type_id, const void *data) const;
 };
 
@@ -83,4 +83,16 @@ HDF5DataSpace::createSimple(i32 rank,
     }
 }
 
+//------------------------------------------------------------------------------
+
+void
+HDF5DataSpace::open(HDF5Id data_set_id)
+{
+    m_id = H5Dget_space(data_set_id);
+    if (!isValid()) {
+        THROW(Iex::IoExc, "Couldn't open data space of data set with id "
+                          << data_set_id);
+    }
+}
+
 END_NKHIVE_NS
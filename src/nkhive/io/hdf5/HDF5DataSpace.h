@@ -67,6 +67,11 @@ public:
     void createScalar();
     void createSimple(i32 rank, const HDF5Size *dims, const HDF5Size *maxdims);
 
+    /**
+     * Opens a copy of the data space of a data set.
+     */
+    void open(HDF5Id data_set_id);
+
 };
 
 END_NKHIVE_NS
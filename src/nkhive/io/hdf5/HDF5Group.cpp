@@ -39,6 +39,7 @@
 
 #include <nkhive/io/hdf5/HDF5Group.h>
 #include <nkhive/io/hdf5/HDF5Property.h>
+#include <nkhive/io/hdf5/HDF5Util.h>
 #include <nkbase/Exceptions.h>
 
 BEGIN_NKHIVE_NS
@@ -163,8 +164,10 @@ HDF5Group::deleteSubtree(HDF5Id group_id, const char *group_name,
 
     // iterate over the group's children
     HDF5Size iter_index = 0;
+    HDF5CallbackGuard guard(NULL);
     H5Literate(child_group.id(), H5_INDEX_CRT_ORDER, H5_ITER_NATIVE, 
-               &iter_index, deleteSubtree, NULL);
+               &iter_index, hdf5Guarded<H5L_info_t, deleteSubtree>, &guard);
+    guard.rethrow();
 
     // close the child group
     child_group.close();
@@ -0,0 +1,193 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// HDF5LeafTable.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_IO_HDF5_HDF5LEAFTABLE_H__
+#define __NKHIVE_IO_HDF5_HDF5LEAFTABLE_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+#include <nkbase/Exceptions.h>
+#include <nkhive/Types.h>
+#include <nkhive/bitfields/BitOps.h>
+#include <nkhive/io/hdf5/HDF5DataSet.h>
+#include <nkhive/io/hdf5/HDF5Util.h>
+#include <nkhive/io/hdf5/HDF5DataType.h>
+
+//------------------------------------------------------------------------------
+// interface
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * In memory image of the leaf table layout. Every leaf of a tree is one
+ * record, bitfields and voxels of all cells are concatenated into two flat
+ * arrays the records point into. Each array is one data set in the file.
+ */
+template <typename T>
+class HDF5LeafTable
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // types
+    //--------------------------------------------------------------------------
+
+    struct Record
+    {
+        u8         quadrant;
+        u8         type;            // LeafType
+        u8         flags;           // cell flags
+        u8         lg_dim;          // lg size of the cell bitfield
+        index_type level;           // level of a fill node
+        index_type offset[3];
+        T          default_value;
+        T          fill_value;
+        u64        bitfield_offset; // in bytes
+        u64        voxel_offset;    // in voxels
+        u64        voxel_count;
+    };
+
+    //--------------------------------------------------------------------------
+    // constructors/destructors
+    //--------------------------------------------------------------------------
+
+    HDF5LeafTable();
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    /**
+     * Appends an empty record and returns it.
+     */
+    Record& append();
+
+    /**
+     * Appends all leaves of that table, pointing them into the arrays of 
+     * this one.
+     */
+    void append(const HDF5LeafTable &that);
+
+    size_t size() const;
+    const Record& operator[](size_t leaf) const;
+
+    /**
+     * Concatenated bitfield bytes and voxels of all cells.
+     */
+    std::vector<u8>& bitfields();
+    const std::vector<u8>& bitfields() const;
+    std::vector<T>& voxels();
+    const std::vector<T>& voxels() const;
+
+    /**
+     * Read and write the three data sets under the given group, optionally
+     * chunked and filtered. The voxels may be left on disk, to be read per
+     * leaf through the voxel data set.
+     */
+    void read(HDF5Id parent_id, bool read_voxels = true);
+    void write(HDF5Id parent_id, 
+               const HDF5Compression &compression = HDF5Compression()) const;
+
+    /**
+     * Partial reads. readRecords() reads the records only, readLeaves() then
+     * keeps the given leaves, in ascending order, and reads just their 
+     * bitfields and voxels. Leaves stored next to each other share a read.
+     */
+    void readRecords(HDF5Id parent_id);
+    void readLeaves(HDF5Id parent_id, const std::vector<size_t> &leaves);
+
+    /**
+     * Size in bytes of the bitfield of a cell record.
+     */
+    static u64 bitFieldBytes(const Record &record);
+
+private:
+
+    //--------------------------------------------------------------------------
+    // types
+    //--------------------------------------------------------------------------
+
+    typedef std::pair<u64, u64>  Range;   // offset, count
+    typedef std::vector<Range>   Ranges;
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Builds the native compound type matching Record.
+     */
+    static void createRecordType(HDF5DataType &record_type);
+
+    /**
+     * Appends count elements at offset to the ranges, merging it with the
+     * last range if they touch.
+     */
+    static void appendRange(Ranges &ranges, u64 offset, u64 count);
+
+    /**
+     * Reads the ranges of the named data set one after the other into data.
+     */
+    template <typename U>
+    static void readRanges(HDF5Id parent_id, const String &name,
+                           HDF5Id mem_type_id, const Ranges &ranges,
+                           std::vector<U> &data);
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    std::vector<Record> m_records;
+    std::vector<u8>     m_bitfields;
+    std::vector<T>      m_voxels;
+};
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+#include <nkhive/io/hdf5/HDF5LeafTable.hpp>
+
+END_NKHIVE_NS
+
+#endif // __NKHIVE_IO_HDF5_HDF5LEAFTABLE_H__
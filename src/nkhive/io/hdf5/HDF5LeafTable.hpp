@@ -0,0 +1,376 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// HDF5LeafTable.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline
+HDF5LeafTable<T>::HDF5LeafTable() :
+    m_records(),
+    m_bitfields(),
+    m_voxels()
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline typename HDF5LeafTable<T>::Record&
+HDF5LeafTable<T>::append()
+{
+    m_records.push_back(Record());
+    return m_records.back();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+HDF5LeafTable<T>::append(const HDF5LeafTable &that)
+{
+    u64 bitfield_offset = m_bitfields.size();
+    u64 voxel_offset    = m_voxels.size();
+
+    size_t first = m_records.size();
+    m_records.insert(m_records.end(), that.m_records.begin(), 
+                     that.m_records.end());
+    for (size_t n = first; n < m_records.size(); ++n) {
+        if (m_records[n].type != LEAF_TYPE_CELL) continue;
+        m_records[n].bitfield_offset += bitfield_offset;
+        m_records[n].voxel_offset    += voxel_offset;
+    }
+
+    m_bitfields.insert(m_bitfields.end(), that.m_bitfields.begin(),
+                       that.m_bitfields.end());
+    m_voxels.insert(m_voxels.end(), that.m_voxels.begin(), 
+                    that.m_voxels.end());
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline size_t
+HDF5LeafTable<T>::size() const
+{
+    return m_records.size();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const typename HDF5LeafTable<T>::Record&
+HDF5LeafTable<T>::operator[](size_t leaf) const
+{
+    assert(leaf < m_records.size());
+    return m_records[leaf];
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline std::vector<u8>&
+HDF5LeafTable<T>::bitfields()
+{
+    return m_bitfields;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const std::vector<u8>&
+HDF5LeafTable<T>::bitfields() const
+{
+    return m_bitfields;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline std::vector<T>&
+HDF5LeafTable<T>::voxels()
+{
+    return m_voxels;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const std::vector<T>&
+HDF5LeafTable<T>::voxels() const
+{
+    return m_voxels;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+HDF5LeafTable<T>::read(HDF5Id parent_id, bool read_voxels)
+{
+    readRecords(parent_id);
+
+    // empty data sets are not written out
+    if (H5Lexists(parent_id, kLeafBitFieldsName.c_str(), H5P_DEFAULT) > 0) {
+        m_bitfields.resize(
+            getDataSetNumElements(parent_id, kLeafBitFieldsName));
+        readSimpleDataSet(parent_id, kLeafBitFieldsName, H5T_NATIVE_CHAR,
+                          &m_bitfields[0]);
+    }
+
+    u64 num_voxels = 0;
+    if (H5Lexists(parent_id, kLeafVoxelsName.c_str(), H5P_DEFAULT) > 0) {
+        num_voxels = getDataSetNumElements(parent_id, kLeafVoxelsName);
+        if (read_voxels) {
+            m_voxels.resize(num_voxels);
+            readSimpleDataSet(parent_id, kLeafVoxelsName,
+                              TypeToHDF5Type<T>::type(), &m_voxels[0]);
+        }
+    }
+
+    // make sure the records stay within the arrays
+    for (size_t n = 0; n < m_records.size(); ++n) {
+        const Record &record = m_records[n];
+        if (record.voxel_offset + record.voxel_count > num_voxels ||
+            record.bitfield_offset > m_bitfields.size()) {
+            THROW(Iex::IoExc, "HDF5LeafTable - Leaf " << n 
+                              << " is out of range");
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+HDF5LeafTable<T>::write(HDF5Id parent_id, 
+                        const HDF5Compression &compression) const
+{
+    if (!m_records.empty()) {
+        HDF5DataType record_type;
+        createRecordType(record_type);
+
+        HDF5Size count = m_records.size();
+        writeSimpleDataSet(parent_id, kLeafTableName, 1, &count,
+                           record_type.id(), &m_records[0], compression);
+    }
+
+    if (!m_bitfields.empty()) {
+        HDF5Size count = m_bitfields.size();
+        writeSimpleDataSet(parent_id, kLeafBitFieldsName, 1, &count,
+                           H5T_NATIVE_CHAR, &m_bitfields[0], compression);
+    }
+
+    if (!m_voxels.empty()) {
+        HDF5Size count = m_voxels.size();
+        writeSimpleDataSet(parent_id, kLeafVoxelsName, 1, &count,
+                           TypeToHDF5Type<T>::type(), &m_voxels[0], 
+                           compression);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+HDF5LeafTable<T>::readRecords(HDF5Id parent_id)
+{
+    m_records.clear();
+    m_bitfields.clear();
+    m_voxels.clear();
+
+    // empty data sets are not written out
+    if (H5Lexists(parent_id, kLeafTableName.c_str(), H5P_DEFAULT) > 0) {
+        HDF5DataType record_type;
+        createRecordType(record_type);
+
+        m_records.resize(getDataSetNumElements(parent_id, kLeafTableName));
+        readSimpleDataSet(parent_id, kLeafTableName, record_type.id(),
+                          &m_records[0]);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+HDF5LeafTable<T>::readLeaves(HDF5Id parent_id, 
+                             const std::vector<size_t> &leaves)
+{
+    std::vector<Record> records;
+    records.reserve(leaves.size());
+
+    // keep the leaves, pointing them at where their data will be read to
+    Ranges bitfield_ranges;
+    Ranges voxel_ranges;
+    u64 bitfield_bytes = 0;
+    u64 voxel_count    = 0;
+    for (size_t n = 0; n < leaves.size(); ++n) {
+        assert(leaves[n] < m_records.size());
+        assert(n == 0 || leaves[n - 1] < leaves[n]);
+
+        Record record = m_records[leaves[n]];
+        if (record.type == LEAF_TYPE_CELL) {
+            u64 bytes = bitFieldBytes(record);
+            appendRange(bitfield_ranges, record.bitfield_offset, bytes);
+            record.bitfield_offset = bitfield_bytes;
+            bitfield_bytes += bytes;
+
+            appendRange(voxel_ranges, record.voxel_offset, 
+                        record.voxel_count);
+            record.voxel_offset = voxel_count;
+            voxel_count += record.voxel_count;
+        }
+        records.push_back(record);
+    }
+    m_records.swap(records);
+
+    readRanges(parent_id, kLeafBitFieldsName, H5T_NATIVE_CHAR, 
+               bitfield_ranges, m_bitfields);
+    readRanges(parent_id, kLeafVoxelsName, TypeToHDF5Type<T>::type(), 
+               voxel_ranges, m_voxels);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline u64
+HDF5LeafTable<T>::bitFieldBytes(const Record &record)
+{
+    return roundPow2(numBits3D(record.lg_dim), bitsof(index_type)) / 8;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+HDF5LeafTable<T>::createRecordType(HDF5DataType &record_type)
+{
+    // offsets are taken from an instance, T need not be a POD
+    Record r;
+    const char *base = reinterpret_cast<const char*>(&r);
+#define NKHIVE_RECORD_OFFSET(member) \
+    (reinterpret_cast<const char*>(&r.member) - base)
+
+    HDF5DataType offset_type;
+    HDF5Size dims[1] = { 3 };
+    offset_type.createArray(TypeToHDF5Type<index_type>::type(), 1, dims);
+
+    record_type.create(H5T_COMPOUND, sizeof(Record));
+    record_type.compoundInsert("quadrant", NKHIVE_RECORD_OFFSET(quadrant),
+                               TypeToHDF5Type<u8>::type());
+    record_type.compoundInsert("type", NKHIVE_RECORD_OFFSET(type),
+                               TypeToHDF5Type<u8>::type());
+    record_type.compoundInsert("flags", NKHIVE_RECORD_OFFSET(flags),
+                               TypeToHDF5Type<u8>::type());
+    record_type.compoundInsert("lg_dim", NKHIVE_RECORD_OFFSET(lg_dim),
+                               TypeToHDF5Type<u8>::type());
+    record_type.compoundInsert("level", NKHIVE_RECORD_OFFSET(level),
+                               TypeToHDF5Type<index_type>::type());
+    record_type.compoundInsert("offset", NKHIVE_RECORD_OFFSET(offset),
+                               offset_type.id());
+    record_type.compoundInsert("default_value",
+                               NKHIVE_RECORD_OFFSET(default_value),
+                               TypeToHDF5Type<T>::type());
+    record_type.compoundInsert("fill_value", NKHIVE_RECORD_OFFSET(fill_value),
+                               TypeToHDF5Type<T>::type());
+    record_type.compoundInsert("bitfield_offset",
+                               NKHIVE_RECORD_OFFSET(bitfield_offset),
+                               TypeToHDF5Type<u64>::type());
+    record_type.compoundInsert("voxel_offset",
+                               NKHIVE_RECORD_OFFSET(voxel_offset),
+                               TypeToHDF5Type<u64>::type());
+    record_type.compoundInsert("voxel_count", NKHIVE_RECORD_OFFSET(voxel_count),
+                               TypeToHDF5Type<u64>::type());
+
+#undef NKHIVE_RECORD_OFFSET
+}
+
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+HDF5LeafTable<T>::appendRange(Ranges &ranges, u64 offset, u64 count)
+{
+    if (count == 0) return;
+
+    if (!ranges.empty() && 
+        ranges.back().first + ranges.back().second == offset) {
+        ranges.back().second += count;
+    } else {
+        ranges.push_back(Range(offset, count));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+template <typename U>
+inline void
+HDF5LeafTable<T>::readRanges(HDF5Id parent_id, const String &name,
+                             HDF5Id mem_type_id, const Ranges &ranges,
+                             std::vector<U> &data)
+{
+    data.clear();
+    if (ranges.empty()) return;
+
+    u64 size  = getDataSetNumElements(parent_id, name);
+    u64 total = 0;
+    for (size_t n = 0; n < ranges.size(); ++n) {
+        if (ranges[n].first + ranges[n].second > size) {
+            THROW(Iex::IoExc, "HDF5LeafTable - Range of " << name 
+                              << " is out of range");
+        }
+        total += ranges[n].second;
+    }
+    data.resize(total);
+
+    HDF5DataSet data_set;
+    data_set.open(parent_id, name);
+
+    u64 position = 0;
+    for (size_t n = 0; n < ranges.size(); ++n) {
+        data_set.read(mem_type_id, ranges[n].first, ranges[n].second, 
+                      &data[position]);
+        position += ranges[n].second;
+    }
+}
+
+//------------------------------------------------------------------------------
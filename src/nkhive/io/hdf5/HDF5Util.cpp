@@ -37,15 +37,96 @@
 // includes
 //------------------------------------------------------------------------------
 
+#include <algorithm>
+#include <vector>
+
 #include <nkbase/Exceptions.h>
 #include <nkhive/io/hdf5/HDF5Util.h>
 #include <nkhive/io/hdf5/HDF5Attribute.h>
 #include <nkhive/io/hdf5/HDF5DataSpace.h>
 #include <nkhive/io/hdf5/HDF5DataType.h>
 #include <nkhive/io/hdf5/HDF5DataSet.h>
+#include <nkhive/io/hdf5/HDF5Property.h>
 
 BEGIN_NKHIVE_NS
 
+//------------------------------------------------------------------------------
+// struct and class implementation
+//------------------------------------------------------------------------------
+
+HDF5Compression::HDF5Compression(HDF5Filter f, i32 l, HDF5Size c) :
+    filter(f),
+    level(l),
+    chunk_bytes(c)
+{
+}
+
+//------------------------------------------------------------------------------
+
+HDF5CallbackGuard::HDF5CallbackGuard(void *op_data) :
+    m_op_data(op_data),
+    m_error(NULL)
+{
+}
+
+//------------------------------------------------------------------------------
+
+HDF5CallbackGuard::~HDF5CallbackGuard()
+{
+    delete m_error;
+}
+
+//------------------------------------------------------------------------------
+
+void*
+HDF5CallbackGuard::opData() const
+{
+    return m_op_data;
+}
+
+//------------------------------------------------------------------------------
+
+HDF5Err
+HDF5CallbackGuard::capture()
+{
+    // the iteration stops at the first error
+    if (m_error) {
+        return -1;
+    }
+
+    try {
+        throw;
+    } catch (const Iex::ArgExc &e) {
+        m_error = new TypedError<Iex::ArgExc>(e);
+    } catch (const Iex::InputExc &e) {
+        m_error = new TypedError<Iex::InputExc>(e);
+    } catch (const Iex::IoExc &e) {
+        m_error = new TypedError<Iex::IoExc>(e);
+    } catch (const Iex::LogicExc &e) {
+        m_error = new TypedError<Iex::LogicExc>(e);
+    } catch (const Iex::TypeExc &e) {
+        m_error = new TypedError<Iex::TypeExc>(e);
+    } catch (const Iex::BaseExc &e) {
+        m_error = new TypedError<Iex::BaseExc>(e);
+    } catch (const std::exception &e) {
+        m_error = new TypedError<Iex::IoExc>(Iex::IoExc(e.what()));
+    } catch (...) {
+        m_error = new TypedError<Iex::IoExc>(
+            Iex::IoExc("Unknown error in HDF5 callback"));
+    }
+    return -1;
+}
+
+//------------------------------------------------------------------------------
+
+void
+HDF5CallbackGuard::rethrow() const
+{
+    if (m_error) {
+        m_error->raise();
+    }
+}
+
 //------------------------------------------------------------------------------
 // interface implementation
 //------------------------------------------------------------------------------
@@ -235,6 +316,33 @@ getDataSetStorageSize(HDF5Id parent_id, const String &name)
 
 //------------------------------------------------------------------------------
 
+HDF5Size
+getDataSetNumElements(HDF5Id parent_id, const String &name)
+{
+    // open the data set
+    HDF5DataSet data_set;
+    data_set.open(parent_id, name);
+
+    if (!data_set.isValid()) {
+        THROW(Iex::IoExc, "getDataSetNumElements - Invalid data set " 
+            << name.c_str());
+    }
+
+    // count the elements of its data space
+    HDF5Id space_id = H5Dget_space(data_set.id());
+    hssize_t count = H5Sget_simple_extent_npoints(space_id);
+    H5Sclose(space_id);
+
+    if (count < 0) {
+        THROW(Iex::IoExc, "getDataSetNumElements - Invalid data space for " 
+            << name.c_str());
+    }
+
+    return count;
+}
+
+//------------------------------------------------------------------------------
+
 void
 readSimpleDataSet(HDF5Id parent_id, const String &name, HDF5Id data_type_id,
                   void *data)
@@ -264,7 +372,8 @@ readSimpleDataSet(HDF5Id parent_id, const String &name, HDF5Id data_type_id,
 
 void
 writeSimpleDataSet(HDF5Id parent_id, const String &name, i32 rank, 
-                   const HDF5Size *dims, HDF5Id data_type_id, const void *data)
+                   const HDF5Size *dims, HDF5Id data_type_id, const void *data,
+                   const HDF5Compression &compression)
 {
     // check if data type is valid
     if (data_type_id == -1) {
@@ -283,8 +392,35 @@ writeSimpleDataSet(HDF5Id parent_id, const String &name, i32 rank,
         HDF5DataSpace data_space;
         data_space.createSimple(rank, dims, dims);
 
+        // filtered data sets need chunked storage
+        HDF5Property create_props(H5P_DATASET_CREATE);
+        if (compression.filter != HDF5_FILTER_NONE && dims[0] > 0) {
+            if (!H5Zfilter_avail(H5Z_FILTER_DEFLATE)) {
+                THROW(Iex::IoExc, "writeSimpleDataSet - Deflate filter is "
+                                  "not available for " << name.c_str());
+            }
+
+            // chunk along the first dimension only
+            HDF5Size row_bytes = H5Tget_size(data_type_id);
+            for (i32 d = 1; d < rank; ++d) {
+                row_bytes *= dims[d];
+            }
+
+            std::vector<HDF5Size> chunk(dims, dims + rank);
+            chunk[0] = std::max(HDF5Size(1), 
+                                compression.chunk_bytes / row_bytes);
+            chunk[0] = std::min(chunk[0], dims[0]);
+            H5Pset_chunk(create_props.id(), rank, &chunk[0]);
+
+            if (compression.filter == HDF5_FILTER_SHUFFLE_DEFLATE) {
+                H5Pset_shuffle(create_props.id());
+            }
+            H5Pset_deflate(create_props.id(), compression.level);
+        }
+
         // create the data set
-        data_set.create(parent_id, name, data_type_id, data_space.id());
+        data_set.create(parent_id, name, data_type_id, data_space.id(),
+                        create_props.id());
     }
 
     // write the data out
@@ -323,4 +459,30 @@ constructLeafGroupName(LeafType type, u8 quadrant, index_vec offset,
 
 //------------------------------------------------------------------------------
 
+String
+filterName(HDF5Filter filter)
+{
+    switch (filter) {
+        case HDF5_FILTER_NONE:            return String("none");
+        case HDF5_FILTER_DEFLATE:         return String("deflate");
+        case HDF5_FILTER_SHUFFLE_DEFLATE: return String("shuffle_deflate");
+    }
+
+    THROW(Iex::ArgExc, "filterName - Unknown filter " << filter);
+}
+
+//------------------------------------------------------------------------------
+
+HDF5Filter
+filterFromName(const String &name)
+{
+    if (name == String("none"))            return HDF5_FILTER_NONE;
+    if (name == String("deflate"))         return HDF5_FILTER_DEFLATE;
+    if (name == String("shuffle_deflate")) return HDF5_FILTER_SHUFFLE_DEFLATE;
+
+    THROW(Iex::ArgExc, "filterFromName - Unknown filter " << name.c_str());
+}
+
+//------------------------------------------------------------------------------
+
 END_NKHIVE_NS
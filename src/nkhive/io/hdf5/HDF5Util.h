@@ -61,6 +61,90 @@ enum LeafType {
     LEAF_TYPE_FILL_NODE,
 };
 
+/**
+ * On disk layout of the leaves of a volume. Leaf groups store one group per
+ * leaf, leaf table stores all leaves in three bulk data sets.
+ */
+enum HDF5Layout {
+    HDF5_LAYOUT_LEAF_GROUPS = 1,
+    HDF5_LAYOUT_LEAF_TABLE  = 2,
+};
+
+/**
+ * Built in HDF5 filters applied to chunked data sets. Shuffle regroups the
+ * bytes of each element before deflate, which helps smooth float fields.
+ */
+enum HDF5Filter {
+    HDF5_FILTER_NONE = 0,
+    HDF5_FILTER_DEFLATE,
+    HDF5_FILTER_SHUFFLE_DEFLATE,
+};
+
+/**
+ * Storage settings for a data set. Filtered data sets are stored in chunks
+ * of about chunk_bytes along the first dimension.
+ */
+struct HDF5Compression
+{
+    HDF5Compression(HDF5Filter f = HDF5_FILTER_NONE, i32 l = 6, 
+                    HDF5Size c = 1 << 20);
+
+    HDF5Filter filter;
+    i32        level;       // deflate level, 0-9
+    HDF5Size   chunk_bytes;
+};
+
+/**
+ * Carries an exception thrown by an iteration callback back to the caller.
+ * Exceptions must not unwind through HDF5, the library would stay locked.
+ * Iterate with hdf5Guarded() and the guard as operator data, then rethrow().
+ */
+class HDF5CallbackGuard
+{
+public:
+
+    explicit HDF5CallbackGuard(void *op_data);
+    ~HDF5CallbackGuard();
+
+    void* opData() const;
+
+    /**
+     * Keeps the exception being handled, called from a catch block. Returns
+     * the value that stops the iteration.
+     */
+    HDF5Err capture();
+
+    /**
+     * Throws the kept exception, if any.
+     */
+    void rethrow() const;
+
+private:
+
+    struct Error
+    {
+        virtual ~Error() {}
+        virtual void raise() const = 0;
+    };
+
+    template <typename E>
+    struct TypedError : public Error
+    {
+        TypedError(const E &e) : exc(e) {}
+        void raise() const { throw exc; }
+        E exc;
+    };
+
+    /**
+     * Not copyable, the guard owns the kept exception.
+     */
+    HDF5CallbackGuard(const HDF5CallbackGuard &that);
+    HDF5CallbackGuard& operator=(const HDF5CallbackGuard &that);
+
+    void  *m_op_data;
+    Error *m_error;
+};
+
 //------------------------------------------------------------------------------
 // io constants
 //------------------------------------------------------------------------------
@@ -80,6 +164,12 @@ const String kVolumeNameAttr = String("name");
  */
 const String kVolumeDescAttr = String("description");
 
+/**
+ * volume compression filter name and deflate level, both optional
+ */
+const String kVolumeCompressionAttr      = String("compression");
+const String kVolumeCompressionLevelAttr = String("compression_level");
+
 /**
  * xform attribute
  */
@@ -106,6 +196,20 @@ const String kBranchingFactorAttr = String("BranchingFactor");
  */
 const String kCellDimAttr = String("CellDimensions");
 
+/**
+ * name of the volume's layout version attribute, missing on volumes written
+ * with leaf groups
+ */
+const String kLayoutVersionAttr = String("LayoutVersion");
+
+/**
+ * names of the leaf table layout data sets: one record per leaf, and the
+ * concatenated bitfields and voxels of all cells
+ */
+const String kLeafTableName     = String("LeafTable");
+const String kLeafBitFieldsName = String("LeafBitFields");
+const String kLeafVoxelsName    = String("LeafVoxels");
+
 /**
  * name of internal attribute storing index based offset to the 
  * current block of data.
@@ -200,18 +304,54 @@ void writeVectorAttribute(HDF5Id parent_id, const String &attr_name,
 HDF5Size getDataSetStorageSize(HDF5Id parent_id,
                               const String &name);
 
+HDF5Size getDataSetNumElements(HDF5Id parent_id, const String &name);
+
 void readSimpleDataSet(HDF5Id parent_id, const String &name,
                        HDF5Id data_type_id, void *data);
 
 void writeSimpleDataSet(HDF5Id parent_id, const String &name, i32 rank, 
                         const HDF5Size *dims, HDF5Id data_type_id, 
-                        const void *data);
+                        const void *data, 
+                        const HDF5Compression &compression = 
+                            HDF5Compression());
 
 void disableHDF5ErrorOutput();
 
 void constructLeafGroupName(LeafType type, u8 quadrant, index_vec offset,
                             String &name);
 
+/**
+ * Converts between filters and the names stored in volume attributes.
+ */
+String filterName(HDF5Filter filter);
+HDF5Filter filterFromName(const String &name);
+
+/**
+ * Link and attribute iteration callback that calls Callback with the
+ * operator data of the HDF5CallbackGuard it is given.
+ */
+template <typename Info, 
+          HDF5Err (*Callback)(HDF5Id, const char*, const Info*, void*)>
+HDF5Err hdf5Guarded(HDF5Id id, const char *name, const Info *info, 
+                    void *guard);
+
+//------------------------------------------------------------------------------
+// template implementation
+//------------------------------------------------------------------------------
+
+template <typename Info, 
+          HDF5Err (*Callback)(HDF5Id, const char*, const Info*, void*)>
+inline HDF5Err
+hdf5Guarded(HDF5Id id, const char *name, const Info *info, void *guard)
+{
+    HDF5CallbackGuard *g = reinterpret_cast<HDF5CallbackGuard *>(guard);
+    try {
+        return Callback(id, name, info, g->opData());
+    } catch (...) {
+        return g->capture();
+    }
+}
+
 //------------------------------------------------------------------------------
 // template specializations
 //------------------------------------------------------------------------------
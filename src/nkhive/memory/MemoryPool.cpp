@@ -0,0 +1,255 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// MemoryPool.cpp
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <new>
+
+#include <nkhive/memory/MemoryPool.h>
+
+BEGIN_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// FixedPool
+//------------------------------------------------------------------------------
+
+FixedPool::FixedPool(size_t block_size, size_t blocks_per_slab) :
+    m_free(NULL),
+    m_slabs(),
+    m_block_size(std::max(block_size, sizeof(FreeBlock))),
+    m_blocks_per_slab(std::max(blocks_per_slab, size_t(1))),
+    m_num_free(0),
+    m_lock()
+{
+}
+
+//------------------------------------------------------------------------------
+
+FixedPool::~FixedPool()
+{
+    for (size_t i = 0; i < m_slabs.size(); ++i) {
+        ::operator delete(m_slabs[i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+FixedPool::grow()
+{
+    char *slab = static_cast<char*>(
+        ::operator new(m_block_size * m_blocks_per_slab));
+    m_slabs.push_back(slab);
+
+    // thread the blocks in address order so fresh slabs are handed out
+    // sequentially
+    for (size_t i = m_blocks_per_slab; i-- > 0; ) {
+        deallocate(slab + (i * m_block_size));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+FixedPool::releaseMemory()
+{
+    if (m_num_free == 0) {
+        return;
+    }
+
+    // nothing in use, everything goes
+    if (m_num_free == m_slabs.size() * m_blocks_per_slab) {
+        for (size_t i = 0; i < m_slabs.size(); ++i) {
+            ::operator delete(m_slabs[i]);
+        }
+        m_slabs.clear();
+        m_free     = NULL;
+        m_num_free = 0;
+        return;
+    }
+
+    // count the free blocks in each slab
+    std::sort(m_slabs.begin(), m_slabs.end());
+    std::vector<size_t> free_counts(m_slabs.size(), 0);
+    for (FreeBlock *block = m_free; block; block = block->next) {
+        char *p = reinterpret_cast<char*>(block);
+        size_t slab = std::upper_bound(m_slabs.begin(), m_slabs.end(), p) - 
+                      m_slabs.begin() - 1;
+        ++free_counts[slab];
+    }
+
+    // rebuild the free list from the slabs that are kept
+    FreeBlock *free_list = NULL;
+    for (FreeBlock *block = m_free, *next; block; block = next) {
+        next = block->next;
+        char *p = reinterpret_cast<char*>(block);
+        size_t slab = std::upper_bound(m_slabs.begin(), m_slabs.end(), p) - 
+                      m_slabs.begin() - 1;
+        if (free_counts[slab] != m_blocks_per_slab) {
+            block->next = free_list;
+            free_list   = block;
+        } else {
+            --m_num_free;
+        }
+    }
+    m_free = free_list;
+
+    // free the empty slabs
+    size_t kept = 0;
+    for (size_t i = 0; i < m_slabs.size(); ++i) {
+        if (free_counts[i] == m_blocks_per_slab) {
+            ::operator delete(m_slabs[i]);
+        } else {
+            m_slabs[kept++] = m_slabs[i];
+        }
+    }
+    m_slabs.resize(kept);
+}
+
+//------------------------------------------------------------------------------
+// MemoryPool
+//------------------------------------------------------------------------------
+
+MemoryPool::MemoryPool() :
+    m_large(),
+    m_lock(),
+    m_thread_safe(false)
+{
+    std::fill(m_small, m_small + kNumSmallClasses, (FixedPool*)NULL);
+}
+
+//------------------------------------------------------------------------------
+
+MemoryPool::~MemoryPool()
+{
+    for (size_t i = 0; i < kNumSmallClasses; ++i) {
+        delete m_small[i];
+    }
+
+    pool_map::iterator iter = m_large.begin();
+    for (; iter != m_large.end(); ++iter) {
+        delete iter->second;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+MemoryPool::releaseMemory()
+{
+    for (size_t i = 0; i < kNumSmallClasses; ++i) {
+        if (m_small[i]) {
+            m_small[i]->releaseMemory();
+        }
+    }
+
+    pool_map::iterator iter = m_large.begin();
+    for (; iter != m_large.end(); ++iter) {
+        iter->second->releaseMemory();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+size_t
+MemoryPool::bytesReserved() const
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < kNumSmallClasses; ++i) {
+        if (m_small[i]) {
+            bytes += m_small[i]->bytesReserved();
+        }
+    }
+
+    pool_map::const_iterator iter = m_large.begin();
+    for (; iter != m_large.end(); ++iter) {
+        bytes += iter->second->bytesReserved();
+    }
+
+    return bytes;
+}
+
+//------------------------------------------------------------------------------
+
+size_t
+MemoryPool::bytesInUse() const
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < kNumSmallClasses; ++i) {
+        if (m_small[i]) {
+            bytes += m_small[i]->bytesInUse();
+        }
+    }
+
+    pool_map::const_iterator iter = m_large.begin();
+    for (; iter != m_large.end(); ++iter) {
+        bytes += iter->second->bytesInUse();
+    }
+
+    return bytes;
+}
+
+//------------------------------------------------------------------------------
+
+FixedPool*
+MemoryPool::createPool(size_t size_class)
+{
+    SpinLock::ScopedLock lock(m_lock);
+
+    // another thread may have created the pool in the meantime
+    size_t index = (size_class / kGranularity) - 1;
+    if (index < kNumSmallClasses) {
+        if (m_small[index]) {
+            return m_small[index];
+        }
+    } else {
+        pool_map::iterator iter = m_large.find(size_class);
+        if (iter != m_large.end()) {
+            return iter->second;
+        }
+    }
+
+    FixedPool *pool = new FixedPool(size_class, kSlabSize / size_class);
+    if (index < kNumSmallClasses) {
+        atomicStore(&m_small[index], pool);
+    } else {
+        m_large[size_class] = pool;
+    }
+
+    return pool;
+}
+
+//------------------------------------------------------------------------------
+
+END_NKHIVE_NS
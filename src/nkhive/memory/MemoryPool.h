@@ -0,0 +1,257 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// MemoryPool.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_MEMORY_MEMORYPOOL_H__
+#define __NKHIVE_MEMORY_MEMORYPOOL_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include <nkhive/Defs.h>
+#include <nkhive/util/SpinLock.h>
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Hands out blocks of a single size, carved from larger slabs. Freed blocks
+ * are kept on a free list and recycled by the next allocation.
+ */
+class FixedPool
+{
+
+public:
+
+    FixedPool(size_t block_size, size_t blocks_per_slab);
+    ~FixedPool();
+
+    /**
+     * The size in bytes of the blocks handed out.
+     */
+    size_t blockSize() const;
+
+    /**
+     * Get/Return a single block.
+     */
+    void *allocate();
+    void deallocate(void *p);
+
+    /**
+     * Frees all slabs that have no blocks in use.
+     */
+    void releaseMemory();
+
+    /**
+     * Bytes held in slabs, and bytes of it currently handed out.
+     */
+    size_t bytesReserved() const;
+    size_t bytesInUse() const;
+
+    /**
+     * Lock guarding the pool when it is shared between threads. The pool
+     * itself never takes it.
+     */
+    SpinLock& spinLock();
+
+private:
+
+    //--------------------------------------------------------------------------
+    // types
+    //--------------------------------------------------------------------------
+
+    struct FreeBlock
+    {
+        FreeBlock *next;
+    };
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Allocates a new slab and threads its blocks onto the free list.
+     */
+    void grow();
+
+    /**
+     * Not copyable, blocks are owned by the pool.
+     */
+    FixedPool(const FixedPool &that);
+    FixedPool& operator=(const FixedPool &that);
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    FreeBlock          *m_free;            // head of the free list
+    std::vector<char*>  m_slabs;           // slabs owned by the pool
+    size_t              m_block_size;      // bytes per block
+    size_t              m_blocks_per_slab; // blocks carved from each slab
+    size_t              m_num_free;        // blocks on the free list
+    SpinLock            m_lock;            // guards concurrent use
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * A collection of FixedPools, one per size class. Requests are rounded up to
+ * the size class granularity, sizes above kMaxBlockSize go straight to the
+ * heap. Allocation is only thread safe while setThreadSafe() is enabled.
+ */
+class MemoryPool
+{
+
+public:
+
+    typedef boost::shared_ptr<MemoryPool> shared_ptr;
+
+    /**
+     * Makes the pool thread safe for the lifetime of the object if enabled,
+     * restoring the previous setting after.
+     */
+    class ScopedThreadSafe
+    {
+    public:
+        ScopedThreadSafe(MemoryPool &pool, bool enable = true);
+        ~ScopedThreadSafe();
+
+    private:
+        ScopedThreadSafe(const ScopedThreadSafe &that);
+        ScopedThreadSafe& operator=(const ScopedThreadSafe &that);
+
+        MemoryPool &m_pool;
+        bool        m_thread_safe;
+    };
+
+    /**
+     * Size classes are multiples of kGranularity bytes. Slabs hold at least
+     * kSlabSize bytes.
+     */
+    static const size_t kGranularity  = 16;
+    static const size_t kSlabSize     = 1 << 16;
+    static const size_t kMaxBlockSize = 1 << 20;
+
+    MemoryPool();
+    ~MemoryPool();
+
+    /**
+     * Get/Return a block of the given size. The size given on deallocation
+     * must match the size it was allocated with.
+     */
+    void *allocate(size_t bytes);
+    void deallocate(void *p, size_t bytes);
+
+    /**
+     * Returns slabs with no blocks in use to the heap.
+     */
+    void releaseMemory();
+
+    /**
+     * Toggles locking around allocate() and deallocate(), so several threads
+     * can share the pool. Must not be toggled while the pool is in use.
+     */
+    void setThreadSafe(bool thread_safe);
+    bool isThreadSafe() const;
+
+    /**
+     * Bytes held in slabs, and bytes of it currently handed out.
+     */
+    size_t bytesReserved() const;
+    size_t bytesInUse() const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    // types
+    //--------------------------------------------------------------------------
+
+    typedef std::map<size_t, FixedPool*> pool_map;
+
+    /**
+     * Size classes up to this many bytes are looked up directly.
+     */
+    static const size_t kNumSmallClasses = 256;
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Returns the pool for the given size class, creating it if needed.
+     */
+    FixedPool* getPool(size_t size_class);
+    FixedPool* createPool(size_t size_class);
+
+    /**
+     * Not copyable, blocks are owned by the pool.
+     */
+    MemoryPool(const MemoryPool &that);
+    MemoryPool& operator=(const MemoryPool &that);
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    FixedPool *m_small[kNumSmallClasses]; // pools indexed by size class
+    pool_map   m_large;                   // pools for the remaining classes
+    SpinLock   m_lock;                    // guards pool creation
+    bool       m_thread_safe;             // lock around allocations
+};
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/memory/MemoryPool.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_MEMORY_MEMORYPOOL_H__
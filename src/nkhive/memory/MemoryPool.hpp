@@ -0,0 +1,217 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// MemoryPool.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// FixedPool
+//------------------------------------------------------------------------------
+
+inline size_t
+FixedPool::blockSize() const
+{
+    return m_block_size;
+}
+
+//------------------------------------------------------------------------------
+
+inline void*
+FixedPool::allocate()
+{
+    if (!m_free) {
+        grow();
+    }
+
+    FreeBlock *block = m_free;
+    m_free = block->next;
+    --m_num_free;
+
+    return block;
+}
+
+//------------------------------------------------------------------------------
+
+inline void
+FixedPool::deallocate(void *p)
+{
+    FreeBlock *block = static_cast<FreeBlock*>(p);
+    block->next = m_free;
+    m_free = block;
+    ++m_num_free;
+}
+
+//------------------------------------------------------------------------------
+
+inline size_t
+FixedPool::bytesReserved() const
+{
+    return m_slabs.size() * m_blocks_per_slab * m_block_size;
+}
+
+//------------------------------------------------------------------------------
+
+inline size_t
+FixedPool::bytesInUse() const
+{
+    return bytesReserved() - (m_num_free * m_block_size);
+}
+
+//------------------------------------------------------------------------------
+
+inline SpinLock&
+FixedPool::spinLock()
+{
+    return m_lock;
+}
+
+//------------------------------------------------------------------------------
+// MemoryPool::ScopedThreadSafe
+//------------------------------------------------------------------------------
+
+inline
+MemoryPool::ScopedThreadSafe::ScopedThreadSafe(MemoryPool &pool, 
+                                               bool enable) :
+    m_pool(pool),
+    m_thread_safe(pool.isThreadSafe())
+{
+    if (enable) {
+        m_pool.setThreadSafe(true);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+inline
+MemoryPool::ScopedThreadSafe::~ScopedThreadSafe()
+{
+    m_pool.setThreadSafe(m_thread_safe);
+}
+
+//------------------------------------------------------------------------------
+// MemoryPool
+//------------------------------------------------------------------------------
+
+inline void*
+MemoryPool::allocate(size_t bytes)
+{
+    if (bytes == 0) {
+        return NULL;
+    }
+
+    // round up to the size class
+    size_t size_class = (bytes + kGranularity - 1) & ~(kGranularity - 1);
+    if (size_class > kMaxBlockSize) {
+        return ::operator new(bytes);
+    }
+
+    FixedPool *pool = getPool(size_class);
+    if (m_thread_safe) {
+        SpinLock::ScopedLock lock(pool->spinLock());
+        return pool->allocate();
+    }
+
+    return pool->allocate();
+}
+
+//------------------------------------------------------------------------------
+
+inline void
+MemoryPool::deallocate(void *p, size_t bytes)
+{
+    if (!p) {
+        return;
+    }
+
+    size_t size_class = (bytes + kGranularity - 1) & ~(kGranularity - 1);
+    if (size_class > kMaxBlockSize) {
+        ::operator delete(p);
+        return;
+    }
+
+    FixedPool *pool = getPool(size_class);
+    if (m_thread_safe) {
+        SpinLock::ScopedLock lock(pool->spinLock());
+        pool->deallocate(p);
+        return;
+    }
+
+    pool->deallocate(p);
+}
+
+//------------------------------------------------------------------------------
+
+inline FixedPool*
+MemoryPool::getPool(size_t size_class)
+{
+    size_t index = (size_class / kGranularity) - 1;
+    if (index < kNumSmallClasses) {
+        FixedPool *pool = atomicLoad(&m_small[index]);
+        return pool ? pool : createPool(size_class);
+    }
+
+    // the map can't be searched while another thread inserts
+    if (m_thread_safe) {
+        SpinLock::ScopedLock lock(m_lock);
+        pool_map::iterator iter = m_large.find(size_class);
+        if (iter != m_large.end()) {
+            return iter->second;
+        }
+    } else {
+        pool_map::iterator iter = m_large.find(size_class);
+        if (iter != m_large.end()) {
+            return iter->second;
+        }
+    }
+
+    return createPool(size_class);
+}
+
+//------------------------------------------------------------------------------
+
+inline void
+MemoryPool::setThreadSafe(bool thread_safe)
+{
+    m_thread_safe = thread_safe;
+}
+
+//------------------------------------------------------------------------------
+
+inline bool
+MemoryPool::isThreadSafe() const
+{
+    return m_thread_safe;
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,166 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// PoolAllocator.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_MEMORY_POOLALLOCATOR_H__
+#define __NKHIVE_MEMORY_POOLALLOCATOR_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <cstddef>
+#include <new>
+
+#include <nkhive/Defs.h>
+#include <nkhive/memory/MemoryPool.h>
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Standard conforming allocator serving memory from a shared MemoryPool. A
+ * default constructed allocator has no pool and falls back on the heap.
+ */
+template <typename T>
+class PoolAllocator
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+
+    typedef T               value_type;
+    typedef T*              pointer;
+    typedef const T*        const_pointer;
+    typedef T&              reference;
+    typedef const T&        const_reference;
+    typedef size_t          size_type;
+    typedef ptrdiff_t       difference_type;
+
+    template <typename U>
+    struct rebind
+    {
+        typedef PoolAllocator<U> other;
+    };
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    PoolAllocator();
+    PoolAllocator(const MemoryPool::shared_ptr &pool);
+    PoolAllocator(const PoolAllocator &that);
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &that);
+
+    /**
+     * The pool memory is served from, empty if using the heap.
+     */
+    const MemoryPool::shared_ptr& pool() const;
+
+    /**
+     * Standard allocator interface.
+     */
+    pointer address(reference x) const;
+    const_pointer address(const_reference x) const;
+
+    pointer allocate(size_type n, const void *hint = 0);
+    void deallocate(pointer p, size_type n);
+
+    size_type max_size() const;
+
+    void construct(pointer p, const_reference value);
+    void destroy(pointer p);
+
+    /**
+     * Allocators are equal if they share the same pool.
+     */
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &that) const;
+    template <typename U>
+    bool operator!=(const PoolAllocator<U> &that) const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    MemoryPool::shared_ptr m_pool; // shared pool, empty for heap
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * Binds allocators to a MemoryPool. Allocators that know nothing of pools
+ * are default constructed and report an empty pool.
+ */
+template <typename Alloc>
+struct PoolTraits
+{
+    static Alloc create(const MemoryPool::shared_ptr &pool);
+    static MemoryPool::shared_ptr pool(const Alloc &a);
+};
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+struct PoolTraits< PoolAllocator<T> >
+{
+    static PoolAllocator<T> create(const MemoryPool::shared_ptr &pool);
+    static MemoryPool::shared_ptr pool(const PoolAllocator<T> &a);
+};
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/memory/PoolAllocator.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_MEMORY_POOLALLOCATOR_H__
@@ -0,0 +1,214 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// PoolAllocator.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// PoolAllocator
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline
+PoolAllocator<T>::PoolAllocator() :
+    m_pool()
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline
+PoolAllocator<T>::PoolAllocator(const MemoryPool::shared_ptr &pool) :
+    m_pool(pool)
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline
+PoolAllocator<T>::PoolAllocator(const PoolAllocator &that) :
+    m_pool(that.m_pool)
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+template <typename U>
+inline
+PoolAllocator<T>::PoolAllocator(const PoolAllocator<U> &that) :
+    m_pool(that.pool())
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline const MemoryPool::shared_ptr&
+PoolAllocator<T>::pool() const
+{
+    return m_pool;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline typename PoolAllocator<T>::pointer
+PoolAllocator<T>::address(reference x) const
+{
+    return &x;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline typename PoolAllocator<T>::const_pointer
+PoolAllocator<T>::address(const_reference x) const
+{
+    return &x;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline typename PoolAllocator<T>::pointer
+PoolAllocator<T>::allocate(size_type n, const void *)
+{
+    if (m_pool) {
+        return static_cast<pointer>(m_pool->allocate(n * sizeof(T)));
+    }
+    return static_cast<pointer>(::operator new(n * sizeof(T)));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+PoolAllocator<T>::deallocate(pointer p, size_type n)
+{
+    if (m_pool) {
+        m_pool->deallocate(p, n * sizeof(T));
+    } else {
+        ::operator delete(p);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline typename PoolAllocator<T>::size_type
+PoolAllocator<T>::max_size() const
+{
+    return size_type(-1) / sizeof(T);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+PoolAllocator<T>::construct(pointer p, const_reference value)
+{
+    new (static_cast<void*>(p)) T(value);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+PoolAllocator<T>::destroy(pointer p)
+{
+    p->~T();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+template <typename U>
+inline bool
+PoolAllocator<T>::operator==(const PoolAllocator<U> &that) const
+{
+    return m_pool == that.pool();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+template <typename U>
+inline bool
+PoolAllocator<T>::operator!=(const PoolAllocator<U> &that) const
+{
+    return !(*this == that);
+}
+
+//------------------------------------------------------------------------------
+// PoolTraits
+//------------------------------------------------------------------------------
+
+template <typename Alloc>
+inline Alloc
+PoolTraits<Alloc>::create(const MemoryPool::shared_ptr &)
+{
+    return Alloc();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename Alloc>
+inline MemoryPool::shared_ptr
+PoolTraits<Alloc>::pool(const Alloc &)
+{
+    return MemoryPool::shared_ptr();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline PoolAllocator<T>
+PoolTraits< PoolAllocator<T> >::create(const MemoryPool::shared_ptr &pool)
+{
+    return PoolAllocator<T>(pool);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline MemoryPool::shared_ptr
+PoolTraits< PoolAllocator<T> >::pool(const PoolAllocator<T> &a)
+{
+    return a.pool();
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Atomic.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_UTIL_ATOMIC_H__
+#define __NKHIVE_UTIL_ATOMIC_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <nkhive/Defs.h>
+
+//------------------------------------------------------------------------------
+// defines
+//------------------------------------------------------------------------------
+
+#if !defined(__GNUC__)
+  #error "nkhive atomics require the GCC __sync or __atomic builtins"
+#endif
+
+// The __atomic builtins allow acquire/release ordering, older compilers only
+// provide the fully fenced __sync builtins.
+#if defined(__ATOMIC_ACQUIRE)
+  #define NKHIVE_ATOMIC_BUILTINS
+#endif
+
+//------------------------------------------------------------------------------
+// interface definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Loads a value, later reads are not reordered before it (acquire).
+ */
+template <typename T>
+T atomicLoad(const T *p);
+
+/**
+ * Stores a value, earlier writes are not reordered after it (release).
+ */
+template <typename T>
+void atomicStore(T *p, T value);
+
+/**
+ * Replaces the value at p with desired if it is equal to expected. Returns 
+ * true if the value was replaced. Acts as a full barrier.
+ */
+template <typename T>
+bool compareAndSwap(T *p, T expected, T desired);
+
+/**
+ * Atomically ors the bits into the value at p. Returns the previous value.
+ */
+template <typename T>
+T atomicOr(T *p, T bits);
+
+/**
+ * Atomically adds to the value at p. Returns the previous value.
+ */
+template <typename T>
+T atomicAdd(T *p, T value);
+
+/**
+ * Hints the processor that the thread is busy waiting.
+ */
+void cpuRelax();
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// implementation
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/util/Atomic.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_UTIL_ATOMIC_H__
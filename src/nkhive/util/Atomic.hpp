@@ -0,0 +1,106 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Atomic.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline T
+atomicLoad(const T *p)
+{
+#if defined(NKHIVE_ATOMIC_BUILTINS)
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#else
+    T value = *static_cast<const volatile T*>(p);
+    __sync_synchronize();
+    return value;
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline void
+atomicStore(T *p, T value)
+{
+#if defined(NKHIVE_ATOMIC_BUILTINS)
+    __atomic_store_n(p, value, __ATOMIC_RELEASE);
+#else
+    __sync_synchronize();
+    *static_cast<volatile T*>(p) = value;
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline bool
+compareAndSwap(T *p, T expected, T desired)
+{
+    return __sync_bool_compare_and_swap(p, expected, desired);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline T
+atomicOr(T *p, T bits)
+{
+    return __sync_fetch_and_or(p, bits);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+inline T
+atomicAdd(T *p, T value)
+{
+    return __sync_fetch_and_add(p, value);
+}
+
+//------------------------------------------------------------------------------
+
+inline void
+cpuRelax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__("pause" ::: "memory");
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,117 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// SpinLock.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_UTIL_SPINLOCK_H__
+#define __NKHIVE_UTIL_SPINLOCK_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <nkbase/Types.h>
+
+#include <nkhive/Defs.h>
+#include <nkhive/util/Atomic.h>
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * A single byte busy waiting lock, for guarding short critical sections in
+ * objects too numerous to carry a mutex. Copies always start unlocked.
+ */
+class SpinLock
+{
+
+public:
+
+    /**
+     * Holds the lock for the lifetime of the object.
+     */
+    class ScopedLock
+    {
+    public:
+        explicit ScopedLock(SpinLock &lock);
+        ~ScopedLock();
+
+    private:
+        ScopedLock(const ScopedLock &that);
+        ScopedLock& operator=(const ScopedLock &that);
+
+        SpinLock &m_lock;
+    };
+
+    SpinLock();
+    SpinLock(const SpinLock &that);
+    SpinLock& operator=(const SpinLock &that);
+
+    /**
+     * Acquire/Release the lock.
+     */
+    void lock();
+    void unlock();
+
+    /**
+     * Acquires the lock if it is free, returns true on success.
+     */
+    bool tryLock();
+
+private:
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    u8 m_flag; // non zero while held
+};
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/util/SpinLock.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_UTIL_SPINLOCK_H__
@@ -0,0 +1,197 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// WorkerGroup.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_UTIL_WORKERGROUP_H__
+#define __NKHIVE_UTIL_WORKERGROUP_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <string>
+#include <boost/thread/thread.hpp>
+
+#include <nkhive/Defs.h>
+#include <nkhive/util/Atomic.h>
+#include <nkhive/util/SpinLock.h>
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Runs a thread body on several threads, handing out tasks from a shared 
+ * counter. The first exception any thread throws is kept as the error and 
+ * stops the hand out, the caller decides how to report it.
+ */
+class WorkerGroup
+{
+
+public:
+
+    /**
+     * A thread count of 0 uses one thread per core.
+     */
+    explicit WorkerGroup(size_t num_threads = 0);
+
+    /**
+     * Waits for threads still running.
+     */
+    ~WorkerGroup();
+
+    /**
+     * Calls body(thread) for every thread below num_threads, capped at 
+     * numThreads(), and waits for them. The calling thread takes part as 
+     * thread 0. The bodies share num_tasks tasks through nextTask().
+     */
+    template <typename Body>
+    void run(size_t num_threads, size_t num_tasks, Body body);
+
+    /**
+     * Calls body(thread) on new threads for every thread below num_threads,
+     * leaving the calling thread free for other work until join().
+     */
+    template <typename Body>
+    void start(size_t num_threads, Body body);
+    void join();
+
+    /**
+     * Hands out the next task, or the next count tasks from begin to end. 
+     * Returns false once all tasks are handed out or a thread has failed.
+     */
+    bool nextTask(size_t &task);
+    bool nextTasks(size_t count, size_t &begin, size_t &end);
+
+    /**
+     * Records the error unless a thread failed before, and stops handing
+     * out tasks.
+     */
+    void fail(const std::string &error);
+
+    /**
+     * Whether a thread has failed, and the first error.
+     */
+    bool failed() const;
+    const std::string& error() const;
+
+    /**
+     * Number of threads used.
+     */
+    size_t numThreads() const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal typedefs
+    //--------------------------------------------------------------------------
+
+    /**
+     * Entry point of a started thread.
+     */
+    template <typename Body>
+    struct Worker
+    {
+        Worker(WorkerGroup *group, const Body &body, size_t thread) :
+            m_group(group),
+            m_body(body),
+            m_thread(thread)
+        {
+        }
+
+        void operator()()
+        {
+            m_group->execute(m_body, m_thread);
+        }
+
+        WorkerGroup    *m_group;
+        Body            m_body;
+        size_t          m_thread;
+    };
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Waits for the previous threads, clears the error and sets the tasks 
+     * to hand out.
+     */
+    void reset(size_t num_tasks);
+
+    /**
+     * Calls the body, recording what it throws.
+     */
+    template <typename Body>
+    void execute(Body body, size_t thread);
+
+    /**
+     * Not copyable, the threads refer to the group.
+     */
+    WorkerGroup(const WorkerGroup &that);
+    WorkerGroup& operator=(const WorkerGroup &that);
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    size_t                  m_num_threads;
+    size_t                  m_num_tasks;
+    size_t                  m_next;     // next task to hand out
+    bool                    m_failed;
+    std::string             m_error;
+    SpinLock                m_lock;     // guards the error
+    std::auto_ptr<boost::thread_group> m_threads;
+};
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/util/WorkerGroup.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_UTIL_WORKERGROUP_H__
@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// WorkerGroup.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+inline
+WorkerGroup::WorkerGroup(size_t num_threads) :
+    m_num_threads(num_threads),
+    m_num_tasks(0),
+    m_next(0),
+    m_failed(false)
+{
+    if (m_num_threads == 0) {
+        m_num_threads = boost::thread::hardware_concurrency();
+    }
+    if (m_num_threads == 0) {
+        m_num_threads = 1;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+inline
+WorkerGroup::~WorkerGroup()
+{
+    join();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename Body>
+inline void
+WorkerGroup::run(size_t num_threads, size_t num_tasks, Body body)
+{
+    reset(num_tasks);
+    num_threads = std::min(num_threads, m_num_threads);
+
+    // The calling thread takes part as the first worker, the others are 
+    // joined even if starting one of them fails.
+    try {
+        for (size_t n = 1; n < num_threads; ++n) {
+            m_threads->create_thread(Worker<Body>(this, body, n));
+        }
+    } catch (...) {
+        fail("failed to start thread");
+        join();
+        throw;
+    }
+    execute(body, 0);
+    join();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename Body>
+inline void
+WorkerGroup::start(size_t num_threads, Body body)
+{
+    reset(0);
+    try {
+        for (size_t n = 0; n < num_threads; ++n) {
+            m_threads->create_thread(Worker<Body>(this, body, n));
+        }
+    } catch (...) {
+        fail("failed to start thread");
+        join();
+        throw;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+inline void
+WorkerGroup::join()
+{
+    if (m_threads.get()) {
+        m_threads->join_all();
+        m_threads.reset();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+inline bool
+WorkerGroup::nextTask(size_t &task)
+{
+    task = atomicAdd(&m_next, size_t(1));
+    return task < m_num_tasks;
+}
+
+//------------------------------------------------------------------------------
+
+inline bool
+WorkerGroup::nextTasks(size_t count, size_t &begin, size_t &end)
+{
+    begin = atomicAdd(&m_next, count);
+    end   = std::min(begin + count, m_num_tasks);
+    return begin < m_num_tasks;
+}
+
+//------------------------------------------------------------------------------
+
+inline void
+WorkerGroup::fail(const std::string &error)
+{
+    SpinLock::ScopedLock lock(m_lock);
+    if (!m_failed) {
+        m_error = error;
+        atomicStore(&m_failed, true);
+    }
+    atomicStore(&m_next, m_num_tasks);
+}
+
+//------------------------------------------------------------------------------
+
+inline bool
+WorkerGroup::failed() const
+{
+    return atomicLoad(&m_failed);
+}
+
+//------------------------------------------------------------------------------
+
+inline const std::string&
+WorkerGroup::error() const
+{
+    return m_error;
+}
+
+//------------------------------------------------------------------------------
+
+inline size_t
+WorkerGroup::numThreads() const
+{
+    return m_num_threads;
+}
+
+//------------------------------------------------------------------------------
+
+inline void
+WorkerGroup::reset(size_t num_tasks)
+{
+    join();
+    m_threads.reset(new boost::thread_group());
+
+    m_num_tasks = num_tasks;
+    m_next      = 0;
+    m_failed    = false;
+    m_error.clear();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename Body>
+inline void
+WorkerGroup::execute(Body body, size_t thread)
+{
+    try {
+        body(thread);
+    } catch (const std::exception &e) {
+        fail(e.what());
+    } catch (...) {
+        fail("unknown exception");
+    }
+}
+
+//------------------------------------------------------------------------------
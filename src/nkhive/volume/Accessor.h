@@ -0,0 +1,343 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Accessor.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_VOLUME_ACCESSOR_H__
+#define __NKHIVE_VOLUME_ACCESSOR_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkhive/bitfields/BitOps.h>
+#include <nkhive/volume/Node.h>
+
+//------------------------------------------------------------------------------
+// forward declarations
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+template <typename C, typename Alloc>
+class Tree;
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Read-only accessor into a Tree. Caches the last visited cell and the nodes
+ * on the path to it, so neighbouring lookups skip the descent from the root.
+ * Scattered lookups gain nothing from the cache, use Tree::get() for those.
+ */
+template <typename CellType,
+          typename A = std::allocator<typename CellType::value_type> >
+class ConstAccessor
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+
+    typedef A                                         allocator_type;
+    typedef typename allocator_type::value_type       value_type;
+    typedef typename allocator_type::reference        reference;
+    typedef typename allocator_type::const_reference  const_reference;
+
+    typedef Tree<CellType, A>                         tree_type;
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    ConstAccessor(const tree_type *tree);
+
+    /**
+     * Get the value at the given coordinates. Same semantics as Tree::get().
+     */
+    value_type get(signed_index_type i, 
+                   signed_index_type j, 
+                   signed_index_type k);
+    value_type get(const signed_index_vec &coords);
+
+    /**
+     * Gathers the size block of values with its minimum corner at min into
+     * out, x fastest. Each cell the block overlaps is looked up once.
+     */
+    void getBlock(const signed_index_vec &min, const index_vec &size, 
+                  value_type *out);
+
+    /**
+     * Returns true if the given coordinates fall inside the cached cell.
+     */
+    bool isCached(signed_index_type i, 
+                  signed_index_type j, 
+                  signed_index_type k) const;
+
+    /**
+     * Drops all cached nodes. Must be called if the tree is modified through
+     * anything other than this accessor.
+     */
+    void clear();
+
+protected:
+
+    //--------------------------------------------------------------------------
+    // internal typedefs
+    //--------------------------------------------------------------------------
+
+    typedef Node<CellType, A>   node_type;
+    typedef node_type*          node_type_ptr;
+    typedef CellType*           cell_type_ptr;
+
+    /**
+     * Upper bound on the height of a tree, dimensions are 32 bit indices.
+     */
+    enum { MAX_LEVELS = 32 };
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Splits the signed coordinates into their quadrant and the unsigned
+     * coordinates inside it. Same mapping as Tree::getQuadrantCoords().
+     */
+    static u8 toQuadrantCoords(signed_index_type i, 
+                               signed_index_type j, 
+                               signed_index_type k, 
+                               index_vec &qc);
+
+    /**
+     * Returns true if the quadrant coordinates lie in the power of two block
+     * of size 2^lg_dim starting at origin.
+     */
+    static bool contains(const index_vec &origin, index_type lg_dim, 
+                         const index_vec &qc);
+
+    /**
+     * Returns Log2 of the dimension spanned by the given node.
+     */
+    static index_type nodeLgDim(const node_type *node);
+
+    /**
+     * Length of the piece of [c, c + n) that lies in the same cell as c. 
+     * Cells tile signed space at multiples of their dimension.
+     */
+    static index_type pieceLength(signed_index_type c, index_type n, 
+                                  index_type lg_cell_dim);
+
+    /**
+     * Local cell coordinate of the signed coordinate c.
+     */
+    static index_type localCoord(signed_index_type c, index_type lg_cell_dim);
+
+    /**
+     * Switches the cache over to the given quadrant, dropping everything
+     * cached if it differs from the current one.
+     */
+    void setQuadrant(u8 quadrant);
+
+    /**
+     * Walks up the cached nodes and returns the deepest one containing the
+     * quadrant coordinates, falls back to the quadrant's root.
+     */
+    node_type_ptr findCachedNode(const index_vec &qc) const;
+
+    /**
+     * Descends from the given node down to the value, caching the path.
+     */
+    const_reference getFrom(node_type_ptr node, const index_vec &qc);
+
+    /**
+     * Cache management.
+     */
+    void cacheNode(node_type_ptr node, const index_vec &qc);
+    void cacheCell(cell_type_ptr cell, const index_vec &qc);
+    void clearBelow(index_type level);
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    /**
+     * The tree being accessed. Held non-const so the traversal can be shared
+     * with the read-write Accessor, this class never modifies it.
+     */
+    tree_type *m_tree;
+
+    /**
+     * Quadrant the cached nodes belong to.
+     */
+    u8 m_quadrant;
+
+    /**
+     * Cached nodes indexed by level along with the quadrant coordinates of
+     * their origins.
+     */
+    node_type_ptr m_nodes[MAX_LEVELS];
+    index_vec m_node_origins[MAX_LEVELS];
+
+    /**
+     * Highest cached level, bounds the walks over the cached nodes.
+     */
+    index_type m_top_level;
+
+    /**
+     * Last visited cell, its origin in quadrant coordinates and Log2 of its
+     * dimension.
+     */
+    cell_type_ptr m_cell;
+    index_vec m_cell_origin;
+    index_type m_lg_cell_dim;
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * Read-write accessor into a Tree. Writes that land in the cached cell go
+ * straight to it, otherwise the descent starts at the deepest cached node.
+ */
+template <typename CellType,
+          typename A = std::allocator<typename CellType::value_type> >
+class Accessor : public ConstAccessor<CellType, A>
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+
+    typedef ConstAccessor<CellType, A>                base_type;
+    typedef typename base_type::value_type            value_type;
+    typedef typename base_type::reference             reference;
+    typedef typename base_type::const_reference       const_reference;
+    typedef typename base_type::tree_type             tree_type;
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    Accessor(tree_type *tree);
+
+    /** 
+     * Set the value at a given voxel, growing the tree if necessary. 
+     */
+    void set(signed_index_type i, 
+             signed_index_type j, 
+             signed_index_type k, const_reference val);
+    void set(const signed_index_vec &coords, const_reference val);
+
+    /**
+     * Updates the size block with its minimum corner at min with vals, laid
+     * out as getBlock() returns them. Each cell is descended to once.
+     */
+    template <typename BinaryOp>
+    void updateBlock(const signed_index_vec &min, const index_vec &size,
+                     const value_type *vals, BinaryOp op);
+
+    /**
+     * Update the value at a given voxel with the given binary operator,
+     * growing the tree if necessary. Safe to use from several threads, one
+     * accessor each, while the tree is in concurrent write mode.
+     */
+    template <typename BinaryOp>
+    void update(signed_index_type i, signed_index_type j, signed_index_type k,
+                const_reference val, BinaryOp op);
+    template <typename BinaryOp>
+    void update(const signed_index_vec &coords, const_reference val, 
+                BinaryOp op);
+
+    /**
+     * Unsets the value at the given voxel. This may remove nodes from the
+     * tree so the cache is dropped.
+     */
+    void unset(signed_index_type i, signed_index_type j, signed_index_type k);
+    void unset(const signed_index_vec &coords);
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal typedefs
+    //--------------------------------------------------------------------------
+
+    typedef typename base_type::node_type_ptr         node_type_ptr;
+    typedef typename base_type::cell_type_ptr         cell_type_ptr;
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Descends from the given node down to the voxel, creating branches as
+     * needed, and applies the update there. Mirrors Node::update().
+     */
+    template <typename BinaryOp>
+    void updateFrom(node_type_ptr node, const index_vec &qc, 
+                    const_reference val, BinaryOp op);
+
+    /**
+     * Update used while the tree takes concurrent writes. Other threads may
+     * replace any node, so only the cell is cached and it is written under
+     * its lock.
+     */
+    template <typename BinaryOp>
+    void updateConcurrent(u8 quadrant, const index_vec &qc, 
+                          const_reference val, BinaryOp op);
+};
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/volume/Accessor.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_VOLUME_ACCESSOR_H__
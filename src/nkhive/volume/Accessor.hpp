@@ -0,0 +1,605 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Accessor.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// ConstAccessor implementation
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline
+ConstAccessor<CellType, A>::ConstAccessor(const tree_type *tree) :
+    m_tree(const_cast<tree_type*>(tree))
+{
+    clear();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename ConstAccessor<CellType, A>::value_type
+ConstAccessor<CellType, A>::get(signed_index_type i, 
+                                signed_index_type j, 
+                                signed_index_type k)
+{
+    // Choose the quadrant and convert into quadrant coords.
+    index_vec qc;
+    u8 q = toQuadrantCoords(i, j, k, qc);
+
+    // Fast path, the voxel lives in the cached cell.
+    if ((q == m_quadrant) && m_cell && 
+        contains(m_cell_origin, m_lg_cell_dim, qc)) {
+        return m_cell->get(moduloLg(qc.x, m_lg_cell_dim),
+                           moduloLg(qc.y, m_lg_cell_dim),
+                           moduloLg(qc.z, m_lg_cell_dim));
+    }
+
+    // Check max dimensions
+    index_type max_dim = m_tree->m_max_dim[q];
+    if (qc.x >= max_dim || qc.y >= max_dim || qc.z >= max_dim) {
+        return m_tree->m_default_value;
+    }
+
+    // Resume the descent from the deepest cached node.
+    setQuadrant(q);
+    return getFrom(findCachedNode(qc), qc);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename ConstAccessor<CellType, A>::value_type
+ConstAccessor<CellType, A>::get(const signed_index_vec &coords)
+{
+    return get(coords.x, coords.y, coords.z);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ConstAccessor<CellType, A>::getBlock(const signed_index_vec &min,
+                                     const index_vec &size, value_type *out)
+{
+    const index_type lg = m_lg_cell_dim;
+    const i32 row   = i32(size.x);
+    const i32 slice = i32(size.x * size.y);
+
+    // Walk the block a cell at a time, a block interior to a cell is a single
+    // piece and anything larger is stitched from its neighbours.
+    index_type nx, ny, nz;
+    for (index_type z = 0; z < size.z; z += nz) {
+        signed_index_type cz = min.z + signed_index_type(z);
+        nz = pieceLength(cz, size.z - z, lg);
+        for (index_type y = 0; y < size.y; y += ny) {
+            signed_index_type cy = min.y + signed_index_type(y);
+            ny = pieceLength(cy, size.y - y, lg);
+            for (index_type x = 0; x < size.x; x += nx) {
+                signed_index_type cx = min.x + signed_index_type(x);
+                nx = pieceLength(cx, size.x - x, lg);
+
+                value_type *dst = out + x + y * row + z * slice;
+                value_type value = get(cx, cy, cz);
+
+                // A fill node, an empty branch or outside the tree.
+                if (!isCached(cx, cy, cz)) {
+                    for (index_type k = 0; k < nz; ++k) {
+                        for (index_type j = 0; j < ny; ++j) {
+                            std::fill(dst + j * row + k * slice, 
+                                      dst + j * row + k * slice + nx, value);
+                        }
+                    }
+                    continue;
+                }
+
+                // Negative quadrants are mirrored, so the piece is copied
+                // from its far end backwards along those axes.
+                vec3i stride(1, row, slice);
+                if (cx < 0) {
+                    dst += i32(nx - 1) * stride.x;
+                    stride.x = -stride.x;
+                }
+                if (cy < 0) {
+                    dst += i32(ny - 1) * stride.y;
+                    stride.y = -stride.y;
+                }
+                if (cz < 0) {
+                    dst += i32(nz - 1) * stride.z;
+                    stride.z = -stride.z;
+                }
+
+                vec3ui local(localCoord(cx < 0 ? cx + nx - 1 : cx, lg),
+                             localCoord(cy < 0 ? cy + ny - 1 : cy, lg),
+                             localCoord(cz < 0 ? cz + nz - 1 : cz, lg));
+                m_cell->getBlock(local, vec3ui(nx, ny, nz), dst, stride);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+ConstAccessor<CellType, A>::isCached(signed_index_type i, 
+                                     signed_index_type j, 
+                                     signed_index_type k) const
+{
+    index_vec qc;
+    u8 q = toQuadrantCoords(i, j, k, qc);
+
+    return (q == m_quadrant) && m_cell && 
+           contains(m_cell_origin, m_lg_cell_dim, qc);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ConstAccessor<CellType, A>::clear()
+{
+    for (index_type level = 0; level < MAX_LEVELS; ++level) {
+        m_nodes[level] = NULL;
+    }
+
+    m_top_level   = 0;
+    m_quadrant    = 0;
+    m_cell        = NULL;
+    m_lg_cell_dim = m_tree->m_root[0]->getLgCellDim();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline u8
+ConstAccessor<CellType, A>::toQuadrantCoords(signed_index_type i, 
+                                             signed_index_type j, 
+                                             signed_index_type k, 
+                                             index_vec &qc)
+{
+    // Negative coordinates map to |i| - 1, which is their complement.
+    qc.x = index_type(i < 0 ? ~i : i);
+    qc.y = index_type(j < 0 ? ~j : j);
+    qc.z = index_type(k < 0 ? ~k : k);
+
+    return ((i < 0) << 2) | ((j < 0) << 1) | (k < 0);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+ConstAccessor<CellType, A>::contains(const index_vec &origin, 
+                                     index_type lg_dim,
+                                     const index_vec &qc)
+{
+    // All bits above the block dimension must match the origin.
+    index_type diff = (qc.x ^ origin.x) | (qc.y ^ origin.y) | 
+                      (qc.z ^ origin.z);
+    return (diff >> lg_dim) == 0;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline index_type
+ConstAccessor<CellType, A>::nodeLgDim(const node_type *node)
+{
+    return node->m_lg_child_divisions + node->m_lg_branching_factor;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline index_type
+ConstAccessor<CellType, A>::pieceLength(signed_index_type c, index_type n,
+                                        index_type lg_cell_dim)
+{
+    // Coordinates left in the cell moving up, towards zero when negative.
+    index_type local = localCoord(c, lg_cell_dim);
+    index_type left  = (c < 0) ? local + 1 : (1 << lg_cell_dim) - local;
+    return std::min(left, n);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline index_type
+ConstAccessor<CellType, A>::localCoord(signed_index_type c, 
+                                       index_type lg_cell_dim)
+{
+    return moduloLg(index_type(c < 0 ? ~c : c), lg_cell_dim);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ConstAccessor<CellType, A>::setQuadrant(u8 quadrant)
+{
+    if (quadrant != m_quadrant) {
+        clearBelow(m_top_level + 1);
+        m_top_level = 0;
+        m_quadrant  = quadrant;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename ConstAccessor<CellType, A>::node_type_ptr
+ConstAccessor<CellType, A>::findCachedNode(const index_vec &qc) const
+{
+    // The cached nodes form a single path, so the first one containing the
+    // coordinates on the way up is the deepest.
+    for (index_type level = 1; level <= m_top_level; ++level) {
+        node_type_ptr node = m_nodes[level];
+        if (node && contains(m_node_origins[level], nodeLgDim(node), qc)) {
+            return node;
+        }
+    }
+
+    return m_tree->m_root[m_quadrant];
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename ConstAccessor<CellType, A>::const_reference
+ConstAccessor<CellType, A>::getFrom(node_type_ptr node, const index_vec &qc)
+{
+    while (true) {
+        cacheNode(node, qc);
+
+        // Fill nodes hold a single value over their whole extent.
+        if (node->isFill()) {
+            clearBelow(node->level());
+            return node->fillValue();
+        }
+
+        // The branch index, using coordinates local to the node.
+        index_type lg_dim = nodeLgDim(node);
+        index_type branch = node->computeBranchIndex(moduloLg(qc.x, lg_dim),
+                                                     moduloLg(qc.y, lg_dim),
+                                                     moduloLg(qc.z, lg_dim));
+
+        // If branch does not have a value, then return default value.
+        if (!node->m_bitfield.isSet(branch)) {
+            clearBelow(node->level());
+            return node->defaultValue();
+        }
+
+        if (node->isCellParent()) {
+            cacheCell(node->getBranch(branch).cell, qc);
+            return m_cell->get(moduloLg(qc.x, m_lg_cell_dim),
+                               moduloLg(qc.y, m_lg_cell_dim),
+                               moduloLg(qc.z, m_lg_cell_dim));
+        }
+
+        node = node->getBranch(branch).node;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ConstAccessor<CellType, A>::cacheNode(node_type_ptr node, const index_vec &qc)
+{
+    index_type level  = node->level();
+    index_type lg_dim = nodeLgDim(node);
+
+    m_nodes[level] = node;
+    m_top_level = std::max(m_top_level, level);
+    m_node_origins[level] = index_vec((qc.x >> lg_dim) << lg_dim,
+                                      (qc.y >> lg_dim) << lg_dim,
+                                      (qc.z >> lg_dim) << lg_dim);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ConstAccessor<CellType, A>::cacheCell(cell_type_ptr cell, const index_vec &qc)
+{
+    m_cell = cell;
+    m_cell_origin = index_vec((qc.x >> m_lg_cell_dim) << m_lg_cell_dim,
+                              (qc.y >> m_lg_cell_dim) << m_lg_cell_dim,
+                              (qc.z >> m_lg_cell_dim) << m_lg_cell_dim);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ConstAccessor<CellType, A>::clearBelow(index_type level)
+{
+    for (index_type l = 1; l < level && l <= m_top_level; ++l) {
+        m_nodes[l] = NULL;
+    }
+
+    m_cell = NULL;
+}
+
+//------------------------------------------------------------------------------
+// Accessor implementation
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline
+Accessor<CellType, A>::Accessor(tree_type *tree) :
+    ConstAccessor<CellType, A>(tree)
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Accessor<CellType, A>::set(signed_index_type i,
+                           signed_index_type j,
+                           signed_index_type k,
+                           const_reference val)
+{
+    update(i, j, k, val, set_op<value_type>());
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Accessor<CellType, A>::set(const signed_index_vec &coords, const_reference val)
+{
+    update(coords.x, coords.y, coords.z, val, set_op<value_type>());
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename BinaryOp>
+inline void
+Accessor<CellType, A>::updateBlock(const signed_index_vec &min,
+                                   const index_vec &size, 
+                                   const value_type *vals, BinaryOp op)
+{
+    const index_type lg = this->m_lg_cell_dim;
+    const index_type row   = size.x;
+    const index_type slice = size.x * size.y;
+
+    // Other threads may replace the cached cell, write voxel by voxel.
+    if (this->m_tree->isConcurrentWrites()) {
+        for (index_type z = 0; z < size.z; ++z) {
+            for (index_type y = 0; y < size.y; ++y) {
+                for (index_type x = 0; x < size.x; ++x) {
+                    update(min.x + signed_index_type(x), 
+                           min.y + signed_index_type(y), 
+                           min.z + signed_index_type(z), 
+                           vals[x + y * row + z * slice], op);
+                }
+            }
+        }
+        return;
+    }
+
+    index_type nx, ny, nz;
+    for (index_type z = 0; z < size.z; z += nz) {
+        signed_index_type cz = min.z + signed_index_type(z);
+        nz = base_type::pieceLength(cz, size.z - z, lg);
+        for (index_type y = 0; y < size.y; y += ny) {
+            signed_index_type cy = min.y + signed_index_type(y);
+            ny = base_type::pieceLength(cy, size.y - y, lg);
+            for (index_type x = 0; x < size.x; x += nx) {
+                signed_index_type cx = min.x + signed_index_type(x);
+                nx = base_type::pieceLength(cx, size.x - x, lg);
+
+                // The first voxel descends, creating the path to the cell 
+                // unless it sits in a fill node the update leaves untouched.
+                const value_type *src = vals + x + y * row + z * slice;
+                update(cx, cy, cz, *src, op);
+                bool cached = this->isCached(cx, cy, cz);
+
+                for (index_type k = 0; k < nz; ++k) {
+                    for (index_type j = 0; j < ny; ++j) {
+                        for (index_type i = 0; i < nx; ++i) {
+                            if ((i | j | k) == 0) continue;
+
+                            const value_type &val = 
+                                src[i + j * row + k * slice];
+                            signed_index_type vx = cx + signed_index_type(i);
+                            signed_index_type vy = cy + signed_index_type(j);
+                            signed_index_type vz = cz + signed_index_type(k);
+                            if (cached) {
+                                this->m_cell->update(
+                                    base_type::localCoord(vx, lg), 
+                                    base_type::localCoord(vy, lg), 
+                                    base_type::localCoord(vz, lg), val, op);
+                            } else {
+                                update(vx, vy, vz, val, op);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename BinaryOp>
+inline void
+Accessor<CellType, A>::update(signed_index_type i, 
+                              signed_index_type j, 
+                              signed_index_type k, 
+                              const_reference val, BinaryOp op)
+{
+    // Choose the quadrant and convert into quadrant coords.
+    index_vec qc;
+    u8 q = base_type::toQuadrantCoords(i, j, k, qc);
+
+    if (this->m_tree->isConcurrentWrites()) {
+        updateConcurrent(q, qc, val, op);
+        return;
+    }
+
+    // Fast path, the voxel lives in the cached cell.
+    index_type lg_cell_dim = this->m_lg_cell_dim;
+    if ((q == this->m_quadrant) && this->m_cell && 
+        base_type::contains(this->m_cell_origin, lg_cell_dim, qc)) {
+        this->m_cell->update(moduloLg(qc.x, lg_cell_dim),
+                             moduloLg(qc.y, lg_cell_dim),
+                             moduloLg(qc.z, lg_cell_dim), val, op);
+        return;
+    }
+
+    // Growing the quadrant may delete an empty root, drop the cache.
+    index_type max_dim = this->m_tree->m_max_dim[q];
+    if (qc.x >= max_dim || qc.y >= max_dim || qc.z >= max_dim) {
+        this->m_tree->grow(q, qc.x, qc.y, qc.z);
+        this->clear();
+    }
+
+    // Resume the descent from the deepest cached node.
+    this->setQuadrant(q);
+    updateFrom(this->findCachedNode(qc), qc, val, op);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename BinaryOp>
+inline void
+Accessor<CellType, A>::update(const signed_index_vec &coords, 
+                              const_reference val, BinaryOp op)
+{
+    update(coords.x, coords.y, coords.z, val, op);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Accessor<CellType, A>::unset(signed_index_type i,
+                             signed_index_type j,
+                             signed_index_type k)
+{
+    this->m_tree->unset(i, j, k);
+    this->clear();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Accessor<CellType, A>::unset(const signed_index_vec &coords)
+{
+    unset(coords.x, coords.y, coords.z);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename BinaryOp>
+inline void
+Accessor<CellType, A>::updateFrom(node_type_ptr node, const index_vec &qc,
+                                  const_reference val, BinaryOp op)
+{
+    while (true) {
+        this->cacheNode(node, qc);
+
+        if (node->isFill()) {
+            // Nothing to do if the fill value is left untouched.
+            if (op(node->fillValue(), val) == node->fillValue()) {
+                this->clearBelow(node->level());
+                return;
+            }
+
+            // Allocate and create LOD tree with fill branches.
+            node->createFillBranches(node->fillValue());
+        }
+
+        // Get/Allocate the right branch and get the child coordinates to
+        // traverse down it. 
+        index_type lg_dim = base_type::nodeLgDim(node);
+        index_type branch, i_child, j_child, k_child;
+        node->setBranch(moduloLg(qc.x, lg_dim),
+                        moduloLg(qc.y, lg_dim),
+                        moduloLg(qc.z, lg_dim),
+                        branch, i_child, j_child, k_child);
+
+        if (node->isCellParent()) {
+            this->cacheCell(node->getBranch(branch).cell, qc);
+            this->m_cell->update(i_child, j_child, k_child, val, op);
+            return;
+        }
+
+        node = node->getBranch(branch).node;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename BinaryOp>
+inline void
+Accessor<CellType, A>::updateConcurrent(u8 q, const index_vec &qc,
+                                        const_reference val, BinaryOp op)
+{
+    // Fast path, the voxel lives in the cached cell.
+    index_type lg_cell_dim = this->m_lg_cell_dim;
+    if ((q == this->m_quadrant) && this->m_cell && 
+        base_type::contains(this->m_cell_origin, lg_cell_dim, qc)) {
+        SpinLock::ScopedLock lock(this->m_cell->spinLock());
+        this->m_cell->update(moduloLg(qc.x, lg_cell_dim),
+                             moduloLg(qc.y, lg_cell_dim),
+                             moduloLg(qc.z, lg_cell_dim), val, op);
+        return;
+    }
+
+    // Descend through the tree, caching only the cell written to.
+    this->clearBelow(this->m_top_level + 1);
+    this->m_top_level = 0;
+    this->m_quadrant  = q;
+
+    cell_type_ptr cell = 
+        this->m_tree->updateConcurrent(q, qc.x, qc.y, qc.z, val, op);
+    if (cell) {
+        this->cacheCell(cell, qc);
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -43,6 +43,7 @@
 #include <assert.h>
 #include <algorithm>
 #include <memory>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include <boost/typeof/typeof.hpp>
 
@@ -51,12 +52,18 @@
 
 #include <nkhive/Defs.h>
 #include <nkhive/Types.h>
+#include <nkhive/memory/PoolAllocator.h>
+#include <nkhive/util/SpinLock.h>
 #include <nkhive/bitfields/BitField3D.h>
 #include <nkhive/tiling/Stamp.h>
 #include <nkhive/util/Bounds3D.h>
 #include <nkhive/io/hdf5/HDF5Group.h>
 #include <nkhive/io/hdf5/HDF5Util.h>
 #include <nkhive/io/hdf5/HDF5DataType.h>
+#include <nkhive/io/hdf5/HDF5LeafTable.h>
+#include <nkhive/io/MappedLeafTable.h>
+#include <nkhive/io/StreamLeafIndex.h>
+#include <nkhive/volume/CellPager.h>
 
 //------------------------------------------------------------------------------
 // forward declarations
@@ -68,17 +75,26 @@ class TestNode;
 
 BEGIN_NKHIVE_NS
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 class Cell;
 
 template <typename T> 
 class CellSetIterator;
 
-template<typename T, typename A>
-std::istream& operator>>(std::istream& is, const Cell<T, A>& cell); 
+template <typename CellType>
+class Leaf;
 
-template<typename T, typename A>
-std::ostream& operator<<(std::ostream& os, const Cell<T, A>& cell); 
+template <typename CellType, typename A>
+class Node;
+
+template <typename CellType>
+class CellPager;
+
+template<typename T, typename A, typename L>
+std::istream& operator>>(std::istream& is, const Cell<T, A, L>& cell); 
+
+template<typename T, typename A, typename L>
+std::ostream& operator<<(std::ostream& os, const Cell<T, A, L>& cell); 
 
 END_NKHIVE_NS
 
@@ -88,7 +104,8 @@ END_NKHIVE_NS
 
 BEGIN_NKHIVE_NS
 
-template < typename T, typename A = std::allocator<T> >
+template < typename T, typename A = std::allocator<T>, 
+           typename L = RowMajorLayout >
 class Cell
 {
     
@@ -113,6 +130,9 @@ public:
     typedef boost::shared_ptr<Cell>                  shared_ptr;
     typedef boost::shared_ptr<const Cell>            shared_const_ptr;
 
+    typedef L                                        layout_type;
+    typedef BitField3D<index_type, bitfield_alloc, L> bitfield_type;
+
     class iterator;
     class const_iterator;
 
@@ -129,7 +149,10 @@ public:
     enum Flags 
     {
         CELL_FLAG_COMPRESSED = 0x01,
-        CELL_FLAG_FILLED     = 0x02
+        CELL_FLAG_FILLED     = 0x02,
+        CELL_FLAG_MAPPED     = 0x04,  // voxels belong to a mapped file
+        CELL_FLAG_PAGED      = 0x08,  // voxels are paged out to disk
+        CELL_FLAG_DIRTY      = 0x10   // modified since read or last saved
     };
 
     //--------------------------------------------------------------------------
@@ -178,8 +201,18 @@ public:
      * Check state of cell.
      */
     bool isEmpty() const;
+    bool isFull() const;
     bool isFilled() const;
     bool isCompressed() const;
+    bool isMapped() const;
+    bool isPaged() const;
+
+    /**
+     * Cells are dirty when created or modified, and clean once read or 
+     * saved incrementally, see Tree::writeIncremental().
+     */
+    bool isDirty() const;
+    void markClean();
 
     /**
      * Check the status of a voxel at the given coordinates.
@@ -227,6 +260,13 @@ public:
     void setBlock(const vec3ui &min, size_type window_size, 
                   const_reference value);
 
+    /**
+     * Copies the size block of voxels at local min to out. A step along
+     * each axis moves out by that axis' stride, which may be negative.
+     */
+    void getBlock(const vec3ui &min, const vec3ui &size, pointer out, 
+                  const vec3i &stride) const;
+
     /**
      * Writes the stamp to the cell.  
      */
@@ -263,6 +303,18 @@ public:
      * Fill all voxels with value.
      */
     void fill(const_reference value);
+
+    /**
+     * Turns the cell into a fill cell if all set voxels are within tolerance
+     * of the first one. Returns true if the cell is a fill cell afterwards.
+     */
+    bool prune(const_reference tolerance);
+
+    /**
+     * Returns true if the values differ by no more than tolerance.
+     */
+    static bool withinTolerance(const_reference a, const_reference b, 
+                                const_reference tolerance);
  
     /**
      * Read and write cell to/from input stream.
@@ -272,6 +324,38 @@ public:
     void read(HDF5Id leaf_group_id);
     void write(HDF5Id volume_group_id, 
                size_t quadrant, index_vec offset) const;
+    void read(const HDF5LeafTable<T> &table, size_t leaf);
+    void write(HDF5LeafTable<T> &table,
+               size_t quadrant, index_vec offset) const;
+
+    /**
+     * Fills in the record of the cell stored in a leaf group and appends its
+     * bitfield and voxels to the table as stored, without decoding them. 
+     * The cell is read from the table later, see ParallelReader.
+     */
+    static void gather(HDF5Id leaf_group_id, HDF5LeafTable<T> &table,
+                       typename HDF5LeafTable<T>::Record &record);
+
+    /**
+     * Points the cell at its compressed voxels in a mapped native file. The
+     * voxels are copied into the cell on the first write. Cells not stored
+     * row major are copied right away.
+     */
+    void read(const MappedLeafTable<T> &table, size_t leaf);
+
+    /**
+     * Reads the cell paged out, the pager loads its voxels on first access.
+     * Fill cells have no voxels and are read right away.
+     */
+    void read(CellPager<Cell> &pager, size_t leaf);
+
+    /**
+     * Indexed tree streams, see StreamLeafIndex. The cell is stored as by
+     * write(std::ostream&) and recorded in the table of contents.
+     */
+    void read(const StreamLeafIndex<T> &index, size_t leaf);
+    void write(StreamLeafWriter<T> &writer,
+               size_t quadrant, index_vec offset) const;
                
 
     /** 
@@ -284,19 +368,25 @@ public:
      * Read cell from input stream.
      */
     friend std::istream& operator>> <> (std::istream& is, 
-                                        const Cell<T, A>& cell);
+                                        const Cell<T, A, L>& cell);
 
     /**
      * Write cell to output stream.
      */
     friend std::ostream& operator<< <> (std::ostream& os, 
-                                        const Cell<T, A>& cell);
+                                        const Cell<T, A, L>& cell);
 
     /**
-     * Returns memory used by class.
+     * Returns memory used by class. Mapped voxels are not counted.
      */
     int sizeOf() const;
 
+    /**
+     * Lock serializing writers while the owning tree takes concurrent writes.
+     * The cell itself never takes it.
+     */
+    SpinLock& spinLock() const;
+
 private:
 
     //--------------------------------------------------------------------------
@@ -331,11 +421,34 @@ private:
     void unsetFlag(uint8_t flag);
     bool isFlagSet(uint8_t flag) const;
 
+    /**
+     * Flags describing the contents of the cell, leaving out where its
+     * voxels are kept and whether they were saved.
+     */
+    u8 storedFlags() const;
+
     /**
      * Operations for destructing the cell.
      */
     void destruct();
 
+    /**
+     * Copies mapped voxels into memory owned by the cell and takes paged
+     * cells off their pager, before the cell is modified. Marks the cell
+     * dirty.
+     */
+    void detach();
+
+    /**
+     * Paging hooks. page() makes the voxels resident before they are read,
+     * unpage() also releases the cell from its pager. pageIn() takes the
+     * compressed row major voxels of the cell, pageOut() frees them.
+     */
+    void page() const;
+    void unpage();
+    void pageIn(const std::vector<value_type> &voxels);
+    void pageOut();
+
     /** 
      * Copy from another cell.
      */
@@ -362,6 +475,47 @@ private:
     void writeInternal(std::ostream &os) const;
     void writeInternal(HDF5Id cell_group_id) const;
 
+    /**
+     * Number of voxels stored on disk for the cell, the set voxels unless
+     * the cell is filled.
+     */
+    size_type storedSize() const;
+
+    /**
+     * Hands the stored voxels of a row major cell to out(data, count) in
+     * runs, compacting uncompressed voxels through a small stack buffer.
+     */
+    template <typename Writer>
+    void writeVoxels(Writer &out) const;
+
+    /** Voxels compacted per run by writeVoxels(). */
+    enum { WRITE_BUFFER_SIZE = 256 };
+
+    /**
+     * Voxel writers appending runs to a stream or to a vector.
+     */
+    struct StreamWriter
+    {
+        StreamWriter(std::ostream &os) : m_os(os) {}
+        void operator()(const T *data, size_type count);
+        std::ostream &m_os;
+    };
+
+    struct VectorWriter
+    {
+        VectorWriter(std::vector<T> &voxels) : m_voxels(voxels) {}
+        void operator()(const T *data, size_type count);
+        std::vector<T> &m_voxels;
+    };
+
+    /**
+     * Copies a cell, moving its voxels into this cell's layout. Cells are
+     * read and written row major through it.
+     */
+    void relayout(const Cell &that);
+    template <typename M>
+    void relayout(const Cell<T, A, M> &that);
+
     //--------------------------------------------------------------------------
     // friends
     //--------------------------------------------------------------------------
@@ -376,6 +530,18 @@ private:
     template <typename U>
     friend class CellSetIterator;
 
+    template <typename U, typename B, typename M>
+    friend class Cell;
+
+    template <typename CellType>
+    friend class Leaf;
+
+    template <typename CellType, typename Alloc>
+    friend class Node;
+
+    template <typename CellType>
+    friend class CellPager;
+
     //--------------------------------------------------------------------------
     // members
     //--------------------------------------------------------------------------
@@ -387,6 +553,9 @@ private:
     value_type         m_fill_value;
     bitfield_type      m_bitfield; 
     u8                 m_flags;
+    mutable SpinLock   m_lock;
+    CellPager<Cell>   *m_pager;
+    size_type          m_page;
     
 }; 
 
@@ -394,8 +563,8 @@ private:
 // iterator
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A = std::allocator<T> >
-class Cell<T, A>::iterator
+template<typename T, typename A, typename L>
+class Cell<T, A, L>::iterator
 {
 
 public:
@@ -455,8 +624,8 @@ private:
 // const iterator
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A = std::allocator<T> >
-class Cell<T, A>::const_iterator
+template<typename T, typename A, typename L>
+class Cell<T, A, L>::const_iterator
 {
 
 public:
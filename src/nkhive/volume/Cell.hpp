@@ -39,29 +39,33 @@
 // class implementation 
 //-----------------------------------------------------------------------------
 
-template < typename T, typename A>
+template < typename T, typename A, typename L>
 inline
-Cell<T, A>::Cell() :
+Cell<T, A, L>::Cell() :
     m_allocator(),
     m_data(0),
     m_data_size(0),
     m_default_value(),
     m_fill_value(),
     m_bitfield(),
-    m_flags(0)
+    m_flags(CELL_FLAG_DIRTY),
+    m_pager(NULL),
+    m_page(0)
 {
 }
 
 //-----------------------------------------------------------------------------
 
-template < typename T, typename A>
+template < typename T, typename A, typename L>
 inline
-Cell<T, A>::Cell(u8 lg_dim_size,  const_reference v,
+Cell<T, A, L>::Cell(u8 lg_dim_size,  const_reference v,
                  const allocator_type& a) :
     m_allocator(a),
     m_fill_value(v),
-    m_bitfield(lg_dim_size, bitfield_alloc()),
-    m_flags(0)
+    m_bitfield(lg_dim_size, bitfield_alloc(PoolTraits<A>::pool(a))),
+    m_flags(CELL_FLAG_DIRTY),
+    m_pager(NULL),
+    m_page(0)
 {
     // Do not allocate data until the first set.
     m_data = NULL;
@@ -77,13 +81,15 @@ Cell<T, A>::Cell(u8 lg_dim_size,  const_reference v,
 
 //------------------------------------------------------------------------------
 
-template < typename T, typename A>
+template < typename T, typename A, typename L>
 inline
-Cell<T, A>::Cell(u8 lg_dim_size,  const_reference default_value,
+Cell<T, A, L>::Cell(u8 lg_dim_size,  const_reference default_value,
                  const_reference fill_value, const allocator_type& a) :
     m_allocator(a),
-    m_bitfield(lg_dim_size, bitfield_alloc()),
-    m_flags(0)
+    m_bitfield(lg_dim_size, bitfield_alloc(PoolTraits<A>::pool(a))),
+    m_flags(CELL_FLAG_DIRTY),
+    m_pager(NULL),
+    m_page(0)
 {
     // Do not allocate data until the first set.
     m_data = NULL;
@@ -104,27 +110,27 @@ Cell<T, A>::Cell(u8 lg_dim_size,  const_reference default_value,
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline
-Cell<T, A>::Cell(const Cell& other)
+Cell<T, A, L>::Cell(const Cell& other)
 {
     copy(other);
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline
-Cell<T, A>::~Cell()
+Cell<T, A, L>::~Cell()
 {
     destruct();
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename Cell<T, A>::reference
-Cell<T, A>::get(size_type i, size_type j, size_type k)
+template <typename T, typename A, typename L>
+inline typename Cell<T, A, L>::reference
+Cell<T, A, L>::get(size_type i, size_type j, size_type k)
 {
     size_type index = m_bitfield.getIndex(i, j, k);
     return get(index);
@@ -132,18 +138,18 @@ Cell<T, A>::get(size_type i, size_type j, size_type k)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_reference
-Cell<T, A>::get(size_type i, size_type j, size_type k) const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_reference
+Cell<T, A, L>::get(size_type i, size_type j, size_type k) const
 {
     return const_cast<Cell&>(*this).get(i, j, k);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
-inline typename Cell<T, A>::reference
-Cell<T, A>::get(size_type index)
+template <typename T, typename A, typename L>
+inline typename Cell<T, A, L>::reference
+Cell<T, A, L>::get(size_type index)
 {
     if (!m_bitfield.isSet(index)) {
         return getDefaultValue();
@@ -151,6 +157,7 @@ Cell<T, A>::get(size_type index)
         // the bit is set and is a filled node.
         return getFillValue();
     } else {
+        page();
         if (isCompressed()) {
             // get the number of set bits up to and including this index 
             // subtract 1 to get the index  
@@ -164,24 +171,24 @@ Cell<T, A>::get(size_type index)
 
 //------------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_reference
-Cell<T, A>::get(size_type index) const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_reference
+Cell<T, A, L>::get(size_type index) const
 {
     return const_cast<Cell&>(*this).get(index);
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void 
-Cell<T, A>::unsetBlock(const vec3ui &min, size_type window_size)
+Cell<T, A, L>::unsetBlock(const vec3ui &min, size_type window_size)
 {
     // get the min raw bit index
     size_type min_index = m_bitfield.getIndex(min.x, min.y, min.z);
     
     // create a window iterator on the bitfield
-    bitfield_type::window_iterator window_iter = 
+    typename bitfield_type::window_iterator window_iter = 
         m_bitfield.windowIterator(min_index, window_size);
 
     // iterate through and unset each set index
@@ -197,9 +204,9 @@ Cell<T, A>::unsetBlock(const vec3ui &min, size_type window_size)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void 
-Cell<T, A>::setBlock(const vec3ui &min, size_type window_size, 
+Cell<T, A, L>::setBlock(const vec3ui &min, size_type window_size, 
                     const_reference value)
 {
     // get the min raw bit index
@@ -211,7 +218,7 @@ Cell<T, A>::setBlock(const vec3ui &min, size_type window_size,
         fill(value);
     } else {
         // create a window iterator on the bitfield
-        bitfield_type::window_iterator window_iter = 
+        typename bitfield_type::window_iterator window_iter = 
             m_bitfield.windowIterator(min_index, window_size);
 
         // iterate through and set each index
@@ -225,10 +232,38 @@ Cell<T, A>::setBlock(const vec3ui &min, size_type window_size,
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
+inline void 
+Cell<T, A, L>::getBlock(const vec3ui &min, const vec3ui &size, pointer out,
+                        const vec3i &stride) const
+{
+    page();
+
+    // Unset voxels always read the current default, dense data may hold a
+    // stale one. Filled and compressed cells go through get().
+    const bool dense = !isFilled() && !isCompressed();
+    for (size_type k = 0; k < size.z; ++k) {
+        for (size_type j = 0; j < size.y; ++j) {
+            pointer dst = out + i32(k) * stride.z + i32(j) * stride.y;
+            for (size_type i = 0; i < size.x; ++i, dst += stride.x) {
+                size_type index = m_bitfield.getIndex(min.x + i, min.y + j, 
+                                                      min.z + k);
+                if (!m_bitfield.isSet(index)) {
+                    *dst = m_default_value;
+                } else {
+                    *dst = dense ? m_data[index] : get(index);
+                }
+            }
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
 template <typename U, template <typename> class Source>
 inline void 
-Cell<T, A>::stamp(const Stamp<U, Source> &stamp, 
+Cell<T, A, L>::stamp(const Stamp<U, Source> &stamp, 
                   signed_index_bounds stamp_bounds, 
                   const index_bounds &cell_bounds, 
                   const signed_index_vec &transform) 
@@ -263,18 +298,18 @@ Cell<T, A>::stamp(const Stamp<U, Source> &stamp,
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::size_type
-Cell<T, A>::getDimension() const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::size_type
+Cell<T, A, L>::getDimension() const
 {
     return (1 << m_bitfield.size());
 }
 
 //------------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void
-Cell<T, A>::computeSetBounds(index_bounds &bounds) const
+Cell<T, A, L>::computeSetBounds(index_bounds &bounds) const
 {
     // We should never have empty cells.
     assert(!isEmpty());
@@ -300,45 +335,90 @@ Cell<T, A>::computeSetBounds(index_bounds &bounds) const
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool
-Cell<T, A>::isCompressed() const
+Cell<T, A, L>::isCompressed() const
 {
     return isFlagSet(CELL_FLAG_COMPRESSED);
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool
-Cell<T, A>::isFilled() const
+Cell<T, A, L>::isFilled() const
 {
     return isFlagSet(CELL_FLAG_FILLED);
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
+inline bool
+Cell<T, A, L>::isMapped() const
+{
+    return isFlagSet(CELL_FLAG_MAPPED);
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+inline bool
+Cell<T, A, L>::isPaged() const
+{
+    return isFlagSet(CELL_FLAG_PAGED);
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+inline bool
+Cell<T, A, L>::isDirty() const
+{
+    return isFlagSet(CELL_FLAG_DIRTY);
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::markClean()
+{
+    unsetFlag(CELL_FLAG_DIRTY);
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
 inline bool
-Cell<T, A>::isSet(size_type i, size_type j, size_type k) const
+Cell<T, A, L>::isFull() const
+{
+    return m_bitfield.isFull();
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+inline bool
+Cell<T, A, L>::isSet(size_type i, size_type j, size_type k) const
 {
     return m_bitfield.isSet(i, j, k);
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool
-Cell<T, A>::isEmpty() const
+Cell<T, A, L>::isEmpty() const
 {
     return m_bitfield.isEmpty();
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::iterator 
-Cell<T, A>::begin()
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::iterator 
+Cell<T, A, L>::begin()
 {
     assert(!isFilled());
     return iterator(m_data, m_data + m_data_size, m_data);
@@ -346,28 +426,30 @@ Cell<T, A>::begin()
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::iterator 
-Cell<T, A>::end()
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::iterator 
+Cell<T, A, L>::end()
 {
     return iterator(m_data, m_data + m_data_size, m_data + m_data_size);
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_iterator 
-Cell<T, A>::begin() const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_iterator 
+Cell<T, A, L>::begin() const
 {
+    page();
     return const_iterator(this, m_bitfield.begin(), m_data);
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_iterator 
-Cell<T, A>::end() const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_iterator 
+Cell<T, A, L>::end() const
 {
+    page();
     if (isFilled()) {
         // HACK: Since we have a filled cell we can pass in the largest
         // available pointer value for the end condition.
@@ -379,9 +461,9 @@ Cell<T, A>::end() const
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void 
-Cell<T, A>::set(size_type i, size_type j, size_type k, const_reference value)
+Cell<T, A, L>::set(size_type i, size_type j, size_type k, const_reference value)
 {
     size_type index = m_bitfield.getIndex(i, j, k);
     set(index, value);
@@ -389,10 +471,12 @@ Cell<T, A>::set(size_type i, size_type j, size_type k, const_reference value)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void 
-Cell<T, A>::set(size_type index, const_reference value)
+Cell<T, A, L>::set(size_type index, const_reference value)
 {
+    detach();
+
     if (isCompressed()) {
         // can't modify a compressed cell
         throw Iex::LogicExc("Can't modify a compressed cell");
@@ -442,10 +526,10 @@ Cell<T, A>::set(size_type index, const_reference value)
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename BinaryOp>
 inline void
-Cell<T, A>::update(size_type i, size_type j, size_type k,
+Cell<T, A, L>::update(size_type i, size_type j, size_type k,
                    const_reference value, BinaryOp op)
 {
     size_type index = m_bitfield.getIndex(i, j, k);
@@ -454,10 +538,10 @@ Cell<T, A>::update(size_type i, size_type j, size_type k,
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 template <typename BinaryOp>
 inline void
-Cell<T, A>::update(size_type index, const_reference value, BinaryOp op)
+Cell<T, A, L>::update(size_type index, const_reference value, BinaryOp op)
 {
     // Update the value first in a temporary variable.
     value_type val = get(index);
@@ -469,9 +553,9 @@ Cell<T, A>::update(size_type index, const_reference value, BinaryOp op)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void 
-Cell<T, A>::unset(size_type i, size_type j, size_type k)
+Cell<T, A, L>::unset(size_type i, size_type j, size_type k)
 {
     size_type index = m_bitfield.getIndex(i, j, k);
     unset(index);
@@ -479,10 +563,12 @@ Cell<T, A>::unset(size_type i, size_type j, size_type k)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void 
-Cell<T, A>::unset(size_type index)
+Cell<T, A, L>::unset(size_type index)
 {
+    detach();
+
     if (isCompressed()) {
         // can't modify a compressed cell
         throw new Iex::LogicExc("Can't modify a compressed cell");
@@ -499,10 +585,12 @@ Cell<T, A>::unset(size_type index)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void 
-Cell<T, A>::compress()
+Cell<T, A, L>::compress()
 {
+    unpage();
+
     if (!isCompressed() && !isFilled()) {
 
         size_type num_set_bits = m_bitfield.count();
@@ -531,6 +619,9 @@ Cell<T, A>::compress()
         // point to the compressed data
         m_data = compressed_data;
         m_data_size = num_set_bits;
+
+        // compressed lookups rank the set bits
+        m_bitfield.buildRankDirectory();
     } 
         
     // set the compressed flag
@@ -539,10 +630,12 @@ Cell<T, A>::compress()
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void 
-Cell<T, A>::uncompress()
+Cell<T, A, L>::uncompress()
 {
+    unpage();
+
     if (isCompressed() && !isFilled()) {
         // allocate space for uncompressed data
         size_type total_voxels = numBits3D(m_bitfield.size());
@@ -566,18 +659,23 @@ Cell<T, A>::uncompress()
             *set_bit_itr = *cmp_data_itr;
         }
 
-        // delete the compressed data
-        
-        // destroy objects
-        deinitialize(begin(), end());
+        // delete the compressed data, mapped data belongs to the file
+        if (isMapped()) {
+            unsetFlag(CELL_FLAG_MAPPED);
+        } else {
+            // destroy objects
+            deinitialize(begin(), end());
     
-        // free memory
-        m_allocator.deallocate(m_data, m_data_size);
+            // free memory
+            m_allocator.deallocate(m_data, m_data_size);
+        }
 
         // point to the uncompressed data
         m_data = uncompressed_data;
         m_data_size = total_voxels;
 
+        m_bitfield.clearRankDirectory();
+
     }    
         
     // unset the compressed state variable
@@ -586,10 +684,12 @@ Cell<T, A>::uncompress()
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void
-Cell<T, A>::fill(const_reference value)
+Cell<T, A, L>::fill(const_reference value)
 {
+    detach();
+
     // can't fill a compressed cell
     if (isCompressed()) {
         // can't modify a compressed cell
@@ -616,10 +716,66 @@ Cell<T, A>::fill(const_reference value)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
+inline bool
+Cell<T, A, L>::prune(const_reference tolerance)
+{
+    if (isFilled()) return true;
+
+    page();
+
+    if (m_bitfield.isEmpty()) {
+        destruct();
+        setFlag(CELL_FLAG_FILLED | CELL_FLAG_DIRTY);
+        return true;
+    }
+
+    // compressed cells only hold the set voxels
+    bool uniform = true;
+    value_type value;
+    if (isCompressed()) {
+        value = m_data[0];
+        for (size_type n = 1; uniform && n < m_data_size; ++n) {
+            uniform = withinTolerance(m_data[n], value, tolerance);
+        }
+    } else {
+        set_iterator iter = m_bitfield.setIterator(begin());
+        value = *iter;
+        for (++iter; uniform && iter(); ++iter) {
+            uniform = withinTolerance(*iter, value, tolerance);
+        }
+    }
+
+    if (!uniform) return false;
+
+    // drop the data, the bitfield keeps tracking the set voxels
+    destruct();
+    m_bitfield.clearRankDirectory();
+    setFillValue(value);
+    setFlag(CELL_FLAG_FILLED | CELL_FLAG_DIRTY);
+
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+inline bool
+Cell<T, A, L>::withinTolerance(const_reference a, const_reference b, 
+                               const_reference tolerance)
+{
+    // written to avoid wrapping around for unsigned types
+    return (a < b) ? !(tolerance < b - a) : !(tolerance < a - b);
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
 inline void
-Cell<T, A>::clear()
+Cell<T, A, L>::clear()
 {
+    detach();
+
     // can't clear a compressed cell
     if (isCompressed()) {
         // can't modify a compressed cell
@@ -640,10 +796,17 @@ Cell<T, A>::clear()
     
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void
-Cell<T, A>::read(std::istream &is)
+Cell<T, A, L>::read(std::istream &is)
 {
+    if (!L::kRowMajor) {
+        Cell<T, A> row_major;
+        row_major.read(is);
+        relayout(row_major);
+        return;
+    }
+
     destruct();
 
     // read cell flags
@@ -676,15 +839,24 @@ Cell<T, A>::read(std::istream &is)
         setFlag(CELL_FLAG_COMPRESSED);
 
         uncompress();
+    } else if (!isFilled()) {
+        m_bitfield.buildRankDirectory();
     }
 }
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void
-Cell<T, A>::read(HDF5Id leaf_group_id)
+Cell<T, A, L>::read(HDF5Id leaf_group_id)
 {
+    if (!L::kRowMajor) {
+        Cell<T, A> row_major;
+        row_major.read(leaf_group_id);
+        relayout(row_major);
+        return;
+    }
+
     destruct();
 
     // read in flags
@@ -731,37 +903,203 @@ Cell<T, A>::read(HDF5Id leaf_group_id)
         // won't do anything
         setFlag(CELL_FLAG_COMPRESSED);
         uncompress();
+    } else if (!isFilled()) {
+        m_bitfield.buildRankDirectory();
     }
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template <typename T, typename A, typename L>
 inline void
-Cell<T, A>::write(std::ostream &os) const
+Cell<T, A, L>::read(const HDF5LeafTable<T> &table, size_t leaf)
 {
-    // write cell flags
-    os.write((char*)&m_flags, sizeof(BOOST_TYPEOF(m_flags)));
+    if (!L::kRowMajor) {
+        Cell<T, A> row_major;
+        row_major.read(table, leaf);
+        relayout(row_major);
+        return;
+    }
+
+    destruct();
+
+    const typename HDF5LeafTable<T>::Record &record = table[leaf];
+    m_flags         = record.flags;
+    m_default_value = record.default_value;
+    m_fill_value    = record.fill_value;
+
+    // read in bitfield
+    m_bitfield.read(record.lg_dim,
+                    &table.bitfields()[0] + record.bitfield_offset);
+
+    // copy out voxel data
+    if (!isFilled()) {
+        m_data_size = record.voxel_count;
+        m_data = m_allocator.allocate(m_data_size);
+        std::copy(table.voxels().begin() + record.voxel_offset,
+                  table.voxels().begin() + record.voxel_offset + m_data_size,
+                  m_data);
+    }
+
+    // check state to see if we should uncompress
+    if (!isCompressed()) {
+        // uncompress since it's always compressed on disk
+        // first set the flag to compressed otherwise uncompress
+        // won't do anything
+        setFlag(CELL_FLAG_COMPRESSED);
+        uncompress();
+    } else if (!isFilled()) {
+        m_bitfield.buildRankDirectory();
+    }
+}
 
-    // make a copy to compress
-    // this is so the compression doesn't affect the state
-    // of this object.
-    // the other alternative is uncompressing after the write is done
-    // which would be slower
-    Cell<T, A> cellCopy(*this);
+//-----------------------------------------------------------------------------
 
-    // compress
-    cellCopy.compress();
+template <typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::gather(HDF5Id leaf_group_id, HDF5LeafTable<T> &table,
+                      typename HDF5LeafTable<T>::Record &record)
+{
+    record.type = LEAF_TYPE_CELL;
+    readScalarAttribute(leaf_group_id,
+                        kCellFlagsAttr,
+                        TypeToHDF5Type<BOOST_TYPEOF(record.flags)>::type(),
+                        &record.flags);
+    readScalarAttribute(leaf_group_id, 
+                        kCellDefaultValueAttr,
+                        TypeToHDF5Type<T>::type(),
+                        &record.default_value);
+    readScalarAttribute(leaf_group_id, 
+                        kCellFillValueAttr,
+                        TypeToHDF5Type<T>::type(),
+                        &record.fill_value);
+
+    // append bitfield, stored row major
+    BitField3D<index_type, bitfield_alloc> bitfield;
+    bitfield.read(leaf_group_id);
+    record.lg_dim          = bitfield.size();
+    record.bitfield_offset = table.bitfields().size();
+    bitfield.write(table.bitfields());
+
+    // append voxel data
+    record.voxel_offset = table.voxels().size();
+    record.voxel_count  = 0;
+    if (!(record.flags & CELL_FLAG_FILLED)) {
+        record.voxel_count = 
+            getDataSetStorageSize(leaf_group_id, kCellDataSetName) / sizeof(T);
+        table.voxels().resize(record.voxel_offset + record.voxel_count);
+        if (record.voxel_count) {
+            readSimpleDataSet(leaf_group_id, 
+                              kCellDataSetName, 
+                              TypeToHDF5Type<T>::type(), 
+                              &table.voxels()[record.voxel_offset]);
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::read(const MappedLeafTable<T> &table, size_t leaf)
+{
+    const typename MappedLeafTable<T>::Record &record = table[leaf];
+
+    if (!L::kRowMajor) {
+        Cell<T, A> row_major;
+        row_major.read(table, leaf);
+        relayout(row_major);
+        if (!(record.flags & CELL_FLAG_COMPRESSED)) {
+            uncompress();
+        }
+        return;
+    }
+
+    destruct();
+
+    m_flags         = record.flags;
+    m_default_value = record.default_value;
+    m_fill_value    = record.fill_value;
+
+    // read in bitfield
+    m_bitfield.read(record.lg_dim, table.bitfields() + record.bitfield_offset);
+
+    if (!isFilled()) {
+        // point at the compressed voxels, no copy is made until a write
+        m_data      = const_cast<pointer>(table.voxels() + 
+                                          record.voxel_offset);
+        m_data_size = record.voxel_count;
+        setFlag(CELL_FLAG_COMPRESSED | CELL_FLAG_MAPPED);
+        m_bitfield.buildRankDirectory();
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::read(CellPager<Cell> &pager, size_t leaf)
+{
+    const typename CellPager<Cell>::Record &record = pager[leaf];
+
+    destruct();
+
+    m_flags         = record.flags;
+    m_default_value = record.default_value;
+    m_fill_value    = record.fill_value;
+
+    // read in bitfield, stored row major
+    const u8 *bytes = &pager.bitfields()[0] + record.bitfield_offset;
+    if (L::kRowMajor) {
+        m_bitfield.read(record.lg_dim, bytes);
+    } else {
+        BitField3D<index_type, bitfield_alloc> row_major;
+        row_major.read(record.lg_dim, bytes);
+        m_bitfield.relayout(row_major);
+    }
+
+    // voxels are left on disk until accessed
+    if (!isFilled()) {
+        setFlag(CELL_FLAG_PAGED);
+        pager.attach(*this, leaf);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::read(const StreamLeafIndex<T> &index, size_t leaf)
+{
+    // decode the leaf in place, it is stored as written to a stream
+    LeafStreamBuf buf(index.leafBytes(leaf), index[leaf].size);
+    std::istream is(&buf);
+    read(is);
+
+    if (!is) {
+        THROW(Iex::IoExc, "Cell - Leaf " << leaf << " is truncated");
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::write(std::ostream &os) const
+{
+    // write cell flags
+    u8 flags = storedFlags();
+    os.write((char*)&flags, sizeof(BOOST_TYPEOF(flags)));
 
     // write the data out
-    cellCopy.writeInternal(os);
+    writeInternal(os);
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void
-Cell<T, A>::write(HDF5Id volume_group_id, size_t quadrant,
+Cell<T, A, L>::write(HDF5Id volume_group_id, size_t quadrant,
                   index_vec offset) const
 {
     // open or create a group for the cell
@@ -779,10 +1117,11 @@ Cell<T, A>::write(HDF5Id volume_group_id, size_t quadrant,
     }
 
     // write flags
+    u8 flags = storedFlags();
     writeScalarAttribute(cell_group.id(),
                          kCellFlagsAttr,
-                         TypeToHDF5Type<BOOST_TYPEOF(m_flags)>::type(),
-                         &m_flags);
+                         TypeToHDF5Type<BOOST_TYPEOF(flags)>::type(),
+                         &flags);
 
     // write out the index offset
     writeVectorAttribute(cell_group.id(),
@@ -812,25 +1151,67 @@ Cell<T, A>::write(HDF5Id volume_group_id, size_t quadrant,
     writeScalarAttribute(cell_group.id(), kLeafTypeAttr, 
                          leaf_type_enum.id(), &type);
   
-    // make a copy to compress
-    // this is so the compression doesn't affect the state
-    // of this object.
-    // the other alternative is uncompressing after the write is done
-    // which would be slower
-    Cell<T, A> cellCopy(*this);
+    // write the data out
+    writeInternal(cell_group.id());
+}
 
-    // compress
-    cellCopy.compress();
+//-----------------------------------------------------------------------------
 
-    // write the data out
-    cellCopy.writeInternal(cell_group.id());
+template<typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::write(HDF5LeafTable<T> &table, size_t quadrant,
+                     index_vec offset) const
+{
+    // cells in other layouts are written through a row major copy
+    if (!L::kRowMajor) {
+        Cell<T, A> row_major;
+        row_major.relayout(*this);
+        row_major.write(table, quadrant, offset);
+        return;
+    }
+
+    page();
+
+    typename HDF5LeafTable<T>::Record &record = table.append();
+    record.quadrant        = quadrant;
+    record.type            = LEAF_TYPE_CELL;
+    record.flags           = storedFlags();
+    record.lg_dim          = m_bitfield.size();
+    record.offset[0]       = offset[0];
+    record.offset[1]       = offset[1];
+    record.offset[2]       = offset[2];
+    record.default_value   = m_default_value;
+    record.fill_value      = m_fill_value;
+    record.bitfield_offset = table.bitfields().size();
+    record.voxel_offset    = table.voxels().size();
+
+    // append bitfield and voxels to the bulk arrays, the set voxels are
+    // compacted straight from the cell
+    m_bitfield.write(table.bitfields());
+    if (!isFilled()) {
+        record.voxel_count = storedSize();
+        VectorWriter out(table.voxels());
+        writeVoxels(out);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::write(StreamLeafWriter<T> &writer, size_t quadrant,
+                     index_vec offset) const
+{
+    writer.beginLeaf(LEAF_TYPE_CELL, 0, quadrant, offset, m_fill_value);
+    write(writer.stream());
+    writer.endLeaf();
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline std::istream& 
-operator>>(std::istream& is, const Cell<T, A>& cell)
+operator>>(std::istream& is, const Cell<T, A, L>& cell)
 {
     cell.read(is);
     return is;
@@ -838,9 +1219,9 @@ operator>>(std::istream& is, const Cell<T, A>& cell)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline std::ostream& 
-operator<<(std::ostream& os, const Cell<T, A>& cell)
+operator<<(std::ostream& os, const Cell<T, A, L>& cell)
 {
     cell.write(os);
     return os;
@@ -848,12 +1229,21 @@ operator<<(std::ostream& os, const Cell<T, A>& cell)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
+inline SpinLock&
+Cell<T, A, L>::spinLock() const
+{
+    return m_lock;
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
 inline int
-Cell<T, A>::sizeOf() const
+Cell<T, A, L>::sizeOf() const
 {
     int sizeof_this     = sizeof(*this);
-    int sizeof_data     = sizeof(T) * m_data_size;
+    int sizeof_data     = isMapped() ? 0 : sizeof(T) * m_data_size;
     int sizeof_bitfield = m_bitfield.sizeOf();
     return sizeof_this + sizeof_data + sizeof_bitfield;
 }
@@ -861,9 +1251,9 @@ Cell<T, A>::sizeOf() const
 //-----------------------------------------------------------------------------
 
 #if 0
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline std::ostream& 
-operator<<(std::ostream& o, const Cell<T, A>& cell) const
+operator<<(std::ostream& o, const Cell<T, A, L>& cell) const
 {
     o << "data: " << cell.m_data << std::endl;
     o << "default value: " << cell.m_default_val << std::endl;
@@ -877,9 +1267,9 @@ operator<<(std::ostream& o, const Cell<T, A>& cell) const
 
 //-----------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void
-Cell<T, A>::initializeSet(const_reference v)
+Cell<T, A, L>::initializeSet(const_reference v)
 {
     // First intialize the data with the default value.
     uninitializedFill(begin(), end(), getDefaultValue());
@@ -893,9 +1283,9 @@ Cell<T, A>::initializeSet(const_reference v)
 
 //------------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::iterator 
-Cell<T, A>::uninitializedFill(iterator b, iterator e, const_reference v) 
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::iterator 
+Cell<T, A, L>::uninitializedFill(iterator b, iterator e, const_reference v) 
 {
     iterator p = b;   // save start position
     try 
@@ -915,9 +1305,9 @@ Cell<T, A>::uninitializedFill(iterator b, iterator e, const_reference v)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::iterator 
-Cell<T, A>::deinitialize(iterator b, iterator e)
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::iterator 
+Cell<T, A, L>::deinitialize(iterator b, iterator e)
 {
     assert((b <= e) && (b && e));
     while (b != e) {
@@ -928,9 +1318,9 @@ Cell<T, A>::deinitialize(iterator b, iterator e)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void
-Cell<T, A>::shallow_copy(pointer dst, pointer src, size_type size)
+Cell<T, A, L>::shallow_copy(pointer dst, pointer src, size_type size)
 {
     if (src) {
         memcpy(dst, src, size * sizeof(T));
@@ -939,38 +1329,59 @@ Cell<T, A>::shallow_copy(pointer dst, pointer src, size_type size)
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void
-Cell<T, A>::setFlag(uint8_t flag)
+Cell<T, A, L>::setFlag(uint8_t flag)
 {
     m_flags |= flag;
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline void
-Cell<T, A>::unsetFlag(uint8_t flag)
+Cell<T, A, L>::unsetFlag(uint8_t flag)
 {
     m_flags &= ~flag;
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
 inline bool 
-Cell<T, A>::isFlagSet(uint8_t flag) const
+Cell<T, A, L>::isFlagSet(uint8_t flag) const
 {
     return (m_flags & flag);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
+inline u8
+Cell<T, A, L>::storedFlags() const
+{
+    return m_flags & ~(CELL_FLAG_MAPPED | CELL_FLAG_PAGED | CELL_FLAG_DIRTY);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
 inline void
-Cell<T, A>::destruct()
+Cell<T, A, L>::destruct()
 {
-    if (m_data) {
+    if (m_pager) {
+        m_pager->release(*this);
+    }
+    unsetFlag(CELL_FLAG_PAGED);
+
+    if (isMapped()) {
+
+        // mapped data belongs to the file
+        unsetFlag(CELL_FLAG_MAPPED);
+        m_data = NULL;
+        m_data_size = 0;
+
+    } else if (m_data) {
 
         // destroy objects
         deinitialize(begin(), end());
@@ -984,16 +1395,125 @@ Cell<T, A>::destruct()
 
 //------------------------------------------------------------------------------
 
-template <typename T, typename A>
+template <typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::detach()
+{
+    unpage();
+
+    // mapped cells are compressed, uncompressing copies the voxels
+    if (isMapped()) {
+        uncompress();
+    }
+
+    setFlag(CELL_FLAG_DIRTY);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::page() const
+{
+    if (m_pager) {
+        m_pager->access(const_cast<Cell&>(*this));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::unpage()
+{
+    // modified cells are no longer backed by the file
+    if (m_pager) {
+        m_pager->access(*this);
+        m_pager->release(*this);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::pageIn(const std::vector<value_type> &voxels)
+{
+    assert(isPaged() && !m_data);
+
+    if (L::kRowMajor) {
+        m_data_size = voxels.size();
+        m_data = m_allocator.allocate(m_data_size);
+        for (size_type n = 0; n < m_data_size; ++n) {
+            m_allocator.construct(m_data + n, voxels[n]);
+        }
+    } else {
+        // move the voxels through a row major copy into this layout
+        Cell<T, A> row_major(m_bitfield.size(), m_default_value, m_allocator);
+        row_major.m_bitfield.relayout(m_bitfield);
+        row_major.unsetFlag(CELL_FLAG_FILLED);
+        row_major.setFlag(CELL_FLAG_COMPRESSED);
+        row_major.m_data_size = voxels.size();
+        row_major.m_data = m_allocator.allocate(voxels.size());
+        for (size_type n = 0; n < voxels.size(); ++n) {
+            m_allocator.construct(row_major.m_data + n, voxels[n]);
+        }
+
+        Cell relayouted(m_bitfield.size(), m_default_value, m_allocator);
+        relayouted.relayout(row_major);
+        m_data = relayouted.m_data;
+        m_data_size = relayouted.m_data_size;
+        relayouted.m_data = NULL;
+        relayouted.m_data_size = 0;
+    }
+    unsetFlag(CELL_FLAG_PAGED);
+
+    // voxels are compressed on disk, cells written uncompressed are
+    // uncompressed again without leaving the pager
+    if (isCompressed()) {
+        m_bitfield.buildRankDirectory();
+    } else {
+        CellPager<Cell> *pager = m_pager;
+        m_pager = NULL;
+        setFlag(CELL_FLAG_COMPRESSED);
+        uncompress();
+        m_pager = pager;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::pageOut()
+{
+    assert(!isPaged() && !isFilled());
+
+    if (m_data) {
+        deinitialize(begin(), end());
+        m_allocator.deallocate(m_data, m_data_size);
+        m_data = NULL;
+        m_data_size = 0;
+    }
+    setFlag(CELL_FLAG_PAGED);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename A, typename L>
 inline void
-Cell<T, A>::copy(const Cell& that)
+Cell<T, A, L>::copy(const Cell& that)
 {
+    that.page();
+
     m_allocator     = that.m_allocator;
     m_data_size     = that.m_data_size;
     m_default_value = that.m_default_value;
     m_fill_value    = that.m_fill_value;
     m_bitfield      = that.m_bitfield;
-    m_flags         = that.m_flags;
+    m_flags         = that.storedFlags() | (that.m_flags & CELL_FLAG_DIRTY);
+    m_pager         = NULL;
+    m_page          = 0;
 
     m_data = NULL;
 
@@ -1008,9 +1528,9 @@ Cell<T, A>::copy(const Cell& that)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline Cell<T, A>&
-Cell<T, A>::operator=(const Cell& that)
+template<typename T, typename A, typename L>
+inline Cell<T, A, L>&
+Cell<T, A, L>::operator=(const Cell& that)
 {
     destruct(); 
     copy(that);
@@ -1019,36 +1539,36 @@ Cell<T, A>::operator=(const Cell& that)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_reference
-Cell<T, A>::getDefaultValue() const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_reference
+Cell<T, A, L>::getDefaultValue() const
 {
     return const_cast<Cell&>(*this).getDefaultValue();
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_reference
-Cell<T, A>::getFillValue() const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_reference
+Cell<T, A, L>::getFillValue() const
 {
     return const_cast<Cell&>(*this).getFillValue();
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::reference
-Cell<T, A>::getDefaultValue()
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::reference
+Cell<T, A, L>::getDefaultValue()
 {
     return m_default_value;
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::reference
-Cell<T, A>::getFillValue()
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::reference
+Cell<T, A, L>::getFillValue()
 {
     assert(isFilled());
     return m_fill_value;
@@ -1056,28 +1576,84 @@ Cell<T, A>::getFillValue()
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void
-Cell<T, A>::setDefaultValue(const_reference val)
+Cell<T, A, L>::setDefaultValue(const_reference val)
 {
     m_default_value = val;
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void
-Cell<T, A>::setFillValue(const_reference val)
+Cell<T, A, L>::setFillValue(const_reference val)
 {
     m_fill_value = val;
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::relayout(const Cell &that)
+{
+    destruct();
+    copy(that);
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+template<typename M>
+inline void
+Cell<T, A, L>::relayout(const Cell<T, A, M> &that)
+{
+    // compressed data follows the order of the set bits, so the voxels are
+    // moved from an uncompressed copy
+    Cell<T, A, M> source(that);
+    source.uncompress();
+
+    destruct();
+    m_default_value = source.m_default_value;
+    m_fill_value    = source.m_fill_value;
+    m_flags         = source.m_flags;
+    m_bitfield.relayout(source.m_bitfield);
+
+    if (!isFilled()) {
+        m_data_size = source.m_data_size;
+        m_data      = m_allocator.allocate(m_data_size);
+
+        index_type i, j, k;
+        size_type lg_size = m_bitfield.size();
+        for (size_type index = 0; index < m_data_size; ++index) {
+            M::getCoordinates(index, lg_size, i, j, k);
+            m_allocator.construct(m_data + L::getIndex(i, j, k, lg_size), 
+                                  source.m_data[index]);
+        }
+    }
+
+    if (that.isCompressed()) {
+        compress();
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
 inline void
-Cell<T, A>::writeInternal(std::ostream &os) const
+Cell<T, A, L>::writeInternal(std::ostream &os) const
 {
+    // cells in other layouts are written through a row major copy
+    if (!L::kRowMajor) {
+        Cell<T, A> row_major;
+        row_major.relayout(*this);
+        row_major.writeInternal(os);
+        return;
+    }
+
+    page();
+
     // write out bitfield
     m_bitfield.write(os);
 
@@ -1086,21 +1662,30 @@ Cell<T, A>::writeInternal(std::ostream &os) const
     os.write((char*)&m_fill_value, sizeof(T));
 
     // write out data size
-    os.write((char*)&m_data_size, sizeof(size_type));
+    size_type data_size = storedSize();
+    os.write((char*)&data_size, sizeof(size_type));
     
-    if (!isFilled()) {
-        // write out voxels
-        os.write(reinterpret_cast<char*>(m_data), m_data_size * sizeof(T));
-    }
+    // write out voxels, compacted as they are written
+    StreamWriter out(os);
+    writeVoxels(out);
 }
 
-
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline void
-Cell<T, A>::writeInternal(HDF5Id cell_group_id) const
+Cell<T, A, L>::writeInternal(HDF5Id cell_group_id) const
 {
+    // cells in other layouts are written through a row major copy
+    if (!L::kRowMajor) {
+        Cell<T, A> row_major;
+        row_major.relayout(*this);
+        row_major.writeInternal(cell_group_id);
+        return;
+    }
+
+    page();
+
     // write out bitfield
     m_bitfield.write(cell_group_id);
 
@@ -1117,26 +1702,105 @@ Cell<T, A>::writeInternal(HDF5Id cell_group_id) const
                          &m_fill_value);
 
     if (!isFilled()) {
+        // the data set is written in one call, so uncompressed voxels are
+        // compacted into a single buffer first
+        std::vector<T> voxels;
+        const T *data = m_data;
+        if (!isCompressed()) {
+            voxels.reserve(storedSize());
+            VectorWriter out(voxels);
+            writeVoxels(out);
+            if (!voxels.empty()) { data = &voxels[0]; }
+        }
+
         // write out voxel data
         // have to convert to HDF5Size manually here
-        HDF5Size data_size = m_data_size;
+        HDF5Size data_size = storedSize();
         writeSimpleDataSet(cell_group_id,
                            kCellDataSetName,
                            1, &data_size,
                            TypeToHDF5Type<T>::type(),
-                           m_data);
+                           data);
     }
 }
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::size_type
+Cell<T, A, L>::storedSize() const
+{
+    if (isFilled() || isCompressed()) {
+        return m_data_size;
+    }
+    return m_bitfield.count();
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+template<typename Writer>
+inline void
+Cell<T, A, L>::writeVoxels(Writer &out) const
+{
+    if (isFilled()) {
+        return;
+    }
+
+    // compressed voxels are already stored as on disk
+    if (isCompressed()) {
+        out(m_data, m_data_size);
+        return;
+    }
+
+    // compact the set voxels a run at a time
+    T buffer[WRITE_BUFFER_SIZE];
+    size_type count = 0;
+    const_set_iterator set_bit_itr = m_bitfield.setIterator(begin());
+    while (set_bit_itr()) {
+        buffer[count++] = *set_bit_itr;
+        if (count == WRITE_BUFFER_SIZE) {
+            out(buffer, count);
+            count = 0;
+        }
+        ++set_bit_itr;
+    }
+
+    if (count) {
+        out(buffer, count);
+    }
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::StreamWriter::operator()(const T *data, size_type count)
+{
+    m_os.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+//-----------------------------------------------------------------------------
+
+template<typename T, typename A, typename L>
+inline void
+Cell<T, A, L>::VectorWriter::operator()(const T *data, size_type count)
+{
+    m_voxels.insert(m_voxels.end(), data, data + count);
+}
                            
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool
-Cell<T, A>::operator==(const Cell& that) const
+Cell<T, A, L>::operator==(const Cell& that) const
 {
     // check setup
+    page();
+    that.page();
+
     bool is_equal = true;
-    is_equal = m_flags == that.m_flags;
+    is_equal = storedFlags() == that.storedFlags();
     is_equal = is_equal && m_data_size == that.m_data_size;
     is_equal = is_equal && m_default_value == that.m_default_value;
     if (!is_equal) {
@@ -1165,20 +1829,20 @@ Cell<T, A>::operator==(const Cell& that) const
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool
-Cell<T, A>::operator!=(const Cell& that) const
+Cell<T, A, L>::operator!=(const Cell& that) const
 {
     return !(*this == that);
 }
 
 //-----------------------------------------------------------------------------
-// Cell<T, A>::iterator
+// Cell<T, A, L>::iterator
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline
-Cell<T, A>::iterator::iterator() :
+Cell<T, A, L>::iterator::iterator() :
     m_begin(0),
     m_end(0),
     m_p(0)
@@ -1188,9 +1852,9 @@ Cell<T, A>::iterator::iterator() :
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline
-Cell<T, A>::iterator::iterator(pointer _begin, pointer _end, pointer _p) :
+Cell<T, A, L>::iterator::iterator(pointer _begin, pointer _end, pointer _p) :
     m_begin(_begin),
     m_end(_end),
     m_p(_p)
@@ -1200,27 +1864,27 @@ Cell<T, A>::iterator::iterator(pointer _begin, pointer _end, pointer _p) :
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::iterator::reference 
-Cell<T, A>::iterator::operator*() const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::iterator::reference 
+Cell<T, A, L>::iterator::operator*() const
 {
     return *m_p;
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::iterator::pointer 
-Cell<T, A>::iterator::operator->() const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::iterator::pointer 
+Cell<T, A, L>::iterator::operator->() const
 {
     return &**this;
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::iterator& 
-Cell<T, A>::iterator::operator++()
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::iterator& 
+Cell<T, A, L>::iterator::operator++()
 {
     ++m_p;
     assert(isValid());
@@ -1229,9 +1893,9 @@ Cell<T, A>::iterator::operator++()
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::iterator 
-Cell<T, A>::iterator::operator++(int)
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::iterator 
+Cell<T, A, L>::iterator::operator++(int)
 {
     iterator x = *this;
     ++(*this);
@@ -1241,9 +1905,9 @@ Cell<T, A>::iterator::operator++(int)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::iterator& 
-Cell<T, A>::iterator::operator--()
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::iterator& 
+Cell<T, A, L>::iterator::operator--()
 {
     --m_p;
     assert(isValid());
@@ -1252,9 +1916,9 @@ Cell<T, A>::iterator::operator--()
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::iterator 
-Cell<T, A>::iterator::operator--(int)
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::iterator 
+Cell<T, A, L>::iterator::operator--(int)
 {
     iterator x = *this;
     --(*this);
@@ -1264,56 +1928,56 @@ Cell<T, A>::iterator::operator--(int)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool 
-Cell<T, A>::iterator::operator==(const iterator& that) const
+Cell<T, A, L>::iterator::operator==(const iterator& that) const
 {
     return m_p == that.m_p;
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool 
-Cell<T, A>::iterator::operator!=(const iterator& that) const
+Cell<T, A, L>::iterator::operator!=(const iterator& that) const
 {
     return !(*this == that);
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool 
-Cell<T, A>::iterator::operator&&(const iterator& that) const
+Cell<T, A, L>::iterator::operator&&(const iterator& that) const
 {
     return this->isValid() && that.isValid();
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool 
-Cell<T, A>::iterator::operator<=(const iterator& that) const
+Cell<T, A, L>::iterator::operator<=(const iterator& that) const
 {
     return this->m_p <= that.m_p;
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool 
-Cell<T, A>::iterator::isValid() const
+Cell<T, A, L>::iterator::isValid() const
 {
     return m_p >= m_begin && m_p <= m_end;
 }
 
 //-----------------------------------------------------------------------------
-// Cell<T, A>::const_iterator
+// Cell<T, A, L>::const_iterator
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline
-Cell<T, A>::const_iterator::const_iterator() :
+Cell<T, A, L>::const_iterator::const_iterator() :
     m_bitfield_iter(),
     m_p(0),
     m_isFilled(false)
@@ -1322,9 +1986,9 @@ Cell<T, A>::const_iterator::const_iterator() :
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline
-Cell<T, A>::const_iterator::const_iterator(const Cell *cell,
+Cell<T, A, L>::const_iterator::const_iterator(const Cell *cell,
                                            const bitfield_iterator_type &bit,
                                            pointer p) :
     m_bitfield_iter(bit),
@@ -1340,9 +2004,9 @@ Cell<T, A>::const_iterator::const_iterator(const Cell *cell,
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_iterator::reference 
-Cell<T, A>::const_iterator::operator*() const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_iterator::reference 
+Cell<T, A, L>::const_iterator::operator*() const
 {
     pointer val = m_value_jumptable[m_isFilled][m_bitfield_iter.isSet()];
     return *val;
@@ -1350,18 +2014,18 @@ Cell<T, A>::const_iterator::operator*() const
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_iterator::pointer 
-Cell<T, A>::const_iterator::operator->() const
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_iterator::pointer 
+Cell<T, A, L>::const_iterator::operator->() const
 {
     return &**this;
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_iterator& 
-Cell<T, A>::const_iterator::operator++()
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_iterator& 
+Cell<T, A, L>::const_iterator::operator++()
 {
     // Update the bitfield iterator.
     ++m_bitfield_iter;
@@ -1379,9 +2043,9 @@ Cell<T, A>::const_iterator::operator++()
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_iterator 
-Cell<T, A>::const_iterator::operator++(int)
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_iterator 
+Cell<T, A, L>::const_iterator::operator++(int)
 {
     const_iterator x = *this;
     ++(*this);
@@ -1390,9 +2054,9 @@ Cell<T, A>::const_iterator::operator++(int)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_iterator& 
-Cell<T, A>::const_iterator::operator--()
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_iterator& 
+Cell<T, A, L>::const_iterator::operator--()
 {
     // Update the bitfield iterator.
     --m_bitfield_iter;
@@ -1410,9 +2074,9 @@ Cell<T, A>::const_iterator::operator--()
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
-inline typename Cell<T, A>::const_iterator 
-Cell<T, A>::const_iterator::operator--(int)
+template<typename T, typename A, typename L>
+inline typename Cell<T, A, L>::const_iterator 
+Cell<T, A, L>::const_iterator::operator--(int)
 {
     const_iterator x = *this;
     --(*this);
@@ -1421,9 +2085,9 @@ Cell<T, A>::const_iterator::operator--(int)
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool 
-Cell<T, A>::const_iterator::operator==(const const_iterator& that) const
+Cell<T, A, L>::const_iterator::operator==(const const_iterator& that) const
 {
     // Either check bitfields if we have a filled cell or the pointer if we
     // don't.
@@ -1433,18 +2097,18 @@ Cell<T, A>::const_iterator::operator==(const const_iterator& that) const
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool 
-Cell<T, A>::const_iterator::operator!=(const const_iterator& that) const
+Cell<T, A, L>::const_iterator::operator!=(const const_iterator& that) const
 {
     return !(*this == that);
 }
 
 //-----------------------------------------------------------------------------
 
-template<typename T, typename A>
+template<typename T, typename A, typename L>
 inline bool 
-Cell<T, A>::const_iterator::operator<=(const const_iterator& that) const
+Cell<T, A, L>::const_iterator::operator<=(const const_iterator& that) const
 {
     return this->m_bitfield_iter <= that.m_bitfield_iter;
 }
@@ -0,0 +1,222 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// CellPager.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_VOLUME_CELLPAGER_H__
+#define __NKHIVE_VOLUME_CELLPAGER_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <nkbase/Exceptions.h>
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkhive/io/hdf5/HDF5DataSet.h>
+#include <nkhive/io/hdf5/HDF5LeafTable.h>
+#include <nkhive/io/hdf5/HDF5Util.h>
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Counters of a pager. Hits and misses count voxel accesses to paged cells,
+ * resident bytes are the voxels of paged cells currently in memory.
+ */
+struct CellPagerStats
+{
+    CellPagerStats();
+
+    u64    hits;
+    u64    misses;
+    u64    evictions;
+    size_t resident_bytes;
+    size_t budget_bytes;
+};
+
+//------------------------------------------------------------------------------
+// interface
+//------------------------------------------------------------------------------
+
+/**
+ * Pages the voxels of cells in and out of a leaf table volume on disk. The
+ * records and bitfields are read up front, the voxels of a cell are read the
+ * first time they are accessed and evicted least recently used first once
+ * the resident voxels exceed the memory budget. A reference to a voxel
+ * stays valid through the next access to another cell. Cells that get 
+ * modified are released from the pager and stay resident. Only safe for 
+ * concurrent access while shared.
+ */
+template <typename CellType>
+class CellPager
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+
+    typedef boost::shared_ptr<CellPager>               shared_ptr;
+    typedef typename CellType::value_type              value_type;
+    typedef typename HDF5LeafTable<value_type>::Record Record;
+
+    //--------------------------------------------------------------------------
+    // constructors/destructors
+    //--------------------------------------------------------------------------
+
+    /**
+     * Reads the leaf index of the volume group. The voxel data set is held
+     * open, and with it the file, until the pager is destroyed.
+     */
+    CellPager(HDF5Id volume_group_id, size_t memory_budget);
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    /**
+     * Leaf index access, for building the tree.
+     */
+    size_t size() const;
+    const Record& operator[](size_t leaf) const;
+    const std::vector<u8>& bitfields() const;
+
+    /**
+     * Frees the bitfield bytes once the cells have read them.
+     */
+    void releaseBitFields();
+
+    CellPagerStats stats() const;
+
+    /**
+     * Hands the voxels of the given leaf over to the pager, the cell starts
+     * out paged out.
+     */
+    void attach(CellType &cell, size_t leaf);
+
+    /**
+     * Called by cells on access. Loads the voxels of a paged out cell, 
+     * otherwise marks the cell as most recently used.
+     */
+    void access(CellType &cell);
+
+    /**
+     * Stops paging the cell, its voxels are left as they are.
+     */
+    void release(CellType &cell);
+
+    /**
+     * Lets several threads access cells at once. Accesses are serialized
+     * and nothing is evicted until the last share ends, so voxels read by
+     * one thread are not freed by another.
+     */
+    void beginShared();
+    void endShared();
+
+private:
+
+    //--------------------------------------------------------------------------
+    // types
+    //--------------------------------------------------------------------------
+
+    /**
+     * Pages are linked in least recently used order through their indices.
+     */
+    struct Page
+    {
+        CellType *cell;
+        size_t    prev;
+        size_t    next;
+        bool      resident;
+    };
+
+    static const size_t kNoPage = size_t(-1);
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    void link(size_t page);
+    void unlink(size_t page);
+    size_t pageBytes(size_t page) const;
+
+    /**
+     * Evicts from the tail until the budget is met. The two most recently
+     * used pages are always kept, so a reference returned by a lookup stays
+     * valid until the lookup after next.
+     */
+    void evict();
+
+    /**
+     * Not copyable, cells point at their pager.
+     */
+    CellPager(const CellPager &that);
+    CellPager& operator=(const CellPager &that);
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    HDF5LeafTable<value_type> m_table;
+    HDF5DataSet               m_voxels;
+    std::vector<Page>         m_pages;
+    size_t                    m_head;
+    size_t                    m_tail;
+    CellPagerStats            m_stats;
+
+    /**
+     * Number of open shares, the mutex is only taken while shared.
+     */
+    size_t                    m_shared;
+    mutable boost::mutex      m_mutex;
+};
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+#include <nkhive/volume/CellPager.hpp>
+
+END_NKHIVE_NS
+
+#endif // __NKHIVE_VOLUME_CELLPAGER_H__
@@ -0,0 +1,292 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// CellPager.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// CellPagerStats implementation
+//------------------------------------------------------------------------------
+
+inline
+CellPagerStats::CellPagerStats() :
+    hits(0),
+    misses(0),
+    evictions(0),
+    resident_bytes(0),
+    budget_bytes(0)
+{
+}
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline
+CellPager<CellType>::CellPager(HDF5Id volume_group_id, size_t memory_budget) :
+    m_table(),
+    m_voxels(),
+    m_pages(),
+    m_head(kNoPage),
+    m_tail(kNoPage),
+    m_stats(),
+    m_shared(0)
+{
+    // the voxels stay on disk
+    m_table.read(volume_group_id, false);
+    if (H5Lexists(volume_group_id, kLeafVoxelsName.c_str(), H5P_DEFAULT) > 0) {
+        m_voxels.open(volume_group_id, kLeafVoxelsName);
+        if (!m_voxels.isValid()) {
+            THROW(Iex::IoExc, "CellPager - Could not open leaf voxels");
+        }
+    }
+
+    Page page = { NULL, kNoPage, kNoPage, false };
+    m_pages.resize(m_table.size(), page);
+
+    m_stats.budget_bytes = memory_budget;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline size_t
+CellPager<CellType>::size() const
+{
+    return m_table.size();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline const typename CellPager<CellType>::Record&
+CellPager<CellType>::operator[](size_t leaf) const
+{
+    return m_table[leaf];
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline const std::vector<u8>&
+CellPager<CellType>::bitfields() const
+{
+    return m_table.bitfields();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline void
+CellPager<CellType>::releaseBitFields()
+{
+    std::vector<u8>().swap(m_table.bitfields());
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline CellPagerStats
+CellPager<CellType>::stats() const
+{
+    boost::unique_lock<boost::mutex> lock(m_mutex, boost::defer_lock);
+    if (m_shared) lock.lock();
+
+    return m_stats;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline void
+CellPager<CellType>::attach(CellType &cell, size_t leaf)
+{
+    assert(leaf < m_pages.size());
+    m_pages[leaf].cell = &cell;
+    cell.m_pager = this;
+    cell.m_page  = leaf;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline void
+CellPager<CellType>::access(CellType &cell)
+{
+    boost::unique_lock<boost::mutex> lock(m_mutex, boost::defer_lock);
+    if (m_shared) lock.lock();
+
+    size_t page = cell.m_page;
+    assert(m_pages[page].cell == &cell);
+
+    if (m_pages[page].resident) {
+        ++m_stats.hits;
+        if (page != m_head) {
+            unlink(page);
+            link(page);
+        }
+        return;
+    }
+
+    ++m_stats.misses;
+
+    // read the compressed voxels of the leaf
+    const Record &record = m_table[page];
+    std::vector<value_type> voxels(record.voxel_count);
+    if (!voxels.empty()) {
+        m_voxels.read(TypeToHDF5Type<value_type>::type(), 
+                      record.voxel_offset, record.voxel_count, &voxels[0]);
+    }
+    cell.pageIn(voxels);
+
+    m_pages[page].resident = true;
+    link(page);
+    m_stats.resident_bytes += pageBytes(page);
+
+    evict();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline void
+CellPager<CellType>::release(CellType &cell)
+{
+    boost::unique_lock<boost::mutex> lock(m_mutex, boost::defer_lock);
+    if (m_shared) lock.lock();
+
+    size_t page = cell.m_page;
+    assert(m_pages[page].cell == &cell);
+
+    if (m_pages[page].resident) {
+        unlink(page);
+        m_stats.resident_bytes -= pageBytes(page);
+        m_pages[page].resident = false;
+    }
+    m_pages[page].cell = NULL;
+    cell.m_pager = NULL;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline void
+CellPager<CellType>::beginShared()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    ++m_shared;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline void
+CellPager<CellType>::endShared()
+{
+    boost::mutex::scoped_lock lock(m_mutex);
+    assert(m_shared > 0);
+    if (--m_shared == 0) {
+        evict();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline void
+CellPager<CellType>::link(size_t page)
+{
+    m_pages[page].prev = kNoPage;
+    m_pages[page].next = m_head;
+    if (m_head != kNoPage) {
+        m_pages[m_head].prev = page;
+    } else {
+        m_tail = page;
+    }
+    m_head = page;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline void
+CellPager<CellType>::unlink(size_t page)
+{
+    Page &p = m_pages[page];
+    if (p.prev != kNoPage) {
+        m_pages[p.prev].next = p.next;
+    } else {
+        m_head = p.next;
+    }
+    if (p.next != kNoPage) {
+        m_pages[p.next].prev = p.prev;
+    } else {
+        m_tail = p.prev;
+    }
+    p.prev = p.next = kNoPage;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline size_t
+CellPager<CellType>::pageBytes(size_t page) const
+{
+    return m_pages[page].cell->m_data_size * sizeof(value_type);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline void
+CellPager<CellType>::evict()
+{
+    // other threads may be reading any resident page while shared
+    if (m_shared) return;
+
+    // references returned by the previous access stay valid through this
+    // one, so the two most recently used pages are kept
+    while (m_stats.resident_bytes > m_stats.budget_bytes && 
+           m_tail != m_head && m_tail != m_pages[m_head].next) {
+        size_t page = m_tail;
+        unlink(page);
+        m_stats.resident_bytes -= pageBytes(page);
+        m_pages[page].resident = false;
+        m_pages[page].cell->pageOut();
+        ++m_stats.evictions;
+    }
+}
+
+//------------------------------------------------------------------------------
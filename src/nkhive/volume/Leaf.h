@@ -0,0 +1,171 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Leaf.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_VOLUME_LEAF_H__
+#define __NKHIVE_VOLUME_LEAF_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <vector>
+#include <boost/type_traits/remove_const.hpp>
+
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkhive/bitfields/BitOps.h>
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * A cell of a tree along with its placement in the volume, as handed out by
+ * the parallel for-each traversals. CellType is const qualified for read-only
+ * traversals. Voxels of the cell are addressed by linear index in 
+ * [begin(), end()).
+ */
+template <typename CellType>
+class Leaf
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+
+    typedef CellType                                        cell_type;
+    typedef typename CellType::value_type                   value_type;
+    typedef typename CellType::reference                    reference;
+    typedef typename CellType::const_reference              const_reference;
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    /**
+     * Params:
+     *   cell: the cell of the leaf.
+     *   quadrant: the quadrant of the tree the cell lives in.
+     *   offset: the quadrant coordinates of the cell's first voxel.
+     */
+    Leaf(CellType *cell, u8 quadrant, const index_vec &offset);
+
+    /**
+     * The cell of the leaf.
+     */
+    CellType& cell() const;
+
+    /**
+     * The quadrant of the tree the leaf lives in.
+     */
+    u8 quadrant() const;
+
+    /**
+     * Volume coordinates of the first voxel of the cell. Cells in negative
+     * quadrants are mirrored, step() holds the direction each cell axis runs
+     * in volume space.
+     */
+    const signed_index_vec& origin() const;
+    const signed_index_vec& step() const;
+
+    /**
+     * The linear voxel index range of the cell.
+     */
+    index_type begin() const;
+    index_type end() const;
+
+    /**
+     * Returns the volume coordinates of the voxel at the linear index.
+     */
+    void getCoordinates(index_type index, signed_index_vec &coords) const;
+
+    /**
+     * Calls f(coords, value) for every set voxel of the cell. The value is
+     * writable unless the CellType is const. Writes to filled cells are 
+     * gathered and applied once all voxels are visited, so the cell stays 
+     * filled if every voxel ends up with the same value.
+     */
+    template <typename Functor>
+    void forEachVoxel(Functor &f) const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal typedefs
+    //--------------------------------------------------------------------------
+
+    typedef typename boost::remove_const<CellType>::type    mutable_cell_type;
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Voxel traversal for writable and read-only cells.
+     */
+    template <typename Functor>
+    void forEachVoxel(mutable_cell_type *cell, Functor &f) const;
+    template <typename Functor>
+    void forEachVoxel(const mutable_cell_type *cell, Functor &f) const;
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    CellType           *m_cell;
+    u8                  m_quadrant;
+    signed_index_vec    m_origin;
+    signed_index_vec    m_step;
+};
+
+END_NKHIVE_NS
+
+//-----------------------------------------------------------------------------
+// class implementation
+//-----------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/volume/Leaf.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_VOLUME_LEAF_H__
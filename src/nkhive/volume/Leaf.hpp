@@ -0,0 +1,208 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Leaf.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline
+Leaf<CellType>::Leaf(CellType *cell, u8 quadrant, const index_vec &offset) :
+    m_cell(cell),
+    m_quadrant(quadrant)
+{
+    // The first voxel is mapped like any other quadrant coordinate, the
+    // direction of the axes follows the sign of the quadrant.
+    signed_index_type oi, oj, ok;
+    getQuadrantOffsets(oi, oj, ok, quadrant);
+    m_origin = signed_index_vec(offset.x + oi, offset.y + oj, offset.z + ok);
+    getQuadrantCoordinates(m_origin.x, m_origin.y, m_origin.z, quadrant);
+
+    m_step = signed_index_vec(1, 1, 1);
+    getQuadrantCoordinates(m_step.x, m_step.y, m_step.z, quadrant);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline CellType&
+Leaf<CellType>::cell() const
+{
+    return *m_cell;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline u8
+Leaf<CellType>::quadrant() const
+{
+    return m_quadrant;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline const signed_index_vec&
+Leaf<CellType>::origin() const
+{
+    return m_origin;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline const signed_index_vec&
+Leaf<CellType>::step() const
+{
+    return m_step;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline index_type
+Leaf<CellType>::begin() const
+{
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline index_type
+Leaf<CellType>::end() const
+{
+    return numBits3D(m_cell->m_bitfield.size());
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+inline void
+Leaf<CellType>::getCoordinates(index_type index, 
+                               signed_index_vec &coords) const
+{
+    index_type i, j, k;
+    m_cell->m_bitfield.getCoordinates(index, i, j, k);
+    coords.x = m_origin.x + m_step.x * signed_index_type(i);
+    coords.y = m_origin.y + m_step.y * signed_index_type(j);
+    coords.z = m_origin.z + m_step.z * signed_index_type(k);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+template <typename Functor>
+inline void
+Leaf<CellType>::forEachVoxel(Functor &f) const
+{
+    forEachVoxel(m_cell, f);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+template <typename Functor>
+inline void
+Leaf<CellType>::forEachVoxel(mutable_cell_type *cell, Functor &f) const
+{
+    signed_index_vec coords;
+    const index_type last = end();
+
+    if (!cell->isFilled()) {
+        // Allocated cells hand out references into their data, which must
+        // be owned by the cell.
+        cell->detach();
+        for (index_type index = begin(); index < last; ++index) {
+            if (cell->m_bitfield.isSet(index)) {
+                getCoordinates(index, coords);
+                f(coords, cell->get(index));
+            }
+        }
+        return;
+    }
+
+    // All voxels of a filled cell share the fill value, so each one is
+    // handed a copy and the results are written back afterwards.
+    std::vector<index_type> indices;
+    std::vector<value_type> values;
+    bool uniform = true;
+    for (index_type index = begin(); index < last; ++index) {
+        if (cell->m_bitfield.isSet(index)) {
+            value_type value = cell->getFillValue();
+            getCoordinates(index, coords);
+            f(coords, value);
+            uniform = uniform && (values.empty() || values[0] == value);
+            indices.push_back(index);
+            values.push_back(value);
+        }
+    }
+
+    if (values.empty()) return;
+
+    if (uniform) {
+        cell->setFillValue(values[0]);
+    } else {
+        // Setting a differing value allocates the cell.
+        value_type fill_value = cell->getFillValue();
+        for (size_t n = 0; n < values.size(); ++n) {
+            if (!(values[n] == fill_value)) {
+                cell->set(indices[n], values[n]);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType>
+template <typename Functor>
+inline void
+Leaf<CellType>::forEachVoxel(const mutable_cell_type *cell, Functor &f) const
+{
+    signed_index_vec coords;
+    const index_type last = end();
+    for (index_type index = begin(); index < last; ++index) {
+        if (cell->m_bitfield.isSet(index)) {
+            getCoordinates(index, coords);
+            f(coords, cell->get(index));
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
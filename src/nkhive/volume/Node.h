@@ -40,6 +40,9 @@
 // includes
 //------------------------------------------------------------------------------
 
+#include <cstddef>
+#include <new>
+#include <set>
 #include <vector>
 #include <boost/shared_ptr.hpp>
 #include <boost/typeof/typeof.hpp>
@@ -49,11 +52,15 @@
 
 #include <nkhive/Defs.h>
 #include <nkhive/Types.h>
+#include <nkhive/memory/PoolAllocator.h>
+#include <nkhive/util/Atomic.h>
 #include <nkhive/bitfields/BitField3D.h>
 #include <nkhive/tiling/Stamp.h>
 #include <nkhive/util/Bounds3D.h>
 #include <nkhive/io/hdf5/HDF5Group.h>
 #include <nkhive/io/hdf5/HDF5DataType.h>
+#include <nkhive/io/hdf5/HDF5LeafTable.h>
+#include <nkhive/io/StreamLeafIndex.h>
 
 //------------------------------------------------------------------------------
 // forward declarations
@@ -75,6 +82,15 @@ class NodeSetIterator;
 template <typename CT>
 class SetIterator;
 
+template <typename C, typename Alloc>
+class ConstAccessor;
+
+template <typename C, typename Alloc>
+class Accessor;
+
+template <typename C, typename Alloc>
+class ParallelForEach;
+
 END_NKHIVE_NS
 
 //------------------------------------------------------------------------------
@@ -108,6 +124,19 @@ public:
     typedef boost::shared_ptr<Node>                     shared_ptr;
     typedef boost::shared_ptr<const Node>               const_shared_ptr;
 
+    typedef typename CellType::layout_type              layout_type;
+
+    //--------------------------------------------------------------------------
+    // enums
+    //--------------------------------------------------------------------------
+
+    enum Flags
+    {
+        NODE_FLAG_FILL  = 0x01,
+        NODE_FLAG_DENSE = 0x02,
+        NODE_FLAG_DIRTY = 0x04   // fill node modified since read or saved
+    };
+
     //--------------------------------------------------------------------------
     // public interface
     //--------------------------------------------------------------------------
@@ -120,12 +149,24 @@ public:
      *   default_value: the default value to set for this node.
      *   as_fill: creates a fill node or a branching node. If this is true,
      *            then the default_value parameter is treated as a fill value.
+     *   a: allocator for the node's branches, children and bitfield.
      */
     Node(index_type level, 
          uint8_t lg_branching_factor, uint8_t lg_cell_dim,
-         const_reference default_value, bool as_fill = false);
+         const_reference default_value, bool as_fill = false,
+         const allocator_type &a = allocator_type());
     ~Node();
 
+    /**
+     * Allocates/Frees a node using the given allocator. Nodes created through
+     * the tree should be handled with these rather than new/delete.
+     */
+    static Node* create(index_type level, 
+                        uint8_t lg_branching_factor, uint8_t lg_cell_dim,
+                        const_reference default_value, bool as_fill,
+                        const allocator_type &a);
+    static void destroy(Node *node);
+
     /** 
      * The current level of the node in the tree.
      */
@@ -143,6 +184,12 @@ public:
      */
     bool isFill() const;
 
+    /**
+     * Returns true if the branches are stored in a full array indexed by
+     * branch, rather than compactly in the order of the set bits.
+     */
+    bool isDense() const;
+
     /**
      * Returns true if this node has no set values under it.
      */
@@ -204,6 +251,20 @@ public:
     void unset(index_type i, index_type j, index_type k, const_reference
                default_value);
 
+    /**
+     * Turns cells whose set voxels are uniform within tolerance into fill 
+     * cells, and branches that are fully set with uniform fill children into
+     * fill nodes. Returns true if the node is a fill node afterwards.
+     */
+    bool prune(const_reference tolerance);
+
+    /**
+     * Same as prune(), limited to the fully set cell holding the voxel at 
+     * i, j, k relative to this node and the nodes above it.
+     */
+    bool prune(index_type i, index_type j, index_type k, 
+               const_reference tolerance);
+
     /**
      * Writes the stamp to the node.  The stamp will be passed down the tree
      * until they get written by cells.
@@ -213,6 +274,12 @@ public:
                const index_bounds &node_bounds, 
                const signed_index_vec &transform);
 
+    /**
+     * Sets every voxel within the bounds, relative to this node, to value.
+     * Branches inside the bounds become fill nodes and fill cells.
+     */
+    void fill(const index_bounds &bounds, const_reference value);
+
     /**
      * I/O methods.
      */
@@ -222,6 +289,30 @@ public:
     void write(HDF5Id volume_group_id, 
                size_t quadrant,
                index_vec offset) const;
+    template <typename Table>
+    void read(Table &table, size_t leaf, index_vec index_offset);
+
+    /**
+     * Builds the branches down to the leaf without reading it, returning 
+     * the cell to read it into. Fill nodes have no cell and are read right
+     * away. Distinct cells can be read concurrently, see ParallelReader.
+     */
+    template <typename Table>
+    CellType* readPath(Table &table, size_t leaf, index_vec index_offset);
+    void write(HDF5LeafTable<value_type> &table,
+               size_t quadrant,
+               index_vec offset) const;
+    void write(StreamLeafWriter<value_type> &writer,
+               size_t quadrant,
+               index_vec offset) const;
+
+    /**
+     * Rewrites the leaf groups of the dirty leaves under this node and marks
+     * them clean, see Tree::writeIncremental(). The names of the groups of
+     * the leaves visited are taken out of stored.
+     */
+    void writeDirty(HDF5Id volume_group_id, size_t quadrant, 
+                    index_vec offset, std::set<String> &stored);
 
     /**
      * Comparision operators.
@@ -250,19 +341,79 @@ private:
         CellType *cell;
     } branch_type;
 
+    /**
+     * Allocators for the child nodes, cells and the branches.
+     */
+    typedef typename A::template rebind<Node>::other    node_allocator;
+    typedef typename A::template rebind<CellType>::other
+                                                        cell_allocator;
+    typedef typename A::template rebind<branch_type>::other
+                                                        branch_allocator;
+
     /** 
-     * Vector to hold the branches and it's iterator.
+     * Vector to hold the branches.
+     */
+    typedef std::vector<branch_type, branch_allocator>  branch_vector;
+
+    /**
+     * Branches are laid out like the voxels of the cells.
      */
-    typedef std::vector<branch_type>                    branch_vector;
-    typedef typename branch_vector::iterator            bv_iterator;
-    typedef typename branch_vector::const_iterator      const_bv_iterator;
+    typedef BitField3D<index_type, bitfield_alloc, layout_type> 
+                                                        bitfield_type;
+
+    /**
+     * Walks the branch slots in step with the bits of the bitfield. Sparse
+     * nodes only hold slots for set bits, so the slot only moves past set 
+     * bits.
+     */
+    template <typename VectorPtr, typename Pointer, typename Reference>
+    class branch_cursor
+    {
+    public:
+        typedef branch_type                             value_type;
+        typedef std::ptrdiff_t                          difference_type;
+        typedef Pointer                                 pointer;
+        typedef Reference                               reference;
+
+        branch_cursor() : 
+            m_branches(NULL), m_bitfield(NULL), m_index(0), m_slot(0), 
+            m_dense(false) {}
+        branch_cursor(VectorPtr branches, const bitfield_type *bitfield, 
+                      bool dense) :
+            m_branches(branches), m_bitfield(bitfield), m_index(0), 
+            m_slot(0), m_dense(dense) {}
+
+        reference operator*() const 
+        { 
+            return (*m_branches)[m_dense ? m_index : m_slot]; 
+        }
+
+        branch_cursor& operator++()
+        {
+            if (!m_dense && m_bitfield->isSet(m_index)) ++m_slot;
+            ++m_index;
+            return *this;
+        }
+
+    private:
+        VectorPtr            m_branches;
+        const bitfield_type *m_bitfield;
+        index_type           m_index;
+        index_type           m_slot;
+        bool                 m_dense;
+    };
+
+    typedef branch_cursor<branch_vector*, branch_type*, branch_type&>
+                                                        bv_cursor;
+    typedef branch_cursor<const branch_vector*, const branch_type*, 
+                          const branch_type&>           const_bv_cursor;
 
     /**
      * Type to iterator over set branches using the bitfield's set iterator.
      */
-    typedef typename bitfield_type::template set_iterator<bv_iterator>
+    typedef typename bitfield_type::template set_iterator<bv_cursor>
                                                         branch_iterator;
-    typedef typename bitfield_type::template set_iterator<const_bv_iterator>
+    typedef typename bitfield_type::template set_iterator<const_bv_cursor>
                                                         const_branch_iterator;
 
     //--------------------------------------------------------------------------
@@ -274,6 +425,69 @@ private:
      */
     void destruct();
 
+    /**
+     * Flag accessors.
+     */
+    void setFlag(uint8_t flag);
+    void unsetFlag(uint8_t flag);
+    bool isFlagSet(uint8_t flag) const;
+
+    /**
+     * Returns an iterator over the set branches.
+     */
+    branch_iterator branchIterator();
+    const_branch_iterator branchIterator() const;
+
+    /**
+     * Returns the slot of a set branch.
+     */
+    branch_type& getBranch(index_type branch);
+    const branch_type& getBranch(index_type branch) const;
+
+    /**
+     * Sets the bit of the branch and stores the child in its slot, the node
+     * becomes dense once the set branches pass the dense threshold.
+     */
+    void insertBranch(index_type branch, branch_type child);
+
+    /**
+     * Frees the child of a set branch and unsets its bit, the node becomes
+     * sparse again once the set branches drop to half the dense threshold.
+     */
+    void removeBranch(index_type branch);
+
+    /**
+     * Number of set branches above which the node is stored dense.
+     */
+    index_type denseThreshold() const;
+
+    /**
+     * Switch the branch storage between a full array and a compact one.
+     */
+    void makeDense();
+    void makeSparse();
+
+    /**
+     * Makes the node sparse if there are no more set branches than the
+     * dense threshold.
+     */
+    void compactBranches();
+
+    /**
+     * Returns an empty branch of the right type.
+     */
+    branch_type emptyBranch() const;
+
+    /**
+     * Allocates/Frees child nodes and cells using the node's allocator.
+     */
+    Node* createNode(index_type level, const_reference value, bool as_fill);
+    void destroyNode(Node *node);
+    CellType* createCell(const_reference default_value);
+    CellType* createCell(const_reference default_value, 
+                         const_reference fill_value);
+    void destroyCell(CellType *cell);
+
     /**
      * Get the default value of this node. 
      */
@@ -298,14 +512,15 @@ private:
     void computeChildDivisions();
 
     /**
-     * Allocates to total number of branches and the correct type of branches
-     * necessary for the current node.
+     * Allocates empty slots for the set branches, either a slot for each 
+     * branch or only for the set ones depending on their number.
      */
     void allocateBranches();
 
     /**
-     * Creates a child branch of the proper type at the given branch index. 
-     * This should not be used if node is filled.
+     * Creates a child branch of the proper type at the given branch index and
+     * sets its bit, if the branch is not set yet. This should not be used if 
+     * node is filled.
      */
     void createBranch(index_type branch);
 
@@ -326,6 +541,37 @@ private:
      */
     void createFillBranches(const_reference default_val);
 
+    /**
+     * Thread safe version of createBranch(). The child is published with a
+     * compare and swap, threads losing the race free their copy and use the
+     * winner's. Returns the child on the branch, created is set if it is
+     * this thread's. The node must be dense, so slots never move, and new
+     * child nodes are created dense.
+     */
+    branch_type createBranchConcurrent(index_type branch, bool &created);
+
+    /**
+     * Turns the node into a fill node if every branch is a fully set fill 
+     * cell or fill node, with fill values within tolerance of each other.
+     * Returns true if the node is a fill node afterwards.
+     */
+    bool mergeFillBranches(const_reference tolerance);
+
+    /**
+     * Returns a new branching node holding the same values as this fill node.
+     * Used to split fill nodes without modifying them while other threads
+     * may be reading them.
+     */
+    Node* splitFill() const;
+
+    /**
+     * Returns a dense node sharing the branches of this sparse node. Used to
+     * densify nodes without modifying them while other threads may be 
+     * reading them, the sparse node then releases its branches.
+     */
+    Node* denseCopy() const;
+    void releaseBranches();
+
     /** 
      * Computes the local branch index for the given i, j, k coordinates. The
      * coordinates are given local Node coordinates.
@@ -380,13 +626,26 @@ private:
      */
     void writeFillNode(HDF5Id volume_group_id, size_t quadrant, 
                        index_vec offset) const;
+    void writeFillNode(HDF5LeafTable<value_type> &table, size_t quadrant,
+                       index_vec offset) const;
+    void writeFillNode(StreamLeafWriter<value_type> &writer, size_t quadrant,
+                       index_vec offset) const;
 
     /**
-     * handles writing of contents under branching node
+     * handles writing of contents under branching node, to leaf groups, a
+     * leaf table or an indexed stream
      */
-    void writeBranchNode(HDF5Id volume_group_id, size_t quadrant, 
+    template <typename Sink>
+    void writeBranchNode(Sink &sink, size_t quadrant, 
                          index_vec offset) const;
 
+    /**
+     * Returns true if the leaf of the named group has to be written, as it
+     * is dirty or not in stored. The stale group of a dirty leaf is deleted.
+     */
+    static bool replaceLeafGroup(HDF5Id volume_group_id, const String &name,
+                                 bool dirty, std::set<String> &stored);
+
     //--------------------------------------------------------------------------
     // friends.
     //--------------------------------------------------------------------------
@@ -400,6 +659,15 @@ private:
     template <typename CT>
     friend class SetIterator;
 
+    template <typename C, typename Alloc>
+    friend class ConstAccessor;
+
+    template <typename C, typename Alloc>
+    friend class Accessor;
+
+    template <typename C, typename Alloc>
+    friend class ParallelForEach;
+
 #ifdef UNITTEST
     friend class ::TestNode;
     friend class ::TestTree;
@@ -409,6 +677,11 @@ private:
     // members.
     //--------------------------------------------------------------------------
     
+    /**
+     * The allocator used for all memory under this node.
+     */
+    allocator_type m_allocator;
+
     /**
      * The current level of the node in the tree. Level 0 is the leaf node,
      * which is dictated by a Cell, thus Nodes can never be of level < 1.
@@ -441,6 +714,11 @@ private:
      */
     value_type m_value;
 
+    /**
+     * Fill and branch storage flags.
+     */
+    uint8_t m_flags;
+
     /**
      * The bit field that tracks which branch has set values underneath them. 
      */
@@ -449,8 +727,10 @@ private:
     /**
      * The branches from this node. This can either be branching into other
      * branch nodes or into cells. The cells are the leaf nodes of the tree.
-     * This can be an empty array if the node is not a branch node and only
-     * contains a single fillvalue.
+     * Sparse nodes hold the set branches in bit order, the slot of a branch
+     * being the number of set bits before it, dense nodes hold a slot for
+     * every branch. This is an empty array if the node is not a branch node 
+     * and only contains a single fillvalue.
      */
     branch_vector m_branches;
 
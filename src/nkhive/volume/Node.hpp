@@ -45,20 +45,23 @@ Node<CellType, A>::Node(index_type level,
                         uint8_t lg_branching_factor,
                         uint8_t lg_cell_dim,
                         const_reference default_value, 
-                        bool as_fill) : 
+                        bool as_fill,
+                        const allocator_type &a) : 
+    m_allocator(a),
     m_level(level),
     m_lg_branching_factor(lg_branching_factor),
     m_lg_cell_dim(lg_cell_dim),
     m_value(default_value),
-    m_bitfield(lg_branching_factor, bitfield_alloc())
+    m_flags(0),
+    m_bitfield(lg_branching_factor, bitfield_alloc(PoolTraits<A>::pool(a))),
+    m_branches(branch_allocator(a))
 {
     assert(level > 0);
 
+    // branching nodes start out sparse without any branches.
     if (as_fill) {
-        m_branches.clear();
+        setFlag(NODE_FLAG_FILL | NODE_FLAG_DIRTY);
         m_bitfield.fillBits();
-    } else {
-        allocateBranches();
     }
 
     computeChildDivisions();
@@ -75,6 +78,42 @@ Node<CellType, A>::~Node()
 
 //------------------------------------------------------------------------------
 
+template <typename CellType, typename A>
+inline Node<CellType, A>*
+Node<CellType, A>::create(index_type level, 
+                          uint8_t lg_branching_factor,
+                          uint8_t lg_cell_dim,
+                          const_reference default_value, 
+                          bool as_fill,
+                          const allocator_type &a)
+{
+    node_allocator alloc(a);
+    Node *node = alloc.allocate(1);
+    try {
+        new (node) Node(level, lg_branching_factor, lg_cell_dim, 
+                        default_value, as_fill, a);
+    } catch (...) {
+        alloc.deallocate(node, 1);
+        throw;
+    }
+    return node;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::destroy(Node *node)
+{
+    if (node) {
+        node_allocator alloc(node->m_allocator);
+        node->~Node();
+        alloc.deallocate(node, 1);
+    }
+}
+
+//------------------------------------------------------------------------------
+
 template <typename CellType, typename A>
 inline index_type
 Node<CellType, A>::level() const
@@ -88,7 +127,7 @@ template <typename CellType, typename A>
 inline bool
 Node<CellType, A>::isBranching() const
 {
-    return m_branches.size() > 0;
+    return !isFlagSet(NODE_FLAG_FILL);
 }
 
 //------------------------------------------------------------------------------
@@ -102,6 +141,15 @@ Node<CellType, A>::isFill() const
 
 //------------------------------------------------------------------------------
 
+template <typename CellType, typename A>
+inline bool
+Node<CellType, A>::isDense() const
+{
+    return isFlagSet(NODE_FLAG_DENSE);
+}
+
+//------------------------------------------------------------------------------
+
 template <typename CellType, typename A>
 inline bool
 Node<CellType, A>::isEmpty() const
@@ -168,7 +216,7 @@ Node<CellType, A>::computeSetBounds(index_bounds &bounds) const
         bounds = index_bounds(dim, 0);
 
         // Iterate over all set branches.
-        const_branch_iterator iter = m_bitfield.setIterator(m_branches.begin());
+        const_branch_iterator iter = branchIterator();
         for ( ; iter(); ++iter) {
             // Local node's branch 3D coordinates and compute the offset based
             // on the 3D coordinates for the child node/cell division.
@@ -199,7 +247,7 @@ inline typename Node<CellType, A>::reference
 Node<CellType, A>::get(index_type i, index_type j, index_type k)
 {
     // If no branches, then return the fill value.
-    if (m_branches.size() == 0) {
+    if (isFill()) {
         return fillValue();
     }
 
@@ -217,9 +265,9 @@ Node<CellType, A>::get(index_type i, index_type j, index_type k)
 
     // Call get on the child.
     if (isCellParent()) {
-        return m_branches[branch].cell->get(i_child, j_child, k_child);
+        return getBranch(branch).cell->get(i_child, j_child, k_child);
     } // else
-    return m_branches[branch].node->get(i_child, j_child, k_child);
+    return getBranch(branch).node->get(i_child, j_child, k_child);
 }
 
 //------------------------------------------------------------------------------
@@ -255,9 +303,9 @@ Node<CellType, A>::set(index_type i, index_type j, index_type k,
 
     // Recurse down tree
     if (isCellParent()) {
-        m_branches[branch].cell->set(i_child, j_child, k_child, val);
+        getBranch(branch).cell->set(i_child, j_child, k_child, val);
     } else {
-        m_branches[branch].node->set(i_child, j_child, k_child, val);
+        getBranch(branch).node->set(i_child, j_child, k_child, val);
     }
 }
 
@@ -286,9 +334,9 @@ Node<CellType, A>::update(index_type i, index_type j, index_type k,
 
         // Recurse down the tree. 
         if (isCellParent()) {
-            m_branches[branch].cell->update(i_child, j_child, k_child, val, op);
+            getBranch(branch).cell->update(i_child, j_child, k_child, val, op);
         } else {
-            m_branches[branch].node->update(i_child, j_child, k_child, val, op);
+            getBranch(branch).node->update(i_child, j_child, k_child, val, op);
         }
     }
 }
@@ -319,24 +367,74 @@ Node<CellType, A>::unset(index_type i, index_type j, index_type k,
 
     // Call unset recursively on child nodes.
     if (isCellParent()) {
-        m_branches[branch].cell->unset(i_child, j_child, k_child);
+        CellType *cell = getBranch(branch).cell;
+
+        // cells split from a fill node were given the fill value as default
+        cell->setDefaultValue(default_val);
+        cell->unset(i_child, j_child, k_child);
 
         // If the cell is empty, deallocate it and unset this branch.
-        if (m_branches[branch].cell->isEmpty()) {
-            delete m_branches[branch].cell;
-            m_branches[branch].cell = NULL;
-            m_bitfield.unsetBit(branch);
+        if (cell->isEmpty()) {
+            removeBranch(branch);
         }
     } else {
-        m_branches[branch].node->unset(i_child, j_child, k_child, default_val);
+        Node *node = getBranch(branch).node;
+        node->unset(i_child, j_child, k_child, default_val);
 
         // Check if the branch is empty and should be unset.
-        if (m_branches[branch].node->isEmpty()) {
-            delete m_branches[branch].node;
-            m_branches[branch].node = NULL;
-            m_bitfield.unsetBit(branch);
+        if (node->isEmpty()) {
+            removeBranch(branch);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+Node<CellType, A>::prune(const_reference tolerance)
+{
+    if (isFill()) return true;
+
+    // prune every child, even once this node can no longer be merged
+    branch_iterator iter = branchIterator();
+    for ( ; iter(); ++iter) {
+        if (isCellParent()) {
+            iter->cell->prune(tolerance);
+        } else {
+            iter->node->prune(tolerance);
+        }
+    }
+
+    return mergeFillBranches(tolerance);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+Node<CellType, A>::prune(index_type i, index_type j, index_type k, 
+                         const_reference tolerance)
+{
+    if (isFill()) return true;
+
+    index_type branch = computeBranchIndex(i, j, k);
+    if (!m_bitfield.isSet(branch)) return false;
+
+    // only merge above a child that is uniform now
+    if (isCellParent()) {
+        CellType *cell = getBranch(branch).cell;
+        if (!cell->isFull() || !cell->prune(tolerance)) return false;
+    } else {
+        index_type i_child, j_child, k_child;
+        computeChildCoordinates(i, j, k, i_child, j_child, k_child);
+        if (!getBranch(branch).node->prune(i_child, j_child, k_child, 
+                                           tolerance)) {
+            return false;
         }
     }
+
+    return mergeFillBranches(tolerance);
 }
 
 //------------------------------------------------------------------------------
@@ -383,8 +481,8 @@ Node<CellType, A>::stamp(const Stamp<U, Source> &stamp,
                 child_intersection.translate(-child_bounds.min());
 
                 // Set the bit and allocate child node/cell
-                index_type branch = getIndex(i, j, k, m_lg_branching_factor);
-                m_bitfield.setBit(branch);
+                index_type branch = layout_type::getIndex(
+                    i, j, k, m_lg_branching_factor);
                 createBranch(branch);
 
                 // compute the intersection in stamp's space
@@ -401,14 +499,83 @@ Node<CellType, A>::stamp(const Stamp<U, Source> &stamp,
                     vector min = stamp_intersection.max() * transform; 
                     signed_bounds.setExtrema(min, max);
 
-                    m_branches[branch].cell->stamp(stamp, signed_bounds, 
-                                                   child_intersection, 
-                                                   transform);
+                    getBranch(branch).cell->stamp(stamp, signed_bounds, 
+                                                  child_intersection, 
+                                                  transform);
                 } else {
 
-                    m_branches[branch].node->stamp(stamp, stamp_intersection, 
-                                                   child_intersection, 
-                                                   transform);
+                    getBranch(branch).node->stamp(stamp, stamp_intersection, 
+                                                  child_intersection, 
+                                                  transform);
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::fill(const index_bounds &bounds, const_reference value)
+{
+    // turn into a fill node if completely covered
+    index_bounds node_bounds(0, computeMaxDim());
+    if (bounds.contains(node_bounds)) {
+        m_value = value;
+
+        destruct();
+        setFlag(NODE_FLAG_FILL | NODE_FLAG_DIRTY);
+        unsetFlag(NODE_FLAG_DENSE);
+        m_bitfield.fillBits();
+        return;
+    }
+
+    // allocate branches if fill node.
+    if (isFill()) createFillBranches(defaultValue());
+
+    // the full extent of a cell, in the cell's space
+    index_bounds cell_bounds(0, computeChildDim());
+
+    // calculate the intersecting branches
+    index_bounds branch_bounds = calculateBranchIntersection(bounds);
+
+    const index_vec &min = branch_bounds.min();
+    const index_vec &max = branch_bounds.max();
+    for (index_type k = min.z; k < max.z; ++k) {
+        for (index_type j = min.y; j < max.y; ++j) {
+            for (index_type i = min.x; i < max.x; ++i) {
+
+                // intersection in the child's space
+                index_bounds child_bounds = computeChildBounds(i, j, k);
+                index_bounds intersection = bounds.intersection(child_bounds);
+                intersection.translate(-child_bounds.min());
+
+                // Set the bit and allocate child node/cell
+                index_type branch = layout_type::getIndex(
+                    i, j, k, m_lg_branching_factor);
+                createBranch(branch);
+
+                if (!isCellParent()) {
+                    getBranch(branch).node->fill(intersection, value);
+                    continue;
+                }
+
+                CellType *cell = getBranch(branch).cell;
+                if (intersection.contains(cell_bounds)) {
+                    cell->fill(value);
+                    continue;
+                }
+
+                // set the covered voxels of a partially covered cell
+                const index_vec &lo = intersection.min();
+                const index_vec &hi = intersection.max();
+                for (index_type z = lo.z; z < hi.z; ++z) {
+                    for (index_type y = lo.y; y < hi.y; ++y) {
+                        for (index_type x = lo.x; x < hi.x; ++x) {
+                            cell->set(x, y, z, value);
+                        }
+                    }
                 }
             }
         }
@@ -442,28 +609,33 @@ Node<CellType, A>::read(std::istream &is)
 
     // Read the default value or the fill value.
     if (branching) {
-        // Allocate space for all branches
+        // Allocate space for the set branches
+        unsetFlag(NODE_FLAG_FILL);
         allocateBranches();
 
         is.read((char*)&defaultValue(), sizeof(value_type));
 
-        // Create the nodes/cells on all active branches and read them in.
-        if (isCellParent()) {
-            branch_iterator iter = m_bitfield.setIterator(m_branches.begin());
-            for ( ; iter(); ++iter) {
-                iter->cell = new CellType(m_lg_cell_dim, defaultValue());
-                iter->cell->read(is);
-            }
-        } else {
-            branch_iterator iter = m_bitfield.setIterator(m_branches.begin());
-            for ( ; iter(); ++iter) {
-                iter->node = new Node(m_level - 1, m_lg_branching_factor, 
-                                      m_lg_cell_dim, defaultValue());
-                iter->node->read(is);
+        // Create the nodes/cells on all active branches and read them in,
+        // branches are stored in row major order.
+        const index_type branches = numBits3D(m_lg_branching_factor);
+        for (index_type n = 0; n < branches; ++n) {
+            index_type branch = 
+                layout_type::fromRowMajor(n, m_lg_branching_factor);
+            if (!m_bitfield.isSet(branch)) continue;
+
+            branch_type &slot = getBranch(branch);
+            if (isCellParent()) {
+                slot.cell = createCell(defaultValue());
+                slot.cell->read(is);
+            } else {
+                slot.node = createNode(m_level - 1, defaultValue(), false);
+                slot.node->read(is);
             }
         }
 
     } else {
+        setFlag(NODE_FLAG_FILL);
+        unsetFlag(NODE_FLAG_DENSE | NODE_FLAG_DIRTY);
         is.read((char*)&fillValue(), sizeof(value_type));
 
         // no branches to read in.
@@ -496,7 +668,9 @@ Node<CellType, A>::read(HDF5Id leaf_group_id, index_vec index_offset)
                                 TypeToHDF5Type<value_type>::type(),
                                 &m_value);
 
-            m_branches.clear();
+            destruct();
+            setFlag(NODE_FLAG_FILL);
+            unsetFlag(NODE_FLAG_DENSE | NODE_FLAG_DIRTY);
             m_bitfield.fillBits();
             return;
         }
@@ -507,19 +681,14 @@ Node<CellType, A>::read(HDF5Id leaf_group_id, index_vec index_offset)
                                            index_offset[1], 
                                            index_offset[2]);
 
-    // Set the bit
-    m_bitfield.setBit(branch);
+    // Allocate a child node or cell and set the bit.
+    createBranch(branch);
 
-    // Allocate a child node or cell.
     if (isCellParent()) {
         assert(type == LEAF_TYPE_CELL);
 
         // cell end case
-        if (m_branches[branch].cell == NULL) {
-            m_branches[branch].cell = new CellType(m_lg_cell_dim, 
-                                                   defaultValue());
-        }
-        m_branches[branch].cell->read(leaf_group_id);
+        getBranch(branch).cell->read(leaf_group_id);
 
     // recurse down the tree
     } else {
@@ -530,14 +699,67 @@ Node<CellType, A>::read(HDF5Id leaf_group_id, index_vec index_offset)
             index_offset[0], index_offset[1], index_offset[2],
             child_offset[0], child_offset[1], child_offset[2]); 
 
-       if (m_branches[branch].node == NULL) {
-            m_branches[branch].node = new Node(m_level - 1,
-                                               m_lg_branching_factor,
-                                               m_lg_cell_dim,
-                                               defaultValue());
-        }
-        m_branches[branch].node->read(leaf_group_id, child_offset);
+        getBranch(branch).node->read(leaf_group_id, child_offset);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Table>
+inline void
+Node<CellType, A>::read(Table &table, size_t leaf, 
+                        index_vec index_offset)
+{
+    CellType *cell = readPath(table, leaf, index_offset);
+    if (cell) {
+        cell->read(table, leaf);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Table>
+inline CellType*
+Node<CellType, A>::readPath(Table &table, size_t leaf, 
+                            index_vec index_offset)
+{
+    const typename Table::Record &record = table[leaf];
+
+    if (record.type == LEAF_TYPE_FILL_NODE && record.level == m_level) {
+        // construct the fill node
+        m_value = record.fill_value;
+
+        destruct();
+        setFlag(NODE_FLAG_FILL);
+        unsetFlag(NODE_FLAG_DENSE | NODE_FLAG_DIRTY);
+        m_bitfield.fillBits();
+        return NULL;
+    }
+
+    // The branch index 
+    index_type branch = computeBranchIndex(index_offset[0],
+                                           index_offset[1], 
+                                           index_offset[2]);
+
+    // Allocate a child node or cell and set the bit.
+    createBranch(branch);
+
+    if (isCellParent()) {
+        assert(record.type == LEAF_TYPE_CELL);
+
+        // cell end case
+        return getBranch(branch).cell;
     }
+
+    // Compute the local coordinates for the child node and recurse. 
+    index_vec child_offset;
+    computeChildCoordinates(
+        index_offset[0], index_offset[1], index_offset[2],
+        child_offset[0], child_offset[1], child_offset[2]); 
+
+    return getBranch(branch).node->readPath(table, leaf, child_offset);
 }
 
 //------------------------------------------------------------------------------
@@ -566,18 +788,17 @@ Node<CellType, A>::write(std::ostream &os) const
     if (branching) {
         os.write((char*)&defaultValue(), sizeof(value_type));
 
-        // Call write on the set branches.
-        if (isCellParent()) {
-            const_branch_iterator iter = 
-                m_bitfield.setIterator(m_branches.begin());
-            for ( ; iter(); ++iter) {
-                iter->cell->write(os);
-            }
-        } else {
-            const_branch_iterator iter = 
-                m_bitfield.setIterator(m_branches.begin());
-            for ( ; iter(); ++iter) {
-                iter->node->write(os);
+        // Call write on the set branches, in row major order.
+        const index_type branches = numBits3D(m_lg_branching_factor);
+        for (index_type n = 0; n < branches; ++n) {
+            index_type branch = 
+                layout_type::fromRowMajor(n, m_lg_branching_factor);
+            if (!m_bitfield.isSet(branch)) continue;
+
+            if (isCellParent()) {
+                getBranch(branch).cell->write(os);
+            } else {
+                getBranch(branch).node->write(os);
             }
         }
 
@@ -610,6 +831,83 @@ Node<CellType, A>::write(HDF5Id volume_group_id, size_t quadrant,
 
 //------------------------------------------------------------------------------
 
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::write(HDF5LeafTable<value_type> &table, size_t quadrant,
+                         index_vec offset) const
+{
+    if (isBranching()) {
+        writeBranchNode(table, quadrant, offset);
+    } else if (isFill()) {
+        writeFillNode(table, quadrant, offset);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::write(StreamLeafWriter<value_type> &writer, 
+                         size_t quadrant, index_vec offset) const
+{
+    if (isBranching()) {
+        writeBranchNode(writer, quadrant, offset);
+    } else if (isFill()) {
+        writeFillNode(writer, quadrant, offset);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::writeDirty(HDF5Id volume_group_id, size_t quadrant,
+                              index_vec offset, std::set<String> &stored)
+{
+    String leaf_group_name;
+
+    if (isFill()) {
+        constructLeafGroupName(LEAF_TYPE_FILL_NODE, quadrant, offset,
+                               leaf_group_name);
+        if (replaceLeafGroup(volume_group_id, leaf_group_name, 
+                             isFlagSet(NODE_FLAG_DIRTY), stored)) {
+            writeFillNode(volume_group_id, quadrant, offset);
+            unsetFlag(NODE_FLAG_DIRTY);
+        }
+        return;
+    }
+
+    index_type child_dim = computeChildDim();
+
+    // iterate over set branches
+    branch_iterator iter = branchIterator();
+    for ( ; iter(); ++iter) {
+        index_type i, j, k;
+        iter.getCoordinates(i, j, k);
+
+        // accumulate offsets to pass down the tree
+        index_vec accum_offset = 
+            accumulateBranchOffset(offset, child_dim, i, j, k);
+
+        if (!isCellParent()) {
+            iter->node->writeDirty(volume_group_id, quadrant, accum_offset,
+                                   stored);
+            continue;
+        }
+
+        CellType *cell = iter->cell;
+        constructLeafGroupName(LEAF_TYPE_CELL, quadrant, accum_offset, 
+                               leaf_group_name);
+        if (replaceLeafGroup(volume_group_id, leaf_group_name, 
+                             cell->isDirty(), stored)) {
+            cell->write(volume_group_id, quadrant, accum_offset);
+            cell->markClean();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
 template <typename CellType, typename A>
 inline bool
 Node<CellType, A>::operator==(const Node &that) const
@@ -619,7 +917,6 @@ Node<CellType, A>::operator==(const Node &that) const
         (m_lg_branching_factor == that.m_lg_branching_factor) &&
         (m_lg_cell_dim == that.m_lg_cell_dim) &&
         (m_lg_child_divisions == that.m_lg_child_divisions) &&
-        (m_branches.size() == that.m_branches.size()) && 
         (isFill() == that.isFill());
 
     if (!simpleChecks) return false;
@@ -637,10 +934,10 @@ Node<CellType, A>::operator==(const Node &that) const
     // Don't check branches if we have a fill node.
     if (isFill()) return true;
 
-    // Recursively check each branch for branching nodes.
-    const_branch_iterator this_it = m_bitfield.setIterator(m_branches.begin());
-    const_branch_iterator that_it = 
-        m_bitfield.setIterator(that.m_branches.begin());
+    // Recursively check each branch for branching nodes, either node may be
+    // sparse or dense.
+    const_branch_iterator this_it = branchIterator();
+    const_branch_iterator that_it = that.branchIterator();
     for ( ; this_it(); ++this_it, ++that_it) {
         if (isCellParent()) {
             if (this_it->cell->operator!=(*(that_it->cell))) return false;
@@ -670,8 +967,13 @@ Node<CellType, A>::sizeOf() const
     int sizeof_this     = sizeof(*this);
     int sizeof_bitfield = m_bitfield.sizeOf();
 
-    int sizeof_branches = sizeof(branch_type*) * m_branches.capacity();
-    const_branch_iterator iter = m_bitfield.setIterator(m_branches.begin());
+    // sparse nodes only pay for the slots of their set branches.
+    int sizeof_branches = sizeof(branch_type) * m_branches.capacity();
+    if (isFill()) {
+        return sizeof_this + sizeof_bitfield + sizeof_branches;
+    }
+
+    const_branch_iterator iter = branchIterator();
     for ( ; iter(); ++iter) {
         if (isCellParent()) { 
             sizeof_branches += iter->cell->sizeOf();
@@ -689,16 +991,13 @@ template <typename CellType, typename A>
 inline void
 Node<CellType, A>::allocateBranches()
 {
-    // Allocate the branch nodes.
-    m_branches.resize(numBits3D(m_lg_branching_factor));
-    if (isCellParent()) {
-        for (size_t i = 0; i < m_branches.size(); ++i) {
-            m_branches[i].cell = NULL;
-        }
+    // Allocate the branch slots, the children are filled in by the caller.
+    if (m_bitfield.count() > denseThreshold()) {
+        setFlag(NODE_FLAG_DENSE);
+        m_branches.assign(numBits3D(m_lg_branching_factor), emptyBranch());
     } else {
-        for (size_t i = 0; i < m_branches.size(); ++i) {
-            m_branches[i].node = NULL;
-        }
+        unsetFlag(NODE_FLAG_DENSE);
+        m_branches.assign(m_bitfield.count(), emptyBranch());
     }
 }
 
@@ -715,13 +1014,10 @@ Node<CellType, A>::setBranch(index_type i, index_type j, index_type k,
     // The branch index 
     branch = computeBranchIndex(i, j, k);
 
-    // Set the bit
-    m_bitfield.setBit(branch);
-
     // Compute the local coordinates for the child node. 
     computeChildCoordinates(i, j, k, i_child, j_child, k_child);
 
-    // Allocate a child node or cell.
+    // Allocate a child node or cell and set the bit.
     createBranch(branch);
 }
 
@@ -734,19 +1030,18 @@ Node<CellType, A>::createBranch(index_type branch)
     // this should only be called if the node is a normal node.
     assert(!isFill());
 
+    if (m_bitfield.isSet(branch)) return;
+
     value_type value = defaultValue();
 
     // allocate a child node or cell.
+    branch_type child;
     if (isCellParent()) {
-        if (m_branches[branch].cell == NULL) {
-            m_branches[branch].cell = new CellType(m_lg_cell_dim, value);
-        }
+        child.cell = createCell(value);
     } else {
-        if (m_branches[branch].node == NULL) {
-            m_branches[branch].node = new Node(
-                m_level - 1, m_lg_branching_factor, m_lg_cell_dim, value);
-        }
+        child.node = createNode(m_level - 1, value, false);
     }
+    insertBranch(branch, child);
 }
 
 //------------------------------------------------------------------------------
@@ -760,21 +1055,157 @@ Node<CellType, A>::createFillBranches(const_reference default_val)
 
     value_type fill_val = fillValue();
 
-    // Allocate branch nodes.
+    // Allocate branch nodes, every branch is set so the node is dense.
     m_branches.resize(numBits3D(m_lg_branching_factor));
     if (isCellParent()) {
         for (size_t i = 0; i < m_branches.size(); ++i) {
-            m_branches[i].cell = 
-                new CellType(m_lg_cell_dim, default_val, fill_val, 
-                             typename CellType::allocator_type());
+            m_branches[i].cell = createCell(default_val, fill_val);
         }
     } else {
         for (size_t i = 0; i < m_branches.size(); ++i) {
-            m_branches[i].node = 
-                new Node(m_level - 1, m_lg_branching_factor, 
-                         m_lg_cell_dim, fill_val, true);
+            m_branches[i].node = createNode(m_level - 1, fill_val, true);
+        }
+    }
+    unsetFlag(NODE_FLAG_FILL);
+    setFlag(NODE_FLAG_DENSE);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename Node<CellType, A>::branch_type
+Node<CellType, A>::createBranchConcurrent(index_type branch, bool &created)
+{
+    // this should only be called if the node is a normal node.
+    assert(!isFill());
+    assert(isDense());
+
+    created = false;
+    branch_type child;
+    if (isCellParent()) {
+        child.cell = atomicLoad(&m_branches[branch].cell);
+        if (child.cell == NULL) {
+            CellType *cell = createCell(defaultValue());
+            if (compareAndSwap(&m_branches[branch].cell, 
+                               static_cast<CellType*>(NULL), cell)) {
+                child.cell = cell;
+                created = true;
+            } else {
+                destroyCell(cell);
+                child.cell = atomicLoad(&m_branches[branch].cell);
+            }
+        }
+    } else {
+        child.node = atomicLoad(&m_branches[branch].node);
+        if (child.node == NULL) {
+            Node *node = createNode(m_level - 1, defaultValue(), false);
+            node->makeDense();
+            if (compareAndSwap(&m_branches[branch].node, 
+                               static_cast<Node*>(NULL), node)) {
+                child.node = node;
+                created = true;
+            } else {
+                destroyNode(node);
+                child.node = atomicLoad(&m_branches[branch].node);
+            }
+        }
+    }
+
+    // the child is published before its bit, a set bit always has a child.
+    m_bitfield.setBitAtomic(branch);
+
+    return child;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+Node<CellType, A>::mergeFillBranches(const_reference tolerance)
+{
+    if (isFill()) return true;
+    if (!m_bitfield.isFull()) return false;
+
+    // compressed cells are left alone, they may not be modified
+    value_type value = value_type();
+    branch_iterator iter = branchIterator();
+    for ( ; iter(); ++iter) {
+        value_type branch_value;
+        if (isCellParent()) {
+            const CellType *cell = iter->cell;
+            if (!cell->isFilled() || !cell->isFull() || cell->isCompressed()) {
+                return false;
+            }
+            branch_value = cell->get(0);
+        } else {
+            const Node *node = iter->node;
+            if (!node->isFill()) return false;
+            branch_value = node->fillValue();
+        }
+
+        if (iter.getIndex() == 0) {
+            value = branch_value;
+        } else if (!CellType::withinTolerance(branch_value, value, 
+                                              tolerance)) {
+            return false;
         }
     }
+
+    // release the branch storage along with the branches
+    destruct();
+    branch_vector(m_branches.get_allocator()).swap(m_branches);
+    setFlag(NODE_FLAG_FILL | NODE_FLAG_DIRTY);
+    unsetFlag(NODE_FLAG_DENSE);
+    m_value = value;
+    m_bitfield.fillBits();
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline Node<CellType, A>*
+Node<CellType, A>::splitFill() const
+{
+    assert(isFill());
+
+    Node *node = create(m_level, m_lg_branching_factor, m_lg_cell_dim, 
+                        fillValue(), true, m_allocator);
+    node->createFillBranches(node->fillValue());
+
+    return node;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline Node<CellType, A>*
+Node<CellType, A>::denseCopy() const
+{
+    assert(isBranching() && !isDense());
+
+    Node *node = create(m_level, m_lg_branching_factor, m_lg_cell_dim, 
+                        m_value, false, m_allocator);
+    node->m_flags = m_flags | NODE_FLAG_DENSE;
+    node->m_bitfield = m_bitfield;
+    node->m_branches.resize(numBits3D(m_lg_branching_factor), emptyBranch());
+    const_branch_iterator iter = branchIterator();
+    for ( ; iter(); ++iter) {
+        node->m_branches[iter.getIndex()] = *iter;
+    }
+
+    return node;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::releaseBranches()
+{
+    branch_vector(m_branches.get_allocator()).swap(m_branches);
+    m_bitfield.clearBits();
 }
 
 //------------------------------------------------------------------------------ 
@@ -787,10 +1218,10 @@ Node<CellType, A>::computeBranchIndex(index_type i,
 {
     // Convert each given coordinate into local node coordinates by dividing by
     // the total number of branches under the node.
-    return getIndex(i >> m_lg_child_divisions,
-                    j >> m_lg_child_divisions,
-                    k >> m_lg_child_divisions,
-                    m_lg_branching_factor);
+    return layout_type::getIndex(i >> m_lg_child_divisions,
+                                 j >> m_lg_child_divisions,
+                                 k >> m_lg_child_divisions,
+                                 m_lg_branching_factor);
 }
 
 //------------------------------------------------------------------------------ 
@@ -835,13 +1266,13 @@ Node<CellType, A>::destruct()
     if (isCellParent()) {
         for (size_t i = 0; i < m_branches.size(); ++i) {
             if (m_branches[i].cell) {
-                delete m_branches[i].cell;
+                destroyCell(m_branches[i].cell);
             }
         }
     } else {
         for (size_t i = 0; i < m_branches.size(); ++i) {
             if (m_branches[i].node) {
-                delete m_branches[i].node;
+                destroyNode(m_branches[i].node);
             }
         }
     }
@@ -851,11 +1282,279 @@ Node<CellType, A>::destruct()
 
 //------------------------------------------------------------------------------
 
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::setFlag(uint8_t flag)
+{
+    m_flags |= flag;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::unsetFlag(uint8_t flag)
+{
+    m_flags &= ~flag;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+Node<CellType, A>::isFlagSet(uint8_t flag) const
+{
+    return (m_flags & flag);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename Node<CellType, A>::branch_iterator
+Node<CellType, A>::branchIterator()
+{
+    return m_bitfield.setIterator(
+        bv_cursor(&m_branches, &m_bitfield, isDense()));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename Node<CellType, A>::const_branch_iterator
+Node<CellType, A>::branchIterator() const
+{
+    return m_bitfield.setIterator(
+        const_bv_cursor(&m_branches, &m_bitfield, isDense()));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename Node<CellType, A>::branch_type&
+Node<CellType, A>::getBranch(index_type branch)
+{
+    assert(m_bitfield.isSet(branch));
+    return m_branches[isDense() ? branch : m_bitfield.countRange(branch)];
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline const typename Node<CellType, A>::branch_type&
+Node<CellType, A>::getBranch(index_type branch) const
+{
+    return const_cast<Node&>(*this).getBranch(branch);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::insertBranch(index_type branch, branch_type child)
+{
+    assert(isBranching());
+    assert(!m_bitfield.isSet(branch));
+
+    if (isDense()) {
+        m_branches[branch] = child;
+        m_bitfield.setBit(branch);
+        return;
+    }
+
+    // the slot goes after the slots of the set branches before it.
+    m_branches.insert(m_branches.begin() + m_bitfield.countRange(branch), 
+                      child);
+    m_bitfield.setBit(branch);
+
+    if (m_branches.size() > denseThreshold()) {
+        makeDense();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::removeBranch(index_type branch)
+{
+    branch_type &slot = getBranch(branch);
+    if (isCellParent()) {
+        destroyCell(slot.cell);
+    } else {
+        destroyNode(slot.node);
+    }
+
+    if (isDense()) {
+        slot = emptyBranch();
+        m_bitfield.unsetBit(branch);
+
+        // keep some slack so nodes around the threshold don't flip flop.
+        if (m_bitfield.count() <= denseThreshold() / 2) {
+            makeSparse();
+        }
+    } else {
+        m_branches.erase(m_branches.begin() + m_bitfield.countRange(branch));
+        m_bitfield.unsetBit(branch);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline index_type
+Node<CellType, A>::denseThreshold() const
+{
+    // a quarter of the branches, past that the rank lookups cost more than
+    // the memory saved.
+    return numBits3D(m_lg_branching_factor) >> 2;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::makeDense()
+{
+    if (isFill() || isDense()) return;
+
+    branch_vector branches(numBits3D(m_lg_branching_factor), emptyBranch(),
+                           m_branches.get_allocator());
+    branch_iterator iter = branchIterator();
+    for ( ; iter(); ++iter) {
+        branches[iter.getIndex()] = *iter;
+    }
+
+    m_branches.swap(branches);
+    setFlag(NODE_FLAG_DENSE);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::makeSparse()
+{
+    if (isFill() || !isDense()) return;
+
+    // a fresh vector so the dense storage is released.
+    branch_vector branches(m_branches.get_allocator());
+    branches.reserve(m_bitfield.count());
+    branch_iterator iter = branchIterator();
+    for ( ; iter(); ++iter) {
+        branches.push_back(*iter);
+    }
+
+    m_branches.swap(branches);
+    unsetFlag(NODE_FLAG_DENSE);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::compactBranches()
+{
+    if (m_bitfield.count() <= denseThreshold()) {
+        makeSparse();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename Node<CellType, A>::branch_type
+Node<CellType, A>::emptyBranch() const
+{
+    branch_type branch;
+    if (isCellParent()) {
+        branch.cell = NULL;
+    } else {
+        branch.node = NULL;
+    }
+    return branch;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline Node<CellType, A>*
+Node<CellType, A>::createNode(index_type level, const_reference value, 
+                              bool as_fill)
+{
+    return create(level, m_lg_branching_factor, m_lg_cell_dim, value, as_fill,
+                  m_allocator);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::destroyNode(Node *node)
+{
+    destroy(node);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline CellType*
+Node<CellType, A>::createCell(const_reference default_value)
+{
+    typedef typename CellType::allocator_type cell_data_allocator;
+
+    cell_allocator alloc(m_allocator);
+    CellType *cell = alloc.allocate(1);
+    try {
+        new (cell) CellType(m_lg_cell_dim, default_value, 
+            PoolTraits<cell_data_allocator>::create(
+                PoolTraits<A>::pool(m_allocator)));
+    } catch (...) {
+        alloc.deallocate(cell, 1);
+        throw;
+    }
+    return cell;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline CellType*
+Node<CellType, A>::createCell(const_reference default_value, 
+                              const_reference fill_value)
+{
+    typedef typename CellType::allocator_type cell_data_allocator;
+
+    cell_allocator alloc(m_allocator);
+    CellType *cell = alloc.allocate(1);
+    try {
+        new (cell) CellType(m_lg_cell_dim, default_value, fill_value, 
+            PoolTraits<cell_data_allocator>::create(
+                PoolTraits<A>::pool(m_allocator)));
+    } catch (...) {
+        alloc.deallocate(cell, 1);
+        throw;
+    }
+    return cell;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::destroyCell(CellType *cell)
+{
+    cell_allocator alloc(m_allocator);
+    cell->~CellType();
+    alloc.deallocate(cell, 1);
+}
+
+//------------------------------------------------------------------------------
+
 template <typename CellType, typename A>
 inline typename Node<CellType, A>::value_type&
 Node<CellType, A>::defaultValue()
 {
-    assert(m_branches.size() == numBits3D(m_bitfield.size()));
+    assert(isBranching());
     return m_value;
 }
 
@@ -874,7 +1573,8 @@ template <typename CellType, typename A>
 inline typename Node<CellType, A>::value_type&
 Node<CellType, A>::fillValue()
 {
-    assert(m_branches.size() == 0);
+    assert(isFill());
+    assert(m_branches.empty());
     assert(m_bitfield.isFull());
     return m_value;
 }
@@ -919,11 +1619,12 @@ Node<CellType, A>::setSubtree(Node<CellType, A> *subtree)
     // should never be used as a subtree of the current node.
     assert(!subtree->isEmpty());
     assert(isBranching());
-    assert(m_branches[0].node == NULL);
+    assert(!m_bitfield.isSet(0));
 
     // Assign the branch and set the bit to signify set values.
-    m_branches[0].node = subtree;
-    m_bitfield.setBit(0);
+    branch_type child;
+    child.node = subtree;
+    insertBranch(0, child);
 }
 
 //------------------------------------------------------------------------------
@@ -945,9 +1646,9 @@ Node<CellType, A>::calculateBranchIntersection(index_bounds voxel_bounds)
 
     // convert the min/max into branch coordinates
     index_bounds branch_bounds;
-    getCoordinates(branch_min_index, m_lg_branching_factor, 
+    layout_type::getCoordinates(branch_min_index, m_lg_branching_factor, 
         branch_bounds.min().x, branch_bounds.min().y, branch_bounds.min().z);
-    getCoordinates(branch_max_index, m_lg_branching_factor, 
+    layout_type::getCoordinates(branch_max_index, m_lg_branching_factor, 
         branch_bounds.max().x, branch_bounds.max().y, branch_bounds.max().z);
 
     // add 'edge' to bounds
@@ -1042,7 +1743,37 @@ Node<CellType, A>::writeFillNode(HDF5Id volume_group_id, size_t quadrant,
 
 template <typename CellType, typename A>
 inline void
-Node<CellType, A>::writeBranchNode(HDF5Id volume_group_id, size_t quadrant,
+Node<CellType, A>::writeFillNode(HDF5LeafTable<value_type> &table,
+                                 size_t quadrant, index_vec offset) const
+{
+    typename HDF5LeafTable<value_type>::Record &record = table.append();
+    record.quadrant   = quadrant;
+    record.type       = LEAF_TYPE_FILL_NODE;
+    record.level      = m_level;
+    record.offset[0]  = offset[0];
+    record.offset[1]  = offset[1];
+    record.offset[2]  = offset[2];
+    record.fill_value = m_value;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Node<CellType, A>::writeFillNode(StreamLeafWriter<value_type> &writer,
+                                 size_t quadrant, index_vec offset) const
+{
+    // fill nodes are held in the table of contents only
+    writer.beginLeaf(LEAF_TYPE_FILL_NODE, m_level, quadrant, offset, m_value);
+    writer.endLeaf();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Sink>
+inline void
+Node<CellType, A>::writeBranchNode(Sink &sink, size_t quadrant,
                                    index_vec offset) const
 {
     index_type child_dim = computeChildDim();
@@ -1051,8 +1782,7 @@ Node<CellType, A>::writeBranchNode(HDF5Id volume_group_id, size_t quadrant,
     if (isCellParent()) {
 
         // iterate over set branches
-        const_branch_iterator iter = 
-            m_bitfield.setIterator(m_branches.begin());
+        const_branch_iterator iter = branchIterator();
         for ( ; iter(); ++iter) {
             index_type i, j, k;
             iter.getCoordinates(i, j, k);
@@ -1062,14 +1792,13 @@ Node<CellType, A>::writeBranchNode(HDF5Id volume_group_id, size_t quadrant,
                 accumulateBranchOffset(offset, child_dim, i, j, k);
 
             // write out the cell  
-            iter->cell->write(volume_group_id, quadrant, accum_offset);
+            iter->cell->write(sink, quadrant, accum_offset);
         }
 
     } else {
 
         // iterate over set branches
-        const_branch_iterator iter = 
-            m_bitfield.setIterator(m_branches.begin());
+        const_branch_iterator iter = branchIterator();
         for ( ; iter(); ++iter) {
             index_type i, j, k;
             iter.getCoordinates(i, j, k);
@@ -1079,9 +1808,30 @@ Node<CellType, A>::writeBranchNode(HDF5Id volume_group_id, size_t quadrant,
                 accumulateBranchOffset(offset, child_dim, i, j, k);
            
             // recurse on the child 
-            iter->node->write(volume_group_id, quadrant, accum_offset);
+            iter->node->write(sink, quadrant, accum_offset);
         }
     }
 }
 
 //------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+Node<CellType, A>::replaceLeafGroup(HDF5Id volume_group_id, 
+                                    const String &name, bool dirty,
+                                    std::set<String> &stored)
+{
+    bool exists = stored.erase(name) > 0;
+    if (exists && !dirty) {
+        return false;
+    }
+
+    // leaf groups only hold attributes and data sets, unlinking the group
+    // removes them all
+    if (exists) {
+        H5Ldelete(volume_group_id, name.c_str(), H5P_DEFAULT);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
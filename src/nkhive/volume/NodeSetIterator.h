@@ -73,10 +73,13 @@ public:
     typedef typename CellType::const_reference              const_reference;
     typedef std::forward_iterator_tag                       iterator_category;
 
+    typedef Node<CellType, typename CellType::allocator_type>
+                                                            node_type;
+
     /**
      * Constructors and destructors.
      */
-    NodeSetIterator(Node<CellType> *n);
+    NodeSetIterator(node_type *n);
     virtual ~NodeSetIterator();
 
     //--------------------------------------------------------------------------
@@ -116,9 +119,9 @@ public:
     // Other members.
     //--------------------------------------------------------------------------
 
-    Node<CellType>* getNode() const;
+    node_type* getNode() const;
 
-    const typename Node<CellType>::branch_iterator& getBranchIterator() const;
+    const typename node_type::branch_iterator& getBranchIterator() const;
 
 protected:
 
@@ -142,13 +145,13 @@ private:
     /**
      * Store the node we are iterating over.
      */
-    Node<CellType> *m_node;
+    node_type *m_node;
 
     /** 
      * Store the current branch_iterator of the node we are iterating over.
      * This allows us to iterate over existing branches in the node.
      */
-    typename Node<CellType>::branch_iterator m_branch_iterator;
+    typename node_type::branch_iterator m_branch_iterator;
 };
 
 END_NKHIVE_NS
@@ -39,7 +39,7 @@
 
 template <typename CellType>
 inline 
-NodeSetIterator<CellType>::NodeSetIterator(Node<CellType> *node) : 
+NodeSetIterator<CellType>::NodeSetIterator(node_type *node) : 
     m_node(node)
 {
     // The current node should never be the fill node. We always look ahead
@@ -48,8 +48,7 @@ NodeSetIterator<CellType>::NodeSetIterator(Node<CellType> *node) :
     assert(!m_node->isFill());
 
     // Initialize the branch iterator.
-    m_branch_iterator = 
-        m_node->m_bitfield.setIterator(m_node->m_branches.begin());
+    m_branch_iterator = m_node->branchIterator();
 }
 
 //------------------------------------------------------------------------------
@@ -119,7 +118,7 @@ NodeSetIterator<CellType>::isValueIterator() const
 //------------------------------------------------------------------------------
 
 template <typename CellType>
-inline Node<CellType>*
+inline typename NodeSetIterator<CellType>::node_type*
 NodeSetIterator<CellType>::getNode() const
 {
     return m_node;
@@ -128,7 +127,7 @@ NodeSetIterator<CellType>::getNode() const
 //------------------------------------------------------------------------------
 
 template <typename CellType>
-inline const typename Node<CellType>::branch_iterator&
+inline const typename NodeSetIterator<CellType>::node_type::branch_iterator&
 NodeSetIterator<CellType>::getBranchIterator() const
 {
     return m_branch_iterator;
@@ -0,0 +1,260 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// ParallelForEach.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_VOLUME_PARALLELFOREACH_H__
+#define __NKHIVE_VOLUME_PARALLELFOREACH_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <vector>
+#include <boost/bind.hpp>
+
+#include <nkbase/Exceptions.h>
+
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkhive/util/WorkerGroup.h>
+#include <nkhive/volume/Leaf.h>
+#include <nkhive/volume/Node.h>
+
+//------------------------------------------------------------------------------
+// forward declarations
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+template <typename C, typename Alloc>
+class Tree;
+
+template <typename C, typename Alloc>
+class ParallelWriter;
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Runs functors over the leaves of a Tree on several threads. The quadrants
+ * are split into subtrees at the branch level until there are enough of them
+ * to balance the threads, which then pull subtrees off a shared counter.
+ */
+template <typename CellType,
+          typename A = std::allocator<typename CellType::value_type> >
+class ParallelForEach
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+
+    typedef Tree<CellType, A>                         tree_type;
+    typedef Leaf<CellType>                            leaf;
+    typedef Leaf<const CellType>                      const_leaf;
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    /**
+     * A thread count of 0 uses one thread per core.
+     */
+    ParallelForEach(const tree_type *tree, size_t num_threads = 0);
+
+    /**
+     * Calls f(leaf) for every cell of the tree. Fill nodes are handed out 
+     * as the filled cells they stand for, the writable version splits them 
+     * into actual cells. Returns the per thread copies of the functor.
+     */
+    template <typename Functor>
+    std::vector<Functor> forEachLeaf(const Functor &f);
+    template <typename Functor>
+    std::vector<Functor> forEachConstLeaf(const Functor &f);
+
+    /**
+     * Calls f(coords, value) for every set voxel of the tree, see 
+     * Leaf::forEachVoxel(). Returns the per thread copies of the functor.
+     */
+    template <typename Functor>
+    std::vector<Functor> forEachVoxel(const Functor &f);
+    template <typename Functor>
+    std::vector<Functor> forEachConstVoxel(const Functor &f);
+
+    /**
+     * Number of threads used.
+     */
+    size_t numThreads() const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal typedefs
+    //--------------------------------------------------------------------------
+
+    typedef Node<CellType, A>   node_type;
+
+    /**
+     * A subtree handed to a thread, with the quadrant coordinates of its
+     * first voxel.
+     */
+    struct Task
+    {
+        node_type  *node;
+        u8          quadrant;
+        index_vec   offset;
+    };
+
+    /**
+     * Adapts a per voxel functor to a leaf functor.
+     */
+    template <typename Functor>
+    class VoxelFunctor
+    {
+    public:
+        VoxelFunctor(const Functor &f) : 
+            m_functor(f) 
+        {
+        }
+
+        template <typename LeafType>
+        void operator()(const LeafType &leaf) 
+        { 
+            leaf.forEachVoxel(m_functor); 
+        }
+
+        const Functor& functor() const 
+        { 
+            return m_functor; 
+        }
+
+    private:
+        Functor m_functor;
+    };
+
+    /**
+     * Split subtrees into their children until every thread has a number of
+     * them to pick from.
+     */
+    enum { TASKS_PER_THREAD = 8 };
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Fills the task list from the roots of the tree.
+     */
+    void collectTasks();
+
+    /**
+     * Runs the leaf functor over all tasks, one copy of it per thread.
+     */
+    template <typename LeafType, typename Functor>
+    std::vector<Functor> run(const Functor &f, bool writable);
+
+    /**
+     * Thread body, processes tasks with the thread's copy of the functor
+     * until none are left.
+     */
+    template <typename LeafType, typename Functor>
+    void work(std::vector<Functor> *functors, size_t thread);
+
+    /**
+     * Visits all cells under the node.
+     */
+    template <typename LeafType, typename Functor>
+    void visit(node_type *node, u8 quadrant, const index_vec &offset, 
+               Functor &f);
+
+    /**
+     * Visits a fill node. Writable traversals split the node into cells, 
+     * read-only ones pass a filled cell for every cell the node covers.
+     */
+    template <typename Functor>
+    void visitFill(node_type *node, u8 quadrant, const index_vec &offset,
+                   Functor &f, leaf*);
+    template <typename Functor>
+    void visitFill(node_type *node, u8 quadrant, const index_vec &offset,
+                   Functor &f, const_leaf*);
+
+    /**
+     * Unwraps the per voxel functors.
+     */
+    template <typename Functor>
+    static std::vector<Functor> 
+    unwrap(const std::vector< VoxelFunctor<Functor> > &functors);
+
+    //--------------------------------------------------------------------------
+    // friends
+    //--------------------------------------------------------------------------
+
+    /**
+     * Encodes the same subtrees for writing.
+     */
+    template <typename C, typename Alloc>
+    friend class ParallelWriter;
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    tree_type          *m_tree;
+    WorkerGroup         m_workers;
+    std::vector<Task>   m_tasks;
+};
+
+END_NKHIVE_NS
+
+//-----------------------------------------------------------------------------
+// class implementation
+//-----------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/volume/ParallelForEach.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_VOLUME_PARALLELFOREACH_H__
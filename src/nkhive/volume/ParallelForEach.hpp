@@ -0,0 +1,290 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// ParallelForEach.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline
+ParallelForEach<CellType, A>::ParallelForEach(const tree_type *tree, 
+                                              size_t num_threads) :
+    m_tree(const_cast<tree_type*>(tree)),
+    m_workers(num_threads)
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline std::vector<Functor>
+ParallelForEach<CellType, A>::forEachLeaf(const Functor &f)
+{
+    return run<leaf>(f, true);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline std::vector<Functor>
+ParallelForEach<CellType, A>::forEachConstLeaf(const Functor &f)
+{
+    return run<const_leaf>(f, false);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline std::vector<Functor>
+ParallelForEach<CellType, A>::forEachVoxel(const Functor &f)
+{
+    return unwrap<Functor>(run<leaf>(VoxelFunctor<Functor>(f), true));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline std::vector<Functor>
+ParallelForEach<CellType, A>::forEachConstVoxel(const Functor &f)
+{
+    return unwrap<Functor>(run<const_leaf>(VoxelFunctor<Functor>(f), false));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline size_t
+ParallelForEach<CellType, A>::numThreads() const
+{
+    return m_workers.numThreads();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ParallelForEach<CellType, A>::collectTasks()
+{
+    m_tasks.clear();
+    for (u8 q = 0; q < NUM_QUADRANTS; ++q) {
+        if (!m_tree->m_root[q]->isEmpty()) {
+            Task task = { m_tree->m_root[q], q, index_vec(0, 0, 0) };
+            m_tasks.push_back(task);
+        }
+    }
+
+    // Replace the subtrees by their children until there are enough to go 
+    // around, or only cell parents and fill nodes are left.
+    size_t num_threads = m_workers.numThreads();
+    size_t target = (num_threads > 1) ? num_threads * TASKS_PER_THREAD : 0;
+    while (m_tasks.size() < target) {
+        std::vector<Task> tasks;
+        bool split = false;
+
+        for (size_t n = 0; n < m_tasks.size(); ++n) {
+            const Task &task = m_tasks[n];
+            node_type *node = task.node;
+            if (node->isFill() || node->isCellParent()) {
+                tasks.push_back(task);
+                continue;
+            }
+
+            index_type child_dim = node->computeChildDim();
+            typename node_type::branch_iterator iter = 
+                node->branchIterator();
+            for ( ; iter(); ++iter) {
+                Task child = { iter->node, task.quadrant, index_vec() };
+                iter.getCoordinates(child.offset);
+                child.offset *= child_dim;
+                child.offset += task.offset;
+                tasks.push_back(child);
+            }
+            split = true;
+        }
+
+        m_tasks.swap(tasks);
+        if (!split) break;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename LeafType, typename Functor>
+inline std::vector<Functor>
+ParallelForEach<CellType, A>::run(const Functor &f, bool writable)
+{
+    // The tree must not change shape under the threads.
+    assert(!m_tree->isConcurrentWrites());
+
+    collectTasks();
+
+    // Paged trees are walked on one thread, keeping the memory budget.
+    size_t num_threads = std::min(m_workers.numThreads(), m_tasks.size());
+    if (m_tree->m_pager) {
+        num_threads = std::min(num_threads, size_t(1));
+    }
+    std::vector<Functor> functors(std::max(num_threads, size_t(1)), f);
+
+    // Writable traversals allocate from the tree's pool when splitting fill
+    // nodes and filled cells.
+    {
+        MemoryPool::ScopedThreadSafe thread_safe(*m_tree->m_pool, 
+                                                 writable && num_threads > 1);
+        m_workers.run(num_threads, m_tasks.size(),
+            boost::bind(&ParallelForEach::template work<LeafType, Functor>,
+                        this, &functors, _1));
+    }
+
+    if (m_workers.failed()) {
+        THROW(Iex::LogicExc, "Parallel for-each failed: " << 
+                             m_workers.error());
+    }
+
+    return functors;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename LeafType, typename Functor>
+inline void
+ParallelForEach<CellType, A>::work(std::vector<Functor> *functors, 
+                                   size_t thread)
+{
+    Functor &f = (*functors)[thread];
+    size_t n;
+    while (m_workers.nextTask(n)) {
+        const Task &task = m_tasks[n];
+        visit<LeafType>(task.node, task.quadrant, task.offset, f);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename LeafType, typename Functor>
+inline void
+ParallelForEach<CellType, A>::visit(node_type *node, u8 quadrant, 
+                                    const index_vec &offset, Functor &f)
+{
+    if (node->isFill()) {
+        visitFill(node, quadrant, offset, f, static_cast<LeafType*>(NULL));
+        return;
+    }
+
+    index_type child_dim = node->computeChildDim();
+    typename node_type::branch_iterator iter = node->branchIterator();
+    for ( ; iter(); ++iter) {
+        index_vec child_offset;
+        iter.getCoordinates(child_offset);
+        child_offset *= child_dim;
+        child_offset += offset;
+
+        if (node->isCellParent()) {
+            LeafType leaf(iter->cell, quadrant, child_offset);
+            f(leaf);
+        } else {
+            visit<LeafType>(iter->node, quadrant, child_offset, f);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline void
+ParallelForEach<CellType, A>::visitFill(node_type *node, u8 quadrant, 
+                                        const index_vec &offset, Functor &f, 
+                                        leaf*)
+{
+    // The node belongs to this thread's subtree, nobody else touches it.
+    node->createFillBranches(m_tree->m_default_value);
+    visit<leaf>(node, quadrant, offset, f);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline void
+ParallelForEach<CellType, A>::visitFill(node_type *node, u8 quadrant, 
+                                        const index_vec &offset, Functor &f, 
+                                        const_leaf*)
+{
+    // One filled cell stands in for all cells of the node. It is heap 
+    // allocated, the tree's pool is not thread safe here.
+    const CellType cell(node->m_lg_cell_dim, m_tree->m_default_value, 
+                        node->fillValue());
+
+    index_type cell_dim = index_type(1) << node->m_lg_cell_dim;
+    index_type num_cells = node->computeMaxDim() / cell_dim;
+    for (index_type k = 0; k < num_cells; ++k) {
+        for (index_type j = 0; j < num_cells; ++j) {
+            for (index_type i = 0; i < num_cells; ++i) {
+                index_vec cell_offset(i * cell_dim, j * cell_dim, k * cell_dim);
+                cell_offset += offset;
+
+                const_leaf leaf(&cell, quadrant, cell_offset);
+                f(leaf);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline std::vector<Functor>
+ParallelForEach<CellType, A>::unwrap(
+    const std::vector< VoxelFunctor<Functor> > &functors)
+{
+    std::vector<Functor> unwrapped;
+    unwrapped.reserve(functors.size());
+    for (size_t n = 0; n < functors.size(); ++n) {
+        unwrapped.push_back(functors[n].functor());
+    }
+    return unwrapped;
+}
+
+//------------------------------------------------------------------------------
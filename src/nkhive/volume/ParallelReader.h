@@ -0,0 +1,158 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// ParallelReader.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_VOLUME_PARALLELREADER_H__
+#define __NKHIVE_VOLUME_PARALLELREADER_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <boost/bind.hpp>
+
+#include <nkbase/Exceptions.h>
+
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkhive/util/WorkerGroup.h>
+#include <nkhive/volume/ParallelForEach.h>
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Constructs a Tree from a table of leaves read up front. The calling thread
+ * grows the roots and builds the nodes down to every cell, then worker 
+ * threads decode the cells, each cell on one thread only. Fill nodes are 
+ * built with the nodes.
+ */
+template <typename CellType,
+          typename A = std::allocator<typename CellType::value_type> >
+class ParallelReader
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+
+    typedef Tree<CellType, A>                       tree_type;
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    /**
+     * A thread count of 0 uses one decoding thread per core.
+     */
+    ParallelReader(tree_type *tree, size_t num_threads = 0);
+
+    /**
+     * Adds all leaves of the table to the tree. Table is any leaf table 
+     * cells read from, HDF5LeafTable or StreamLeafIndex.
+     */
+    template <typename Table>
+    void read(Table &table);
+
+    /**
+     * Number of decoding threads used.
+     */
+    size_t numThreads() const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal typedefs
+    //--------------------------------------------------------------------------
+
+    typedef std::pair<CellType*, size_t>        Task;   // cell, leaf
+
+    /**
+     * Cells handed to a thread at a time.
+     */
+    enum { CELLS_PER_TASK = 32 };
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Thread body, decodes cells until none are left.
+     */
+    template <typename Table>
+    void work(Table *table, size_t thread);
+
+    /**
+     * Keeps the last leaf of every cell, as a serial read would.
+     */
+    void removeDuplicates();
+
+    /**
+     * Orders tasks by cell.
+     */
+    static bool cellLess(const Task &a, const Task &b);
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    tree_type           *m_tree;
+    WorkerGroup          m_workers;
+    std::vector<Task>    m_tasks;
+};
+
+END_NKHIVE_NS
+
+//-----------------------------------------------------------------------------
+// class implementation
+//-----------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/volume/ParallelReader.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_VOLUME_PARALLELREADER_H__
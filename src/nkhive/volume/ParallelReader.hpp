@@ -0,0 +1,140 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// ParallelReader.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline
+ParallelReader<CellType, A>::ParallelReader(tree_type *tree, 
+                                            size_t num_threads) :
+    m_tree(tree),
+    m_workers(num_threads),
+    m_tasks()
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Table>
+inline void
+ParallelReader<CellType, A>::read(Table &table)
+{
+    // Build the tree down to the cells, the shape stays fixed from here on.
+    m_tasks.clear();
+    m_tasks.reserve(table.size());
+    for (size_t n = 0; n < table.size(); ++n) {
+        CellType *cell = m_tree->readPath(table, n);
+        if (cell) {
+            m_tasks.push_back(Task(cell, n));
+        }
+    }
+    removeDuplicates();
+
+    size_t num_tasks   = (m_tasks.size() + CELLS_PER_TASK - 1) / 
+                         CELLS_PER_TASK;
+    size_t num_threads = std::min(m_workers.numThreads(), num_tasks);
+
+    // Cells allocate their voxels from the tree's pool.
+    {
+        MemoryPool::ScopedThreadSafe thread_safe(*m_tree->m_pool, 
+                                                 num_threads > 1);
+        m_workers.run(num_threads, m_tasks.size(), 
+            boost::bind(&ParallelReader::template work<Table>, this, &table,
+                        _1));
+    }
+    m_tasks.clear();
+
+    if (m_workers.failed()) {
+        THROW(Iex::IoExc, "Parallel read failed: " << m_workers.error());
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline size_t
+ParallelReader<CellType, A>::numThreads() const
+{
+    return m_workers.numThreads();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Table>
+inline void
+ParallelReader<CellType, A>::work(Table *table, size_t)
+{
+    size_t begin, end;
+    while (m_workers.nextTasks(CELLS_PER_TASK, begin, end)) {
+        for (size_t n = begin; n < end; ++n) {
+            m_tasks[n].first->read(*table, m_tasks[n].second);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ParallelReader<CellType, A>::removeDuplicates()
+{
+    // well formed tables list every cell once, leaves stay in table order
+    std::stable_sort(m_tasks.begin(), m_tasks.end(), cellLess);
+
+    size_t count = 0;
+    for (size_t n = 0; n < m_tasks.size(); ++n) {
+        if (n + 1 < m_tasks.size() && 
+            m_tasks[n + 1].first == m_tasks[n].first) continue;
+        m_tasks[count++] = m_tasks[n];
+    }
+    m_tasks.resize(count);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+ParallelReader<CellType, A>::cellLess(const Task &a, const Task &b)
+{
+    return a.first < b.first;
+}
+
+//------------------------------------------------------------------------------
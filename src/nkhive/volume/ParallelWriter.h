@@ -0,0 +1,198 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// ParallelWriter.h
+//------------------------------------------------------------------------------
+
+#ifndef __NKHIVE_VOLUME_PARALLELWRITER_H__
+#define __NKHIVE_VOLUME_PARALLELWRITER_H__
+
+//------------------------------------------------------------------------------
+// includes
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <nkbase/Exceptions.h>
+
+#include <nkhive/Defs.h>
+#include <nkhive/Types.h>
+#include <nkhive/io/hdf5/HDF5LeafTable.h>
+#include <nkhive/util/WorkerGroup.h>
+#include <nkhive/volume/ParallelForEach.h>
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+/**
+ * Gathers the leaves of a Tree into a leaf table as a pipeline. Worker 
+ * threads encode the subtrees of ParallelForEach into tables of their own,
+ * the calling thread appends them in tree order as they complete, so the 
+ * result matches a serial traversal. Workers stall once a bounded number of
+ * encoded subtrees wait to be appended.
+ */
+template <typename CellType,
+          typename A = std::allocator<typename CellType::value_type> >
+class ParallelWriter
+{
+
+public:
+
+    //--------------------------------------------------------------------------
+    // typedefs
+    //--------------------------------------------------------------------------
+
+    typedef Tree<CellType, A>                       tree_type;
+    typedef typename CellType::value_type           value_type;
+    typedef HDF5LeafTable<value_type>               table_type;
+
+    //--------------------------------------------------------------------------
+    // public interface
+    //--------------------------------------------------------------------------
+
+    /**
+     * A thread count of 0 uses one encoding thread per core.
+     */
+    ParallelWriter(const tree_type *tree, size_t num_threads = 0);
+
+    /**
+     * Appends all leaves of the tree to the table.
+     */
+    void write(table_type &table);
+
+    /**
+     * Calls sink(chunk) on the calling thread for the leaves of every 
+     * subtree, in tree order. The chunk may be modified.
+     */
+    template <typename Sink>
+    void write(Sink &sink);
+
+    /**
+     * Number of encoding threads used.
+     */
+    size_t numThreads() const;
+
+private:
+
+    //--------------------------------------------------------------------------
+    // internal typedefs
+    //--------------------------------------------------------------------------
+
+    typedef ParallelForEach<CellType, A>        for_each_type;
+    typedef typename for_each_type::Task        Task;
+
+    /**
+     * Appends chunks to a table.
+     */
+    struct TableSink
+    {
+        TableSink(table_type &table) : 
+            m_table(table) 
+        {
+        }
+
+        void operator()(table_type &chunk) 
+        { 
+            m_table.append(chunk); 
+        }
+
+        table_type &m_table;
+    };
+
+    /**
+     * Encoded subtrees allowed to wait per encoding thread.
+     */
+    enum { CHUNKS_PER_THREAD = 2 };
+
+    //--------------------------------------------------------------------------
+    // internal methods
+    //--------------------------------------------------------------------------
+
+    /**
+     * Thread body, encodes subtrees until none are left.
+     */
+    void work();
+
+    /**
+     * Records the first error and wakes up all threads.
+     */
+    void fail(const std::string &error);
+
+    /**
+     * Frees the chunks left over after a failure.
+     */
+    void clearChunks();
+
+    //--------------------------------------------------------------------------
+    // members
+    //--------------------------------------------------------------------------
+
+    for_each_type               m_for_each;
+    WorkerGroup                 m_workers;
+
+    /**
+     * Encoded subtrees by task, the next task to hand out and the number of
+     * tasks consumed, guarded by the mutex.
+     */
+    std::vector<table_type*>    m_chunks;
+    size_t                      m_next;
+    size_t                      m_consumed;
+    size_t                      m_capacity;
+    boost::mutex                m_mutex;
+    boost::condition_variable   m_chunk_ready;
+    boost::condition_variable   m_chunk_taken;
+};
+
+END_NKHIVE_NS
+
+//-----------------------------------------------------------------------------
+// class implementation
+//-----------------------------------------------------------------------------
+
+BEGIN_NKHIVE_NS
+
+#include <nkhive/volume/ParallelWriter.hpp>
+
+END_NKHIVE_NS
+
+//------------------------------------------------------------------------------
+
+#endif // __NKHIVE_VOLUME_PARALLELWRITER_H__
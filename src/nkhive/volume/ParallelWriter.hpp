@@ -0,0 +1,215 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// ParallelWriter.hpp
+//------------------------------------------------------------------------------
+
+// no includes allowed
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline
+ParallelWriter<CellType, A>::ParallelWriter(const tree_type *tree, 
+                                            size_t num_threads) :
+    m_for_each(tree, num_threads),
+    m_workers(m_for_each.numThreads()),
+    m_chunks(),
+    m_next(0),
+    m_consumed(0),
+    m_capacity(0)
+{
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ParallelWriter<CellType, A>::write(table_type &table)
+{
+    // a single thread encodes straight into the table
+    if (m_workers.numThreads() <= 1) {
+        m_for_each.collectTasks();
+        const std::vector<Task> &tasks = m_for_each.m_tasks;
+        for (size_t n = 0; n < tasks.size(); ++n) {
+            tasks[n].node->write(table, tasks[n].quadrant, tasks[n].offset);
+        }
+        return;
+    }
+
+    TableSink sink(table);
+    write(sink);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Sink>
+inline void
+ParallelWriter<CellType, A>::write(Sink &sink)
+{
+    m_for_each.collectTasks();
+    const std::vector<Task> &tasks = m_for_each.m_tasks;
+    const size_t num_tasks = tasks.size();
+
+    // a single thread encodes and appends in turn
+    size_t num_threads = std::min(m_workers.numThreads(), num_tasks);
+    if (num_threads <= 1) {
+        for (size_t n = 0; n < num_tasks; ++n) {
+            table_type chunk;
+            tasks[n].node->write(chunk, tasks[n].quadrant, tasks[n].offset);
+            sink(chunk);
+        }
+        return;
+    }
+
+    m_chunks.assign(num_tasks, NULL);
+    m_next     = 0;
+    m_consumed = 0;
+    m_capacity = num_threads * CHUNKS_PER_THREAD;
+    m_workers.start(num_threads, boost::bind(&ParallelWriter::work, this));
+
+    // The calling thread hands the chunks to the sink in tree order.
+    for (size_t n = 0; n < num_tasks; ++n) {
+        std::auto_ptr<table_type> chunk;
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            while (!m_chunks[n] && !m_workers.failed()) {
+                m_chunk_ready.wait(lock);
+            }
+            if (m_workers.failed()) break;
+
+            chunk.reset(m_chunks[n]);
+            m_chunks[n] = NULL;
+            ++m_consumed;
+        }
+        m_chunk_taken.notify_all();
+
+        try {
+            sink(*chunk);
+        } catch (...) {
+            // stop the workers and pass the error on as is
+            fail("sink failed");
+            m_workers.join();
+            clearChunks();
+            throw;
+        }
+    }
+
+    m_workers.join();
+    clearChunks();
+
+    if (m_workers.failed()) {
+        THROW(Iex::LogicExc, "Parallel write failed: " << m_workers.error());
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline size_t
+ParallelWriter<CellType, A>::numThreads() const
+{
+    return m_workers.numThreads();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ParallelWriter<CellType, A>::work()
+{
+    const std::vector<Task> &tasks = m_for_each.m_tasks;
+    for (;;) {
+        size_t n;
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            if (m_workers.failed() || m_next >= tasks.size()) return;
+            n = m_next++;
+
+            // stall while enough chunks wait to be appended
+            while (n >= m_consumed + m_capacity && !m_workers.failed()) {
+                m_chunk_taken.wait(lock);
+            }
+            if (m_workers.failed()) return;
+        }
+
+        std::auto_ptr<table_type> chunk(new table_type());
+        try {
+            tasks[n].node->write(*chunk, tasks[n].quadrant, tasks[n].offset);
+        } catch (const std::exception &e) {
+            fail(e.what());
+            return;
+        } catch (...) {
+            fail("unknown exception");
+            return;
+        }
+
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_chunks[n] = chunk.release();
+        }
+        m_chunk_ready.notify_all();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ParallelWriter<CellType, A>::fail(const std::string &error)
+{
+    // Keep the first error, taking the mutex so no thread misses it between
+    // checking and waiting.
+    m_workers.fail(error);
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+    }
+    m_chunk_ready.notify_all();
+    m_chunk_taken.notify_all();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+ParallelWriter<CellType, A>::clearChunks()
+{
+    for (size_t n = 0; n < m_chunks.size(); ++n) {
+        delete m_chunks[n];
+    }
+    m_chunks.clear();
+}
+
+//------------------------------------------------------------------------------
@@ -76,6 +76,9 @@ public:
     typedef typename CellType::const_reference              const_reference;
     typedef std::forward_iterator_tag                       iterator_category;
 
+    typedef Node<CellType, typename CellType::allocator_type>
+                                                            node_type;
+
     //--------------------------------------------------------------------------
     // public interface
     //--------------------------------------------------------------------------
@@ -83,7 +86,7 @@ public:
     /**
      * Constructors and destructors.
      */
-    SetIterator(Node<CellType> *n);
+    SetIterator(node_type *n);
     virtual ~SetIterator();
 
     //--------------------------------------------------------------------------
@@ -133,7 +136,7 @@ private:
     /**
      * Initialize the hierarchy iterator stack given the root node.
      */
-    void init(Node<CellType> *n);
+    void init(node_type *n);
 
     /**
      * Destroys all allocated iterators.
@@ -39,7 +39,7 @@
 
 template <typename CellType>
 inline
-SetIterator<CellType>::SetIterator(Node<CellType> *node)
+SetIterator<CellType>::SetIterator(node_type *node)
 {
     init(node);
 }
@@ -90,7 +90,7 @@ SetIterator<CellType>::destroy()
 
 template <typename CellType>
 inline void 
-SetIterator<CellType>::init(Node<CellType> *node)
+SetIterator<CellType>::init(node_type *node)
 {
     destroy();
 
@@ -216,10 +216,10 @@ SetIterator<CellType>::createChildIterator(NodeSetIterator<CellType> *iter,
 
     // The current node should never be a fill node, as this function assumes
     // that the given node has nodes/cells underneath it.
-    Node<CellType> *node = iter->getNode();
+    node_type *node = iter->getNode();
     assert(!node->isFill());
 
-    const typename Node<CellType>::branch_iterator& branch_iter = 
+    const typename node_type::branch_iterator& branch_iter = 
         iter->getBranchIterator();
 
     // If direct descendent of parent, then create the cell iterator..
@@ -232,7 +232,7 @@ SetIterator<CellType>::createChildIterator(NodeSetIterator<CellType> *iter,
         return true;
     } else {
         // else, the child is a node.
-        Node<CellType> *child_node = branch_iter->node;
+        node_type *child_node = branch_iter->node;
         if (child_node->isFill()) {
             // If the child is a FillNode, then create and return a
             // FilledBoundsIterator.
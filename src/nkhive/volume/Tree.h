@@ -40,12 +40,28 @@
 // includes
 //------------------------------------------------------------------------------
 
+#include <algorithm>
+#include <sstream>
+#include <set>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
 #include <boost/typeof/typeof.hpp>
 
 #include <nkbase/BinaryOps.h>
 
+#include <nkhive/memory/MemoryPool.h>
+#include <nkhive/memory/PoolAllocator.h>
 #include <nkhive/tiling/Stamp.h>
+#include <nkhive/util/Atomic.h>
+#include <nkhive/util/SpinLock.h>
+#include <nkhive/util/WorkerGroup.h>
 #include <nkhive/volume/Node.h>
+#include <nkhive/volume/Accessor.h>
+#include <nkhive/volume/Leaf.h>
+#include <nkhive/volume/ParallelForEach.h>
+#include <nkhive/volume/ParallelReader.h>
+#include <nkhive/volume/ParallelWriter.h>
 #include <nkhive/volume/AbstractIterator.h>
 #include <nkhive/volume/SetIterator.h>
 #include <nkhive/volume/FilledBoundsIterator.h>
@@ -53,6 +69,10 @@
 #include <nkhive/io/hdf5/HDF5Util.h>
 #include <nkhive/io/hdf5/HDF5Group.h>
 #include <nkhive/io/hdf5/HDF5Attribute.h>
+#include <nkhive/io/hdf5/HDF5LeafTable.h>
+#include <nkhive/io/MappedFile.h>
+#include <nkhive/io/MappedLeafTable.h>
+#include <nkhive/io/StreamLeafIndex.h>
 
 //------------------------------------------------------------------------------
 // forward declarations
@@ -85,6 +105,12 @@ public:
     typedef typename allocator_type::reference        reference;
     typedef typename allocator_type::const_reference  const_reference;
 
+    typedef Accessor<CellType, A>                     accessor;
+    typedef ConstAccessor<CellType, A>                const_accessor;
+
+    typedef Leaf<CellType>                            leaf;
+    typedef Leaf<const CellType>                      const_leaf;
+
     //--------------------------------------------------------------------------
     // Forward declare internal classes.
     //--------------------------------------------------------------------------
@@ -111,14 +137,18 @@ public:
     const_reference getDefault() const;
 
     /**
-     * Get the value at the given coordinates. We can only return a
-     * const_reference here b/c we don't want people to inadvertantly change
-     * the default value in case that is returned when indices are accessed out
-     * of bounds of the Tree. 
+     * Returns Log2 of the branching factor and cell dimension of the tree.
+     */
+    uint8_t getLgBranchingFactor() const;
+    uint8_t getLgCellDim() const;
+
+    /**
+     * Get the value at the given coordinates. Returned by value, the voxels
+     * of a lazily read tree may be paged out by the next lookup.
      */
-    const_reference get(signed_index_type i, 
-                        signed_index_type j, 
-                        signed_index_type k) const;
+    value_type get(signed_index_type i, 
+                   signed_index_type j, 
+                   signed_index_type k) const;
 
     /** 
      * Set the value at a given voxel, growing the tree if necessary. 
@@ -141,6 +171,41 @@ public:
     void update(signed_index_type i, signed_index_type j, signed_index_type k,
                 const_reference val, BinaryOp op);
 
+    /**
+     * Gets/updates the size block of voxels with its minimum corner at min,
+     * x fastest. Each cell the block overlaps is visited once, reading cell
+     * data directly, so stencils cost a lookup per cell rather than a 
+     * descent per voxel.
+     */
+    void getBlock(const signed_index_vec &min, const index_vec &size, 
+                  value_type *out) const;
+    template <typename BinaryOp>
+    void updateBlock(const signed_index_vec &min, const index_vec &size, 
+                     const value_type *vals, BinaryOp op);
+
+    /**
+     * Sets/updates count voxels at once, values[n] going to coords[n]. The
+     * entries are sorted by the Morton key of their cell, the tree is grown
+     * once for the batch and each cell is descended to once. Entries for the
+     * same voxel are applied in order. With more than one thread (0 for one
+     * per core) the cells are split between threads in concurrent write mode.
+     */
+    void setBatch(const signed_index_vec *coords, const value_type *values,
+                  size_t count, size_t num_threads = 1);
+    template <typename BinaryOp>
+    void updateBatch(const signed_index_vec *coords, const value_type *values,
+                     size_t count, BinaryOp op, size_t num_threads = 1);
+
+    /**
+     * Enter/Leave concurrent write mode. While in it set() and update() may be
+     * called from any number of threads, writes to different cells do not
+     * contend. No other method may be called until the mode is left. Nodes
+     * written through get a slot for every branch until the mode is left.
+     */
+    void beginConcurrentWrites();
+    void endConcurrentWrites();
+    bool isConcurrentWrites() const;
+
     /**
      * Writes the stamp at the requested location using the given op.
      * The position indicates the origin of the stamps bounds.
@@ -149,6 +214,22 @@ public:
     void stamp(const Stamp<U, Source> &stamp, 
                const signed_index_vec &position);
 
+    /**
+     * Collapses uniform regions, cells whose set voxels are within tolerance
+     * of each other become fill cells and fully set uniform branches become
+     * fill nodes, releasing their memory.
+     */
+    void prune(const_reference tolerance = value_type());
+
+    /**
+     * While auto prune is on, set() and update() prune the cell written to
+     * once it is fully set, along with the nodes above it. Writes through 
+     * accessors, batches and concurrent writes are not pruned.
+     */
+    void setAutoPrune(bool enable, 
+                      const_reference tolerance = value_type());
+    bool isAutoPrune() const;
+
     /**
      * Return true if there are no set values in the tree. 
      */
@@ -166,6 +247,37 @@ public:
      */
     set_iterator setIterator() const;
 
+    /**
+     * Return an accessor caching the path to the last visited cell, for
+     * repeated access to neighbouring voxels.
+     */
+    accessor getAccessor();
+    const_accessor getAccessor() const;
+
+    /**
+     * Calls f(leaf) for every cell of the tree, spread over num_threads 
+     * threads (0 for one per core). Each thread calls its own copy of the 
+     * functor, the copies are returned. The non-const version may modify the
+     * cells, and splits fill nodes into cells to do so.
+     */
+    template <typename Functor>
+    std::vector<Functor> parallelForEachLeaf(const Functor &f, 
+                                             size_t num_threads = 0);
+    template <typename Functor>
+    std::vector<Functor> parallelForEachLeaf(const Functor &f, 
+                                             size_t num_threads = 0) const;
+
+    /**
+     * Calls f(coords, value) for every set voxel of the tree, see 
+     * parallelForEachLeaf(). The value is writable in the non-const version.
+     */
+    template <typename Functor>
+    std::vector<Functor> parallelForEach(const Functor &f, 
+                                         size_t num_threads = 0);
+    template <typename Functor>
+    std::vector<Functor> parallelForEach(const Functor &f, 
+                                         size_t num_threads = 0) const;
+
     /** 
      * Comparison operators.
      */
@@ -173,21 +285,112 @@ public:
     bool operator!=(const Tree &that) const;
 
     /**
-     * I/O operations.
+     * I/O operations. Streams hold an indexed tree, see StreamLeafIndex. 
+     * Streams written before the index was added are still read. Streams 
+     * that cannot seek are written through a buffer. Cells are decoded on
+     * num_threads threads (0 for one per core), see ParallelReader.
      */
-    void read(std::istream &is);
+    void read(std::istream &is, size_t num_threads = 1);
     void write(std::ostream &os) const;
 
-    void read(HDF5Id volume_group_id);
-    void write(HDF5Id volume_group_id) const;
+    /**
+     * Reads the part of an indexed tree stream intersecting roi, like the
+     * HDF5 partial read below. The stream has to be seekable, only the 
+     * bytes of the leaves read are loaded from it.
+     */
+    void read(std::istream &is, const signed_index_bounds &roi);
+
+    /**
+     * Cells are decoded on num_threads threads (0 for one per core), see 
+     * ParallelReader. The leaves are read from the file up front, leaf 
+     * groups one at a time.
+     */
+    void read(HDF5Id volume_group_id, size_t num_threads = 1);
+
+    /**
+     * Reads the part of the tree intersecting roi, a box of voxels with an
+     * exclusive max. Cells intersecting it are read whole, fill nodes are 
+     * clipped to it. Only the leaves read are loaded from the file.
+     */
+    void read(HDF5Id volume_group_id, const signed_index_bounds &roi);
+
+    /**
+     * Reads the leaf index only, cell voxels are paged in on access and 
+     * evicted least recently used first beyond memory_budget bytes, see
+     * CellPager. Needs the leaf table layout. Paged trees must not be 
+     * accessed concurrently.
+     */
+    void readLazy(HDF5Id volume_group_id, size_t memory_budget);
+    CellPagerStats getPagerStats() const;
+
+    /**
+     * The leaf table layout and the native format have their leaves encoded
+     * on num_threads threads (0 for one per core), see ParallelWriter. The
+     * file itself is written from the calling thread.
+     */
+    void write(HDF5Id volume_group_id,
+               HDF5Layout layout = HDF5_LAYOUT_LEAF_TABLE,
+               const HDF5Compression &compression = HDF5Compression(),
+               size_t num_threads = 1) const;
+
+    /**
+     * Native format, see MappedLeafTable. map() builds the tree over the 
+     * mapped table, cells keep pointing at the file until first written.
+     */
+    void writeNative(std::ostream &os, 
+                     const std::string &metadata = std::string(),
+                     size_t num_threads = 1) const;
+
+    /**
+     * Incremental save to leaf groups. Only the leaves modified since the 
+     * tree was read or last saved this way are rewritten, and the groups of
+     * removed leaves are deleted. The group must hold the tree as it was
+     * then, in the leaf groups layout. Leaves are marked clean afterwards.
+     */
+    void writeIncremental(HDF5Id volume_group_id);
+    void map(const MappedLeafTable<value_type> &table);
 
     /**
      * Returns memory used by class.
      */
     int sizeOf() const;
 
+    /**
+     * Returns pooled memory that is no longer used by any node or cell back 
+     * to the system. Only has an effect with a pooling allocator.
+     */
+    void releaseMemory();
+
 private:
 
+    //--------------------------------------------------------------------------
+    // internal types.
+    //--------------------------------------------------------------------------
+
+    /**
+     * A voxel write of a batch, keyed by quadrant and the Morton key of its 
+     * cell.
+     */
+    struct BatchEntry
+    {
+        uint64_t         key;
+        signed_index_vec coords;
+        value_type       value;
+    };
+
+    typedef std::vector<BatchEntry> batch_entries;
+
+    /**
+     * Box of voxels of a partial read, split by quadrant into quadrant 
+     * coordinates. Leaf groups get the tree through it while iterated.
+     */
+    struct Region
+    {
+        Tree         *tree;
+        u8           quadrants;
+        index_bounds bounds[NUM_QUADRANTS];
+    };
+
     //--------------------------------------------------------------------------
     // internal helpers.
     //--------------------------------------------------------------------------
@@ -207,6 +410,64 @@ private:
      */
     void grow(index_type quadrant, index_type i, index_type j, index_type k);
 
+    /**
+     * Thread safe versions of update() and grow() used in concurrent write 
+     * mode. Returns the cell written to, NULL if nothing was written.
+     */
+    template <typename BinaryOp>
+    CellType* updateConcurrent(index_type quadrant, 
+                               index_type i, index_type j, index_type k,
+                               const_reference val, BinaryOp op);
+    void growConcurrent(index_type quadrant, 
+                        index_type i, index_type j, index_type k);
+
+    /**
+     * Stable radix sort of the batch entries on the low key_bits of their 
+     * keys, scratch is used as the second buffer.
+     */
+    static void sortBatch(batch_entries &entries, batch_entries &scratch,
+                          index_type key_bits);
+
+    /**
+     * Applies the sorted batch entries in [begin, end) through an accessor.
+     */
+    template <typename BinaryOp>
+    void applyBatch(const batch_entries *entries, size_t begin, size_t end, 
+                    BinaryOp op);
+
+    /**
+     * Applies the entries between the split of the thread and the next one.
+     */
+    template <typename BinaryOp>
+    void applySplit(const batch_entries *entries, 
+                    const std::vector<size_t> *splits, BinaryOp op, 
+                    size_t thread);
+
+    /**
+     * Queues a node replaced during concurrent writes for deletion once the
+     * writes are done, other threads may still be reading it. Retired nodes
+     * hand their branches to their replacement.
+     */
+    void retire(Node<CellType, A> *node);
+
+    /**
+     * Records a node made dense for concurrent writers, to be compacted
+     * again once the writes are done.
+     */
+    void expanded(Node<CellType, A> *node);
+
+    /**
+     * Frees the retired nodes, without their branches.
+     */
+    void destroyRetired();
+
+    /**
+     * Removes nodes left empty along the first branch of the given node.
+     * Concurrent growth keeps empty roots alive, which the serial growth 
+     * deletes. Returns true if the node itself is empty.
+     */
+    bool pruneEmptySubtrees(Node<CellType, A> *node);
+
     /**
      * Convert the given quadrant index coordinates to their proper volume
      * coordinates. 
@@ -232,7 +493,67 @@ private:
      * IO helper for reading in a leaf group into memory and constructing
      * the appropriate portion of the tree down to the leaf
      */
-    void readLeaf(HDF5Id leaf_group_id);
+    void readLeaf(HDF5Id leaf_group_id, const Region *region = NULL);
+    template <typename Table>
+    void readLeaf(Table &table, size_t leaf);
+
+    /**
+     * Grows the tree and builds it down to the leaf, returning the cell to 
+     * read the leaf into, or NULL for fill nodes. See Node::readPath().
+     */
+    template <typename Table>
+    CellType* readPath(Table &table, size_t leaf);
+
+    /**
+     * Helpers for partial reads. Region splits a box of voxels into 
+     * quadrant coordinates. clipLeaf() clips the bounds of a leaf to the
+     * region, returning false if they don't intersect. fillLeaf() sets the
+     * voxels within the bounds, for fill nodes cut by the region.
+     */
+    void computeRegion(const signed_index_bounds &roi, Region &region);
+    index_bounds computeLeafBounds(u8 type, index_type level,
+                                   const index_vec &offset) const;
+    bool clipLeaf(const Region &region, u8 quadrant, 
+                  index_bounds &bounds) const;
+    void fillLeaf(u8 quadrant, const index_bounds &bounds, 
+                  const_reference value);
+
+    /**
+     * Picks the leaves of the table intersecting the region, in order. Fill
+     * nodes cut by the region are filled in right away instead.
+     */
+    template <typename Table>
+    void pickLeaves(const Table &table, const Region &region,
+                    std::vector<size_t> &leaves);
+
+    /**
+     * Gathers all leaves into the table. Paged trees are always gathered on
+     * the calling thread, paging in is not thread safe.
+     */
+    void writeLeaves(HDF5LeafTable<value_type> &table, 
+                     size_t num_threads) const;
+
+    /**
+     * Reads the default value and node dimensions of a volume group and
+     * creates empty roots from them. Returns the layout of the leaves.
+     */
+    u32 readHeader(HDF5Id volume_group_id);
+
+    /**
+     * Creates empty roots with the given node dimensions.
+     */
+    void createRoots(u8 lg_branching_factor, u8 lg_cell_dim);
+
+    /**
+     * Reads a stream written before the index was added, the nodes one 
+     * after the other.
+     */
+    void readUnindexed(std::istream &is);
+
+    /**
+     * Writes the default value and node dimensions to a volume group.
+     */
+    void writeHeader(HDF5Id volume_group_id) const;
 
     /**
      * Convert a given set of signed quadrant coordinates into it's local 
@@ -258,6 +579,33 @@ private:
                               const H5L_info_t *group_info,
                               void *op_data);
 
+    /**
+     * Appends the leaf of a leaf group to the HDF5LeafTable passed in as the
+     * user data, leaving cells encoded.
+     */
+    static HDF5Err gatherLeaf(HDF5Id volume_group_id,
+                              const char *group_name,
+                              const H5L_info_t *group_info,
+                              void *op_data);
+
+    /**
+     * Same as createLeaf(), skipping leaves outside of the Region passed in
+     * as the user data.
+     */
+    static HDF5Err createLeafInRegion(HDF5Id volume_group_id,
+                                      const char *group_name,
+                                      const H5L_info_t *group_info,
+                                      void *op_data);
+
+    /**
+     * Gathers the names of the leaf groups of a volume group into the 
+     * std::set<String> passed in as the user data.
+     */
+    static HDF5Err collectLeafGroup(HDF5Id volume_group_id,
+                                    const char *group_name,
+                                    const H5L_info_t *group_info,
+                                    void *op_data);
+
     //--------------------------------------------------------------------------
     // typedefs 
     //--------------------------------------------------------------------------
@@ -270,6 +618,21 @@ private:
     friend class ::TestTree;
 #endif // UNITTEST
 
+    template <typename C, typename Alloc>
+    friend class ConstAccessor;
+
+    template <typename C, typename Alloc>
+    friend class Accessor;
+
+    template <typename C, typename Alloc>
+    friend class ParallelForEach;
+
+    template <typename C, typename Alloc>
+    friend class ParallelWriter;
+
+    template <typename C, typename Alloc>
+    friend class ParallelReader;
+
     //--------------------------------------------------------------------------
     // members
     //--------------------------------------------------------------------------
@@ -290,6 +653,38 @@ private:
      */
     value_type m_default_value;
 
+    /**
+     * File backing mapped cells, held until the tree is destroyed.
+     */
+    MappedFile::shared_ptr m_mapped_file;
+
+    /**
+     * Pager of a lazily read tree, held until the tree is destroyed.
+     */
+    typename CellPager<CellType>::shared_ptr m_pager;
+
+    /**
+     * Memory pool backing the nodes, cells and bitfields of the tree, and the
+     * allocator bound to it.
+     */
+    MemoryPool::shared_ptr m_pool;
+    allocator_type m_allocator;
+
+    /**
+     * Concurrent write mode state. The lock guards root growth and the lists
+     * of nodes retired and made dense while in the mode.
+     */
+    bool m_concurrent;
+    SpinLock m_lock;
+    std::vector<Node<CellType, A>*> m_retired;
+    std::vector<Node<CellType, A>*> m_expanded;
+
+    /**
+     * Auto prune state, see setAutoPrune().
+     */
+    bool m_auto_prune;
+    value_type m_prune_tolerance;
+
     //--------------------------------------------------------------------------
     // friends
     //--------------------------------------------------------------------------
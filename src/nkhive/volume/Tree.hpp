@@ -42,10 +42,19 @@
 template <typename CellType, typename A>
 inline
 Tree<CellType, A>::Tree() : 
-    m_default_value(typename CellType::value_type(0))
+    m_default_value(typename CellType::value_type(0)),
+    m_pool(new MemoryPool()),
+    m_allocator(PoolTraits<A>::create(m_pool)),
+    m_concurrent(false),
+    m_lock(),
+    m_retired(),
+    m_expanded(),
+    m_auto_prune(false),
+    m_prune_tolerance()
 {
     for (size_t i = 0; i < NUM_QUADRANTS; ++i) {
-        m_root[i] = new Node<CellType, A>(1, 2, 2, m_default_value);
+        m_root[i] = node_type::create(1, 2, 2, m_default_value, false, 
+                                      m_allocator);
         m_max_dim[i] = m_root[i]->computeMaxDim();
     }
 }
@@ -55,11 +64,19 @@ Tree<CellType, A>::Tree() :
 template <typename CellType, typename A>
 inline
 Tree<CellType, A>::Tree(uint8_t lg_branching_factor, uint8_t lg_cell_dim,
-                        const_reference default_value)
+                        const_reference default_value) :
+    m_pool(new MemoryPool()),
+    m_allocator(PoolTraits<A>::create(m_pool)),
+    m_concurrent(false),
+    m_lock(),
+    m_retired(),
+    m_expanded(),
+    m_auto_prune(false),
+    m_prune_tolerance()
 {
     for (size_t i = 0; i < NUM_QUADRANTS; ++i) {
-        m_root[i] = new Node<CellType, A>(1, lg_branching_factor, lg_cell_dim,
-                                          default_value);
+        m_root[i] = node_type::create(1, lg_branching_factor, lg_cell_dim,
+                                      default_value, false, m_allocator);
         m_max_dim[i] = m_root[i]->computeMaxDim();
     }
     m_default_value = default_value;
@@ -81,8 +98,15 @@ inline void
 Tree<CellType, A>::destruct()
 {
     for (size_t i = 0; i < NUM_QUADRANTS; ++i) {
-        delete m_root[i];
+        node_type::destroy(m_root[i]);
     }
+
+    destroyRetired();
+    m_expanded.clear();
+
+    // cells no longer reference the file
+    m_mapped_file.reset();
+    m_pager.reset();
 }
 
 //------------------------------------------------------------------------------
@@ -106,7 +130,25 @@ Tree<CellType, A>::getDefault() const
 //------------------------------------------------------------------------------
 
 template <typename CellType, typename A>
-inline typename Tree<CellType, A>::const_reference
+inline uint8_t
+Tree<CellType, A>::getLgBranchingFactor() const
+{
+    return m_root[0]->getLgBranchingFactor();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline uint8_t
+Tree<CellType, A>::getLgCellDim() const
+{
+    return m_root[0]->getLgCellDim();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename Tree<CellType, A>::value_type
 Tree<CellType, A>::get(signed_index_type i, 
                        signed_index_type j, 
                        signed_index_type k) const
@@ -183,6 +225,44 @@ Tree<CellType, A>::update(signed_index_type i,
 
 //------------------------------------------------------------------------------
 
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::getBlock(const signed_index_vec &min, 
+                            const index_vec &size, value_type *out) const
+{
+    const_accessor acc = getAccessor();
+    acc.getBlock(min, size, out);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename BinaryOp>
+inline void
+Tree<CellType, A>::updateBlock(const signed_index_vec &min, 
+                               const index_vec &size, 
+                               const value_type *vals, BinaryOp op)
+{
+    // Auto prune runs per voxel in update().
+    if (m_auto_prune) {
+        for (index_type z = 0; z < size.z; ++z) {
+            for (index_type y = 0; y < size.y; ++y) {
+                for (index_type x = 0; x < size.x; ++x) {
+                    update(min.x + signed_index_type(x), 
+                           min.y + signed_index_type(y), 
+                           min.z + signed_index_type(z), *vals++, op);
+                }
+            }
+        }
+        return;
+    }
+
+    accessor acc = getAccessor();
+    acc.updateBlock(min, size, vals, op);
+}
+
+//------------------------------------------------------------------------------
+
 template <typename CellType, typename A>
 template <typename BinaryOp>
 inline void
@@ -190,11 +270,191 @@ Tree<CellType, A>::update(index_type q,
                           index_type i, index_type j, index_type k, 
                           const_reference val, BinaryOp op)
 {
+    if (m_concurrent) {
+        updateConcurrent(q, i, j, k, val, op);
+        return;
+    }
+
     // make sure quadrant spans large enough to contain the index
     grow(q, i, j, k);
 
     // call set on the quadrant's unsigned indices
     m_root[q]->update(i, j, k, val, op);
+
+    if (m_auto_prune) {
+        m_root[q]->prune(i, j, k, m_prune_tolerance);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::setBatch(const signed_index_vec *coords, 
+                            const value_type *values,
+                            size_t count, size_t num_threads)
+{
+    updateBatch(coords, values, count, set_op<value_type>(), num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename BinaryOp>
+inline void
+Tree<CellType, A>::updateBatch(const signed_index_vec *coords, 
+                               const value_type *values,
+                               size_t count, BinaryOp op, size_t num_threads)
+{
+    if (count == 0) return;
+
+    // Copy the writes and track the extents needed in each quadrant.
+    batch_entries entries(count);
+    index_type extents[NUM_QUADRANTS];
+    bool touched[NUM_QUADRANTS];
+    std::fill(extents, extents + NUM_QUADRANTS, 0);
+    std::fill(touched, touched + NUM_QUADRANTS, false);
+
+    for (size_t n = 0; n < count; ++n) {
+        const signed_index_vec &c = coords[n];
+        u8 q = getQuadrant<signed_index_type>(c.x, c.y, c.z);
+        index_vec qc = getQuadrantCoords(c, q);
+
+        index_type extent = std::max(qc.x, std::max(qc.y, qc.z));
+        extents[q] = std::max(extents[q], extent);
+        touched[q] = true;
+
+        entries[n].key    = q;
+        entries[n].coords = c;
+        entries[n].value  = values[n];
+    }
+
+    // Only sort on as many bits as the furthest cell needs, 20 bits per axis
+    // at most. Cells further out share keys, costing locality but nothing 
+    // else.
+    const index_type lg_cell_dim = m_root[0]->getLgCellDim();
+    index_type max_extent = *std::max_element(extents, 
+                                              extents + NUM_QUADRANTS);
+    index_type cell_bits = std::min<index_type>(
+        getLastSetBitIndex(max_extent >> lg_cell_dim), 20);
+    const index_type mask = (1 << cell_bits) - 1;
+
+    for (size_t n = 0; n < count; ++n) {
+        BatchEntry &entry = entries[n];
+        index_vec qc = getQuadrantCoords(entry.coords, u8(entry.key));
+        uint64_t key = getMortonKey((qc.x >> lg_cell_dim) & mask, 
+                                    (qc.y >> lg_cell_dim) & mask, 
+                                    (qc.z >> lg_cell_dim) & mask);
+        entry.key = (entry.key << (3 * cell_bits)) | key;
+    }
+
+    // The sort is stable so writes to a voxel stay in order.
+    {
+        batch_entries scratch(count);
+        sortBatch(entries, scratch, 3 * cell_bits + 3);
+    }
+
+    // Already taking concurrent writes, the accessor grows the tree safely.
+    if (m_concurrent) {
+        applyBatch(&entries, 0, count, op);
+        return;
+    }
+
+    for (u8 q = 0; q < NUM_QUADRANTS; ++q) {
+        if (touched[q]) grow(q, extents[q], extents[q], extents[q]);
+    }
+
+    WorkerGroup workers(num_threads);
+    num_threads = workers.numThreads();
+    if ((num_threads <= 1) || (count < 2)) {
+        applyBatch(&entries, 0, count, op);
+        return;
+    }
+
+    // Split into equal ranges, moving each split to the next change of key
+    // so every cell is written by a single thread.
+    std::vector<size_t> splits(1, 0);
+    for (size_t t = 1; t < num_threads; ++t) {
+        size_t split = std::max(splits.back(), count * t / num_threads);
+        while ((split < count) && (split > 0) && 
+               (entries[split].key == entries[split - 1].key)) {
+            ++split;
+        }
+        if (split > splits.back() && split < count) splits.push_back(split);
+    }
+    splits.push_back(count);
+
+    size_t num_splits = splits.size() - 1;
+    beginConcurrentWrites();
+    workers.run(num_splits, num_splits,
+        boost::bind(&Tree::template applySplit<BinaryOp>, this, &entries, 
+                    &splits, op, _1));
+    endConcurrentWrites();
+
+    if (workers.failed()) {
+        THROW(Iex::LogicExc, "Parallel update failed: " << workers.error());
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::sortBatch(batch_entries &entries, batch_entries &scratch,
+                             index_type key_bits)
+{
+    const index_type lg_radix = 11;
+    const size_t radix = size_t(1) << lg_radix;
+
+    // Least significant digit first, each pass is a stable counting sort.
+    std::vector<size_t> offsets(radix);
+    for (index_type shift = 0; shift < key_bits; shift += lg_radix) {
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (size_t n = 0; n < entries.size(); ++n) {
+            ++offsets[(entries[n].key >> shift) & (radix - 1)];
+        }
+
+        size_t total = 0;
+        for (size_t d = 0; d < radix; ++d) {
+            size_t digit_count = offsets[d];
+            offsets[d] = total;
+            total += digit_count;
+        }
+
+        for (size_t n = 0; n < entries.size(); ++n) {
+            size_t digit = (entries[n].key >> shift) & (radix - 1);
+            scratch[offsets[digit]++] = entries[n];
+        }
+        entries.swap(scratch);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename BinaryOp>
+inline void
+Tree<CellType, A>::applyBatch(const batch_entries *entries, 
+                              size_t begin, size_t end, BinaryOp op)
+{
+    // Consecutive entries mostly land in the accessor's cached cell.
+    accessor acc = getAccessor();
+    for (size_t n = begin; n < end; ++n) {
+        const BatchEntry &entry = (*entries)[n];
+        acc.update(entry.coords, entry.value, op);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename BinaryOp>
+inline void
+Tree<CellType, A>::applySplit(const batch_entries *entries, 
+                              const std::vector<size_t> *splits, BinaryOp op,
+                              size_t thread)
+{
+    applyBatch(entries, (*splits)[thread], (*splits)[thread + 1], op);
 }
 
 //------------------------------------------------------------------------------
@@ -210,15 +470,16 @@ Tree<CellType, A>::grow(index_type q,
 
         // Allocate the new root.
         Node<CellType, A> *root = 
-            new Node<CellType, A>(height(q) + 1, 
-                                  m_root[q]->getLgBranchingFactor(),
-                                  m_root[q]->getLgCellDim(), m_default_value);
+            node_type::create(height(q) + 1, 
+                              m_root[q]->getLgBranchingFactor(),
+                              m_root[q]->getLgCellDim(), m_default_value,
+                              false, m_allocator);
 
         // If the current tree is empty, then we delete it and just use the new
         // node as root. Otherwise, we need to make the current tree a subtree
         // of the new node.
         if (m_root[q]->isEmpty()) {
-            delete m_root[q];
+            node_type::destroy(m_root[q]);
             m_root[q] = NULL;
         } else {
             root->setSubtree(m_root[q]);
@@ -232,6 +493,228 @@ Tree<CellType, A>::grow(index_type q,
 
 //------------------------------------------------------------------------------
 
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::beginConcurrentWrites()
+{
+    m_pool->setThreadSafe(true);
+    if (m_pager) {
+        m_pager->beginShared();
+    }
+    m_concurrent = true;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::endConcurrentWrites()
+{
+    m_concurrent = false;
+    m_pool->setThreadSafe(false);
+    if (m_pager) {
+        m_pager->endShared();
+    }
+
+    // nobody can be reading the replaced nodes anymore.
+    destroyRetired();
+
+    // only nodes written through were made dense, pruning may free some.
+    for (size_t i = 0; i < m_expanded.size(); ++i) {
+        m_expanded[i]->compactBranches();
+    }
+    m_expanded.clear();
+
+    for (size_t q = 0; q < NUM_QUADRANTS; ++q) {
+        pruneEmptySubtrees(m_root[q]);
+        m_max_dim[q] = m_root[q]->computeMaxDim();
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+Tree<CellType, A>::isConcurrentWrites() const
+{
+    return m_concurrent;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename BinaryOp>
+inline CellType*
+Tree<CellType, A>::updateConcurrent(index_type q,
+                                    index_type i, index_type j, index_type k, 
+                                    const_reference val, BinaryOp op)
+{
+    // Other threads may replace the root at any time, work from a snapshot.
+    node_type_ptr node = atomicLoad(&m_root[q]);
+    index_type max_dim = node->computeMaxDim();
+    if (i >= max_dim || j >= max_dim || k >= max_dim) {
+        growConcurrent(q, i, j, k);
+        node = atomicLoad(&m_root[q]);
+    }
+
+    // The slot holding the current node, roots share the quadrant's
+    // coordinates so a reload of the root slot needs no adjustment.
+    node_type_ptr *slot = &m_root[q];
+
+    while (true) {
+        if (node->isFill()) {
+            // Nothing to do if the fill value is left untouched.
+            if (op(node->fillValue(), val) == node->fillValue()) {
+                return NULL;
+            }
+
+            // Swap in a branching copy, someone else may beat us to it.
+            node_type_ptr split = node->splitFill();
+            if (!compareAndSwap(slot, node, split)) {
+                node_type::destroy(split);
+                node = atomicLoad(slot);
+                continue;
+            }
+            retire(node);
+            node = split;
+        }
+
+        // Writers only add branches to dense nodes, whose slots don't move.
+        // Swap in a dense copy, the sparse node is left as other threads
+        // may be reading it.
+        if (!node->isDense()) {
+            node_type_ptr dense = node->denseCopy();
+            if (!compareAndSwap(slot, node, dense)) {
+                dense->releaseBranches();
+                node_type::destroy(dense);
+                node = atomicLoad(slot);
+                continue;
+            }
+            retire(node);
+            expanded(dense);
+            node = dense;
+        }
+
+        // Get/Allocate the right branch and move into child coordinates.
+        index_type branch = node->computeBranchIndex(i, j, k);
+        index_type i_child, j_child, k_child;
+        node->computeChildCoordinates(i, j, k, i_child, j_child, k_child);
+        i = i_child;
+        j = j_child;
+        k = k_child;
+
+        bool created;
+        typename node_type::branch_type child = 
+            node->createBranchConcurrent(branch, created);
+        if (created && !node->isCellParent()) {
+            expanded(child.node);
+        }
+
+        // Writes into the same cell are serialized by the cell's lock.
+        if (node->isCellParent()) {
+            SpinLock::ScopedLock lock(child.cell->spinLock());
+            child.cell->update(i, j, k, val, op);
+            return child.cell;
+        }
+
+        slot = &node->getBranch(branch).node;
+        node = child.node;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::growConcurrent(index_type q, 
+                                  index_type i, index_type j, index_type k)
+{
+    SpinLock::ScopedLock lock(m_lock);
+
+    while (true) {
+        node_type_ptr root = atomicLoad(&m_root[q]);
+        index_type max_dim = root->computeMaxDim();
+        if (i < max_dim && j < max_dim && k < max_dim) {
+            break;
+        }
+
+        // Unlike grow() the current root is kept even if it is empty, other
+        // threads may be writing into it.
+        node_type_ptr new_root = 
+            node_type::create(root->level() + 1, 
+                              root->getLgBranchingFactor(),
+                              root->getLgCellDim(), m_default_value,
+                              false, m_allocator);
+        new_root->makeDense();
+        new_root->m_branches[0].node = root;
+        new_root->m_bitfield.setBit(0);
+
+        // The root may have been split in the meantime, then try again.
+        if (compareAndSwap(&m_root[q], root, new_root)) {
+            m_max_dim[q] = new_root->computeMaxDim();
+            m_expanded.push_back(new_root);
+        } else {
+            new_root->m_branches[0].node = NULL;
+            new_root->m_bitfield.unsetBit(0);
+            node_type::destroy(new_root);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::retire(Node<CellType, A> *node)
+{
+    SpinLock::ScopedLock lock(m_lock);
+    m_retired.push_back(node);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::expanded(Node<CellType, A> *node)
+{
+    SpinLock::ScopedLock lock(m_lock);
+    m_expanded.push_back(node);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::destroyRetired()
+{
+    // the branches now belong to the nodes that replaced them
+    for (size_t i = 0; i < m_retired.size(); ++i) {
+        m_retired[i]->releaseBranches();
+        node_type::destroy(m_retired[i]);
+    }
+    m_retired.clear();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+Tree<CellType, A>::pruneEmptySubtrees(Node<CellType, A> *node)
+{
+    if (node->isFill() || node->isCellParent()) {
+        return node->isEmpty();
+    }
+
+    if (node->m_bitfield.isSet(0) && 
+        pruneEmptySubtrees(node->getBranch(0).node)) {
+        node->removeBranch(0);
+    }
+
+    return node->isEmpty();
+}
+
+//------------------------------------------------------------------------------
+
 template <typename CellType, typename A>
 template <typename U, template <typename> class Source>
 inline void 
@@ -287,6 +770,36 @@ Tree<CellType, A>::stamp(const Stamp<U, Source> &stamp,
 
 //------------------------------------------------------------------------------
 
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::prune(const_reference tolerance)
+{
+    for (u8 i = 0; i < NUM_QUADRANTS; ++i) {
+        m_root[i]->prune(tolerance);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::setAutoPrune(bool enable, const_reference tolerance)
+{
+    m_auto_prune = enable;
+    m_prune_tolerance = tolerance;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+Tree<CellType, A>::isAutoPrune() const
+{
+    return m_auto_prune;
+}
+
+//------------------------------------------------------------------------------
+
 template <typename CellType, typename A>
 inline bool
 Tree<CellType, A>::isEmpty() const
@@ -480,6 +993,65 @@ Tree<CellType, A>::setIterator() const
 
 //------------------------------------------------------------------------------
 
+template <typename CellType, typename A>
+inline typename Tree<CellType, A>::accessor
+Tree<CellType, A>::getAccessor()
+{
+    return accessor(this);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline typename Tree<CellType, A>::const_accessor
+Tree<CellType, A>::getAccessor() const
+{
+    return const_accessor(this);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline std::vector<Functor>
+Tree<CellType, A>::parallelForEachLeaf(const Functor &f, size_t num_threads)
+{
+    return ParallelForEach<CellType, A>(this, num_threads).forEachLeaf(f);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline std::vector<Functor>
+Tree<CellType, A>::parallelForEachLeaf(const Functor &f, 
+                                       size_t num_threads) const
+{
+    return ParallelForEach<CellType, A>(this, num_threads).forEachConstLeaf(f);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline std::vector<Functor>
+Tree<CellType, A>::parallelForEach(const Functor &f, size_t num_threads)
+{
+    return ParallelForEach<CellType, A>(this, num_threads).forEachVoxel(f);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Functor>
+inline std::vector<Functor>
+Tree<CellType, A>::parallelForEach(const Functor &f, size_t num_threads) const
+{
+    return ParallelForEach<CellType, A>(this, num_threads).forEachConstVoxel(f);
+}
+
+//------------------------------------------------------------------------------
+
 template <typename CellType, typename A>
 inline bool
 Tree<CellType, A>::operator==(const Tree &that) const
@@ -507,7 +1079,64 @@ Tree<CellType, A>::operator!=(const Tree &that) const
 
 template <typename CellType, typename A>
 inline void
-Tree<CellType, A>::read(std::istream &is)
+Tree<CellType, A>::read(std::istream &is, size_t num_threads)
+{
+    if (!StreamLeafIndex<value_type>::isIndexed(is)) {
+        readUnindexed(is);
+        return;
+    }
+
+    // read the leaves in bulk, the tree is kept if the stream is bad
+    StreamLeafIndex<value_type> index;
+    index.read(is);
+
+    // Destroy the current tree.
+    destruct();
+
+    m_default_value = index.defaultValue();
+    createRoots(index.header().lg_branching_factor, 
+                index.header().lg_cell_dim);
+
+    ParallelReader<CellType, A>(this, num_threads).read(index);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::read(std::istream &is, const signed_index_bounds &roi)
+{
+    if (!StreamLeafIndex<value_type>::isIndexed(is)) {
+        THROW(Iex::IoExc, "Partial reads need an indexed tree stream");
+    }
+
+    StreamLeafIndex<value_type> index;
+    index.readRecords(is);
+
+    // Destroy the current tree.
+    destruct();
+
+    m_default_value = index.defaultValue();
+    createRoots(index.header().lg_branching_factor, 
+                index.header().lg_cell_dim);
+
+    Region region;
+    computeRegion(roi, region);
+
+    // read only the bytes of the picked leaves and construct the tree
+    std::vector<size_t> leaves;
+    pickLeaves(index, region, leaves);
+    index.readLeaves(is, leaves);
+    for (size_t n = 0; n < index.size(); ++n) {
+        readLeaf(index, n);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::readUnindexed(std::istream &is)
 {
     // Destroy the current tree.
     destruct();
@@ -518,7 +1147,8 @@ Tree<CellType, A>::read(std::istream &is)
     // Allocate and read in each node.
     for (size_t i = 0; i < NUM_QUADRANTS; ++i) {
         // Create node with bogus parameters.
-        m_root[i] = new Node<CellType, A>(1, 2, 2, m_default_value);
+        m_root[i] = node_type::create(1, 2, 2, m_default_value, false, 
+                                      m_allocator);
 
         // Read in the data from the stream of this node.
         m_root[i]->read(is);
@@ -532,11 +1162,133 @@ Tree<CellType, A>::read(std::istream &is)
 
 template <typename CellType, typename A>
 inline void
-Tree<CellType, A>::read(HDF5Id volume_group_id)
+Tree<CellType, A>::read(HDF5Id volume_group_id, size_t num_threads)
+{
+    // Destroy the current tree
+    destruct();
+
+    u32 layout = readHeader(volume_group_id);
+
+    if (layout == HDF5_LAYOUT_LEAF_TABLE) {
+
+        // read the leaf table in bulk and construct the tree
+        HDF5LeafTable<value_type> table;
+        table.read(volume_group_id);
+        ParallelReader<CellType, A>(this, num_threads).read(table);
+
+    } else if (layout == HDF5_LAYOUT_LEAF_GROUPS && num_threads != 1) {
+
+        // gather the leaf groups into a table, then decode it in parallel
+        HDF5LeafTable<value_type> table;
+        HDF5Size iter_index = 0;
+        HDF5CallbackGuard guard(reinterpret_cast<void *>(&table));
+        H5Literate(volume_group_id, H5_INDEX_CRT_ORDER, H5_ITER_NATIVE, 
+                   &iter_index, 
+                   hdf5Guarded<H5L_info_t, Tree<CellType, A>::gatherLeaf>, 
+                   &guard);
+        guard.rethrow();
+        ParallelReader<CellType, A>(this, num_threads).read(table);
+
+    } else if (layout == HDF5_LAYOUT_LEAF_GROUPS) {
+
+        // iterate over leaf groups and construct the tree
+        HDF5Size iter_index = 0;
+        HDF5CallbackGuard guard(reinterpret_cast<void *>(this));
+        H5Literate(volume_group_id, H5_INDEX_CRT_ORDER, H5_ITER_NATIVE, 
+                   &iter_index, 
+                   hdf5Guarded<H5L_info_t, Tree<CellType, A>::createLeaf>, 
+                   &guard);
+        guard.rethrow();
+
+    } else {
+        THROW(Iex::IoExc, "Unknown volume layout version " << layout);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::read(HDF5Id volume_group_id, 
+                        const signed_index_bounds &roi)
+{
+    // Destroy the current tree
+    destruct();
+
+    u32 layout = readHeader(volume_group_id);
+
+    Region region;
+    computeRegion(roi, region);
+
+    if (layout == HDF5_LAYOUT_LEAF_TABLE) {
+
+        // pick the leaves from the index
+        HDF5LeafTable<value_type> table;
+        table.readRecords(volume_group_id);
+
+        std::vector<size_t> leaves;
+        pickLeaves(table, region, leaves);
+
+        // read only the data of the picked leaves and construct the tree
+        table.readLeaves(volume_group_id, leaves);
+        for (size_t n = 0; n < table.size(); ++n) {
+            readLeaf(table, n);
+        }
+
+    } else if (layout == HDF5_LAYOUT_LEAF_GROUPS) {
+
+        HDF5Size iter_index = 0;
+        HDF5CallbackGuard guard(reinterpret_cast<void *>(&region));
+        H5Literate(volume_group_id, H5_INDEX_CRT_ORDER, H5_ITER_NATIVE, 
+                   &iter_index, 
+                   hdf5Guarded<H5L_info_t, 
+                               Tree<CellType, A>::createLeafInRegion>, 
+                   &guard);
+        guard.rethrow();
+
+    } else {
+        THROW(Iex::IoExc, "Unknown volume layout version " << layout);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::readLazy(HDF5Id volume_group_id, size_t memory_budget)
 {
     // Destroy the current tree
     destruct();
 
+    u32 layout = readHeader(volume_group_id);
+    if (layout != HDF5_LAYOUT_LEAF_TABLE) {
+        THROW(Iex::IoExc, "Lazy reads need the leaf table layout, found "
+                          "layout version " << layout);
+    }
+
+    // construct the tree from the leaf index, voxels stay on disk
+    m_pager.reset(new CellPager<CellType>(volume_group_id, memory_budget));
+    for (size_t n = 0; n < m_pager->size(); ++n) {
+        readLeaf(*m_pager, n);
+    }
+    m_pager->releaseBitFields();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline CellPagerStats
+Tree<CellType, A>::getPagerStats() const
+{
+    return m_pager ? m_pager->stats() : CellPagerStats();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline u32
+Tree<CellType, A>::readHeader(HDF5Id volume_group_id)
+{
     // read in default value
     HDF5Attribute default_val_attr;
     default_val_attr.open(volume_group_id, kDefaultValueAttr);
@@ -561,41 +1313,38 @@ Tree<CellType, A>::read(HDF5Id volume_group_id)
     cell_dim_attr.read(TypeToHDF5Type<BOOST_TYPEOF(lg_cell_dim)>::type(), 
                        &lg_cell_dim);
 
-    // create the root nodes 
-    for (size_t i = 0; i < NUM_QUADRANTS; ++i) {
-        m_root[i] = 
-            new Node<CellType, A>(1, lg_branching_factor, lg_cell_dim,
-                                  m_default_value);
-        m_max_dim[i] = m_root[i]->computeMaxDim();
+    createRoots(lg_branching_factor, lg_cell_dim);
+
+    // volumes written with leaf groups have no layout version
+    u32 layout = HDF5_LAYOUT_LEAF_GROUPS;
+    if (H5Aexists(volume_group_id, kLayoutVersionAttr.c_str()) > 0) {
+        readScalarAttribute(volume_group_id,
+                            kLayoutVersionAttr,
+                            TypeToHDF5Type<BOOST_TYPEOF(layout)>::type(),
+                            &layout);
     }
 
-    // iterate over leaf groups and construct the tree
-    HDF5Size iter_index = 0;
-    H5Literate(volume_group_id, H5_INDEX_CRT_ORDER, H5_ITER_NATIVE, 
-               &iter_index, Tree<CellType, A>::createLeaf, 
-               reinterpret_cast<void *>(this));
+    return layout;
 }
 
 //------------------------------------------------------------------------------
 
 template <typename CellType, typename A>
 inline void
-Tree<CellType, A>::write(std::ostream &os) const
+Tree<CellType, A>::createRoots(u8 lg_branching_factor, u8 lg_cell_dim)
 {
-    // write out the default value.
-    os.write((char*)&m_default_value, sizeof(value_type));
-
-    // Write out each root node.
     for (size_t i = 0; i < NUM_QUADRANTS; ++i) {
-        m_root[i]->write(os);
+        m_root[i] = 
+            node_type::create(1, lg_branching_factor, lg_cell_dim,
+                              m_default_value, false, m_allocator);
+        m_max_dim[i] = m_root[i]->computeMaxDim();
     }
 }
-
 //------------------------------------------------------------------------------
 
 template <typename CellType, typename A>
 inline void
-Tree<CellType, A>::write(HDF5Id volume_group_id) const
+Tree<CellType, A>::writeHeader(HDF5Id volume_group_id) const
 {
     // write out the default value
     writeScalarAttribute(volume_group_id,
@@ -618,12 +1367,154 @@ Tree<CellType, A>::write(HDF5Id volume_group_id) const
                          kCellDimAttr,
                          TypeToHDF5Type<BOOST_TYPEOF(cell_dim)>::type(),
                          &cell_dim);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::write(std::ostream &os) const
+{
+    // the header is completed last, which needs seeking
+    if (os.tellp() == std::streampos(-1)) {
+        std::ostringstream buffer;
+        write(buffer);
+        const std::string &bytes = buffer.str();
+        os.write(bytes.data(), bytes.size());
+        return;
+    }
+
+    StreamLeafWriter<value_type> writer(os, m_default_value, 
+                                        m_root[0]->getLgBranchingFactor(),
+                                        m_root[0]->getLgCellDim());
+
+    // traverse the tree, writing the leaves 
+    index_vec origin(0, 0, 0);
+    for (size_t i = 0; i < NUM_QUADRANTS; ++i) {
+        m_root[i]->write(writer, i, origin);
+    }
+    writer.finish();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::write(HDF5Id volume_group_id, HDF5Layout layout,
+                         const HDF5Compression &compression,
+                         size_t num_threads) const
+{
+    writeHeader(volume_group_id);
  
     // traverse the tree, writing the leaves 
     index_vec origin(0, 0, 0);
-    for (size_t i=0; i < NUM_QUADRANTS; ++i) {
-        m_root[i]->write(volume_group_id, i, origin);
+    if (layout == HDF5_LAYOUT_LEAF_TABLE) {
+
+        // write out the layout version, leaf groups are left without it
+        // so older readers still open them
+        u32 version = layout;
+        writeScalarAttribute(volume_group_id,
+                             kLayoutVersionAttr,
+                             TypeToHDF5Type<BOOST_TYPEOF(version)>::type(),
+                             &version);
+
+        // gather all leaves, then write them in bulk
+        HDF5LeafTable<value_type> table;
+        writeLeaves(table, num_threads);
+        table.write(volume_group_id, compression);
+
+    } else {
+        for (size_t i=0; i < NUM_QUADRANTS; ++i) {
+            m_root[i]->write(volume_group_id, i, origin);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::writeNative(std::ostream &os, 
+                               const std::string &metadata,
+                               size_t num_threads) const
+{
+    // gather all leaves, then write them in bulk
+    HDF5LeafTable<value_type> table;
+    writeLeaves(table, num_threads);
+
+    // NOTE: this assumes uniform branching factor across all nodes.
+    MappedLeafTable<value_type>::write(os, table, m_default_value,
+                                       m_root[0]->getLgBranchingFactor(),
+                                       m_root[0]->getLgCellDim(),
+                                       metadata);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::writeIncremental(HDF5Id volume_group_id)
+{
+    writeHeader(volume_group_id);
+
+    // the leaf groups in the file, the ones still left once the tree is
+    // traversed belong to leaves removed since
+    std::set<String> stored;
+    HDF5Size iter_index = 0;
+    HDF5CallbackGuard guard(reinterpret_cast<void *>(&stored));
+    H5Literate(volume_group_id, H5_INDEX_CRT_ORDER, H5_ITER_NATIVE, 
+               &iter_index, 
+               hdf5Guarded<H5L_info_t, Tree<CellType, A>::collectLeafGroup>, 
+               &guard);
+    guard.rethrow();
+
+    // rewrite the dirty leaves
+    index_vec origin(0, 0, 0);
+    for (size_t i = 0; i < NUM_QUADRANTS; ++i) {
+        m_root[i]->writeDirty(volume_group_id, i, origin, stored);
+    }
+
+    // delete the removed leaves
+    std::set<String>::const_iterator iter = stored.begin();
+    for ( ; iter != stored.end(); ++iter) {
+        H5Ldelete(volume_group_id, iter->c_str(), H5P_DEFAULT);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::writeLeaves(HDF5LeafTable<value_type> &table,
+                               size_t num_threads) const
+{
+    if (m_pager) {
+        num_threads = 1;
+    }
+
+    ParallelWriter<CellType, A>(this, num_threads).write(table);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::map(const MappedLeafTable<value_type> &table)
+{
+    // Destroy the current tree
+    destruct();
+
+    m_default_value = table.defaultValue();
+
+    const NativeHeader &header = table.header();
+    createRoots(header.lg_branching_factor, header.lg_cell_dim);
+
+    // construct the tree, cells point into the mapping
+    for (size_t n = 0; n < table.size(); ++n) {
+        readLeaf(table, n);
     }
+
+    m_mapped_file = table.file();
 }
 
 //------------------------------------------------------------------------------
@@ -644,6 +1535,15 @@ Tree<CellType, A>::sizeOf() const
 
 //------------------------------------------------------------------------------
 
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::releaseMemory()
+{
+    m_pool->releaseMemory();
+}
+
+//------------------------------------------------------------------------------
+
 template <typename CellType, typename A>
 inline HDF5Err
 Tree<CellType, A>::createLeaf(HDF5Id volume_group_id, 
@@ -674,9 +1574,123 @@ Tree<CellType, A>::createLeaf(HDF5Id volume_group_id,
 
 //------------------------------------------------------------------------------
 
+template <typename CellType, typename A>
+inline HDF5Err
+Tree<CellType, A>::gatherLeaf(HDF5Id volume_group_id, 
+                              const char *group_name, 
+                              const H5L_info_t *NK_UNUSED_PARAM(group_info),
+                              void *op_data)
+{
+    // skip the User Attributes group
+    if (String(group_name) == kUserAttrGroup) {
+        return 0;
+    }
+    
+    // open the leaf group
+    HDF5Group leaf_group;
+    leaf_group.open(volume_group_id, String(group_name));
+    if (!leaf_group.isValid()) {
+        THROW(Iex::IoExc, "Invalid leaf group " << group_name);
+    }
+    HDF5Id leaf_group_id = leaf_group.id();
+
+    // cast user data back to the table
+    HDF5LeafTable<value_type> *table = 
+        reinterpret_cast<HDF5LeafTable<value_type>*>(op_data);
+
+    // get the offset and the quadrant
+    index_vec index_offset;
+    readVectorAttribute(leaf_group_id, kIndexOffsetAttr, &index_offset);
+
+    size_t q;
+    readScalarAttribute(leaf_group_id, kQuadrantAttr,
+                        TypeToHDF5Type<BOOST_TYPEOF(q)>::type(),
+                        &q);
+    if (q >= NUM_QUADRANTS) {
+        THROW(Iex::IoExc, "Invalid quadrant for leaf group " << group_name);
+    }
+
+    LeafType type;
+    readScalarAttribute(leaf_group_id, kLeafTypeAttr, -1, &type);
+
+    typename HDF5LeafTable<value_type>::Record &record = table->append();
+    record.quadrant  = q;
+    record.type      = type;
+    record.offset[0] = index_offset[0];
+    record.offset[1] = index_offset[1];
+    record.offset[2] = index_offset[2];
+
+    if (type == LEAF_TYPE_FILL_NODE) {
+        readScalarAttribute(leaf_group_id, kFillNodeLevelAttr,
+                            TypeToHDF5Type<index_type>::type(), 
+                            &record.level);
+        readScalarAttribute(leaf_group_id, kFillNodeValueAttr,
+                            TypeToHDF5Type<value_type>::type(), 
+                            &record.fill_value);
+    } else {
+        CellType::gather(leaf_group_id, *table, record);
+    }
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline HDF5Err
+Tree<CellType, A>::createLeafInRegion(
+    HDF5Id volume_group_id, 
+    const char *group_name, 
+    const H5L_info_t *NK_UNUSED_PARAM(group_info),
+    void *op_data)
+{
+    // skip the User Attributes group
+    if (String(group_name) == kUserAttrGroup) {
+        return 0;
+    }
+    
+    // open the leaf group
+    HDF5Group leaf_group;
+    leaf_group.open(volume_group_id, String(group_name));
+    if (!leaf_group.isValid()) {
+        THROW(Iex::IoExc, "Invalid leaf group " << group_name);
+    }
+
+    // cast user data back to the region
+    const Region *region = reinterpret_cast<const Region*>(op_data);
+
+    // read in the leaf if inside the region
+    region->tree->readLeaf(leaf_group.id(), region);
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline HDF5Err
+Tree<CellType, A>::collectLeafGroup(
+    HDF5Id NK_UNUSED_PARAM(volume_group_id), 
+    const char *group_name,
+    const H5L_info_t *NK_UNUSED_PARAM(group_info),
+    void *op_data)
+{
+    // skip the User Attributes group
+    if (String(group_name) == kUserAttrGroup) {
+        return 0;
+    }
+
+    std::set<String> *names = reinterpret_cast<std::set<String>*>(op_data);
+    names->insert(String(group_name));
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+
 template <typename CellType, typename A>
 inline void
-Tree<CellType, A>::readLeaf(HDF5Id leaf_group_id)
+Tree<CellType, A>::readLeaf(HDF5Id leaf_group_id, const Region *region)
 {
     // get the offset
     index_vec index_offset;
@@ -688,6 +1702,34 @@ Tree<CellType, A>::readLeaf(HDF5Id leaf_group_id)
                         TypeToHDF5Type<BOOST_TYPEOF(q)>::type(),
                         &q);
 
+    if (region) {
+        if (q >= NUM_QUADRANTS) {
+            THROW(Iex::IoExc, "Invalid quadrant for leaf group");
+        }
+
+        LeafType type;
+        readScalarAttribute(leaf_group_id, kLeafTypeAttr, -1, &type);
+
+        index_type level = 0;
+        if (type == LEAF_TYPE_FILL_NODE) {
+            readScalarAttribute(leaf_group_id, kFillNodeLevelAttr,
+                                TypeToHDF5Type<index_type>::type(), &level);
+        }
+
+        // skip leaves outside the region, clip fill nodes to it
+        index_bounds bounds = computeLeafBounds(type, level, index_offset);
+        index_bounds clipped = bounds;
+        if (!clipLeaf(*region, q, clipped)) return;
+
+        if (type == LEAF_TYPE_FILL_NODE && !clipped.contains(bounds)) {
+            value_type value;
+            readScalarAttribute(leaf_group_id, kFillNodeValueAttr,
+                                TypeToHDF5Type<value_type>::type(), &value);
+            fillLeaf(q, clipped, value);
+            return;
+        }
+    }
+
     // Keep  increasing the depth of the tree until we can allocate the value
     // at the given i, j, k
     grow(q, index_offset[0], index_offset[1], index_offset[2]);
@@ -695,6 +1737,148 @@ Tree<CellType, A>::readLeaf(HDF5Id leaf_group_id)
     m_root[q]->read(leaf_group_id, index_offset);
 }
 
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Table>
+inline void
+Tree<CellType, A>::readLeaf(Table &table, size_t leaf)
+{
+    CellType *cell = readPath(table, leaf);
+    if (cell) {
+        cell->read(table, leaf);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Table>
+inline CellType*
+Tree<CellType, A>::readPath(Table &table, size_t leaf)
+{
+    const typename Table::Record &record = table[leaf];
+    if (record.quadrant >= NUM_QUADRANTS) {
+        THROW(Iex::IoExc, "Invalid quadrant for leaf " << leaf);
+    }
+
+    index_vec index_offset(record.offset[0], record.offset[1],
+                           record.offset[2]);
+
+    // Keep increasing the depth of the tree until we can allocate the value
+    // at the given i, j, k
+    grow(record.quadrant, index_offset[0], index_offset[1], index_offset[2]);
+
+    return m_root[record.quadrant]->readPath(table, leaf, index_offset);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::computeRegion(const signed_index_bounds &roi, 
+                                 Region &region)
+{
+    region.tree      = this;
+    region.quadrants = 0;
+
+    // nothing intersects an empty box
+    const signed_index_vec &min = roi.min();
+    const signed_index_vec &max = roi.max();
+    if (max.x <= min.x || max.y <= min.y || max.z <= min.z) return;
+
+    // split up the box by quadrants
+    signed_index_bounds quadrant_bounds[NUM_QUADRANTS];
+    region.quadrants = getQuadrantBounds(roi, quadrant_bounds);
+
+    for (u8 q = 0; q < NUM_QUADRANTS; ++q) {
+        if (!(region.quadrants & (1 << q))) continue;
+        convertToUnsignedBounds(quadrant_bounds[q], region.bounds[q]);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline index_bounds
+Tree<CellType, A>::computeLeafBounds(u8 type, index_type level,
+                                     const index_vec &offset) const
+{
+    // a fill node spans all the cells under it
+    index_type lg_dim = m_root[0]->getLgCellDim();
+    if (type == LEAF_TYPE_FILL_NODE) {
+        lg_dim += level * m_root[0]->getLgBranchingFactor();
+    }
+    if (lg_dim >= bitsof(index_type)) {
+        THROW(Iex::IoExc, "Invalid fill node level " << level);
+    }
+
+    index_type dim = index_type(1) << lg_dim;
+    return index_bounds(offset, offset + index_vec(dim));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline bool
+Tree<CellType, A>::clipLeaf(const Region &region, u8 quadrant, 
+                            index_bounds &bounds) const
+{
+    if (!(region.quadrants & (1 << quadrant))) return false;
+
+    index_bounds region_bounds = region.bounds[quadrant];
+    if (!bounds.intersects(region_bounds)) return false;
+
+    bounds = bounds.intersection(region_bounds);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+inline void
+Tree<CellType, A>::fillLeaf(u8 quadrant, const index_bounds &bounds,
+                            const_reference value)
+{
+    // grow the quadrant to hold the last voxel of the bounds
+    const index_vec unit(1, 1, 1);
+    index_vec corner = bounds.max() - unit;
+    grow(quadrant, corner.x, corner.y, corner.z);
+
+    m_root[quadrant]->fill(bounds, value);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename CellType, typename A>
+template <typename Table>
+inline void
+Tree<CellType, A>::pickLeaves(const Table &table, const Region &region,
+                              std::vector<size_t> &leaves)
+{
+    for (size_t n = 0; n < table.size(); ++n) {
+        const typename Table::Record &record = table[n];
+        if (record.quadrant >= NUM_QUADRANTS) {
+            THROW(Iex::IoExc, "Invalid quadrant for leaf " << n);
+        }
+
+        index_vec offset(record.offset[0], record.offset[1], 
+                         record.offset[2]);
+        index_bounds bounds = 
+            computeLeafBounds(record.type, record.level, offset);
+        index_bounds clipped = bounds;
+        if (!clipLeaf(region, record.quadrant, clipped)) continue;
+
+        if (record.type == LEAF_TYPE_FILL_NODE && 
+            !clipped.contains(bounds)) {
+            fillLeaf(record.quadrant, clipped, record.fill_value);
+        } else {
+            leaves.push_back(n);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 // set_iterator implementation
 //------------------------------------------------------------------------------
@@ -40,6 +40,8 @@
 // includes
 //------------------------------------------------------------------------------
 
+#include <sstream>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 
 #include <nkbase/BinaryOps.h>
@@ -47,8 +49,13 @@
 #include <nkhive/Defs.h>
 #include <nkhive/Types.h>
 #include <nkhive/attributes/AttributeCollection.h>
+#include <nkhive/attributes/PrimitiveTypes.h>
+#include <nkhive/bitfields/Layout.h>
+#include <nkhive/memory/PoolAllocator.h>
 #include <nkhive/tiling/Stamp.h>
+#include <nkhive/volume/Accessor.h>
 #include <nkhive/volume/Cell.h>
+#include <nkhive/volume/Leaf.h>
 #include <nkhive/volume/Tree.h>
 #include <nkhive/xforms/LocalXform.h>
 #include <nkhive/io/hdf5/HDF5Group.h>
@@ -65,7 +72,7 @@ class TestVolumeFile;
 
 BEGIN_NKHIVE_NS
 
-template <typename T>
+template <typename T, typename L = RowMajorLayout>
 class Volume
 {
 
@@ -80,6 +87,17 @@ public:
     typedef const T&                  const_reference;
     typedef boost::shared_ptr<Volume> shared_ptr;
 
+    typedef PoolAllocator<T>          allocator_type;
+    typedef L                         layout_type;
+
+    typedef Accessor< Cell<T, allocator_type, L>, 
+                      allocator_type >      accessor;
+    typedef ConstAccessor< Cell<T, allocator_type, L>, 
+                           allocator_type > const_accessor;
+
+    typedef Leaf< Cell<T, allocator_type, L> >         leaf;
+    typedef Leaf< const Cell<T, allocator_type, L> >   const_leaf;
+
     //--------------------------------------------------------------------------
     // public interface
     //--------------------------------------------------------------------------
@@ -105,13 +123,19 @@ public:
      */
     const_reference getDefault() const;
 
+    /**
+     * Return Log2 of the branching factor and cell dimension of the volume.
+     */
+    uint8_t getLgBranchingFactor() const;
+    uint8_t getLgCellDim() const;
+
     /** 
      * Get the value at voxel index i,j,k.
      */
-    const_reference get(signed_index_type i, 
-                        signed_index_type j, 
-                        signed_index_type k) const;
-    const_reference get(const signed_index_vec &coords) const;
+    value_type get(signed_index_type i, 
+                   signed_index_type j, 
+                   signed_index_type k) const;
+    value_type get(const signed_index_vec &coords) const;
 
     /**
      * Set the value at voxel index i,j,k.
@@ -139,6 +163,35 @@ public:
     void update(const signed_index_vec &coords, const_reference val, 
                 BinaryOp op);
 
+    /**
+     * Gets/updates the size block of voxels with its minimum corner at min,
+     * x fastest, visiting each overlapped cell once. See Tree::getBlock().
+     */
+    void getBlock(const signed_index_vec &min, const index_vec &size, 
+                  value_type *out) const;
+    template <typename BinaryOp>
+    void updateBlock(const signed_index_vec &min, const index_vec &size, 
+                     const value_type *vals, BinaryOp op);
+
+    /**
+     * Sets/updates count voxels at once, values[n] going to coords[n]. Much
+     * cheaper per voxel than set/update for clustered coordinates, see 
+     * Tree::updateBatch().
+     */
+    void setBatch(const signed_index_vec *coords, const value_type *values,
+                  size_t count, size_t num_threads = 1);
+    template <typename BinaryOp>
+    void updateBatch(const signed_index_vec *coords, const value_type *values,
+                     size_t count, BinaryOp op, size_t num_threads = 1);
+
+    /**
+     * Enter/Leave concurrent write mode. While in it set() and update() may be
+     * called from several threads, nothing else may be called on the volume.
+     */
+    void beginConcurrentWrites();
+    void endConcurrentWrites();
+    bool isConcurrentWrites() const;
+
     /**
      * Writes the stamp at the requested location using the given op.
      * The position indicates the minina of the stamps bounds.
@@ -146,6 +199,16 @@ public:
     template <typename U, template <typename> class Source>
     void stamp(Stamp<U, Source> &stamp, signed_index_vec &position);
 
+    /**
+     * Collapses regions uniform within tolerance into fill cells and fill
+     * nodes. With auto prune on, set() and update() prune the cells they
+     * fill up as they go.
+     */
+    void prune(const_reference tolerance = value_type());
+    void setAutoPrune(bool enable, 
+                      const_reference tolerance = value_type());
+    bool isAutoPrune() const;
+
     /**
      * Return true if there are no set values in the volume. 
      */
@@ -169,6 +232,12 @@ public:
      */
     int sizeOf() const;
 
+    /**
+     * Returns pooled memory no longer used by the volume's cells and nodes
+     * back to the system.
+     */
+    void releaseMemory();
+
     //--------------------------------------------------------------------------
     // Local Xform methods.
     //--------------------------------------------------------------------------
@@ -216,15 +285,71 @@ public:
     String getDescription();
     const String& getDescription() const;
 
+    /**
+     * Filter and deflate level for the volume's HDF5 data sets, kept in the
+     * compression attributes. Reading the level needs Int32Attribute
+     * registered.
+     */
+    void setCompression(HDF5Filter filter, i32 level = 6);
+    HDF5Compression getCompression() const;
+
     //--------------------------------------------------------------------------
     // IO methods.
     //--------------------------------------------------------------------------
 
-    void read(std::istream &is);
+    /**
+     * Cells are decoded on num_threads threads (0 for one per core), see
+     * Tree::read().
+     */
+    void read(std::istream &is, size_t num_threads = 1);
     void write(std::ostream &os) const;
-    void read(HDF5Id file_id, String volume_name);
-    void read(HDF5Id file_id, u32 index = 0);
-    void write(HDF5Id file_id) const;
+
+    /**
+     * Reads only the part of the volume intersecting roi from a seekable 
+     * stream, see Tree::read().
+     */
+    void read(std::istream &is, const signed_index_bounds &roi);
+
+    void read(HDF5Id file_id, String volume_name, size_t num_threads = 1);
+    void read(HDF5Id file_id, u32 index = 0, size_t num_threads = 1);
+
+    /**
+     * Leaves are encoded on num_threads threads (0 for one per core), see
+     * Tree::write().
+     */
+    void write(HDF5Id file_id,
+               HDF5Layout layout = HDF5_LAYOUT_LEAF_TABLE,
+               size_t num_threads = 1) const;
+
+    /**
+     * Saves over the copy of the volume in the file, rewriting only the 
+     * leaves modified since it was read or last saved this way, see 
+     * Tree::writeIncremental(). A copy stored as a leaf table, or a volume
+     * not in the file yet, is written in full to leaf groups.
+     */
+    void writeIncremental(HDF5Id file_id);
+
+    /**
+     * Reads only the part of the volume intersecting roi, given in index 
+     * space with an exclusive max, see Tree::read().
+     */
+    void read(HDF5Id file_id, String volume_name, 
+              const signed_index_bounds &roi);
+
+    /**
+     * Reads the leaf index only, voxels are paged in from the file as they
+     * are accessed within memory_budget bytes, see Tree::readLazy(). The 
+     * file stays open until the volume is destroyed or read again.
+     */
+    void readLazy(HDF5Id file_id, size_t memory_budget, u32 index = 0);
+    CellPagerStats getPagerStats() const;
+
+    /**
+     * Native format, mapped into memory on read. Voxels stay in the file 
+     * until a cell is first written, the file must outlive the volume.
+     */
+    void writeNative(std::ostream &os, size_t num_threads = 1) const;
+    void map(const String &file_path);
 
     //--------------------------------------------------------------------------
     // Operators.
@@ -245,14 +370,39 @@ public:
      */
     set_iterator setIterator() const;
 
+    /**
+     * Return an accessor caching the path to the last visited cell. Use it
+     * in place of get/set/update for spatially coherent access.
+     */
+    accessor getAccessor();
+    const_accessor getAccessor() const;
+
+    /**
+     * Parallel traversals over the cells and set voxels of the volume, see
+     * Tree::parallelForEachLeaf() and Tree::parallelForEach(). A leaf 
+     * functor is called as f(leaf), a voxel functor as f(coords, value).
+     */
+    template <typename Functor>
+    std::vector<Functor> parallelForEachLeaf(const Functor &f, 
+                                             size_t num_threads = 0);
+    template <typename Functor>
+    std::vector<Functor> parallelForEachLeaf(const Functor &f, 
+                                             size_t num_threads = 0) const;
+    template <typename Functor>
+    std::vector<Functor> parallelForEach(const Functor &f, 
+                                         size_t num_threads = 0);
+    template <typename Functor>
+    std::vector<Functor> parallelForEach(const Functor &f, 
+                                         size_t num_threads = 0) const;
+
 private:
     
     //--------------------------------------------------------------------------
     // typedefs
     //--------------------------------------------------------------------------
     
-    typedef Cell<T>         cell_type;
-    typedef Tree<cell_type> tree_type;
+    typedef Cell<T, allocator_type, L>      cell_type;
+    typedef Tree<cell_type, allocator_type> tree_type;
 
     //--------------------------------------------------------------------------
     // Internal helpers. 
@@ -266,9 +416,18 @@ private:
     /**
      * Handles reading of volume data 
      */
-    void readVolume(HDF5Id volume_root_group_id, String &volume_name);
+    void readVolume(HDF5Id volume_root_group_id, String &volume_name,
+                    bool lazy = false, size_t memory_budget = 0,
+                    const signed_index_bounds *roi = NULL,
+                    size_t num_threads = 1);
+
+    /**
+     * Name of the volume group at the given creation index.
+     */
+    static String volumeName(HDF5Id volume_root_group_id, u32 index);
     void writeVolume(HDF5Id volume_root_group_id, 
-                     const String &volume_name) const;
+                     const String &volume_name, HDF5Layout layout,
+                     size_t num_threads) const;
 
     //--------------------------------------------------------------------------
     // members
@@ -310,8 +469,8 @@ private:
 // set_iterator interface.
 //------------------------------------------------------------------------------
 
-template <typename T>
-class Volume<T>::set_iterator
+template <typename T, typename L>
+class Volume<T, L>::set_iterator
 {
 public:
 
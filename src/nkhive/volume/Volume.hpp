@@ -51,9 +51,9 @@ typedef Volume<u64> VolumeULong;
 // class implemenation
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline
-Volume<T>::Volume() :
+Volume<T, L>::Volume() :
     m_tree(), 
     m_local_xform(),
     m_attributes()
@@ -62,9 +62,9 @@ Volume<T>::Volume() :
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline
-Volume<T>::Volume(uint8_t lg_branching_factor, 
+Volume<T, L>::Volume(uint8_t lg_branching_factor, 
                   uint8_t lg_cell_dim,
                   const_reference default_value, 
                   const vec3d &res,
@@ -79,44 +79,62 @@ Volume<T>::Volume(uint8_t lg_branching_factor,
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline
-Volume<T>::~Volume()
+Volume<T, L>::~Volume()
 {
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline String 
-Volume<T>::typeName() const
+Volume<T, L>::typeName() const
 {
     return typeid(T).name();
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline vec3d
-Volume<T>::kernelOffset() const
+Volume<T, L>::kernelOffset() const
 {
     return m_kernel_offset;
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
-inline typename Volume<T>::const_reference
-Volume<T>::getDefault() const
+template <typename T, typename L>
+inline typename Volume<T, L>::const_reference
+Volume<T, L>::getDefault() const
 {
     return m_tree.getDefault();
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
-inline typename Volume<T>::const_reference
-Volume<T>::get(signed_index_type i, 
+template <typename T, typename L>
+inline uint8_t
+Volume<T, L>::getLgBranchingFactor() const
+{
+    return m_tree.getLgBranchingFactor();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline uint8_t
+Volume<T, L>::getLgCellDim() const
+{
+    return m_tree.getLgCellDim();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline typename Volume<T, L>::value_type
+Volume<T, L>::get(signed_index_type i, 
                signed_index_type j, 
                signed_index_type k) const
 {
@@ -125,18 +143,18 @@ Volume<T>::get(signed_index_type i,
 
 //------------------------------------------------------------------------------
 
-template <typename T>
-inline typename Volume<T>::const_reference
-Volume<T>::get(const signed_index_vec &coords) const
+template <typename T, typename L>
+inline typename Volume<T, L>::value_type
+Volume<T, L>::get(const signed_index_vec &coords) const
 {
     return get(coords[0], coords[1], coords[2]);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::set(signed_index_type i, 
+Volume<T, L>::set(signed_index_type i, 
                signed_index_type j, 
                signed_index_type k, const_reference val)
 {
@@ -145,37 +163,39 @@ Volume<T>::set(signed_index_type i,
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::set(const signed_index_vec &coords, const_reference val)
+Volume<T, L>::set(const signed_index_vec &coords, const_reference val)
 {
     set(coords[0], coords[1], coords[2], val);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::unset(signed_index_type i, signed_index_type j, signed_index_type k)
+Volume<T, L>::unset(signed_index_type i, 
+                    signed_index_type j, 
+                    signed_index_type k)
 {
     m_tree.unset(i, j, k);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::unset(const signed_index_vec &coords)
+Volume<T, L>::unset(const signed_index_vec &coords)
 {
     unset(coords[0], coords[1], coords[2]);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 template <typename BinaryOp>
 inline void
-Volume<T>::update(signed_index_type i, 
+Volume<T, L>::update(signed_index_type i, 
                   signed_index_type j, 
                   signed_index_type k, 
                   const_reference val, BinaryOp op)
@@ -185,10 +205,10 @@ Volume<T>::update(signed_index_type i,
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 template <typename BinaryOp>
 inline void
-Volume<T>::update(const signed_index_vec &coords, 
+Volume<T, L>::update(const signed_index_vec &coords, 
                   const_reference val, BinaryOp op)
 {
     update(coords[0], coords[1], coords[2], val, op);
@@ -196,37 +216,134 @@ Volume<T>::update(const signed_index_vec &coords,
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
+inline void
+Volume<T, L>::getBlock(const signed_index_vec &min, const index_vec &size,
+                       value_type *out) const
+{
+    m_tree.getBlock(min, size, out);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+template <typename BinaryOp>
+inline void
+Volume<T, L>::updateBlock(const signed_index_vec &min, const index_vec &size,
+                          const value_type *vals, BinaryOp op)
+{
+    m_tree.updateBlock(min, size, vals, op);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline void
+Volume<T, L>::setBatch(const signed_index_vec *coords, const value_type *values,
+                    size_t count, size_t num_threads)
+{
+    m_tree.setBatch(coords, values, count, num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+template <typename BinaryOp>
+inline void
+Volume<T, L>::updateBatch(const signed_index_vec *coords, 
+                       const value_type *values,
+                       size_t count, BinaryOp op, size_t num_threads)
+{
+    m_tree.updateBatch(coords, values, count, op, num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline void
+Volume<T, L>::beginConcurrentWrites()
+{
+    m_tree.beginConcurrentWrites();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline void
+Volume<T, L>::endConcurrentWrites()
+{
+    m_tree.endConcurrentWrites();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline bool
+Volume<T, L>::isConcurrentWrites() const
+{
+    return m_tree.isConcurrentWrites();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline void
+Volume<T, L>::prune(const_reference tolerance)
+{
+    m_tree.prune(tolerance);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline void
+Volume<T, L>::setAutoPrune(bool enable, const_reference tolerance)
+{
+    m_tree.setAutoPrune(enable, tolerance);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline bool
+Volume<T, L>::isAutoPrune() const
+{
+    return m_tree.isAutoPrune();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
 template <typename U, template <typename> class Source>
 inline void 
-Volume<T>::stamp(Stamp<U, Source> &stamp, signed_index_vec &position) 
+Volume<T, L>::stamp(Stamp<U, Source> &stamp, signed_index_vec &position) 
 {
     m_tree.stamp(stamp, position);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline bool
-Volume<T>::isEmpty() const
+Volume<T, L>::isEmpty() const
 {
     return m_tree.isEmpty();
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline bool
-Volume<T>::computeSetBounds(signed_index_bounds &bounds) const
+Volume<T, L>::computeSetBounds(signed_index_bounds &bounds) const
 {
     return m_tree.computeSetBounds(bounds);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline bool
-Volume<T>::computeSetBounds(Bounds3D<double> &bounds) const
+Volume<T, L>::computeSetBounds(Bounds3D<double> &bounds) const
 {
     signed_index_bounds index_bounds;
     if (!m_tree.computeSetBounds(index_bounds)) {
@@ -245,9 +362,9 @@ Volume<T>::computeSetBounds(Bounds3D<double> &bounds) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline int
-Volume<T>::sizeOf() const
+Volume<T, L>::sizeOf() const
 {
     int sizeof_this = sizeof(*this);
     int sizeof_tree = m_tree.sizeOf();
@@ -257,45 +374,54 @@ Volume<T>::sizeOf() const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
+inline void
+Volume<T, L>::releaseMemory()
+{
+    m_tree.releaseMemory();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
 inline void
-Volume<T>::setLocalXform(const vec3d &res)
+Volume<T, L>::setLocalXform(const vec3d &res)
 {
     m_local_xform = LocalXform(res);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline vec3d
-Volume<T>::res() const
+Volume<T, L>::res() const
 {
     return m_local_xform.res();
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::localToVoxel(const vec3d &l, vec3d &v) const
+Volume<T, L>::localToVoxel(const vec3d &l, vec3d &v) const
 {
     m_local_xform.localToVoxel(l, v);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline vec3d
-Volume<T>::localToVoxel(const vec3d &l) const
+Volume<T, L>::localToVoxel(const vec3d &l) const
 {
     return m_local_xform.localToVoxel(l);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::localToIndex(const vec3d &l, vec3i &i) const
+Volume<T, L>::localToIndex(const vec3d &l, vec3i &i) const
 {
     vec3d v = localToVoxel(l);
     voxelToIndex(v, i);
@@ -303,9 +429,9 @@ Volume<T>::localToIndex(const vec3d &l, vec3i &i) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline vec3i
-Volume<T>::localToIndex(const vec3d &l) const
+Volume<T, L>::localToIndex(const vec3d &l) const
 {
     vec3d v = localToVoxel(l);
     return voxelToIndex(v);
@@ -313,27 +439,27 @@ Volume<T>::localToIndex(const vec3d &l) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::voxelToLocal(const vec3d &v, vec3d &l) const
+Volume<T, L>::voxelToLocal(const vec3d &v, vec3d &l) const
 {
     m_local_xform.voxelToLocal(v, l);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline vec3d
-Volume<T>::voxelToLocal(const vec3d &v) const
+Volume<T, L>::voxelToLocal(const vec3d &v) const
 {
     return m_local_xform.voxelToLocal(v);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::voxelToIndex(const vec3d &v, vec3i &i) const
+Volume<T, L>::voxelToIndex(const vec3d &v, vec3i &i) const
 {
     vec3d inv_xformed_v = v - m_kernel_offset;
 
@@ -344,9 +470,9 @@ Volume<T>::voxelToIndex(const vec3d &v, vec3i &i) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline vec3i
-Volume<T>::voxelToIndex(const vec3d &v) const
+Volume<T, L>::voxelToIndex(const vec3d &v) const
 {
     vec3i i(0,0,0);
     voxelToIndex(v, i);
@@ -355,9 +481,9 @@ Volume<T>::voxelToIndex(const vec3d &v) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::indexToVoxel(const vec3i &i, vec3d &v) const
+Volume<T, L>::indexToVoxel(const vec3i &i, vec3d &v) const
 {
     v.x = ((vec3d::BaseType)(i.x)) + m_kernel_offset.x;
     v.y = ((vec3d::BaseType)(i.y)) + m_kernel_offset.y;
@@ -366,9 +492,9 @@ Volume<T>::indexToVoxel(const vec3i &i, vec3d &v) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline vec3d
-Volume<T>::indexToVoxel(const vec3i &i) const
+Volume<T, L>::indexToVoxel(const vec3i &i) const
 {
     vec3d v(0.0, 0.0, 0.0);
     indexToVoxel(i, v);
@@ -377,9 +503,9 @@ Volume<T>::indexToVoxel(const vec3i &i) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::indexToLocal(const vec3i &i, vec3d &l) const
+Volume<T, L>::indexToLocal(const vec3i &i, vec3d &l) const
 {
     vec3d v = indexToVoxel(i);
     voxelToLocal(v, l);
@@ -387,9 +513,9 @@ Volume<T>::indexToLocal(const vec3i &i, vec3d &l) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline vec3d
-Volume<T>::indexToLocal(const vec3i &i) const
+Volume<T, L>::indexToLocal(const vec3i &i) const
 {
     vec3d v = indexToVoxel(i);
     return voxelToLocal(v);
@@ -397,27 +523,27 @@ Volume<T>::indexToLocal(const vec3i &i) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline AttributeCollection&
-Volume<T>::getAttributeCollection()
+Volume<T, L>::getAttributeCollection()
 {
     return m_attributes;
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline const AttributeCollection&
-Volume<T>::getAttributeCollection() const
+Volume<T, L>::getAttributeCollection() const
 {
     return m_attributes;
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::read(std::istream &is)
+Volume<T, L>::read(std::istream &is, size_t num_threads)
 {
     // read in the type.
     String type_name;
@@ -435,86 +561,193 @@ Volume<T>::read(std::istream &is)
     m_local_xform.read(is);
 
     // read in the tree.
-    m_tree.read(is);
+    m_tree.read(is, num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline void
+Volume<T, L>::read(std::istream &is, const signed_index_bounds &roi)
+{
+    // read in the type.
+    String type_name;
+    type_name.read(is);
+
+    // Make sure we have the right type.
+    if (type_name != typeName()) {
+        THROW(Iex::TypeExc, "Invalid volume type.");
+    }
+
+    // read in the attributes and the local xform.
+    m_attributes.read(is);
+    m_local_xform.read(is);
+
+    // read in the part of the tree.
+    m_tree.read(is, roi);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::setName(String &name)
+Volume<T, L>::setName(String &name)
 {
     m_attributes.insert(kVolumeNameAttr, StringAttribute(name));
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline String
-Volume<T>::getName()
+Volume<T, L>::getName()
 {
     return m_attributes.value<String>(kVolumeNameAttr);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline const String&
-Volume<T>::getName() const
+Volume<T, L>::getName() const
 {
     return m_attributes.value<String>(kVolumeNameAttr);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::setDescription(String &description)
+Volume<T, L>::setDescription(String &description)
 {
     m_attributes.insert(kVolumeDescAttr, StringAttribute(description));
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline String
-Volume<T>::getDescription()
+Volume<T, L>::getDescription()
 {
     return m_attributes.value<String>(kVolumeDescAttr);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline const String&
-Volume<T>::getDescription() const
+Volume<T, L>::getDescription() const
 {
     return m_attributes.value<String>(kVolumeDescAttr);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
+inline void
+Volume<T, L>::setCompression(HDF5Filter filter, i32 level)
+{
+    m_attributes.insert(kVolumeCompressionAttr, 
+                        StringAttribute(filterName(filter)));
+    m_attributes.insert(kVolumeCompressionLevelAttr, Int32Attribute(level));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline HDF5Compression
+Volume<T, L>::getCompression() const
+{
+    HDF5Compression compression;
+
+    StringAttribute::shared_ptr filter = 
+        m_attributes.findTypedAttribute<StringAttribute>(
+            kVolumeCompressionAttr);
+    if (filter) {
+        compression.filter = filterFromName(filter->value());
+    }
+
+    Int32Attribute::shared_ptr level = 
+        m_attributes.findTypedAttribute<Int32Attribute>(
+            kVolumeCompressionLevelAttr);
+    if (level) {
+        compression.level = level->value();
+    }
+
+    return compression;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
 inline void
-Volume<T>::read(HDF5Id file_id, String volume_name)
+Volume<T, L>::read(HDF5Id file_id, String volume_name, size_t num_threads)
 {
     HDF5Group volume_root_group;
     HDF5Group::getRootGroup(file_id, kVolumeRootGroup, volume_root_group);
 
-    readVolume(volume_root_group.id(), volume_name);
+    readVolume(volume_root_group.id(), volume_name, false, 0, NULL, 
+               num_threads);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::read(HDF5Id file_id, u32 index)
+Volume<T, L>::read(HDF5Id file_id, String volume_name, 
+                   const signed_index_bounds &roi)
 {
     HDF5Group volume_root_group;
     HDF5Group::getRootGroup(file_id, kVolumeRootGroup, volume_root_group);
 
+    readVolume(volume_root_group.id(), volume_name, false, 0, &roi);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline void
+Volume<T, L>::read(HDF5Id file_id, u32 index, size_t num_threads)
+{
+    HDF5Group volume_root_group;
+    HDF5Group::getRootGroup(file_id, kVolumeRootGroup, volume_root_group);
+
+    // now read in this volume by name
+    String volume_name = volumeName(volume_root_group.id(), index);
+    readVolume(volume_root_group.id(), volume_name, false, 0, NULL, 
+               num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline void
+Volume<T, L>::readLazy(HDF5Id file_id, size_t memory_budget, u32 index)
+{
+    HDF5Group volume_root_group;
+    HDF5Group::getRootGroup(file_id, kVolumeRootGroup, volume_root_group);
+
+    String volume_name = volumeName(volume_root_group.id(), index);
+    readVolume(volume_root_group.id(), volume_name, true, memory_budget);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline CellPagerStats
+Volume<T, L>::getPagerStats() const
+{
+    return m_tree.getPagerStats();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline String
+Volume<T, L>::volumeName(HDF5Id volume_root_group_id, u32 index)
+{
     // get the size of the volume group name
-    u32 size = H5Lget_name_by_idx(volume_root_group.id(), ".",
+    u32 size = H5Lget_name_by_idx(volume_root_group_id, ".",
                                   H5_INDEX_CRT_ORDER,
                                   H5_ITER_INC,
                                   index,
@@ -528,7 +761,7 @@ Volume<T>::read(HDF5Id file_id, u32 index)
 
     // get the name of the link at index
     char buf[size];
-    H5Lget_name_by_idx(volume_root_group.id(), ".",
+    H5Lget_name_by_idx(volume_root_group_id, ".",
                        H5_INDEX_CRT_ORDER,
                        H5_ITER_INC,
                        index,
@@ -536,17 +769,14 @@ Volume<T>::read(HDF5Id file_id, u32 index)
                        size,
                        H5P_DEFAULT);
     
-    String volume_name(buf);
-    
-    // now read in this volume by name
-    readVolume(volume_root_group.id(), volume_name);
+    return String(buf);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::write(std::ostream &os) const
+Volume<T, L>::write(std::ostream &os) const
 {
     // write out the type of the volume.
     String type_name = typeName();
@@ -564,9 +794,53 @@ Volume<T>::write(std::ostream &os) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
+inline void
+Volume<T, L>::writeNative(std::ostream &os, size_t num_threads) const
+{
+    // the type, attributes and local xform are kept as metadata
+    std::ostringstream metadata;
+    String type_name = typeName();
+    type_name.write(metadata);
+    m_attributes.write(metadata);
+    m_local_xform.write(metadata);
+
+    // write out the tree.
+    m_tree.writeNative(os, metadata.str(), num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline void
+Volume<T, L>::map(const String &file_path)
+{
+    MappedFile::shared_ptr file(new MappedFile(file_path));
+    MappedLeafTable<T> table(file);
+
+    // read in the metadata.
+    std::istringstream metadata(table.metadata());
+    String type_name;
+    type_name.read(metadata);
+
+    // Make sure we have the right type.
+    if (type_name != typeName()) {
+        THROW(Iex::TypeExc, "Invalid volume type.");
+    }
+
+    m_attributes.read(metadata);
+    m_local_xform.read(metadata);
+
+    // build the tree over the mapped file.
+    m_tree.map(table);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
 inline void
-Volume<T>::write(HDF5Id file_id) const
+Volume<T, L>::write(HDF5Id file_id, HDF5Layout layout, 
+                    size_t num_threads) const
 {
     // a volume root group is needed in order to allow random access to
     // groups by creation index. We can't set this index creation property
@@ -582,14 +856,14 @@ Volume<T>::write(HDF5Id file_id) const
         m_attributes.value<const String>(kVolumeNameAttr);
 
     // write the volume
-    writeVolume(volume_root_group.id(), volume_name); 
+    writeVolume(volume_root_group.id(), volume_name, layout, num_threads);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline bool
-Volume<T>::operator==(const Volume<T> &that) const
+Volume<T, L>::operator==(const Volume<T, L> &that) const
 {
     if ((m_local_xform != that.m_local_xform) ||
         (m_attributes != that.m_attributes)   ||
@@ -602,27 +876,129 @@ Volume<T>::operator==(const Volume<T> &that) const
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline bool
-Volume<T>::operator!=(const Volume<T> &that) const
+Volume<T, L>::operator!=(const Volume<T, L> &that) const
 {
     return !(operator==(that));
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
-inline typename Volume<T>::set_iterator
-Volume<T>::setIterator() const
+template <typename T, typename L>
+inline typename Volume<T, L>::set_iterator
+Volume<T, L>::setIterator() const
 {
     return set_iterator(this);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
+inline typename Volume<T, L>::accessor
+Volume<T, L>::getAccessor()
+{
+    return m_tree.getAccessor();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline typename Volume<T, L>::const_accessor
+Volume<T, L>::getAccessor() const
+{
+    return m_tree.getAccessor();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+template <typename Functor>
+inline std::vector<Functor>
+Volume<T, L>::parallelForEachLeaf(const Functor &f, size_t num_threads)
+{
+    return m_tree.parallelForEachLeaf(f, num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+template <typename Functor>
+inline std::vector<Functor>
+Volume<T, L>::parallelForEach(const Functor &f, size_t num_threads)
+{
+    return m_tree.parallelForEach(f, num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+template <typename Functor>
+inline std::vector<Functor>
+Volume<T, L>::parallelForEachLeaf(const Functor &f, size_t num_threads) const
+{
+    return m_tree.parallelForEachLeaf(f, num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+template <typename Functor>
+inline std::vector<Functor>
+Volume<T, L>::parallelForEach(const Functor &f, size_t num_threads) const
+{
+    return m_tree.parallelForEach(f, num_threads);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
+inline void
+Volume<T, L>::writeIncremental(HDF5Id file_id)
+{
+    HDF5Group volume_root_group;
+    HDF5Group::getOrCreateRootGroup(file_id, kVolumeRootGroup, 
+                                    volume_root_group);
+
+    const String volume_name = 
+        m_attributes.value<const String>(kVolumeNameAttr);
+
+    HDF5Group volume_group;
+    volume_group.open(volume_root_group.id(), volume_name);
+
+    // leaf tables are written as a whole, start over with leaf groups
+    if (volume_group.isValid() && 
+        H5Aexists(volume_group.id(), kLayoutVersionAttr.c_str()) > 0) {
+        volume_group.close();
+        HDF5Group::deleteSubtree(volume_root_group.id(), volume_name.c_str(),
+                                 NULL, NULL);
+    }
+
+    if (volume_group.isValid()) {
+        // attributes removed since have to go as well
+        HDF5Group user_attr_group;
+        user_attr_group.open(volume_group.id(), kUserAttrGroup);
+        if (user_attr_group.isValid()) {
+            user_attr_group.close();
+            HDF5Group::deleteSubtree(volume_group.id(), 
+                                     kUserAttrGroup.c_str(), NULL, NULL);
+        }
+    } else {
+        volume_group.create(volume_root_group.id(), volume_name);
+    }
+
+    m_attributes.write(volume_group.id());
+    m_local_xform.write(volume_group.id());
+
+    // rewrite the modified leaves, all of them into a new group
+    m_tree.writeIncremental(volume_group.id());
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T, typename L>
 inline void
-Volume<T>::createDefaultAttributes()
+Volume<T, L>::createDefaultAttributes()
 {
     m_attributes.insert(kVolumeNameAttr, StringAttribute("unknown"));
     m_attributes.insert(kVolumeDescAttr, StringAttribute(""));
@@ -630,9 +1006,12 @@ Volume<T>::createDefaultAttributes()
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::readVolume(HDF5Id volume_root_group_id, String &volume_name)
+Volume<T, L>::readVolume(HDF5Id volume_root_group_id, String &volume_name,
+                         bool lazy, size_t memory_budget,
+                         const signed_index_bounds *roi, 
+                         size_t num_threads)
 {
     // read in the volume group 
     HDF5Group volume_group;
@@ -648,15 +1027,22 @@ Volume<T>::readVolume(HDF5Id volume_root_group_id, String &volume_name)
     m_attributes.read(volume_group.id());
     
     // read in the leaves and construct the tree
-    m_tree.read(volume_group.id());
+    if (lazy) {
+        m_tree.readLazy(volume_group.id(), memory_budget);
+    } else if (roi) {
+        m_tree.read(volume_group.id(), *roi);
+    } else {
+        m_tree.read(volume_group.id(), num_threads);
+    }
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::writeVolume(HDF5Id volume_root_group_id, 
-                       const String &volume_name) const
+Volume<T, L>::writeVolume(HDF5Id volume_root_group_id, 
+                       const String &volume_name, HDF5Layout layout,
+                       size_t num_threads) const
 {
     // check if a group for the volume exists by attempting to open
     HDF5Group volume_group;
@@ -683,33 +1069,33 @@ Volume<T>::writeVolume(HDF5Id volume_root_group_id,
     m_local_xform.write(volume_group.id());
 
     // write out the tree
-    m_tree.write(volume_group.id());
+    m_tree.write(volume_group.id(), layout, getCompression(), num_threads);
 }
 
 //------------------------------------------------------------------------------
 // set_iterator implementation
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline
-Volume<T>::set_iterator::set_iterator(const_volume_pointer volume) : 
+Volume<T, L>::set_iterator::set_iterator(const_volume_pointer volume) : 
     m_tree_set_iterator(volume->m_tree.setIterator())
 {
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline
-Volume<T>::set_iterator::~set_iterator()
+Volume<T, L>::set_iterator::~set_iterator()
 {
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::set_iterator::getCoordinates(signed_index_type &i, 
+Volume<T, L>::set_iterator::getCoordinates(signed_index_type &i, 
                                         signed_index_type &j, 
                                         signed_index_type &k) const
 {
@@ -718,27 +1104,27 @@ Volume<T>::set_iterator::getCoordinates(signed_index_type &i,
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline void
-Volume<T>::set_iterator::getCoordinates(signed_index_vec &coords) const
+Volume<T, L>::set_iterator::getCoordinates(signed_index_vec &coords) const
 {
     getCoordinates(coords[0], coords[1], coords[2]);
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
-inline typename Volume<T>::const_reference
-Volume<T>::set_iterator::operator*() const
+template <typename T, typename L>
+inline typename Volume<T, L>::const_reference
+Volume<T, L>::set_iterator::operator*() const
 {
     return *m_tree_set_iterator;
 }
 
 //------------------------------------------------------------------------------
 
-template <typename T>
-inline typename Volume<T>::set_iterator&
-Volume<T>::set_iterator::operator++()
+template <typename T, typename L>
+inline typename Volume<T, L>::set_iterator&
+Volume<T, L>::set_iterator::operator++()
 {
     ++m_tree_set_iterator;
     return *this;
@@ -746,9 +1132,9 @@ Volume<T>::set_iterator::operator++()
 
 //------------------------------------------------------------------------------
 
-template <typename T>
+template <typename T, typename L>
 inline bool
-Volume<T>::set_iterator::operator()() const
+Volume<T, L>::set_iterator::operator()() const
 {
     return m_tree_set_iterator();
 }
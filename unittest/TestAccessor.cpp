@@ -0,0 +1,459 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// TestAccessor.cpp
+//------------------------------------------------------------------------------
+
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <nkbase/BinaryOps.h>
+#include <nkhive/volume/Volume.h>
+
+//-----------------------------------------------------------------------------
+// types
+//-----------------------------------------------------------------------------
+
+template <typename T>
+struct AccessorAddOp
+{
+    T operator()(const T &a, const T &b) const 
+    { 
+        return a + b; 
+    }
+};
+
+//-----------------------------------------------------------------------------
+// interface declaration
+//-----------------------------------------------------------------------------
+
+template <typename T>
+class TestAccessor : public CppUnit::TestFixture 
+{
+    CPPUNIT_TEST_SUITE(TestAccessor);
+    CPPUNIT_TEST(testGet);
+    CPPUNIT_TEST(testSet);
+    CPPUNIT_TEST(testUpdate);
+    CPPUNIT_TEST(testUnset);
+    CPPUNIT_TEST(testGrow);
+    CPPUNIT_TEST(testIsCached);
+    CPPUNIT_TEST(testGetBlock);
+    CPPUNIT_TEST(testUpdateBlock);
+    CPPUNIT_TEST_SUITE_END();
+    
+public:
+    void setUp() {}
+    void tearDown() {}
+    
+    void testGet();
+    void testSet();
+    void testUpdate();
+    void testUnset();
+    void testGrow();
+    void testIsCached();
+    void testGetBlock();
+    void testUpdateBlock();
+
+private:
+
+    /**
+     * Deterministic pseudo random coordinate in [-range, range).
+     */
+    static NKHIVE_NS::signed_index_type random(NK_NS::u32 &seed, 
+                                               NK_NS::i32 range);
+};
+
+//-----------------------------------------------------------------------------
+// test suite registration
+//-----------------------------------------------------------------------------
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestAccessor<float>);
+CPPUNIT_TEST_SUITE_REGISTRATION(TestAccessor<double>);
+CPPUNIT_TEST_SUITE_REGISTRATION(TestAccessor<int32_t>);
+
+//------------------------------------------------------------------------------
+// tests
+//------------------------------------------------------------------------------
+
+template <typename T>
+NKHIVE_NS::signed_index_type
+TestAccessor<T>::random(NK_NS::u32 &seed, NK_NS::i32 range)
+{
+    seed = seed * 1664525u + 1013904223u;
+    return NK_NS::i32((seed >> 8) % NK_NS::u32(2 * range)) - range;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestAccessor<T>::testGet()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Volume<T> volume(2, 2, T(1));
+
+    // scatter values over all quadrants
+    u32 seed = 1;
+    for (int n = 0; n < 500; ++n) {
+        i32 i = random(seed, 40);
+        i32 j = random(seed, 40);
+        i32 k = random(seed, 40);
+        volume.set(i, j, k, T(i + 2 * j + 3 * k));
+    }
+    volume.set(300, -200, 100, T(7));
+
+    // sweep through the region, every value has to match the tree
+    const Volume<T> &const_volume = volume;
+    typename Volume<T>::const_accessor acc = const_volume.getAccessor();
+    for (i32 k = -42; k < 42; ++k) {
+        for (i32 j = -42; j < 42; ++j) {
+            for (i32 i = -42; i < 42; ++i) {
+                CPPUNIT_ASSERT(acc.get(i, j, k) == volume.get(i, j, k));
+            }
+        }
+    }
+
+    // random access jumps between cells and quadrants
+    seed = 7;
+    for (int n = 0; n < 10000; ++n) {
+        signed_index_vec c(random(seed, 48), random(seed, 48), 
+                           random(seed, 48));
+        CPPUNIT_ASSERT(acc.get(c) == volume.get(c));
+    }
+
+    // out of bounds values return the default
+    CPPUNIT_ASSERT(acc.get(300, -200, 100) == T(7));
+    CPPUNIT_ASSERT(acc.get(100000, 0, 0) == T(1));
+    CPPUNIT_ASSERT(acc.get(0, -100000, 0) == T(1));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestAccessor<T>::testSet()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Volume<T> expected(2, 2, T(0));
+    Volume<T> volume(2, 2, T(0));
+    typename Volume<T>::accessor acc = volume.getAccessor();
+
+    // stencil like writes
+    for (i32 k = -9; k < 9; ++k) {
+        for (i32 j = -9; j < 9; ++j) {
+            for (i32 i = -9; i < 9; ++i) {
+                expected.set(i, j, k, T(i * j - k));
+                acc.set(i, j, k, T(i * j - k));
+            }
+        }
+    }
+
+    // random writes
+    u32 seed = 3;
+    for (int n = 0; n < 2000; ++n) {
+        signed_index_vec c(random(seed, 100), random(seed, 100), 
+                           random(seed, 100));
+        expected.set(c, T(n));
+        acc.set(c, T(n));
+    }
+
+    CPPUNIT_ASSERT(volume == expected);
+
+    // reading back through the same accessor sees the writes
+    seed = 3;
+    for (int n = 0; n < 2000; ++n) {
+        signed_index_vec c(random(seed, 100), random(seed, 100), 
+                           random(seed, 100));
+        CPPUNIT_ASSERT(acc.get(c) == expected.get(c));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestAccessor<T>::testUpdate()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Volume<T> expected(2, 2, T(1));
+    Volume<T> volume(2, 2, T(1));
+    typename Volume<T>::accessor acc = volume.getAccessor();
+
+    u32 seed = 11;
+    for (int n = 0; n < 5000; ++n) {
+        signed_index_vec c(random(seed, 12), random(seed, 12), 
+                           random(seed, 12));
+        expected.update(c, T(2), AccessorAddOp<T>());
+        acc.update(c, T(2), AccessorAddOp<T>());
+    }
+
+    CPPUNIT_ASSERT(volume == expected);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestAccessor<T>::testUnset()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Volume<T> volume(2, 2, T(0));
+    typename Volume<T>::accessor acc = volume.getAccessor();
+
+    acc.set(1, 1, 1, T(5));
+    acc.set(2, 1, 1, T(6));
+    CPPUNIT_ASSERT(acc.get(1, 1, 1) == T(5));
+
+    // unsetting the last value removes the cell from the tree
+    acc.unset(1, 1, 1);
+    CPPUNIT_ASSERT(acc.get(1, 1, 1) == T(0));
+    CPPUNIT_ASSERT(acc.get(2, 1, 1) == T(6));
+    acc.unset(signed_index_vec(2, 1, 1));
+    CPPUNIT_ASSERT(acc.get(2, 1, 1) == T(0));
+    CPPUNIT_ASSERT(volume.isEmpty());
+
+    // writes after the cell was dropped recreate it
+    acc.set(2, 1, 1, T(3));
+    CPPUNIT_ASSERT(volume.get(2, 1, 1) == T(3));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestAccessor<T>::testGrow()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Volume<T> volume(2, 2, T(0));
+    typename Volume<T>::accessor acc = volume.getAccessor();
+
+    // grow an empty quadrant
+    acc.set(1000, 1000, 1000, T(1));
+    CPPUNIT_ASSERT(acc.get(1000, 1000, 1000) == T(1));
+
+    // grow a quadrant with values in it
+    acc.set(0, 0, 0, T(2));
+    acc.set(-1, -1, -1, T(3));
+    acc.set(5000, 0, 0, T(4));
+    acc.set(-5000, -1, -1, T(5));
+
+    CPPUNIT_ASSERT(acc.get(1000, 1000, 1000) == T(1));
+    CPPUNIT_ASSERT(acc.get(0, 0, 0) == T(2));
+    CPPUNIT_ASSERT(acc.get(-1, -1, -1) == T(3));
+    CPPUNIT_ASSERT(acc.get(5000, 0, 0) == T(4));
+    CPPUNIT_ASSERT(acc.get(-5000, -1, -1) == T(5));
+
+    CPPUNIT_ASSERT(volume.get(1000, 1000, 1000) == T(1));
+    CPPUNIT_ASSERT(volume.get(0, 0, 0) == T(2));
+    CPPUNIT_ASSERT(volume.get(-1, -1, -1) == T(3));
+    CPPUNIT_ASSERT(volume.get(5000, 0, 0) == T(4));
+    CPPUNIT_ASSERT(volume.get(-5000, -1, -1) == T(5));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestAccessor<T>::testIsCached()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Volume<T> volume(2, 2, T(0));
+    typename Volume<T>::accessor acc = volume.getAccessor();
+
+    // nothing cached yet
+    CPPUNIT_ASSERT(!acc.isCached(0, 0, 0));
+
+    // cells are 4^3, positive quadrant cell at the origin
+    acc.set(1, 1, 1, T(1));
+    CPPUNIT_ASSERT(acc.isCached(0, 0, 0));
+    CPPUNIT_ASSERT(acc.isCached(3, 3, 3));
+    CPPUNIT_ASSERT(!acc.isCached(4, 0, 0));
+    CPPUNIT_ASSERT(!acc.isCached(-1, 0, 0));
+
+    // negative quadrant cells start at -1
+    acc.get(-2, -2, -2);
+    CPPUNIT_ASSERT(!acc.isCached(-2, -2, -2));
+    acc.set(-2, -2, -2, T(1));
+    CPPUNIT_ASSERT(acc.isCached(-1, -1, -1));
+    CPPUNIT_ASSERT(acc.isCached(-4, -4, -4));
+    CPPUNIT_ASSERT(!acc.isCached(-5, -1, -1));
+    CPPUNIT_ASSERT(!acc.isCached(1, 1, 1));
+
+    // clearing drops the cache
+    acc.clear();
+    CPPUNIT_ASSERT(!acc.isCached(-1, -1, -1));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestAccessor<T>::testGetBlock()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    // random values, a filled cell and a pruned fill node
+    Volume<T> volume(1, 2, T(1));
+    u32 seed = 5;
+    for (int n = 0; n < 800; ++n) {
+        i32 i = random(seed, 12);
+        i32 j = random(seed, 12);
+        i32 k = random(seed, 12);
+        volume.set(i, j, k, T(i - 2 * j + 3 * k));
+    }
+    for (i32 k = 16; k < 24; ++k) {
+        for (i32 j = -24; j < -16; ++j) {
+            for (i32 i = 16; i < 24; ++i) {
+                volume.set(i, j, k, T(9));
+            }
+        }
+    }
+    volume.prune();
+    for (i32 k = -8; k < -4; ++k) {
+        for (i32 j = 4; j < 8; ++j) {
+            for (i32 i = -8; i < -4; ++i) {
+                volume.set(i, j, k, T(4));
+            }
+        }
+    }
+
+    // blocks inside a cell, stitched across cells and larger than a cell,
+    // compared voxel by voxel with the tree
+    const index_type sizes[] = { 1, 2, 4, 7 };
+    std::vector<T> block(7 * 7 * 7);
+    seed = 9;
+    for (int n = 0; n < 400; ++n) {
+        index_vec size(sizes[n % 4], sizes[(n / 4) % 4], sizes[n % 3]);
+        signed_index_vec min(random(seed, 26), random(seed, 26), 
+                             random(seed, 26));
+        volume.getBlock(min, size, &block[0]);
+
+        for (index_type k = 0; k < size.z; ++k) {
+            for (index_type j = 0; j < size.y; ++j) {
+                for (index_type i = 0; i < size.x; ++i) {
+                    T expected = volume.get(min.x + i32(i), min.y + i32(j), 
+                                            min.z + i32(k));
+                    T value = block[i + size.x * (j + size.y * k)];
+                    CPPUNIT_ASSERT(value == expected);
+                }
+            }
+        }
+    }
+
+    // morton ordered cells read back the same
+    Volume<T, MortonLayout> morton(1, 2, T(0));
+    for (i32 k = -3; k < 3; ++k) {
+        for (i32 j = -3; j < 3; ++j) {
+            for (i32 i = -3; i < 3; ++i) {
+                morton.set(i, j, k, T(i + 6 * j + 36 * k));
+            }
+        }
+    }
+    morton.getBlock(signed_index_vec(-3, -3, -3), index_vec(6), &block[0]);
+    for (i32 k = -3; k < 3; ++k) {
+        for (i32 j = -3; j < 3; ++j) {
+            for (i32 i = -3; i < 3; ++i) {
+                CPPUNIT_ASSERT(block[(i + 3) + 6 * ((j + 3) + 6 * (k + 3))] ==
+                               T(i + 6 * j + 36 * k));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestAccessor<T>::testUpdateBlock()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    // start with a fill node to split and one to leave untouched
+    Volume<T> expected(1, 2, T(1));
+    Volume<T> volume(1, 2, T(1));
+    for (i32 k = 0; k < 16; ++k) {
+        for (i32 j = 0; j < 16; ++j) {
+            for (i32 i = 0; i < 16; ++i) {
+                expected.set(i, j, k, T(3));
+                volume.set(i, j, k, T(3));
+            }
+        }
+    }
+    expected.prune();
+    volume.prune();
+
+    std::vector<T> vals(5 * 5 * 5);
+    u32 seed = 13;
+    for (int n = 0; n < 300; ++n) {
+        index_vec size(1 + n % 5, 1 + (n / 5) % 5, 1 + (n / 25) % 5);
+        signed_index_vec min(random(seed, 20), random(seed, 20), 
+                             random(seed, 20));
+
+        // adding zero leaves fill nodes and filled cells alone
+        bool zero = (n % 7) == 0;
+        for (size_t v = 0; v < vals.size(); ++v) {
+            vals[v] = zero ? T(0) : T(v % 5);
+        }
+
+        volume.updateBlock(min, size, &vals[0], AccessorAddOp<T>());
+        for (index_type k = 0; k < size.z; ++k) {
+            for (index_type j = 0; j < size.y; ++j) {
+                for (index_type i = 0; i < size.x; ++i) {
+                    expected.update(min.x + i32(i), min.y + i32(j), 
+                                    min.z + i32(k), 
+                                    vals[i + size.x * (j + size.y * k)], 
+                                    AccessorAddOp<T>());
+                }
+            }
+        }
+    }
+
+    CPPUNIT_ASSERT(volume == expected);
+}
+
+//------------------------------------------------------------------------------
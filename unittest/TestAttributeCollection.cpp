@@ -37,6 +37,8 @@
 // includes
 //------------------------------------------------------------------------------
 
+#include <boost/thread/thread.hpp>
+
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -495,6 +497,10 @@ TestAttributeCollection::testIOHDF5()
     // read in the attribute collection
     AttributeCollection c2;
     CPPUNIT_ASSERT_THROW(c2.read(volume_group2.id()), Iex::TypeExc);
+
+    // the failed read leaves the library usable from other threads
+    boost::thread other(&H5garbage_collect);
+    CPPUNIT_ASSERT(other.timed_join(boost::posix_time::seconds(10)));
     
     // Register the three types.
     Attribute::clearAttributeRegistry();
@@ -0,0 +1,327 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// TestBSpline.cpp
+//------------------------------------------------------------------------------
+
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <nkbase/Tolerance.h>
+
+#include <nkhive/interpolation/BSplineInterpolation.h>
+#include <nkhive/interpolation/BSplineSplat.h>
+#include <nkhive/interpolation/ParallelSplatter.h>
+
+//------------------------------------------------------------------------------
+// definitions
+//------------------------------------------------------------------------------
+
+#define TOL_CHECK(v1, v2) \
+    CPPUNIT_ASSERT(fabs(T(v1) - T(v2)) < NK_NS::Tolerance<T>::zero());
+
+//------------------------------------------------------------------------------
+// class definition
+//------------------------------------------------------------------------------
+
+template <typename T>
+class TestBSpline : public CppUnit::TestFixture {
+
+    CPPUNIT_TEST_SUITE(TestBSpline);
+    CPPUNIT_TEST(testWeights);
+    CPPUNIT_TEST(testSplat);
+    CPPUNIT_TEST(testInterp);
+    CPPUNIT_TEST(testParallel);
+    CPPUNIT_TEST_SUITE_END();
+    
+public:
+    void setUp() {}
+    void tearDown() {}
+    
+    void testWeights();
+    void testSplat();
+    void testInterp();
+    void testParallel();
+};
+
+//------------------------------------------------------------------------------
+// test suite registration
+//------------------------------------------------------------------------------
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestBSpline<float>);
+CPPUNIT_TEST_SUITE_REGISTRATION(TestBSpline<double>);
+
+//------------------------------------------------------------------------------
+// class implementation
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestBSpline<T>::testWeights()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef BSplineSamplingUtil<T, 2> quadratic_type;
+    typedef BSplineSamplingUtil<T, 3> cubic_type;
+    typedef typename quadratic_type::calc_type calc_type;
+
+    // weights at the voxel centers
+    calc_type q[3];
+    quadratic_type::evaluate(calc_type(0.5), q);
+    TOL_CHECK(q[0], 0.125);
+    TOL_CHECK(q[1], 0.75);
+    TOL_CHECK(q[2], 0.125);
+
+    calc_type c[4];
+    cubic_type::evaluate(calc_type(0), c);
+    TOL_CHECK(c[0], 1.0 / 6.0);
+    TOL_CHECK(c[1], 2.0 / 3.0);
+    TOL_CHECK(c[2], 1.0 / 6.0);
+    TOL_CHECK(c[3], 0);
+
+    // partition of unity
+    for (i32 n = 0; n < 16; ++n) {
+        calc_type t = calc_type(n) / calc_type(16);
+        quadratic_type::evaluate(t, q);
+        cubic_type::evaluate(t, c);
+        TOL_CHECK(q[0] + q[1] + q[2], 1);
+        TOL_CHECK(c[0] + c[1] + c[2] + c[3], 1);
+    }
+
+    // index bounds, and the table staying close to the polynomials
+    quadratic_type exact;
+    quadratic_type table(true);
+    CPPUNIT_ASSERT(!exact.usesTable());
+    CPPUNIT_ASSERT(table.usesTable());
+
+    vec3d coords(0.3, -0.2, 5.9);
+    vec3d kernel_offset(0.5);
+    vec3i min_exact, min_table;
+    calc_type w_exact[3][3], w_table[3][3];
+    exact.computeWeights(coords, kernel_offset, min_exact, w_exact);
+    table.computeWeights(coords, kernel_offset, min_table, w_table);
+
+    CPPUNIT_ASSERT(min_exact == vec3i(-1, -2, 4));
+    CPPUNIT_ASSERT(min_table == min_exact);
+    for (i32 axis = 0; axis < 3; ++axis) {
+        for (i32 tap = 0; tap < 3; ++tap) {
+            CPPUNIT_ASSERT(fabs(w_exact[axis][tap] - w_table[axis][tap]) < 
+                           0.01);
+        }
+    }
+
+    cubic_type cubic;
+    vec3i min_cubic;
+    calc_type w_cubic[3][4];
+    cubic.computeWeights(coords, kernel_offset, min_cubic, w_cubic);
+    CPPUNIT_ASSERT(min_cubic == vec3i(-2, -2, 4));
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestBSpline<T>::testSplat()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    T default_val(0); 
+    vec3d res(1.0);
+    vec3d kernel_offset(0.5);
+
+    // quadratic splat at a voxel center covers the 27 voxels around it
+    {
+        typename Volume<T>::shared_ptr volume(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+        QuadraticSplat<T> splatter(volume);
+        splatter.splat(0.5, 0.5, 0.5, T(1));
+
+        TOL_CHECK(volume->get(0, 0, 0), 0.75 * 0.75 * 0.75);
+        TOL_CHECK(volume->get(1, 0, 0), 0.125 * 0.75 * 0.75);
+        TOL_CHECK(volume->get(0, -1, 0), 0.125 * 0.75 * 0.75);
+        TOL_CHECK(volume->get(-1, 1, -1), 0.125 * 0.125 * 0.125);
+        TOL_CHECK(volume->get(2, 0, 0), 0);
+        TOL_CHECK(volume->get(0, 0, -2), 0);
+    }
+
+    // cubic splat at a voxel center, the far tap gets nothing
+    {
+        typename Volume<T>::shared_ptr volume(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+        CubicBSplineSplat<T> splatter(volume);
+        splatter.splat(0.5, 0.5, 0.5, T(1));
+
+        double c = 2.0 / 3.0;
+        TOL_CHECK(volume->get(0, 0, 0), c * c * c);
+        TOL_CHECK(volume->get(-1, 0, 0), c * c / 6.0);
+        TOL_CHECK(volume->get(1, 1, 0), c / 36.0);
+        TOL_CHECK(volume->get(2, 0, 0), 0);
+    }
+
+    // summed splats conserve the splatted amount, across cell boundaries
+    {
+        typename Volume<T>::shared_ptr quadratic(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+        typename Volume<T>::shared_ptr cubic(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+        QuadraticSplat<T, std::plus> quadratic_splatter(quadratic);
+        CubicBSplineSplat<T, std::plus> cubic_splatter(cubic, true);
+
+        quadratic_splatter.splat(-0.2, 1.7, 0.05, T(2));
+        quadratic_splatter.splat(-0.1, 1.9, 0.15, T(1));
+        cubic_splatter.splat(-0.2, 1.7, 0.05, T(2));
+        cubic_splatter.splat(-0.1, 1.9, 0.15, T(1));
+
+        double quadratic_sum = 0.0;
+        double cubic_sum = 0.0;
+        for (i32 k = -4; k < 4; ++k) {
+            for (i32 j = -4; j < 6; ++j) {
+                for (i32 i = -4; i < 4; ++i) {
+                    quadratic_sum += quadratic->get(i, j, k);
+                    cubic_sum += cubic->get(i, j, k);
+                }
+            }
+        }
+        TOL_CHECK(quadratic_sum, 3);
+        TOL_CHECK(cubic_sum, 3);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestBSpline<T>::testInterp()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    T default_val(0); 
+    vec3d res(1.0);
+    vec3d kernel_offset(0.5);
+
+    // a linear field over the voxel centers, which B-splines reproduce
+    typename Volume<T>::shared_ptr volume(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+    for (i32 k = -6; k < 6; ++k) {
+        for (i32 j = -6; j < 6; ++j) {
+            for (i32 i = -6; i < 6; ++i) {
+                volume->set(i, j, k, T(0.5 * i - 0.25 * j + 0.125 * k + 1));
+            }
+        }
+    }
+
+    QuadraticInterpolation<T> quadratic(volume);
+    CubicBSplineInterpolation<T> cubic(volume);
+    QuadraticInterpolation<T> quadratic_table(volume, true);
+    CubicBSplineInterpolation<T> cubic_table(volume, true);
+
+    u32 seed = 11;
+    for (i32 n = 0; n < 50; ++n) {
+        vec3d p;
+        for (i32 axis = 0; axis < 3; ++axis) {
+            seed = seed * 1664525u + 1013904223u;
+            p[axis] = ((seed >> 8) % 10000) / 10000.0 * 6.0 - 3.0;
+        }
+        vec3d u = p - kernel_offset;
+        double expected = 0.5 * u.x - 0.25 * u.y + 0.125 * u.z + 1;
+
+        T result;
+        quadratic.interp(p.x, p.y, p.z, result);
+        CPPUNIT_ASSERT(fabs(result - expected) < 1e-4);
+        cubic.interp(p.x, p.y, p.z, result);
+        CPPUNIT_ASSERT(fabs(result - expected) < 1e-4);
+
+        // the table quantizes positions to 1/256 of a voxel
+        quadratic_table.interp(p.x, p.y, p.z, result);
+        CPPUNIT_ASSERT(fabs(result - expected) < 0.01);
+        cubic_table.interp(p.x, p.y, p.z, result);
+        CPPUNIT_ASSERT(fabs(result - expected) < 0.01);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestBSpline<T>::testParallel()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    T default_val(0); 
+    vec3d res(1.0);
+    vec3d kernel_offset(0.5);
+
+    const size_t count = 3000;
+    std::vector<vec3d> pts(count);
+    std::vector<T> vals(count, T(1));
+    u32 seed = 5;
+    for (size_t n = 0; n < count; ++n) {
+        for (i32 axis = 0; axis < 3; ++axis) {
+            seed = seed * 1664525u + 1013904223u;
+            pts[n][axis] = ((seed >> 8) % 10000) / 10000.0 * 8.0 - 4.0;
+        }
+    }
+
+    typename Volume<T>::shared_ptr serial(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+    typename Volume<T>::shared_ptr parallel(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+
+    // the splat policy carries over to the parallel splatter
+    CubicBSplineSplat<T, std::plus> splatter(serial);
+    for (size_t n = 0; n < count; ++n) {
+        splatter.splat(pts[n].x, pts[n].y, pts[n].z, vals[n]);
+    }
+
+    ParallelSplatter< CubicBSplineSplat<T, std::plus> > parallel_splatter(
+                                                        parallel, T(0), 2);
+    parallel_splatter.splat(&pts[0], &vals[0], count);
+
+    for (i32 k = -6; k < 6; ++k) {
+        for (i32 j = -6; j < 6; ++j) {
+            for (i32 i = -6; i < 6; ++i) {
+                CPPUNIT_ASSERT(fabs(parallel->get(i, j, k) - 
+                                    serial->get(i, j, k)) < 1e-3);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
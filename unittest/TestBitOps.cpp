@@ -33,6 +33,8 @@
 // TestBitOps.cpp
 //------------------------------------------------------------------------------
 
+#include <vector>
+
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -47,6 +49,8 @@ class TestBitFieldOps : public CppUnit::TestFixture {
     CPPUNIT_TEST(testGetBitMaskFilled);
     CPPUNIT_TEST(testNumBits3D);
     CPPUNIT_TEST(testGetIndex);
+    CPPUNIT_TEST(testGetMortonKey);
+    CPPUNIT_TEST(testGetMortonIndex);
     CPPUNIT_TEST(testModulo);
     CPPUNIT_TEST(testGetBitCount);
     CPPUNIT_TEST(testIsPow2);
@@ -57,6 +61,9 @@ class TestBitFieldOps : public CppUnit::TestFixture {
     CPPUNIT_TEST(testAbs);
     CPPUNIT_TEST(testGetFirstSetBitIndex);
     CPPUNIT_TEST(testGetLastSetBitIndex);
+    CPPUNIT_TEST(testGetNthSetBitIndex);
+    CPPUNIT_TEST(testGetBitCountArray);
+    CPPUNIT_TEST(testPortableBitOps);
     CPPUNIT_TEST_SUITE_END();
     
 public:
@@ -69,6 +76,8 @@ public:
     void testGetBitMaskFilled();
     void testNumBits3D();
     void testGetIndex();
+    void testGetMortonKey();
+    void testGetMortonIndex();
     void testModulo();
     void testGetBitCount();
     void testIsPow2();
@@ -79,6 +88,9 @@ public:
     void testAbs();
     void testGetFirstSetBitIndex();
     void testGetLastSetBitIndex();
+    void testGetNthSetBitIndex();
+    void testGetBitCountArray();
+    void testPortableBitOps();
 };
 
 //------------------------------------------------------------------------------
@@ -212,6 +224,74 @@ TestBitFieldOps::testGetIndex()
 
 //------------------------------------------------------------------------------
 
+void 
+TestBitFieldOps::testGetMortonKey()
+{
+    USING_NKHIVE_NS
+
+    CPPUNIT_ASSERT(getMortonKey(0, 0, 0) == 0);
+    CPPUNIT_ASSERT(getMortonKey(1, 0, 0) == 1);
+    CPPUNIT_ASSERT(getMortonKey(0, 1, 0) == 2);
+    CPPUNIT_ASSERT(getMortonKey(0, 0, 1) == 4);
+    CPPUNIT_ASSERT(getMortonKey(2, 0, 0) == 8);
+    CPPUNIT_ASSERT(getMortonKey(3, 5, 6) == 427);
+
+    // only the low 21 bits take part
+    CPPUNIT_ASSERT(getMortonKey(0x1fffff, 0, 0) == 0x1249249249249249ULL);
+    CPPUNIT_ASSERT(getMortonKey(0x1fffff, 0x1fffff, 0x1fffff) == 
+                   0x7fffffffffffffffULL);
+    CPPUNIT_ASSERT(getMortonKey(0x200001, 0, 0) == 1);
+}
+
+//------------------------------------------------------------------------------
+
+void 
+TestBitFieldOps::testGetMortonIndex()
+{
+    USING_NKHIVE_NS
+
+    CPPUNIT_ASSERT(getMortonIndex(0, 0, 0, 2) == 0);
+    CPPUNIT_ASSERT(getMortonIndex(1, 0, 0, 2) == 1);
+    CPPUNIT_ASSERT(getMortonIndex(0, 1, 0, 2) == 2);
+    CPPUNIT_ASSERT(getMortonIndex(0, 0, 1, 2) == 4);
+    CPPUNIT_ASSERT(getMortonIndex(1, 1, 1, 2) == 7);
+    CPPUNIT_ASSERT(getMortonIndex(2, 0, 0, 2) == 8);
+    CPPUNIT_ASSERT(getMortonIndex(3, 5, 6, 3) == 427);
+
+    // round trip every coordinate of the smaller sizes
+    for (index_type lg = 0; lg < 5; ++lg) {
+        index_type dim = 1 << lg;
+        std::vector<bool> seen(numBits3D(lg), false);
+        for (index_type k = 0; k < dim; ++k) {
+            for (index_type j = 0; j < dim; ++j) {
+                for (index_type i = 0; i < dim; ++i) {
+                    index_type index = getMortonIndex(i, j, k, lg);
+                    CPPUNIT_ASSERT(index < numBits3D(lg));
+                    CPPUNIT_ASSERT(!seen[index]);
+                    seen[index] = true;
+
+                    index_type x, y, z;
+                    getMortonCoordinates(index, lg, x, y, z);
+                    CPPUNIT_ASSERT(x == i && y == j && z == k);
+                }
+            }
+        }
+    }
+
+    // the high byte of each axis goes past the lookup table
+    CPPUNIT_ASSERT(getMortonIndex(1023, 1023, 1023, 10) == 0x3fffffff);
+    CPPUNIT_ASSERT(getMortonIndex(256, 0, 0, 10) == 
+                   index_type(getMortonKey(256, 0, 0)));
+    CPPUNIT_ASSERT(getMortonIndex(513, 300, 1000, 10) == 
+                   index_type(getMortonKey(513, 300, 1000)));
+
+    index_type x, y, z;
+    getMortonCoordinates(getMortonIndex(513, 300, 1000, 10), 10, x, y, z);
+    CPPUNIT_ASSERT(x == 513 && y == 300 && z == 1000);
+}
+
+//------------------------------------------------------------------------------
+
 void 
 TestBitFieldOps::testModulo()
 {
@@ -776,3 +856,97 @@ TestBitFieldOps::testGetLastSetBitIndex()
         CPPUNIT_ASSERT(getLastSetBitIndex<uint64_t>(n) == 48);
     }
 }
+
+//------------------------------------------------------------------------------
+
+void
+TestBitFieldOps::testGetNthSetBitIndex()
+{
+    USING_NKHIVE_NS
+
+    CPPUNIT_ASSERT(getNthSetBitIndex<uint8_t>(0x01, 0) == 0);
+    CPPUNIT_ASSERT(getNthSetBitIndex<uint8_t>(0x80, 0) == 7);
+    CPPUNIT_ASSERT(getNthSetBitIndex<uint8_t>(0x89, 2) == 7);
+
+    CPPUNIT_ASSERT(getNthSetBitIndex<uint16_t>(0x8001, 1) == 15);
+    CPPUNIT_ASSERT(getNthSetBitIndex<uint32_t>(0x80010100, 1) == 16);
+    CPPUNIT_ASSERT(getNthSetBitIndex<uint64_t>(0x8000000000000001ULL, 1) == 
+                   63);
+
+    // every set bit of random values matches a walk of the bits
+    uint64_t seed = 1;
+    for (int n = 0; n < 1000; ++n) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        uint32_t v32 = uint32_t(seed >> 32);
+        uint64_t v64 = seed >> (n % 64);
+
+        index_type si = 0;
+        for (index_type bit = 0; bit < 32; ++bit) {
+            if (v32 & (uint32_t(1) << bit)) {
+                CPPUNIT_ASSERT(getNthSetBitIndex(v32, si++) == bit);
+            }
+        }
+        si = 0;
+        for (index_type bit = 0; bit < 64; ++bit) {
+            if (v64 & (uint64_t(1) << bit)) {
+                CPPUNIT_ASSERT(getNthSetBitIndex(v64, si++) == bit);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestBitFieldOps::testGetBitCountArray()
+{
+    USING_NKHIVE_NS
+
+    index_type v[5] = { 0x00000000, 0xF0000000, 0x0000000F, 0xF00FF00F, 
+                        0x89ABCDEF };
+
+    CPPUNIT_ASSERT(getBitCount<index_type>(v, 0) == 0);
+    CPPUNIT_ASSERT(getBitCount<index_type>(v, 1) == 0);
+    CPPUNIT_ASSERT(getBitCount<index_type>(v, 2) == 4);
+    CPPUNIT_ASSERT(getBitCount<index_type>(v, 4) == 24);
+    CPPUNIT_ASSERT(getBitCount<index_type>(v, 5) == 44);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestBitFieldOps::testPortableBitOps()
+{
+    USING_NKHIVE_NS
+
+    // the selected backend must agree with the portable one
+    uint64_t seed = 1;
+    for (int n = 0; n < 1000; ++n) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        uint8_t  v8  = uint8_t(seed >> 56);
+        uint16_t v16 = uint16_t(seed >> 48);
+        uint32_t v32 = uint32_t(seed >> 32);
+        uint64_t v64 = seed >> (n % 64);
+
+        CPPUNIT_ASSERT(getBitCount(v8)  == getBitCountPortable(v8));
+        CPPUNIT_ASSERT(getBitCount(v16) == getBitCountPortable(v16));
+        CPPUNIT_ASSERT(getBitCount(v32) == getBitCountPortable(v32));
+        CPPUNIT_ASSERT(getBitCount(v64) == getBitCountPortable(v64));
+
+        CPPUNIT_ASSERT(getFirstSetBitIndex(v8) == 
+                       getFirstSetBitIndexPortable(v8));
+        CPPUNIT_ASSERT(getFirstSetBitIndex(v32) == 
+                       getFirstSetBitIndexPortable(v32));
+        CPPUNIT_ASSERT(getFirstSetBitIndex(v64) == 
+                       getFirstSetBitIndexPortable(v64));
+
+        CPPUNIT_ASSERT(getLastSetBitIndex(v8) == 
+                       getLastSetBitIndexPortable(v8));
+        CPPUNIT_ASSERT(getLastSetBitIndex(v32) == 
+                       getLastSetBitIndexPortable(v32));
+        CPPUNIT_ASSERT(getLastSetBitIndex(v64) == 
+                       getLastSetBitIndexPortable(v64));
+    }
+}
@@ -73,9 +73,12 @@ class TestBitField3D : public CppUnit::TestFixture {
     CPPUNIT_TEST(testCount);
     CPPUNIT_TEST(testCountRange);
     CPPUNIT_TEST(testGetSetIndex);
+    CPPUNIT_TEST(testRankDirectory);
+    CPPUNIT_TEST(testBitwiseOperators);
     CPPUNIT_TEST(testIO);
     CPPUNIT_TEST(testIOHDF5);
     CPPUNIT_TEST(testOperatorComparison);
+    CPPUNIT_TEST(testMortonLayout);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -102,9 +105,12 @@ public:
     void testCount();
     void testCountRange();
     void testGetSetIndex();
+    void testRankDirectory();
+    void testBitwiseOperators();
     void testIO();
     void testIOHDF5();
     void testOperatorComparison();
+    void testMortonLayout();
 
 };
 
@@ -949,6 +955,111 @@ TestBitField3D<T>::testGetSetIndex()
 
 //-----------------------------------------------------------------------------
 
+template <typename T>
+void
+TestBitField3D<T>::testRankDirectory() 
+{
+    USING_NKHIVE_NS
+    DEFINE_TYPEDEFS;
+
+    BitField bf(3);
+    for (index_type i = 0; i < 512; i += 3) {
+        bf.setBit(i);
+    }
+    bf.setBit(511);
+
+    BitField ranked(bf);
+    CPPUNIT_ASSERT(!ranked.hasRankDirectory());
+    ranked.buildRankDirectory();
+    CPPUNIT_ASSERT(ranked.hasRankDirectory());
+
+    // ranked queries match the scanning ones
+    CPPUNIT_ASSERT(ranked.count() == bf.count());
+    for (index_type i = 0; i <= 512; ++i) {
+        CPPUNIT_ASSERT(ranked.countRange(i) == bf.countRange(i));
+    }
+    for (index_type si = 0; si < bf.count(); ++si) {
+        CPPUNIT_ASSERT(ranked.getSetIndex(si) == bf.getSetIndex(si));
+    }
+    CPPUNIT_ASSERT(ranked.getSetIndex(bf.count() - 1) == 511);
+
+    // sparse clusters separated by empty blocks select the same bits as a
+    // walk over the field
+    BitField sparse(3);
+    for (index_type i = 0; i < 512; i += 97) {
+        for (index_type j = i; j < i + 21 && j < 512; j += 2) {
+            sparse.setBit(j);
+        }
+    }
+    sparse.buildRankDirectory();
+    index_type si = 0;
+    for (index_type i = 0; i < 512; ++i) {
+        if (sparse.isSet(i)) {
+            CPPUNIT_ASSERT(sparse.getSetIndex(si++) == i);
+        }
+    }
+    CPPUNIT_ASSERT(si == sparse.count());
+
+    // copies keep the directory
+    BitField copy(ranked);
+    CPPUNIT_ASSERT(copy.hasRankDirectory());
+    CPPUNIT_ASSERT(copy.countRange(100) == bf.countRange(100));
+
+    // modifications drop it
+    ranked.unsetBit(0);
+    CPPUNIT_ASSERT(!ranked.hasRankDirectory());
+    CPPUNIT_ASSERT(ranked.countRange(1) == 0);
+    CPPUNIT_ASSERT(ranked.getSetIndex(0) == 3);
+
+    copy.clearBits();
+    CPPUNIT_ASSERT(!copy.hasRankDirectory());
+    CPPUNIT_ASSERT(copy.count() == 0);
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+void
+TestBitField3D<T>::testBitwiseOperators() 
+{
+    DEFINE_TYPEDEFS;
+
+    BitField a(1);
+    BitField b(1);
+    a.setBit(0);
+    a.setBit(2);
+    a.setBit(5);
+    b.setBit(2);
+    b.setBit(3);
+    CPPUNIT_ASSERT(a.toString() == "10100100");
+    CPPUNIT_ASSERT(b.toString() == "00110000");
+
+    BitField c(a);
+    c &= b;
+    CPPUNIT_ASSERT(c.toString() == "00100000");
+
+    c = a;
+    c |= b;
+    CPPUNIT_ASSERT(c.toString() == "10110100");
+
+    c = a;
+    c ^= b;
+    CPPUNIT_ASSERT(c.toString() == "10010100");
+
+    // xor with itself empties, or with the inverse fills
+    c ^= c;
+    CPPUNIT_ASSERT(c.isEmpty());
+
+    c = a;
+    BitField d(a);
+    d.invertBits();
+    c |= d;
+    CPPUNIT_ASSERT(c.isFull());
+    CPPUNIT_ASSERT(c.count() == 8);
+}
+
+//-----------------------------------------------------------------------------
+
 template <typename T>
 void
 TestBitField3D<T>::testIO() 
@@ -1092,3 +1203,75 @@ TestBitField3D<T>::testOperatorComparison()
     CPPUNIT_ASSERT(bf1 == bf2);
 }
 
+//-----------------------------------------------------------------------------
+
+template <typename T>
+void
+TestBitField3D<T>::testMortonLayout() 
+{
+    DEFINE_TYPEDEFS;
+
+    typedef NKHIVE_NS::MortonLayout                         MortonLayout;
+    typedef NKHIVE_NS::BitField3D<T, allocator<T>, MortonLayout> MortonField;
+    typedef typename MortonField::window_iterator        mwindow_iterator;
+
+    BitField bf(3);
+    MortonField mf(3);
+
+    // same coordinates, different indices
+    NKHIVE_NS::index_type coords[][3] = 
+        { {0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {7, 2, 5}, {3, 6, 1}, {7, 7, 7} };
+    for (size_t n = 0; n < sizeof(coords) / sizeof(coords[0]); ++n) {
+        bf.setBit(coords[n][0], coords[n][1], coords[n][2]);
+        mf.setBit(coords[n][0], coords[n][1], coords[n][2]);
+        CPPUNIT_ASSERT(mf.isSet(coords[n][0], coords[n][1], coords[n][2]));
+    }
+    CPPUNIT_ASSERT(mf.count() == bf.count());
+    CPPUNIT_ASSERT(mf.isSet(MortonLayout::getIndex(7, 2, 5, 3)));
+    CPPUNIT_ASSERT(!mf.isSet(7 + 2 * 8 + 5 * 64 + 1));
+
+    // coordinates come back through the layout
+    NKHIVE_NS::index_type i, j, k;
+    mf.getCoordinates(MortonLayout::getIndex(3, 6, 1, 3), i, j, k);
+    CPPUNIT_ASSERT(i == 3 && j == 6 && k == 1);
+
+    // the window walks exactly the window's coordinates
+    mf.fillBits();
+    NKHIVE_NS::index_type b = MortonLayout::getIndex(2, 4, 2, 3);
+    std::vector<bool> seen(NKHIVE_NS::numBits3D(mf.size()), false);
+    size_t visited = 0;
+    for (mwindow_iterator iter = mf.windowIterator(b, 4); iter(); ++iter) {
+        NKHIVE_NS::index_type index = iter.getIndex();
+        CPPUNIT_ASSERT(iter.isSet());
+        CPPUNIT_ASSERT(!seen[index]);
+        seen[index] = true;
+        ++visited;
+
+        mf.getCoordinates(index, i, j, k);
+        CPPUNIT_ASSERT(i >= 2 && i < 6 && j >= 4 && j < 8 && k >= 2 && k < 6);
+    }
+    CPPUNIT_ASSERT(visited == 64);
+
+    // relayout preserves the set coordinates
+    mf.clearBits();
+    mf.relayout(bf);
+    CPPUNIT_ASSERT(mf.count() == bf.count());
+    for (size_t n = 0; n < sizeof(coords) / sizeof(coords[0]); ++n) {
+        CPPUNIT_ASSERT(mf.isSet(coords[n][0], coords[n][1], coords[n][2]));
+    }
+
+    // the stream is row major regardless of the layout
+    std::ostringstream ostr(std::ios_base::binary);
+    mf.write(ostr);
+    std::istringstream istr(ostr.str(), std::ios_base::binary);
+    BitField bfi;
+    bfi.read(istr);
+    CPPUNIT_ASSERT(bfi == bf);
+
+    std::ostringstream ostr2(std::ios_base::binary);
+    bf.write(ostr2);
+    std::istringstream istr2(ostr2.str(), std::ios_base::binary);
+    MortonField mfi;
+    mfi.read(istr2);
+    CPPUNIT_ASSERT(mfi == mf);
+}
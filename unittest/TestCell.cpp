@@ -162,11 +162,15 @@ class TestCell : public CppUnit::TestFixture
     CPPUNIT_TEST(testFill);
     CPPUNIT_TEST(testFillSetUnset);
     CPPUNIT_TEST(testFilledSet);
+    CPPUNIT_TEST(testPrune);
     CPPUNIT_TEST(testIteration);
     CPPUNIT_TEST(testConstIterationFilled);
     CPPUNIT_TEST(testIsEmpty);
     CPPUNIT_TEST(testIO);
     CPPUNIT_TEST(testIOHDF5);
+    CPPUNIT_TEST(testIOLayout);
+    CPPUNIT_TEST(testIOCompacted);
+    CPPUNIT_TEST(testDirty);
     CPPUNIT_TEST(testOperatorComparison);
     CPPUNIT_TEST(testCreateFilledCell);
     CPPUNIT_TEST(testUnsetBlock);
@@ -202,6 +206,7 @@ public:
     void testCompressedCopy();
     void testCompressCopyFilled();
     void testFill();
+    void testPrune();
     void testFillSetUnset();
     void testFilledSet();
     void testIteration();
@@ -209,6 +214,9 @@ public:
     void testIsEmpty();
     void testIO();
     void testIOHDF5();
+    void testIOLayout();
+    void testIOCompacted();
+    void testDirty();
     void testOperatorComparison();
     void testCreateFilledCell();
     void testUnsetBlock();
@@ -834,6 +842,7 @@ TestCell<T>::testCompress()
 
     // check state
     CPPUNIT_ASSERT(cell->isCompressed());
+    CPPUNIT_ASSERT(cell->m_bitfield.hasRankDirectory());
 
     // check compressed data size
     CPPUNIT_ASSERT(cell->m_data_size == 2);
@@ -860,6 +869,7 @@ TestCell<T>::testCompress()
 
     // check state
     CPPUNIT_ASSERT(!cell->isCompressed());
+    CPPUNIT_ASSERT(!cell->m_bitfield.hasRankDirectory());
 
     // check uncompressed contents
     CPPUNIT_ASSERT(toString(*cell) == "10002000");
@@ -1069,6 +1079,59 @@ TestCell<T>::testCompressCopyFilled()
 
 //-----------------------------------------------------------------------------
 
+template<typename T>
+void
+TestCell<T>::testPrune()
+{
+    USING_NKHIVE_NS
+
+    T default_val(0);
+    T tolerance(1);
+
+    // voxels written one by one, within tolerance of each other
+    Cell<T> cell(1, default_val);
+    cell.set(0, 0, 0, T(5));
+    cell.set(1, 0, 0, T(6));
+    cell.set(0, 1, 1, T(5));
+    CPPUNIT_ASSERT(!cell.isFilled());
+    CPPUNIT_ASSERT(!cell.prune(T(0)));
+    CPPUNIT_ASSERT(!cell.isFilled());
+
+    CPPUNIT_ASSERT(cell.prune(tolerance));
+    CPPUNIT_ASSERT(cell.isFilled());
+    CPPUNIT_ASSERT(!cell.isFull());
+    CPPUNIT_ASSERT(cell.m_data == NULL);
+    CPPUNIT_ASSERT(cell.get(0, 0, 0) == T(5));
+    CPPUNIT_ASSERT(cell.get(1, 0, 0) == T(5));
+    CPPUNIT_ASSERT(cell.get(1, 1, 1) == default_val);
+    CPPUNIT_ASSERT(cell.prune(tolerance));
+
+    // out of tolerance voxels are kept
+    Cell<T> mixed(1, default_val);
+    for (index_type n = 0; n < 8; ++n) {
+        mixed.set(n, T(2 + 2 * (n % 2)));
+    }
+    CPPUNIT_ASSERT(mixed.isFull());
+    CPPUNIT_ASSERT(!mixed.prune(tolerance));
+    CPPUNIT_ASSERT(mixed.get(1) == T(4));
+
+    // compressed cells prune their set voxels
+    mixed.set(1, T(2));
+    mixed.set(3, T(3));
+    mixed.set(7, T(2));
+    mixed.unset(5);
+    mixed.compress();
+    CPPUNIT_ASSERT(mixed.prune(tolerance));
+    CPPUNIT_ASSERT(mixed.isFilled());
+    CPPUNIT_ASSERT(mixed.isCompressed());
+    CPPUNIT_ASSERT(mixed.get(3) == T(2));
+    CPPUNIT_ASSERT(mixed.get(5) == default_val);
+    mixed.uncompress();
+    CPPUNIT_ASSERT(mixed.get(7) == T(2));
+}
+
+//-----------------------------------------------------------------------------
+
 template<typename T>
 void
 TestCell<T>::testFill()
@@ -1496,6 +1559,179 @@ TestCell<T>::testIO()
 
 //-----------------------------------------------------------------------------
 
+template <typename T>
+void
+TestCell<T>::testIOLayout()
+{
+    USING_NKHIVE_NS
+
+    typedef Cell<T, std::allocator<T>, MortonLayout> MortonCell;
+
+    // the stream is row major, so it moves between layouts
+    #define IO_TEST(from, to, expected) {                           \
+        std::ostringstream ostr(std::ios_base::binary);             \
+        from.write(ostr);                                           \
+        std::istringstream istr(ostr.str(), std::ios_base::binary); \
+        to.read(istr);                                              \
+        CPPUNIT_ASSERT(to == expected);                             \
+    } 
+
+    T default_val(0);
+
+    Cell<T> cell(2, default_val);
+    MortonCell mcell(2, default_val);
+    for (index_type n = 0; n < 12; ++n) {
+        index_type i = (n * 5) % 4;
+        index_type j = (n * 3) % 4;
+        index_type k = n % 4;
+        cell.set(i, j, k, T(n + 1));
+        mcell.set(i, j, k, T(n + 1));
+        CPPUNIT_ASSERT(mcell.get(i, j, k) == T(n + 1));
+    }
+
+    Cell<T> ci;
+    MortonCell mci;
+    IO_TEST(mcell, ci, cell);
+    IO_TEST(cell, mci, mcell);
+
+    cell.compress();
+    mcell.compress();
+    IO_TEST(mcell, ci, cell);
+    IO_TEST(cell, mci, mcell);
+
+    cell.uncompress();
+    mcell.uncompress();
+    cell.fill(T(4));
+    mcell.fill(T(4));
+    IO_TEST(mcell, ci, cell);
+    IO_TEST(cell, mci, mcell);
+
+    #undef IO_TEST
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+void
+TestCell<T>::testIOCompacted()
+{
+    USING_NKHIVE_NS
+
+    typedef Cell<T, std::allocator<T>, MortonLayout> MortonCell;
+
+    // enough set voxels to compact over several runs
+    T default_val(0);
+    Cell<T> cell(4, default_val);
+    MortonCell mcell(4, default_val);
+    for (index_type n = 0; n < 1500; ++n) {
+        index_type m = (n * 7) % 4096;
+        index_type i = m % 16;
+        index_type j = (m / 16) % 16;
+        index_type k = m / 256;
+        cell.set(i, j, k, T(n + 1));
+        mcell.set(i, j, k, T(n + 1));
+    }
+
+    std::ostringstream uncompressed(std::ios_base::binary);
+    cell.write(uncompressed);
+
+    // uncompressed voxels are written exactly as compressed ones, past
+    // the leading flags
+    Cell<T> compressed_cell(cell);
+    compressed_cell.compress();
+    std::ostringstream compressed(std::ios_base::binary);
+    compressed_cell.write(compressed);
+    CPPUNIT_ASSERT(uncompressed.str().substr(1) == 
+                   compressed.str().substr(1));
+
+    std::ostringstream morton(std::ios_base::binary);
+    mcell.write(morton);
+    CPPUNIT_ASSERT(uncompressed.str() == morton.str());
+
+    // writing leaves the cell untouched
+    CPPUNIT_ASSERT(!cell.isCompressed());
+
+    std::istringstream istr(uncompressed.str(), std::ios_base::binary);
+    Cell<T> ci;
+    ci.read(istr);
+    CPPUNIT_ASSERT(ci == cell);
+
+    // the leaf table holds the same compacted voxels
+    HDF5LeafTable<T> table;
+    index_vec offset(0, 0, 0);
+    cell.write(table, 0, offset);
+    compressed_cell.write(table, 0, offset);
+    CPPUNIT_ASSERT(table.size() == 2);
+    CPPUNIT_ASSERT(table[0].voxel_count == 1500);
+    CPPUNIT_ASSERT(table[1].voxel_count == 1500);
+    CPPUNIT_ASSERT(std::equal(table.voxels().begin(),
+                              table.voxels().begin() + 1500,
+                              table.voxels().begin() + 1500));
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+void
+TestCell<T>::testDirty()
+{
+    USING_NKHIVE_NS
+
+    T default_val(0);
+
+    // new cells are dirty
+    Cell<T> cell(2, default_val);
+    CPPUNIT_ASSERT(cell.isDirty());
+    cell.markClean();
+    CPPUNIT_ASSERT(!cell.isDirty());
+
+    cell.set(1, 2, 3, T(4));
+    CPPUNIT_ASSERT(cell.isDirty());
+    cell.markClean();
+
+    cell.update(1, 2, 3, T(1), std::plus<T>());
+    CPPUNIT_ASSERT(cell.isDirty());
+    cell.markClean();
+
+    cell.unset(1, 2, 3);
+    CPPUNIT_ASSERT(cell.isDirty());
+    cell.markClean();
+
+    cell.fill(T(2));
+    CPPUNIT_ASSERT(cell.isDirty());
+    cell.markClean();
+
+    cell.clear();
+    CPPUNIT_ASSERT(cell.isDirty());
+
+    // copies keep the state, which is not written out
+    Cell<T> copy(cell);
+    CPPUNIT_ASSERT(copy.isDirty());
+
+    cell.set(0, 0, 0, T(3));
+    cell.set(0, 0, 1, T(4));
+    std::ostringstream ostr(std::ios_base::binary);
+    cell.write(ostr);
+    std::istringstream istr(ostr.str(), std::ios_base::binary);
+    Cell<T> ci;
+    ci.read(istr);
+    CPPUNIT_ASSERT(!ci.isDirty());
+    CPPUNIT_ASSERT(ci == cell);
+
+    // compression keeps the voxels
+    ci.compress();
+    ci.uncompress();
+    CPPUNIT_ASSERT(!ci.isDirty());
+
+    // pruning changes what is stored
+    ci.set(0, 0, 1, T(3));
+    ci.markClean();
+    CPPUNIT_ASSERT(ci.prune(T(0)));
+    CPPUNIT_ASSERT(ci.isDirty());
+}
+
+//-----------------------------------------------------------------------------
+
 template<typename T>
 void
 TestCell<T>::testOperatorComparison()
@@ -0,0 +1,365 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// TestConcurrentWrites.cpp
+//------------------------------------------------------------------------------
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <nkbase/BinaryOps.h>
+#include <nkhive/volume/Volume.h>
+
+//-----------------------------------------------------------------------------
+// types
+//-----------------------------------------------------------------------------
+
+template <typename T>
+struct ConcurrentAddOp
+{
+    T operator()(const T &a, const T &b) const 
+    { 
+        return a + b; 
+    }
+};
+
+//-----------------------------------------------------------------------------
+// interface declaration
+//-----------------------------------------------------------------------------
+
+class TestConcurrentWrites : public CppUnit::TestFixture 
+{
+    CPPUNIT_TEST_SUITE(TestConcurrentWrites);
+    CPPUNIT_TEST(testSet);
+    CPPUNIT_TEST(testUpdateSameVoxels);
+    CPPUNIT_TEST(testGrowth);
+    CPPUNIT_TEST(testAccessor);
+    CPPUNIT_TEST_SUITE_END();
+    
+public:
+    void setUp() {}
+    void tearDown() {}
+    
+    void testSet();
+    void testUpdateSameVoxels();
+    void testGrowth();
+    void testAccessor();
+
+private:
+
+    typedef NKHIVE_NS::Volume<NK_NS::i32> volume_type;
+
+    enum { NUM_THREADS = 8 };
+
+    /**
+     * Thread bodies. Each thread handles the voxels whose index modulo the 
+     * thread count matches its id, so neighbouring voxels, and thus cells, 
+     * are shared between threads.
+     */
+    static void setVoxels(volume_type *volume, int id, int range);
+    static void addVoxels(volume_type *volume, int id, int range, int passes);
+    static void setScattered(volume_type *volume, int id, int count);
+    static void setWithAccessor(volume_type *volume, int id, int range);
+
+    /**
+     * Runs the given function on NUM_THREADS threads in concurrent mode.
+     */
+    template <typename Function>
+    static void run(volume_type &volume, Function function);
+
+    /**
+     * Deterministic value and pseudo random coordinate for the tests.
+     */
+    static NK_NS::i32 value(NK_NS::i32 i, NK_NS::i32 j, NK_NS::i32 k);
+    static NKHIVE_NS::signed_index_vec scattered(int n);
+};
+
+//-----------------------------------------------------------------------------
+// test suite registration
+//-----------------------------------------------------------------------------
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestConcurrentWrites);
+
+//------------------------------------------------------------------------------
+// helpers
+//------------------------------------------------------------------------------
+
+NK_NS::i32
+TestConcurrentWrites::value(NK_NS::i32 i, NK_NS::i32 j, NK_NS::i32 k)
+{
+    return i * 10000 + j * 100 + k;
+}
+
+//------------------------------------------------------------------------------
+
+NKHIVE_NS::signed_index_vec
+TestConcurrentWrites::scattered(int n)
+{
+    USING_NK_NS
+
+    u32 seed = u32(n) * 2654435761u;
+    NKHIVE_NS::signed_index_vec c;
+    for (int axis = 0; axis < 3; ++axis) {
+        seed = seed * 1664525u + 1013904223u;
+        c[axis] = i32((seed >> 8) % 4096u) - 2048;
+    }
+    return c;
+}
+
+//------------------------------------------------------------------------------
+
+template <typename Function>
+void
+TestConcurrentWrites::run(volume_type &volume, Function function)
+{
+    volume.beginConcurrentWrites();
+
+    boost::thread_group threads;
+    for (int id = 0; id < NUM_THREADS; ++id) {
+        threads.create_thread(boost::bind(function, &volume, id));
+    }
+    threads.join_all();
+
+    volume.endConcurrentWrites();
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestConcurrentWrites::setVoxels(volume_type *volume, int id, int range)
+{
+    USING_NK_NS
+
+    int n = 0;
+    for (i32 k = -range; k < range; ++k) {
+        for (i32 j = -range; j < range; ++j) {
+            for (i32 i = -range; i < range; ++i, ++n) {
+                if (n % NUM_THREADS == id) {
+                    volume->set(i, j, k, value(i, j, k));
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestConcurrentWrites::addVoxels(volume_type *volume, int id, int range, 
+                                int passes)
+{
+    USING_NK_NS
+
+    // every thread hits every voxel, starting at different offsets
+    for (int pass = 0; pass < passes; ++pass) {
+        for (i32 k = -range; k < range; ++k) {
+            for (i32 j = -range; j < range; ++j) {
+                for (i32 i = -range; i < range; ++i) {
+                    i32 ii = ((i + range + id) % (2 * range)) - range;
+                    volume->update(ii, j, k, 1, ConcurrentAddOp<i32>());
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestConcurrentWrites::setScattered(volume_type *volume, int id, int count)
+{
+    for (int n = id; n < count; n += NUM_THREADS) {
+        NKHIVE_NS::signed_index_vec c = scattered(n);
+        volume->set(c[0], c[1], c[2], value(c[0], c[1], c[2]));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestConcurrentWrites::setWithAccessor(volume_type *volume, int id, int range)
+{
+    USING_NK_NS
+
+    // each thread sweeps its own slabs, sharing the cells along the seams
+    volume_type::accessor acc = volume->getAccessor();
+    for (i32 k = -range; k < range; ++k) {
+        if (((k + range) / 3) % NUM_THREADS != id) {
+            continue;
+        }
+        for (i32 j = -range; j < range; ++j) {
+            for (i32 i = -range; i < range; ++i) {
+                acc.set(i, j, k, value(i, j, k));
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// tests
+//------------------------------------------------------------------------------
+
+void
+TestConcurrentWrites::testSet()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    const int range = 24;
+
+    volume_type reference(2, 2, 0);
+    setVoxels(&reference, 0, 0);
+    for (int id = 0; id < NUM_THREADS; ++id) {
+        setVoxels(&reference, id, range);
+    }
+
+    volume_type volume(2, 2, 0);
+    run(volume, boost::bind(&setVoxels, _1, _2, range));
+
+    CPPUNIT_ASSERT(!volume.isConcurrentWrites());
+    for (i32 k = -range - 1; k <= range; ++k) {
+        for (i32 j = -range - 1; j <= range; ++j) {
+            for (i32 i = -range - 1; i <= range; ++i) {
+                CPPUNIT_ASSERT(volume.get(i, j, k) == reference.get(i, j, k));
+            }
+        }
+    }
+    CPPUNIT_ASSERT(volume == reference);
+
+    // the volume is usable serially again
+    volume.unset(0, 0, 0);
+    CPPUNIT_ASSERT(volume.get(0, 0, 0) == 0);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestConcurrentWrites::testUpdateSameVoxels()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    const int range  = 6;
+    const int passes = 20;
+
+    volume_type volume(2, 2, 0);
+    run(volume, boost::bind(&addVoxels, _1, _2, range, passes));
+
+    // no increment may be lost
+    for (i32 k = -range; k < range; ++k) {
+        for (i32 j = -range; j < range; ++j) {
+            for (i32 i = -range; i < range; ++i) {
+                CPPUNIT_ASSERT(volume.get(i, j, k) == NUM_THREADS * passes);
+            }
+        }
+    }
+    CPPUNIT_ASSERT(volume.get(range, 0, 0) == 0);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestConcurrentWrites::testGrowth()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    const int count = 20000;
+
+    // scattered writes keep growing the roots from under the other threads
+    volume_type volume(1, 2, 0);
+    run(volume, boost::bind(&setScattered, _1, _2, count));
+
+    volume_type reference(1, 2, 0);
+    for (int id = 0; id < NUM_THREADS; ++id) {
+        setScattered(&reference, id, count);
+    }
+
+    for (int n = 0; n < count; ++n) {
+        signed_index_vec c = scattered(n);
+        CPPUNIT_ASSERT(volume.get(c) == value(c[0], c[1], c[2]));
+    }
+    CPPUNIT_ASSERT(volume == reference);
+
+    signed_index_bounds bounds, reference_bounds;
+    CPPUNIT_ASSERT(volume.computeSetBounds(bounds));
+    CPPUNIT_ASSERT(reference.computeSetBounds(reference_bounds));
+    CPPUNIT_ASSERT(bounds.min() == reference_bounds.min());
+    CPPUNIT_ASSERT(bounds.max() == reference_bounds.max());
+
+    // roots grown while empty are pruned again, matching a serial build
+    volume_type far(1, 2, 0), far_reference(1, 2, 0);
+    far.beginConcurrentWrites();
+    far.set(4000, 4000, 4000, 1);
+    far.endConcurrentWrites();
+    far_reference.set(4000, 4000, 4000, 1);
+    CPPUNIT_ASSERT(far == far_reference);
+
+    int set_count = 0;
+    for (volume_type::set_iterator sit = far.setIterator(); sit(); ++sit) {
+        ++set_count;
+    }
+    CPPUNIT_ASSERT(set_count == 1);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestConcurrentWrites::testAccessor()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    const int range = 24;
+
+    volume_type reference(2, 2, 0);
+    for (int id = 0; id < NUM_THREADS; ++id) {
+        setWithAccessor(&reference, id, range);
+    }
+
+    volume_type volume(2, 2, 0);
+    run(volume, boost::bind(&setWithAccessor, _1, _2, range));
+
+    for (i32 k = -range; k < range; ++k) {
+        for (i32 j = -range; j < range; ++j) {
+            for (i32 i = -range; i < range; ++i) {
+                CPPUNIT_ASSERT(volume.get(i, j, k) == value(i, j, k));
+            }
+        }
+    }
+    CPPUNIT_ASSERT(volume == reference);
+}
+
+//------------------------------------------------------------------------------
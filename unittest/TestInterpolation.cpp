@@ -71,6 +71,9 @@ class TestInterpolation : public CppUnit::TestFixture
     CPPUNIT_TEST(testCollectInterpolants);
     CPPUNIT_TEST(testInterp);
     CPPUNIT_TEST(testInterpNegative);
+    CPPUNIT_TEST(testInterpBatch);
+    CPPUNIT_TEST(testLinearGradient);
+    CPPUNIT_TEST(testCubicGradient);
     CPPUNIT_TEST_SUITE_END();
 
 public:
@@ -85,6 +88,9 @@ public:
     void testCollectInterpolants();
     void testInterp();
     void testInterpNegative();
+    void testInterpBatch();
+    void testLinearGradient();
+    void testCubicGradient();
 };
 
 //------------------------------------------------------------------------------
@@ -657,3 +663,169 @@ TestInterpolation<T>::testInterpNegative()
 
 //------------------------------------------------------------------------------
 
+template<typename T>
+void
+TestInterpolation<T>::testInterpBatch()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    // small cells so the points span many of them in every quadrant
+    T default_val(1); 
+    vec3d res(1.0);
+    vec3d kernel_offset(0.5);
+    typename Volume<T>::shared_ptr volume(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+
+    for (i32 z = -6; z < 6; ++z) {
+        for (i32 y = -6; y < 6; ++y) {
+            for (i32 x = -6; x < 6; ++x) {
+                volume->set(x, y, z, T((x * 7 + y * 3 + z * 5) % 11));
+            }
+        }
+    }
+
+    // scattered points, not a multiple of the block size
+    const size_t n = 150;
+    std::vector<vec3d> pts(n);
+    std::vector<double> xs(n), ys(n), zs(n);
+    u32 seed = 3;
+    for (size_t p = 0; p < n; ++p) {
+        for (i32 a = 0; a < 3; ++a) {
+            seed = seed * 1664525u + 1013904223u;
+            pts[p][a] = ((seed >> 8) % 1600) / 100.0 - 8.0;
+        }
+        xs[p] = pts[p].x;
+        ys[p] = pts[p].y;
+        zs[p] = pts[p].z;
+    }
+
+    LinearInterpolation<T> linear_interp(volume);
+    std::vector<T> aos(n), soa(n);
+    linear_interp.interpBatch(&pts[0], &aos[0], n);
+    linear_interp.interpBatch(&xs[0], &ys[0], &zs[0], &soa[0], n);
+
+    for (size_t p = 0; p < n; ++p) {
+        T result(0);
+        linear_interp.interp(pts[p].x, pts[p].y, pts[p].z, result);
+        TOL_CHECK(aos[p], result);
+        TOL_CHECK(soa[p], result);
+    }
+
+    // empty batches are a no-op
+    linear_interp.interpBatch(&pts[0], &aos[0], 0);
+}
+
+//------------------------------------------------------------------------------
+
+template<typename T>
+void
+TestInterpolation<T>::testLinearGradient()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    // linear ramp, trilinear interpolation reproduces it exactly
+    T default_val(0); 
+    vec3d res(1.0);
+    vec3d kernel_offset(0.5);
+    typename Volume<T>::shared_ptr volume(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+    for (i32 z = -3; z < 3; ++z) {
+        for (i32 y = -3; y < 3; ++y) {
+            for (i32 x = -3; x < 3; ++x) {
+                volume->set(x, y, z, T(0.5 * x - y + 0.25 * z));
+            }
+        }
+    }
+
+    LinearInterpolation<T> linear_interp(volume);
+    typename LinearInterpolation<T>::calc_vec_type gradient;
+    T result(0);
+    T expected(0);
+
+    linear_interp.interpWithGradient(0.75, -1.25, 1.0, result, gradient);
+    linear_interp.interp(0.75, -1.25, 1.0, expected);
+    TOL_CHECK(result, expected);
+    TOL_CHECK(gradient[0], 0.5);
+    TOL_CHECK(gradient[1], -1.0);
+    TOL_CHECK(gradient[2], 0.25);
+
+    // a single raised voxel, the gradient points towards it and matches
+    // the slope of the value along each axis inside the cell
+    volume = typename Volume<T>::shared_ptr(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+    volume->set(1, 1, 1, T(4));
+    LinearInterpolation<T> bump_interp(volume);
+
+    bump_interp.interpWithGradient(1.25, 1.0, 1.75, result, gradient);
+    bump_interp.interp(1.25, 1.0, 1.75, expected);
+    TOL_CHECK(result, expected);
+    TOL_CHECK(gradient[0], 4.0 * 0.5 * 0.75);
+    TOL_CHECK(gradient[1], 4.0 * 0.75 * 0.75);
+    TOL_CHECK(gradient[2], -4.0 * 0.75 * 0.5);
+}
+
+//------------------------------------------------------------------------------
+
+template<typename T>
+void
+TestInterpolation<T>::testCubicGradient()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    // linear ramp over voxel centers, with a resolution that differs per
+    // axis so the local gradient is the voxel gradient scaled by it
+    T default_val(0); 
+    vec3d res(2.0, 1.0, 0.5);
+    vec3d kernel_offset(0.5);
+    typename Volume<T>::shared_ptr volume(
+                        new Volume<T>(1, 2, default_val, res, kernel_offset));
+    for (i32 z = -4; z < 4; ++z) {
+        for (i32 y = -4; y < 4; ++y) {
+            for (i32 x = -4; x < 4; ++x) {
+                volume->set(x, y, z, T(0.5 * x - y + 0.25 * z));
+            }
+        }
+    }
+
+    CubicInterpolation<T> cubic_interp(volume);
+    typename CubicInterpolation<T>::calc_vec_type gradient;
+    T result(0);
+    T expected(0);
+
+    cubic_interp.interpWithGradient(0.3, -0.4, 1.2, result, gradient);
+    cubic_interp.interp(0.3, -0.4, 1.2, expected);
+    TOL_CHECK(result, expected);
+    TOL_CHECK(gradient[0], 0.5 * 2.0);
+    TOL_CHECK(gradient[1], -1.0 * 1.0);
+    TOL_CHECK(gradient[2], 0.25 * 0.5);
+
+    // a single raised voxel, compared with central differences of interp()
+    volume = typename Volume<T>::shared_ptr(
+                        new Volume<T>(1, 2, default_val, vec3d(1.0), 
+                                      kernel_offset));
+    volume->set(1, 1, 1, T(4));
+    CubicInterpolation<T> bump_interp(volume);
+
+    vec3d p(1.3, 1.6, 1.1);
+    bump_interp.interpWithGradient(p.x, p.y, p.z, result, gradient);
+    bump_interp.interp(p.x, p.y, p.z, expected);
+    TOL_CHECK(result, expected);
+
+    const double h = 0.05;
+    for (i32 a = 0; a < 3; ++a) {
+        vec3d lo(p), hi(p);
+        lo[a] -= h;
+        hi[a] += h;
+
+        T lo_val(0), hi_val(0);
+        bump_interp.interp(lo.x, lo.y, lo.z, lo_val);
+        bump_interp.interp(hi.x, hi.y, hi.z, hi_val);
+        double slope = (double(hi_val) - double(lo_val)) / (2.0 * h);
+        CPPUNIT_ASSERT(fabs(slope - gradient[a]) < 0.2);
+    }
+}
+
+//------------------------------------------------------------------------------
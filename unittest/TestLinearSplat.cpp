@@ -33,12 +33,15 @@
 // TestLinearSplat.cpp
 //------------------------------------------------------------------------------
 
+#include <vector>
+
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
 
 #include <nkbase/Tolerance.h>
 
 #include <nkhive/interpolation/LinearSplat.h>
+#include <nkhive/interpolation/ParallelSplatter.h>
 
 //------------------------------------------------------------------------------
 // definitions
@@ -60,6 +63,7 @@ class TestLinearSplat : public CppUnit::TestFixture {
     CPPUNIT_TEST_SUITE(TestLinearSplat);
     CPPUNIT_TEST(test);
     CPPUNIT_TEST(testPolicies);
+    CPPUNIT_TEST(testParallel);
     CPPUNIT_TEST_SUITE_END();
     
 public:
@@ -68,6 +72,7 @@ public:
     
     void test();
     void testPolicies();
+    void testParallel();
 };
 
 //------------------------------------------------------------------------------
@@ -258,3 +263,97 @@ TestLinearSplat<T>::testPolicies()
 }
 
 //------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestLinearSplat<T>::testParallel()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    T default_val(0); 
+    vec3d res(1.0);
+    vec3d kernel_offset(0.5);
+
+    // particles scattered over a few cells, every fourth one on a voxel 
+    // center so the sums stay exact
+    const size_t count = 5000;
+    std::vector<vec3d> pts(count);
+    std::vector<T> vals(count);
+    uint32_t seed = 7;
+    for (size_t n = 0; n < count; ++n) {
+        for (int axis = 0; axis < 3; ++axis) {
+            seed = seed * 1664525u + 1013904223u;
+            pts[n][axis] = double(seed >> 8) / double(1 << 24) * 12.0 - 6.0;
+            if (n % 4 == 0) pts[n][axis] = floor(pts[n][axis]) + 0.5;
+        }
+        vals[n] = T(n % 4 == 0 ? 1 : 0.25 * (n % 3));
+    }
+
+    // set keeps the last particle written to each voxel
+    {
+        typename Volume<T>::shared_ptr serial(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+        typename Volume<T>::shared_ptr parallel(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+
+        LinearSplat<T> splatter(serial);
+        for (size_t n = 0; n < count; ++n) {
+            splatter.splat(pts[n].x, pts[n].y, pts[n].z, vals[n]);
+        }
+
+        ParallelSplatter< LinearSplat<T> > parallel_splatter(parallel, 
+                                                             T(0), 4);
+        CPPUNIT_ASSERT(parallel_splatter.numThreads() == 4);
+        parallel_splatter.splat(&pts[0], &vals[0], count);
+
+        for (int k = -8; k < 8; ++k) {
+            for (int j = -8; j < 8; ++j) {
+                for (int i = -8; i < 8; ++i) {
+                    CPPUNIT_ASSERT(parallel->get(i, j, k) == 
+                                   serial->get(i, j, k));
+                }
+            }
+        }
+    }
+
+    // sums of the voxel centered particles
+    {
+        typename Volume<T>::shared_ptr serial(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+        typename Volume<T>::shared_ptr parallel(
+                        new Volume<T>(2, 1, default_val, res, kernel_offset));
+
+        std::vector<vec3d> centers;
+        std::vector<T> ones;
+        for (size_t n = 0; n < count; n += 4) {
+            centers.push_back(pts[n]);
+            ones.push_back(vals[n]);
+        }
+        // the same particles again, enough for several threads
+        std::vector<vec3d> centers_copy(centers);
+        std::vector<T> ones_copy(ones);
+        centers.insert(centers.end(), centers_copy.begin(), centers_copy.end());
+        ones.insert(ones.end(), ones_copy.begin(), ones_copy.end());
+
+        LinearSplat<T, std::plus> splatter(serial);
+        for (size_t n = 0; n < centers.size(); ++n) {
+            splatter.splat(centers[n].x, centers[n].y, centers[n].z, ones[n]);
+        }
+
+        ParallelSplatter< LinearSplat<T, std::plus> > parallel_splatter(
+                                                        parallel, T(0), 2);
+        parallel_splatter.splat(&centers[0], &ones[0], centers.size());
+
+        for (int k = -8; k < 8; ++k) {
+            for (int j = -8; j < 8; ++j) {
+                for (int i = -8; i < 8; ++i) {
+                    CPPUNIT_ASSERT(parallel->get(i, j, k) == 
+                                   serial->get(i, j, k));
+                }
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -0,0 +1,315 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// TestMemoryPool.cpp
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <nkbase/Types.h>
+
+#include <nkhive/memory/MemoryPool.h>
+#include <nkhive/memory/PoolAllocator.h>
+
+//-----------------------------------------------------------------------------
+// interface declaration
+//-----------------------------------------------------------------------------
+
+class TestMemoryPool : public CppUnit::TestFixture 
+{
+    CPPUNIT_TEST_SUITE(TestMemoryPool);
+    CPPUNIT_TEST(testFixedPoolReuse);
+    CPPUNIT_TEST(testFixedPoolRelease);
+    CPPUNIT_TEST(testSizeClasses);
+    CPPUNIT_TEST(testLargeBlocks);
+    CPPUNIT_TEST(testPoolAllocator);
+    CPPUNIT_TEST(testScopedThreadSafe);
+    CPPUNIT_TEST_SUITE_END();
+    
+public:
+    void setUp() {}
+    void tearDown() {}
+    
+    void testFixedPoolReuse();
+    void testFixedPoolRelease();
+    void testSizeClasses();
+    void testLargeBlocks();
+    void testPoolAllocator();
+    void testScopedThreadSafe();
+};
+
+//-----------------------------------------------------------------------------
+// test suite registration
+//-----------------------------------------------------------------------------
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestMemoryPool);
+
+//------------------------------------------------------------------------------
+// tests
+//------------------------------------------------------------------------------
+
+void
+TestMemoryPool::testFixedPoolReuse()
+{
+    USING_NKHIVE_NS
+
+    FixedPool pool(32, 4);
+    CPPUNIT_ASSERT(pool.blockSize() == 32);
+    CPPUNIT_ASSERT(pool.bytesReserved() == 0);
+
+    // blocks are distinct and carved from a single slab
+    std::set<void*> blocks;
+    for (int i = 0; i < 4; ++i) {
+        blocks.insert(pool.allocate());
+    }
+    CPPUNIT_ASSERT(blocks.size() == 4);
+    CPPUNIT_ASSERT(pool.bytesReserved() == 4 * 32);
+    CPPUNIT_ASSERT(pool.bytesInUse() == 4 * 32);
+
+    // a freed block is handed out again
+    void *p = *blocks.begin();
+    pool.deallocate(p);
+    CPPUNIT_ASSERT(pool.bytesInUse() == 3 * 32);
+    CPPUNIT_ASSERT(pool.allocate() == p);
+
+    // the next allocation needs a new slab
+    void *q = pool.allocate();
+    CPPUNIT_ASSERT(blocks.find(q) == blocks.end());
+    CPPUNIT_ASSERT(pool.bytesReserved() == 8 * 32);
+
+    std::set<void*>::iterator iter = blocks.begin();
+    for (; iter != blocks.end(); ++iter) {
+        pool.deallocate(*iter);
+    }
+    pool.deallocate(q);
+    CPPUNIT_ASSERT(pool.bytesInUse() == 0);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestMemoryPool::testFixedPoolRelease()
+{
+    USING_NKHIVE_NS
+
+    FixedPool pool(16, 8);
+
+    // fill three slabs
+    std::vector<void*> blocks;
+    for (int i = 0; i < 24; ++i) {
+        blocks.push_back(pool.allocate());
+    }
+    CPPUNIT_ASSERT(pool.bytesReserved() == 24 * 16);
+
+    // releasing with all blocks in use frees nothing
+    pool.releaseMemory();
+    CPPUNIT_ASSERT(pool.bytesReserved() == 24 * 16);
+
+    // free the second slab entirely, and a single block of the first
+    for (int i = 8; i < 16; ++i) {
+        pool.deallocate(blocks[i]);
+    }
+    pool.deallocate(blocks[0]);
+
+    pool.releaseMemory();
+    CPPUNIT_ASSERT(pool.bytesReserved() == 16 * 16);
+    CPPUNIT_ASSERT(pool.bytesInUse() == 15 * 16);
+
+    // the remaining free block is still usable
+    CPPUNIT_ASSERT(pool.allocate() == blocks[0]);
+
+    // free everything and release
+    for (int i = 0; i < 24; ++i) {
+        if (i < 8 || i >= 16) {
+            pool.deallocate(blocks[i]);
+        }
+    }
+    pool.releaseMemory();
+    CPPUNIT_ASSERT(pool.bytesReserved() == 0);
+    CPPUNIT_ASSERT(pool.bytesInUse() == 0);
+
+    // the pool keeps working after releasing everything
+    void *p = pool.allocate();
+    CPPUNIT_ASSERT(p != NULL);
+    pool.deallocate(p);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestMemoryPool::testSizeClasses()
+{
+    USING_NKHIVE_NS
+
+    MemoryPool pool;
+    CPPUNIT_ASSERT(pool.allocate(0) == NULL);
+    pool.deallocate(NULL, 0);
+
+    // sizes in the same class share blocks
+    void *p = pool.allocate(17);
+    pool.deallocate(p, 17);
+    void *q = pool.allocate(32);
+    CPPUNIT_ASSERT(p == q);
+
+    // other classes get their own blocks
+    void *r = pool.allocate(33);
+    CPPUNIT_ASSERT(r != q);
+    CPPUNIT_ASSERT(pool.bytesInUse() == 32 + 48);
+
+    // memory is writable across the whole block
+    std::fill((char*)r, (char*)r + 33, 0x7f);
+
+    pool.deallocate(q, 32);
+    pool.deallocate(r, 33);
+    CPPUNIT_ASSERT(pool.bytesInUse() == 0);
+    CPPUNIT_ASSERT(pool.bytesReserved() > 0);
+
+    pool.releaseMemory();
+    CPPUNIT_ASSERT(pool.bytesReserved() == 0);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestMemoryPool::testLargeBlocks()
+{
+    USING_NKHIVE_NS
+
+    MemoryPool pool;
+
+    // sizes beyond the largest class bypass the pool
+    size_t bytes = MemoryPool::kMaxBlockSize + 1;
+    char *p = static_cast<char*>(pool.allocate(bytes));
+    p[0] = p[bytes - 1] = 1;
+    CPPUNIT_ASSERT(pool.bytesReserved() == 0);
+    pool.deallocate(p, bytes);
+
+    // sizes past the directly indexed classes still pool
+    bytes = MemoryPool::kMaxBlockSize;
+    p = static_cast<char*>(pool.allocate(bytes));
+    p[0] = p[bytes - 1] = 1;
+    CPPUNIT_ASSERT(pool.bytesInUse() == bytes);
+    pool.deallocate(p, bytes);
+    CPPUNIT_ASSERT(pool.allocate(bytes) == p);
+    pool.deallocate(p, bytes);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestMemoryPool::testPoolAllocator()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    MemoryPool::shared_ptr pool(new MemoryPool());
+    PoolAllocator<i32> alloc(pool);
+
+    // containers draw from the pool
+    {
+        std::vector<i32, PoolAllocator<i32> > v(alloc);
+        for (i32 i = 0; i < 1000; ++i) {
+            v.push_back(i);
+        }
+        CPPUNIT_ASSERT(pool->bytesInUse() >= 1000 * sizeof(i32));
+        for (i32 i = 0; i < 1000; ++i) {
+            CPPUNIT_ASSERT(v[i] == i);
+        }
+    }
+    CPPUNIT_ASSERT(pool->bytesInUse() == 0);
+
+    // rebound allocators share the pool
+    PoolAllocator<double> rebound(alloc);
+    CPPUNIT_ASSERT(rebound.pool() == pool);
+    CPPUNIT_ASSERT(rebound == alloc);
+    CPPUNIT_ASSERT(PoolTraits< PoolAllocator<double> >::pool(rebound) == pool);
+
+    // default allocators use the heap
+    PoolAllocator<i32> heap;
+    CPPUNIT_ASSERT(heap != alloc);
+    i32 *p = heap.allocate(4);
+    p[3] = 3;
+    heap.deallocate(p, 4);
+    CPPUNIT_ASSERT(pool->bytesInUse() == 0);
+
+    // allocators unaware of pools report none
+    std::allocator<i32> std_alloc = 
+        PoolTraits< std::allocator<i32> >::create(pool);
+    CPPUNIT_ASSERT(!PoolTraits< std::allocator<i32> >::pool(std_alloc));
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestMemoryPool::testScopedThreadSafe()
+{
+    USING_NKHIVE_NS
+
+    MemoryPool pool;
+    {
+        MemoryPool::ScopedThreadSafe thread_safe(pool);
+        CPPUNIT_ASSERT(pool.isThreadSafe());
+    }
+    CPPUNIT_ASSERT(!pool.isThreadSafe());
+
+    // left as is when not enabled
+    {
+        MemoryPool::ScopedThreadSafe thread_safe(pool, false);
+        CPPUNIT_ASSERT(!pool.isThreadSafe());
+    }
+
+    // the previous setting is restored when unwinding
+    pool.setThreadSafe(true);
+    try {
+        MemoryPool::ScopedThreadSafe thread_safe(pool);
+        throw std::runtime_error("unwind");
+    } catch (const std::runtime_error&) {
+    }
+    CPPUNIT_ASSERT(pool.isThreadSafe());
+    pool.setThreadSafe(false);
+
+    try {
+        MemoryPool::ScopedThreadSafe thread_safe(pool);
+        throw std::runtime_error("unwind");
+    } catch (const std::runtime_error&) {
+    }
+    CPPUNIT_ASSERT(!pool.isThreadSafe());
+}
+
+//------------------------------------------------------------------------------
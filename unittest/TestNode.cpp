@@ -149,6 +149,7 @@ class TestNode : public CppUnit::TestFixture {
     CPPUNIT_TEST(testFillUnsetMultiLevel);
     CPPUNIT_TEST(testComputeSetBounds);
     CPPUNIT_TEST(testWriteStamp);
+    CPPUNIT_TEST(testSparseBranches);
     CPPUNIT_TEST_SUITE_END();
     
 public:
@@ -178,6 +179,7 @@ public:
     void testFillUnsetMultiLevel();
     void testComputeSetBounds();
     void testWriteStamp();
+    void testSparseBranches();
 };
 
 //-----------------------------------------------------------------------------
@@ -291,23 +293,23 @@ TestNode::testSetSingleLevel()
 
     Node<Cell<float> > *node = new Node<Cell<float> >(1, 2, 2, 1.0f);
     node->set(0, 0, 0, 5.0f);
-    CPPUNIT_ASSERT(node->m_branches[0].cell->get(0, 0, 0) == 5.0f);
+    CPPUNIT_ASSERT(node->getBranch(0).cell->get(0, 0, 0) == 5.0f);
 
     CPPUNIT_ASSERT(!node->isEmpty());
     CPPUNIT_ASSERT(node->isBranching());
 
     node->set(1, 2, 3, 5.0f);
-    CPPUNIT_ASSERT(node->m_branches[0].cell->get(1, 2, 3) == 5.0f);
-    CPPUNIT_ASSERT(node->m_branches[0].cell->get(0, 0, 0) == 5.0f);
-    CPPUNIT_ASSERT(node->m_branches[0].cell->get(1, 1, 1) == 1.0f);
+    CPPUNIT_ASSERT(node->getBranch(0).cell->get(1, 2, 3) == 5.0f);
+    CPPUNIT_ASSERT(node->getBranch(0).cell->get(0, 0, 0) == 5.0f);
+    CPPUNIT_ASSERT(node->getBranch(0).cell->get(1, 1, 1) == 1.0f);
 
     node->set(12, 15, 13, 5.0f);
-    CPPUNIT_ASSERT(node->m_branches[63].cell->get(0, 3, 1) == 5.0f);
-    CPPUNIT_ASSERT(node->m_branches[63].cell->get(0, 0, 0) == 1.0f);
+    CPPUNIT_ASSERT(node->getBranch(63).cell->get(0, 3, 1) == 5.0f);
+    CPPUNIT_ASSERT(node->getBranch(63).cell->get(0, 0, 0) == 1.0f);
 
     // check that all other cell branches are null
-    for (size_t i = 1; i < node->m_branches.size() - 1; ++i) {
-        CPPUNIT_ASSERT(node->m_branches[i].node == NULL);
+    for (size_t i = 1; i < numBits3D(node->m_bitfield.size()) - 1; ++i) {
+        CPPUNIT_ASSERT(!node->m_bitfield.isSet(i));
     }
     delete node;
 }
@@ -323,24 +325,24 @@ TestNode::testSetMultiLevel()
 
     Node<Cell<float> > *node = new Node<Cell<float> >(2, 2, 2, 1.0f);
     node->set(0, 0, 0, 5.0f);
-    cell = node->m_branches[0].node->m_branches[0].cell;
+    cell = node->getBranch(0).node->getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(0, 0, 0) == 5.0f);
     CPPUNIT_ASSERT(cell->get(1, 1, 1) == 1.0f);
 
     // make sure all other nodes are NULL
-    for (size_t i = 1; i < node->m_branches.size(); ++i) 
-        CPPUNIT_ASSERT(node->m_branches[i].node == NULL);
+    for (size_t i = 1; i < numBits3D(node->m_bitfield.size()); ++i) 
+        CPPUNIT_ASSERT(!node->m_bitfield.isSet(i));
 
     node->set(16, 1, 2, 5.0f);
-    cell = node->m_branches[1].node->m_branches[0].cell;
+    cell = node->getBranch(1).node->getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(0, 1, 2) == 5.0f);
 
     // make sure all other nodes are NULL
-    for (size_t i = 2; i < node->m_branches.size(); ++i) 
-        CPPUNIT_ASSERT(node->m_branches[i].node == NULL);
+    for (size_t i = 2; i < numBits3D(node->m_bitfield.size()); ++i) 
+        CPPUNIT_ASSERT(!node->m_bitfield.isSet(i));
 
     node->set(16, 16, 16, 5.0f);
-    cell = node->m_branches[21].node->m_branches[0].cell;
+    cell = node->getBranch(21).node->getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(0, 0, 0) == 5.0f);
     CPPUNIT_ASSERT(cell->get(1, 0, 0) == 1.0f);
 
@@ -358,24 +360,24 @@ TestNode::testUpdateMultiLevel()
 
     Node<Cell<float> > *node = new Node<Cell<float> >(2, 2, 2, 1.0f);
     node->set(0, 0, 0, 5.0f);
-    cell = node->m_branches[0].node->m_branches[0].cell;
+    cell = node->getBranch(0).node->getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(0, 0, 0) == 5.0f);
     CPPUNIT_ASSERT(cell->get(1, 1, 1) == 1.0f);
 
     // make sure all other nodes are NULL
-    for (size_t i = 1; i < node->m_branches.size(); ++i) 
-        CPPUNIT_ASSERT(node->m_branches[i].node == NULL);
+    for (size_t i = 1; i < numBits3D(node->m_bitfield.size()); ++i) 
+        CPPUNIT_ASSERT(!node->m_bitfield.isSet(i));
 
     node->set(16, 1, 2, 5.0f);
-    cell = node->m_branches[1].node->m_branches[0].cell;
+    cell = node->getBranch(1).node->getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(0, 1, 2) == 5.0f);
 
     // make sure all other nodes are NULL
-    for (size_t i = 2; i < node->m_branches.size(); ++i) 
-        CPPUNIT_ASSERT(node->m_branches[i].node == NULL);
+    for (size_t i = 2; i < numBits3D(node->m_bitfield.size()); ++i) 
+        CPPUNIT_ASSERT(!node->m_bitfield.isSet(i));
 
     node->set(16, 16, 16, 5.0f);
-    cell = node->m_branches[21].node->m_branches[0].cell;
+    cell = node->getBranch(21).node->getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(0, 0, 0) == 5.0f);
     CPPUNIT_ASSERT(cell->get(1, 0, 0) == 1.0f);
 
@@ -425,7 +427,7 @@ TestNode::testUpdateWithFillNode()
     CPPUNIT_ASSERT(n.m_branches.size() != 0);
     CPPUNIT_ASSERT(n.m_bitfield.isFull());
 
-    Cell<float> *cell = n.m_branches[0].cell;
+    Cell<float> *cell = n.getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(1, 2, 3) == fill_val + fill_val);
 }
 
@@ -650,7 +652,7 @@ TestNode::testFillSetSingleLevel()
     CPPUNIT_ASSERT(!node.isBranching());
 
     node.set(1, 2, 3, val);
-    Cell<float> *cell = node.m_branches[0].cell;
+    Cell<float> *cell = node.getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(1, 2, 3) == val);
     // All other cell components should have the fill value.
     for (size_t i = 0; i < cell->getDimension(); ++i) {
@@ -664,11 +666,11 @@ TestNode::testFillSetSingleLevel()
 
     // Check that all other cell's are fill cells.
     CPPUNIT_ASSERT(node.m_bitfield.isFull());
-    for (size_t i = 1; i < node.m_branches.size(); ++i) {
-        CPPUNIT_ASSERT(node.m_branches[i].cell != NULL);
-        CPPUNIT_ASSERT(node.m_branches[i].cell->isFilled());
-        CPPUNIT_ASSERT(node.m_branches[i].cell->getFillValue() == fill_val);
-        CPPUNIT_ASSERT(node.m_branches[i].cell->m_bitfield.isFull());
+    for (size_t i = 1; i < numBits3D(node.m_bitfield.size()); ++i) {
+        CPPUNIT_ASSERT(node.m_bitfield.isSet(i));
+        CPPUNIT_ASSERT(node.getBranch(i).cell->isFilled());
+        CPPUNIT_ASSERT(node.getBranch(i).cell->getFillValue() == fill_val);
+        CPPUNIT_ASSERT(node.getBranch(i).cell->m_bitfield.isFull());
     }
 }
 
@@ -691,7 +693,7 @@ TestNode::testFillSetMultiLevel()
     CPPUNIT_ASSERT(!node.isBranching());
 
     node.set(0, 0, 0, val);
-    cell = node.m_branches[0].node->m_branches[0].cell;
+    cell = node.getBranch(0).node->getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(0, 0, 0) == val);
     CPPUNIT_ASSERT(cell->m_bitfield.isFull());
     // All other cell components should have the fill value.
@@ -707,43 +709,43 @@ TestNode::testFillSetMultiLevel()
     CPPUNIT_ASSERT(node.m_bitfield.isFull());
 
     // make sure all other nodes are fill nodes.
-    for (size_t i = 1; i < node.m_branches.size(); ++i) {
-        CPPUNIT_ASSERT(node.m_branches[i].node != NULL);
-        CPPUNIT_ASSERT(node.m_branches[i].node->isFill());
-        CPPUNIT_ASSERT(node.m_branches[i].node->m_branches.size() == 0);
-        CPPUNIT_ASSERT(node.m_branches[i].node->fillValue() == fill_val);
-        CPPUNIT_ASSERT(node.m_branches[i].node->m_bitfield.isFull());
+    for (size_t i = 1; i < numBits3D(node.m_bitfield.size()); ++i) {
+        CPPUNIT_ASSERT(node.m_bitfield.isSet(i));
+        CPPUNIT_ASSERT(node.getBranch(i).node->isFill());
+        CPPUNIT_ASSERT(node.getBranch(i).node->m_branches.size() == 0);
+        CPPUNIT_ASSERT(node.getBranch(i).node->fillValue() == fill_val);
+        CPPUNIT_ASSERT(node.getBranch(i).node->m_bitfield.isFull());
     }
 
     node.set(16, 1, 2, val);
-    cell = node.m_branches[1].node->m_branches[0].cell;
+    cell = node.getBranch(1).node->getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(0, 1, 2) == val);
     CPPUNIT_ASSERT(cell->m_bitfield.isFull());
     CPPUNIT_ASSERT(node.m_bitfield.isFull());
 
     // make sure all other nodes are fill nodes 
-    for (size_t i = 2; i < node.m_branches.size(); ++i) {
-        CPPUNIT_ASSERT(node.m_branches[i].node != NULL);
-        CPPUNIT_ASSERT(node.m_branches[i].node->isFill());
-        CPPUNIT_ASSERT(node.m_branches[i].node->m_branches.size() == 0);
-        CPPUNIT_ASSERT(node.m_branches[i].node->fillValue() == fill_val);
-        CPPUNIT_ASSERT(node.m_branches[i].node->m_bitfield.isFull());
+    for (size_t i = 2; i < numBits3D(node.m_bitfield.size()); ++i) {
+        CPPUNIT_ASSERT(node.m_bitfield.isSet(i));
+        CPPUNIT_ASSERT(node.getBranch(i).node->isFill());
+        CPPUNIT_ASSERT(node.getBranch(i).node->m_branches.size() == 0);
+        CPPUNIT_ASSERT(node.getBranch(i).node->fillValue() == fill_val);
+        CPPUNIT_ASSERT(node.getBranch(i).node->m_bitfield.isFull());
     }
 
     node.set(16, 16, 16, 5.0f);
-    cell = node.m_branches[21].node->m_branches[0].cell;
+    cell = node.getBranch(21).node->getBranch(0).cell;
     CPPUNIT_ASSERT(cell->get(0, 0, 0) == val);
     CPPUNIT_ASSERT(cell->m_bitfield.isFull());
     CPPUNIT_ASSERT(node.m_bitfield.isFull());
 
     // make sure all other nodes are fill nodes 
-    for (size_t i = 0; i < node.m_branches.size(); ++i) {
+    for (size_t i = 0; i < numBits3D(node.m_bitfield.size()); ++i) {
         if (i == 0 || i == 1 || i == 21) continue;
-        CPPUNIT_ASSERT(node.m_branches[i].node != NULL);
-        CPPUNIT_ASSERT(node.m_branches[i].node->isFill());
-        CPPUNIT_ASSERT(node.m_branches[i].node->m_branches.size() == 0);
-        CPPUNIT_ASSERT(node.m_branches[i].node->fillValue() == fill_val);
-        CPPUNIT_ASSERT(node.m_branches[i].node->m_bitfield.isFull());
+        CPPUNIT_ASSERT(node.m_bitfield.isSet(i));
+        CPPUNIT_ASSERT(node.getBranch(i).node->isFill());
+        CPPUNIT_ASSERT(node.getBranch(i).node->m_branches.size() == 0);
+        CPPUNIT_ASSERT(node.getBranch(i).node->fillValue() == fill_val);
+        CPPUNIT_ASSERT(node.getBranch(i).node->m_bitfield.isFull());
     }
 }
 
@@ -765,19 +767,18 @@ TestNode::testUnsetSingleLevel()
     // do the unset
     node.unset(1, 2, 3, default_val);
 
-    CPPUNIT_ASSERT(node.m_branches[0].cell->get(1, 2, 3) == default_val);
-    CPPUNIT_ASSERT(!node.m_branches[0].cell->m_bitfield.isSet(1, 2, 3));
-    CPPUNIT_ASSERT(node.m_branches[0].cell->m_bitfield.isSet(0, 0, 0));
+    CPPUNIT_ASSERT(node.getBranch(0).cell->get(1, 2, 3) == default_val);
+    CPPUNIT_ASSERT(!node.getBranch(0).cell->m_bitfield.isSet(1, 2, 3));
+    CPPUNIT_ASSERT(node.getBranch(0).cell->m_bitfield.isSet(0, 0, 0));
 
     node.unset(12, 15, 13, default_val);
 
     // Make sure the cell was removed. 
-    CPPUNIT_ASSERT(node.m_branches[63].cell == NULL);
     CPPUNIT_ASSERT(!node.m_bitfield.isSet(63));
 
     // check that all other cell branches are null
-    for (size_t i = 1; i < node.m_branches.size(); ++i) {
-        CPPUNIT_ASSERT(node.m_branches[i].cell == NULL);
+    for (size_t i = 1; i < numBits3D(node.m_bitfield.size()); ++i) {
+        CPPUNIT_ASSERT(!node.m_bitfield.isSet(i));
     }
 }
 
@@ -801,7 +802,7 @@ TestNode::testUnsetMultiLevel()
     // do unset operations.
     node.unset(0, 0, 0, default_val);
 
-    cell = node.m_branches[0].node->m_branches[0].cell;
+    cell = node.getBranch(0).node->getBranch(0).cell;
     CPPUNIT_ASSERT(!cell->m_bitfield.isSet(0, 0, 0));
     CPPUNIT_ASSERT(cell->get(0, 0, 0) == default_val);
     CPPUNIT_ASSERT(cell->get(1, 1, 1) == val);
@@ -810,20 +811,20 @@ TestNode::testUnsetMultiLevel()
     node.unset(4, 0, 0, default_val);
 
     CPPUNIT_ASSERT(node.get(4, 0, 0) == default_val);
-    CPPUNIT_ASSERT(node.m_branches[0].node != NULL);
-    CPPUNIT_ASSERT(!node.m_branches[0].node->m_bitfield.isSet(1));
-    CPPUNIT_ASSERT(node.m_branches[0].node->m_branches[1].cell == NULL);
+    CPPUNIT_ASSERT(node.m_bitfield.isSet(0));
+    CPPUNIT_ASSERT(!node.getBranch(0).node->m_bitfield.isSet(1));
 
     // another unset that removes the node and the cell
     node.unset(1, 1, 1, default_val);
     CPPUNIT_ASSERT(node.m_bitfield.isEmpty());
     CPPUNIT_ASSERT(node.m_bitfield.isEmpty());
     CPPUNIT_ASSERT(node.defaultValue() == default_val);
-    CPPUNIT_ASSERT(node.m_branches.size() == numBits3D(node.m_bitfield.size()));
+    CPPUNIT_ASSERT(node.m_branches.empty());
+    CPPUNIT_ASSERT(!node.isDense());
 
     // make sure all nodes are null
-    for (size_t i = 0; i < node.m_branches.size(); ++i) {
-        CPPUNIT_ASSERT(node.m_branches[i].node == NULL);
+    for (size_t i = 0; i < numBits3D(node.m_bitfield.size()); ++i) {
+        CPPUNIT_ASSERT(!node.m_bitfield.isSet(i));
     }
 }
 
@@ -847,7 +848,7 @@ TestNode::testFillUnsetSingleLevel()
     node.unset(1, 2, 3, default_val);
 
     CPPUNIT_ASSERT(node.m_bitfield.isFull());
-    cell = node.m_branches[0].cell;
+    cell = node.getBranch(0).cell;
     CPPUNIT_ASSERT(cell != NULL);
     CPPUNIT_ASSERT(!cell->m_bitfield.isFull());
     CPPUNIT_ASSERT(cell->get(1, 2, 3) == default_val);
@@ -865,14 +866,14 @@ TestNode::testFillUnsetSingleLevel()
 
     // maek sure all other branches are filled cells.
     for (size_t i = 1; i < numBits3D(node.m_bitfield.size()); ++i) {
-        CPPUNIT_ASSERT(node.m_branches[i].cell->isFilled());
-        CPPUNIT_ASSERT(node.m_branches[i].cell->m_bitfield.isFull());
+        CPPUNIT_ASSERT(node.getBranch(i).cell->isFilled());
+        CPPUNIT_ASSERT(node.getBranch(i).cell->m_bitfield.isFull());
     }
 
     node.unset(12, 15, 13, default_val);
 
     // Make sure the cell was converted to a allocated cell. 
-    cell = node.m_branches[63].cell;
+    cell = node.getBranch(63).cell;
     CPPUNIT_ASSERT(cell->isFilled());
     CPPUNIT_ASSERT(node.m_bitfield.isFull());
     CPPUNIT_ASSERT(cell->get(0, 3, 1) == default_val);
@@ -914,24 +915,24 @@ TestNode::testFillUnsetMultiLevel()
     CPPUNIT_ASSERT(node.m_branches.size() == numBits3D(2));
 
     // make sure that all subsequent nodes are created and are fill nodes.
-    for (size_t i = 1; i < node.m_branches.size(); ++i) {
-        CPPUNIT_ASSERT(node.m_branches[i].node != NULL);
-        CPPUNIT_ASSERT(node.m_branches[i].node->isFill());
-        CPPUNIT_ASSERT(node.m_branches[i].node->fillValue() == fill_val);
+    for (size_t i = 1; i < numBits3D(node.m_bitfield.size()); ++i) {
+        CPPUNIT_ASSERT(node.m_bitfield.isSet(i));
+        CPPUNIT_ASSERT(node.getBranch(i).node->isFill());
+        CPPUNIT_ASSERT(node.getBranch(i).node->fillValue() == fill_val);
     }
 
     // The node that has the cell.
-    node2 = node.m_branches[0].node;
+    node2 = node.getBranch(0).node;
     CPPUNIT_ASSERT(!node2->isFill());
     CPPUNIT_ASSERT(node2->m_bitfield.isFull());
 
-    cell = node2->m_branches[0].cell;
+    cell = node2->getBranch(0).cell;
 
     // make sure all other cell branches are filled cells.
     CPPUNIT_ASSERT(node2->m_branches.size() == numBits3D(2));
-    for (size_t i = 1; i < node2->m_branches.size(); ++i) {
-        CPPUNIT_ASSERT(node2->m_branches[i].cell->isFilled());
-        CPPUNIT_ASSERT(node2->m_branches[i].cell->getFillValue() == fill_val);
+    for (size_t i = 1; i < numBits3D(node2->m_bitfield.size()); ++i) {
+        CPPUNIT_ASSERT(node2->getBranch(i).cell->isFilled());
+        CPPUNIT_ASSERT(node2->getBranch(i).cell->getFillValue() == fill_val);
     }
 
     CPPUNIT_ASSERT(cell->get(0, 0, 0) == default_val);
@@ -1093,3 +1094,69 @@ TestNode::testWriteStamp()
     TEST_STAMP_BOUNDS(-1, -1, -1);
 }
 
+//------------------------------------------------------------------------------
+
+void
+TestNode::testSparseBranches()
+{
+    USING_NKHIVE_NS
+
+    typedef Node<Cell<float> > node_type;
+
+    // 64 branches, dense above 16 set ones.
+    node_type node(1, 2, 2, 0.0f);
+    CPPUNIT_ASSERT(node.denseThreshold() == 16);
+    CPPUNIT_ASSERT(!node.isDense());
+    CPPUNIT_ASSERT(node.m_branches.empty());
+
+    // set the branches back to front, slots must stay in bit order.
+    for (index_type b = 63; b >= 48; --b) {
+        index_type i, j, k;
+        node.m_bitfield.getCoordinates(b, i, j, k);
+        node.set(i * 4 + 1, j * 4 + 2, k * 4 + 3, float(b));
+    }
+    CPPUNIT_ASSERT(!node.isDense());
+    CPPUNIT_ASSERT(node.m_branches.size() == 16);
+
+    node_type::branch_iterator iter = node.branchIterator();
+    for (index_type b = 48; b < 64; ++b, ++iter) {
+        CPPUNIT_ASSERT(iter());
+        CPPUNIT_ASSERT(iter.getIndex() == b);
+        CPPUNIT_ASSERT(iter->cell->get(1, 2, 3) == float(b));
+        CPPUNIT_ASSERT(node.getBranch(b).cell == iter->cell);
+    }
+    CPPUNIT_ASSERT(!iter());
+
+    // the same node stored dense is equal but bigger.
+    node_type dense(1, 2, 2, 0.0f);
+    std::ostringstream ostr(std::ios_base::binary);
+    node.write(ostr);
+    std::istringstream istr(ostr.str(), std::ios_base::binary);
+    dense.read(istr);
+    CPPUNIT_ASSERT(!dense.isDense());
+    dense.makeDense();
+    CPPUNIT_ASSERT(dense.isDense());
+    CPPUNIT_ASSERT(dense == node);
+    CPPUNIT_ASSERT(dense.sizeOf() > node.sizeOf());
+
+    // one more branch switches to dense storage.
+    node.set(1, 2, 3, 100.0f);
+    CPPUNIT_ASSERT(node.isDense());
+    CPPUNIT_ASSERT(node.m_branches.size() == 64);
+    CPPUNIT_ASSERT(node.get(1, 2, 3) == 100.0f);
+    CPPUNIT_ASSERT(node.get(13, 14, 15) == 63.0f);
+
+    // and it switches back once half the threshold is left.
+    node.unset(1, 2, 3, 0.0f);
+    for (index_type b = 48; b < 56; ++b) {
+        index_type i, j, k;
+        node.m_bitfield.getCoordinates(b, i, j, k);
+        CPPUNIT_ASSERT(node.isDense());
+        node.unset(i * 4 + 1, j * 4 + 2, k * 4 + 3, 0.0f);
+    }
+    CPPUNIT_ASSERT(!node.isDense());
+    CPPUNIT_ASSERT(node.m_branches.size() == 8);
+    CPPUNIT_ASSERT(node.get(13, 14, 15) == 63.0f);
+    CPPUNIT_ASSERT(node.get(1, 2, 3) == 0.0f);
+}
+
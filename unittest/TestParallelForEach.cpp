@@ -0,0 +1,400 @@
+//------------------------------------------------------------------------------
+//
+// Copyright (c) 2011, NektarFX, Inc. (http://www.nektarfx.com)
+// All rights reserved.
+// 
+// Redistribution and use in source and binary forms, with or without modific-
+// ation, are permitted provided that the following conditions are met:
+// 
+//  - Redistributions of source code must retain the above copyright notice, 
+//    this list of conditions and the following disclaimer.
+//  - Redistributions in binary form must reproduce the above copyright 
+//    notice, this list of conditions and the following disclaimer in the 
+//    documentation and/or other materials provided with the distribution.
+//  - Neither the name of NektarFX, Inc. nor the names of its contributors may 
+//    be used to endorse or promote products derived from this software 
+//    without specific prior written permission.
+// 
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" 
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE 
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE 
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE 
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSE-
+// QUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE 
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) 
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT 
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY 
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH 
+// DAMAGE.
+// 
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// TestParallelForEach.cpp
+//------------------------------------------------------------------------------
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <cppunit/TestFixture.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <nkhive/volume/Volume.h>
+
+//-----------------------------------------------------------------------------
+// types
+//-----------------------------------------------------------------------------
+
+typedef NKHIVE_NS::Volume<NK_NS::i32> pfe_volume_type;
+
+/**
+ * A visited voxel, ordered by coordinates.
+ */
+struct PfeVoxel
+{
+    NKHIVE_NS::signed_index_vec coords;
+    NK_NS::i32                  value;
+
+    bool operator<(const PfeVoxel &that) const
+    {
+        if (coords.z != that.coords.z) return coords.z < that.coords.z;
+        if (coords.y != that.coords.y) return coords.y < that.coords.y;
+        return coords.x < that.coords.x;
+    }
+
+    bool operator==(const PfeVoxel &that) const
+    {
+        return (coords == that.coords) && (value == that.value);
+    }
+};
+
+typedef std::vector<PfeVoxel> pfe_voxel_vector;
+
+/**
+ * Records the voxels it is called for.
+ */
+struct PfeCollect
+{
+    void operator()(const NKHIVE_NS::signed_index_vec &coords, 
+                    const NK_NS::i32 &value)
+    {
+        PfeVoxel voxel = { coords, value };
+        voxels.push_back(voxel);
+    }
+
+    pfe_voxel_vector voxels;
+};
+
+/**
+ * Coordinate dependent in place update.
+ */
+struct PfeAddCoords
+{
+    void operator()(const NKHIVE_NS::signed_index_vec &coords, 
+                    NK_NS::i32 &value)
+    {
+        value = value * 2 + coords.x;
+    }
+};
+
+/**
+ * Uniform in place update.
+ */
+struct PfeTriple
+{
+    void operator()(const NKHIVE_NS::signed_index_vec&, NK_NS::i32 &value)
+    {
+        value *= 3;
+    }
+};
+
+/**
+ * Fails on voxels right of the origin.
+ */
+struct PfeThrowPositive
+{
+    void operator()(const NKHIVE_NS::signed_index_vec &coords, 
+                    const NK_NS::i32&)
+    {
+        if (coords.x > 0) throw std::runtime_error("positive voxel");
+    }
+};
+
+/**
+ * Counts the filled cells.
+ */
+struct PfeCountFilled
+{
+    PfeCountFilled() : 
+        filled(0) 
+    {
+    }
+
+    void operator()(const pfe_volume_type::const_leaf &leaf)
+    {
+        if (leaf.cell().isFilled()) ++filled;
+    }
+
+    int filled;
+};
+
+/**
+ * Checks the leaves against the volume, counting cells and voxels.
+ */
+struct PfeCheckLeaves
+{
+    PfeCheckLeaves(const pfe_volume_type *v) : 
+        volume(v), cells(0), voxels(0), mismatches(0) 
+    {
+    }
+
+    void operator()(const pfe_volume_type::const_leaf &leaf)
+    {
+        ++cells;
+        for (NKHIVE_NS::index_type n = leaf.begin(); n < leaf.end(); ++n) {
+            NKHIVE_NS::index_type i, j, k;
+            NKHIVE_NS::getCoordinates(n, 2, i, j, k);
+            if (!leaf.cell().isSet(i, j, k)) continue;
+
+            ++voxels;
+            NKHIVE_NS::signed_index_vec coords;
+            leaf.getCoordinates(n, coords);
+            if (volume->get(coords) != leaf.cell().get(n)) ++mismatches;
+        }
+    }
+
+    const pfe_volume_type *volume;
+    int cells;
+    int voxels;
+    int mismatches;
+};
+
+//-----------------------------------------------------------------------------
+// interface declaration
+//-----------------------------------------------------------------------------
+
+class TestParallelForEach : public CppUnit::TestFixture 
+{
+    CPPUNIT_TEST_SUITE(TestParallelForEach);
+    CPPUNIT_TEST(testEmpty);
+    CPPUNIT_TEST(testReadOnly);
+    CPPUNIT_TEST(testInPlace);
+    CPPUNIT_TEST(testLeaves);
+    CPPUNIT_TEST(testFailure);
+    CPPUNIT_TEST_SUITE_END();
+    
+public:
+    void setUp() {}
+    void tearDown() {}
+    
+    void testEmpty();
+    void testReadOnly();
+    void testInPlace();
+    void testLeaves();
+    void testFailure();
+
+private:
+
+    /**
+     * Fills the volume with scattered voxels in all quadrants and a few
+     * filled cells.
+     */
+    static void populate(pfe_volume_type &volume);
+
+    /**
+     * Merges and sorts the voxels gathered by the functor copies.
+     */
+    static pfe_voxel_vector merge(const std::vector<PfeCollect> &functors);
+
+    /**
+     * Gathers the voxels of the volume with its set iterator.
+     */
+    static pfe_voxel_vector serial(const pfe_volume_type &volume);
+};
+
+//-----------------------------------------------------------------------------
+// test suite registration
+//-----------------------------------------------------------------------------
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TestParallelForEach);
+
+//------------------------------------------------------------------------------
+// helpers
+//------------------------------------------------------------------------------
+
+void
+TestParallelForEach::populate(pfe_volume_type &volume)
+{
+    USING_NK_NS
+
+    u32 seed = 7;
+    for (int n = 0; n < 4000; ++n) {
+        i32 c[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            seed = seed * 1664525u + 1013904223u;
+            c[axis] = i32((seed >> 8) % 200u) - 100;
+        }
+        volume.set(c[0], c[1], c[2], i32(seed >> 20));
+    }
+
+    // filled cells, one in a positive and one in a negative quadrant
+    for (i32 k = 0; k < 4; ++k) {
+        for (i32 j = 0; j < 4; ++j) {
+            for (i32 i = 0; i < 4; ++i) {
+                volume.set(i + 200, j, k, 5);
+                volume.set(-i - 200, -j - 8, k, 6);
+            }
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+
+pfe_voxel_vector
+TestParallelForEach::merge(const std::vector<PfeCollect> &functors)
+{
+    pfe_voxel_vector voxels;
+    for (size_t n = 0; n < functors.size(); ++n) {
+        voxels.insert(voxels.end(), 
+                      functors[n].voxels.begin(), functors[n].voxels.end());
+    }
+    std::sort(voxels.begin(), voxels.end());
+    return voxels;
+}
+
+//------------------------------------------------------------------------------
+
+pfe_voxel_vector
+TestParallelForEach::serial(const pfe_volume_type &volume)
+{
+    PfeCollect collect;
+    pfe_volume_type::set_iterator sit = volume.setIterator();
+    for ( ; sit(); ++sit) {
+        NKHIVE_NS::signed_index_vec coords;
+        sit.getCoordinates(coords);
+        collect(coords, *sit);
+    }
+    std::sort(collect.voxels.begin(), collect.voxels.end());
+    return collect.voxels;
+}
+
+//------------------------------------------------------------------------------
+// tests
+//------------------------------------------------------------------------------
+
+void
+TestParallelForEach::testEmpty()
+{
+    const pfe_volume_type volume(2, 2, 0);
+
+    std::vector<PfeCollect> functors = 
+        volume.parallelForEach(PfeCollect(), 4);
+    CPPUNIT_ASSERT(functors.size() == 1);
+    CPPUNIT_ASSERT(functors[0].voxels.empty());
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestParallelForEach::testReadOnly()
+{
+    pfe_volume_type volume(2, 2, 0);
+    populate(volume);
+
+    pfe_voxel_vector expected = serial(volume);
+    CPPUNIT_ASSERT(!expected.empty());
+
+    const pfe_volume_type &const_volume = volume;
+    for (size_t threads = 1; threads <= 8; threads *= 2) {
+        std::vector<PfeCollect> functors = 
+            const_volume.parallelForEach(PfeCollect(), threads);
+        CPPUNIT_ASSERT(functors.size() <= threads);
+        CPPUNIT_ASSERT(merge(functors) == expected);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestParallelForEach::testInPlace()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    pfe_volume_type volume(2, 2, 0);
+    populate(volume);
+
+    pfe_voxel_vector expected = serial(volume);
+    for (size_t n = 0; n < expected.size(); ++n) {
+        expected[n].value = expected[n].value * 2 + expected[n].coords.x;
+    }
+
+    volume.parallelForEach(PfeAddCoords(), 4);
+    CPPUNIT_ASSERT(serial(volume) == expected);
+
+    // uniform results keep filled cells filled
+    pfe_volume_type filled(2, 2, 0);
+    for (i32 k = 0; k < 4; ++k) {
+        for (i32 j = 0; j < 4; ++j) {
+            for (i32 i = 0; i < 4; ++i) {
+                filled.set(-i - 1, j, k, 3);
+            }
+        }
+    }
+    filled.parallelForEach(PfeTriple(), 2);
+
+    const pfe_volume_type &const_filled = filled;
+    CPPUNIT_ASSERT(
+        const_filled.parallelForEachLeaf(PfeCountFilled(), 1)[0].filled == 1);
+    CPPUNIT_ASSERT(filled.get(-1, 0, 0) == 9);
+    CPPUNIT_ASSERT(filled.get(-4, 3, 3) == 9);
+    CPPUNIT_ASSERT(filled.get(0, 0, 0) == 0);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestParallelForEach::testLeaves()
+{
+    pfe_volume_type volume(2, 2, 0);
+    populate(volume);
+
+    const pfe_volume_type &const_volume = volume;
+    std::vector<PfeCheckLeaves> functors = 
+        const_volume.parallelForEachLeaf(PfeCheckLeaves(&volume), 3);
+
+    int cells = 0, voxels = 0, mismatches = 0;
+    for (size_t n = 0; n < functors.size(); ++n) {
+        cells      += functors[n].cells;
+        voxels     += functors[n].voxels;
+        mismatches += functors[n].mismatches;
+    }
+
+    CPPUNIT_ASSERT(cells > 0);
+    CPPUNIT_ASSERT(voxels == int(serial(volume).size()));
+    CPPUNIT_ASSERT(mismatches == 0);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestParallelForEach::testFailure()
+{
+    pfe_volume_type volume(2, 2, 0);
+    populate(volume);
+
+    // every thread count reports the error and the volume stays usable
+    const pfe_volume_type &const_volume = volume;
+    pfe_voxel_vector expected = serial(volume);
+    for (size_t threads = 1; threads <= 4; threads *= 2) {
+        CPPUNIT_ASSERT_THROW(
+            const_volume.parallelForEach(PfeThrowPositive(), threads),
+            Iex::LogicExc);
+        CPPUNIT_ASSERT(
+            merge(const_volume.parallelForEach(PfeCollect(), threads)) == 
+            expected);
+    }
+}
+
+//------------------------------------------------------------------------------
@@ -33,6 +33,11 @@
 // TestTree.cpp
 //------------------------------------------------------------------------------
 
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -40,11 +45,42 @@
 #include <nkhive/volume/Tree.h>
 #include <nkhive/volume/Cell.h>
 #include <nkhive/io/VolumeFile.h>
+#include <nkhive/memory/PoolAllocator.h>
 
 //-----------------------------------------------------------------------------
 // types
 //-----------------------------------------------------------------------------
 
+/**
+ * Output buffer that cannot seek, like a pipe.
+ */
+class AppendBuf : public std::streambuf
+{
+public:
+    std::string& bytes() 
+    { 
+        return m_bytes; 
+    }
+
+protected:
+    int_type overflow(int_type c)
+    {
+        if (c != traits_type::eof()) m_bytes.push_back(char(c));
+        return c;
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n)
+    {
+        m_bytes.append(s, n);
+        return n;
+    }
+
+private:
+    std::string m_bytes;
+};
+
+//------------------------------------------------------------------------------
+
 template <typename T> 
 class CoordinateMapper
 {
@@ -66,6 +102,44 @@ private:
     NKHIVE_NS::signed_index_bounds m_bounds;
 };
 
+//-----------------------------------------------------------------------------
+// parallel for-each functors
+//-----------------------------------------------------------------------------
+
+struct TreeSumVoxels
+{
+    TreeSumVoxels() : 
+        count(0), sum(0.0), min(1 << 30), max(-(1 << 30))
+    {
+    }
+
+    void operator()(const NKHIVE_NS::signed_index_vec &coords, 
+                    const float &value)
+    {
+        ++count;
+        sum += value;
+        min.x = std::min(min.x, coords.x);
+        max.x = std::max(max.x, coords.x);
+    }
+
+    size_t count;
+    double sum;
+    NKHIVE_NS::signed_index_vec min, max;
+};
+
+struct TreeOffsetVoxels
+{
+    void operator()(const NKHIVE_NS::signed_index_vec &coords, float &value)
+    {
+        value += float(coords.x);
+    }
+};
+
+struct TreeAddOp
+{
+    float operator()(const float &a, const float &b) const { return a + b; }
+};
+
 //-----------------------------------------------------------------------------
 // interface declaration
 //-----------------------------------------------------------------------------
@@ -84,6 +158,7 @@ class TestTree: public CppUnit::TestFixture {
     CPPUNIT_TEST(testUnsetEmpty);
     CPPUNIT_TEST(testUnset);
     CPPUNIT_TEST(testIO);
+    CPPUNIT_TEST(testIOIndexed);
     CPPUNIT_TEST(testIOHDF5);
     CPPUNIT_TEST(testSetIteratorEmptyTree);
     CPPUNIT_TEST(testSetIteratorSingleQuadrant);
@@ -93,6 +168,13 @@ class TestTree: public CppUnit::TestFixture {
     CPPUNIT_TEST(testGetQuadrantBounds);
     CPPUNIT_TEST(testWriteStamp);
     CPPUNIT_TEST(testWriteStampOrigin);
+    CPPUNIT_TEST(testAccessorFillNode);
+    CPPUNIT_TEST(testPooledTree);
+    CPPUNIT_TEST(testConcurrentFillSplit);
+    CPPUNIT_TEST(testConcurrentDensify);
+    CPPUNIT_TEST(testParallelForEachFillNode);
+    CPPUNIT_TEST(testPrune);
+    CPPUNIT_TEST(testAutoPrune);
     CPPUNIT_TEST_SUITE_END();
     
 public:
@@ -110,6 +192,7 @@ public:
     void testUnsetEmpty();
     void testUnset();
     void testIO();
+    void testIOIndexed();
     void testIOHDF5();
     void testSetIteratorEmptyTree();
     void testSetIteratorSingleQuadrant();
@@ -119,6 +202,13 @@ public:
     void testGetQuadrantBounds();
     void testWriteStamp();
     void testWriteStampOrigin();
+    void testAccessorFillNode();
+    void testPooledTree();
+    void testConcurrentFillSplit();
+    void testConcurrentDensify();
+    void testParallelForEachFillNode();
+    void testPrune();
+    void testAutoPrune();
 };
 
 //-----------------------------------------------------------------------------
@@ -155,7 +245,7 @@ TestTree::testSetQuadrant()
 
         tree.update(q, 0, 0, 0, 5.0f, set_op<float>());
 
-        Cell<float> *cell = tree.m_root[q]->m_branches[0].cell;
+        Cell<float> *cell = tree.m_root[q]->getBranch(0).cell;
 
         CPPUNIT_ASSERT(cell->get(0, 0, 0) == 5.0f);
 
@@ -172,7 +262,7 @@ TestTree::testSetQuadrant()
         CPPUNIT_ASSERT(cell->get(3, 3, 3) == 5.0f);
 
         tree.update(q, 15, 15, 15, 5.0f, set_op<float>());
-        cell = tree.m_root[q]->m_branches[63].cell;
+        cell = tree.m_root[q]->getBranch(63).cell;
         CPPUNIT_ASSERT(cell->get(3, 3, 3) == 5.0f);
 
         for (size_t i = 0; i < 2; ++i) {
@@ -204,10 +294,9 @@ TestTree::testSetGrowingTree()
         CPPUNIT_ASSERT(tree.height(q) == 2);
         CPPUNIT_ASSERT(tree.m_max_dim[q] == 64);
         CPPUNIT_ASSERT(!tree.m_root[q]->m_bitfield.isSet(0));
-        CPPUNIT_ASSERT(tree.m_root[q]->m_branches[0].node == NULL);
 
         Cell<float> *cell = 
-            tree.m_root[q]->m_branches[1].node->m_branches[0].cell;
+            tree.m_root[q]->getBranch(1).node->getBranch(0).cell;
 
         CPPUNIT_ASSERT(cell->get(0, 0, 0) == 5.0f);
 
@@ -221,8 +310,8 @@ TestTree::testSetGrowingTree()
 
         tree.update(q, 64, 64, 64, 5.0f, set_op<float>());
 
-        cell = tree.m_root[q]->m_branches[21].node->m_branches[0].node->
-               m_branches[0].cell;
+        cell = tree.m_root[q]->getBranch(21).node->getBranch(0).node->
+               getBranch(0).cell;
 
         CPPUNIT_ASSERT(cell->get(0, 0, 0) == 5.0f);
         for (size_t i = 1; i < 3; ++i) {
@@ -238,9 +327,9 @@ TestTree::testSetGrowingTree()
         // Make sure the the subtree bit is set.
         CPPUNIT_ASSERT(tree.m_root[q]->m_bitfield.isSet(0));
 
-        // Test the original cell at m_branches[0] for 16,0,0
-        cell = tree.m_root[q]->m_branches[0].node->m_branches[1].node->
-               m_branches[0].cell;
+        // Test the original cell at branch 0 for 16,0,0
+        cell = tree.m_root[q]->getBranch(0).node->getBranch(1).node->
+               getBranch(0).cell;
         CPPUNIT_ASSERT(cell->get(0, 0, 0) == 5.0f);
     }
 }
@@ -263,7 +352,6 @@ TestTree::testMultiLevelGrowing()
         CPPUNIT_ASSERT(tree.height(q) == 4);
         CPPUNIT_ASSERT(!tree.m_root[q]->isEmpty());
 
-        CPPUNIT_ASSERT(tree.m_root[q]->m_branches[0].node == NULL);
         CPPUNIT_ASSERT(!tree.m_root[q]->m_bitfield.isSet(0));
     }
 }
@@ -353,7 +441,7 @@ TestTree::testSetSigned()
         index_type q = getQuadrant(i, j, k);                           \
         tree.set(63 * i, 63 * j, 63 * k, 5.0f);                        \
         Cell<float> *cell =                                            \
-            tree.m_root[q]->m_branches[63].node->m_branches[63].cell;  \
+            tree.m_root[q]->getBranch(63).node->getBranch(63).cell;    \
         vec3i check(3, 3, 3);                                          \
         index_type offset_i, offset_j, offset_k;                       \
         getQuadrantOffsets(offset_i, offset_j, offset_k, q);           \
@@ -392,21 +480,21 @@ TestTree::testSetSigned()
         tree.set(-1, -1, -1, 8.0f);
         
         CPPUNIT_ASSERT(tree.m_root[0]->
-                m_branches[0].cell->get(0,  0,  0) == 1.0f);
+                getBranch(0).cell->get(0,  0,  0) == 1.0f);
         CPPUNIT_ASSERT(tree.m_root[1]->
-                m_branches[0].cell->get(0,  0,  0) == 2.0f);
+                getBranch(0).cell->get(0,  0,  0) == 2.0f);
         CPPUNIT_ASSERT(tree.m_root[2]->
-                m_branches[0].cell->get(0,  0,  0) == 3.0f);
+                getBranch(0).cell->get(0,  0,  0) == 3.0f);
         CPPUNIT_ASSERT(tree.m_root[3]->
-                m_branches[0].cell->get(0,  0,  0) == 4.0f);
+                getBranch(0).cell->get(0,  0,  0) == 4.0f);
         CPPUNIT_ASSERT(tree.m_root[4]->
-                m_branches[0].cell->get(0,  0,  0) == 5.0f);
+                getBranch(0).cell->get(0,  0,  0) == 5.0f);
         CPPUNIT_ASSERT(tree.m_root[5]->
-                m_branches[0].cell->get(0,  0,  0) == 6.0f);
+                getBranch(0).cell->get(0,  0,  0) == 6.0f);
         CPPUNIT_ASSERT(tree.m_root[6]->
-                m_branches[0].cell->get(0,  0,  0) == 7.0f);
+                getBranch(0).cell->get(0,  0,  0) == 7.0f);
         CPPUNIT_ASSERT(tree.m_root[7]->
-                m_branches[0].cell->get(0,  0,  0) == 8.0f);
+                getBranch(0).cell->get(0,  0,  0) == 8.0f);
     }
 }
 
@@ -555,6 +643,96 @@ TestTree::testIO()
 
 //------------------------------------------------------------------------------
 
+void
+TestTree::testIOIndexed()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef Tree<Cell<float> > tree_type;
+
+    tree_type tree(2, 2, 1.0f);
+    tree.set(0, 0, 0, 10.0f);
+    tree.set(-1, -1, -4, 6.0f);
+    tree.set(64, 64, 64, 10.0f);
+    for (int k = 0; k < 16; ++k) {
+        for (int j = 0; j < 16; ++j) {
+            for (int i = 32; i < 48; ++i) {
+                tree.set(i, j, k, 3.0f);
+            }
+        }
+    }
+    tree.prune();
+
+    // the table of contents lists every leaf
+    std::ostringstream ostr(std::ios_base::binary);
+    tree.write(ostr);
+    ostr << "tail";
+    std::string bytes = ostr.str();
+    CPPUNIT_ASSERT(bytes.compare(0, 8, "nkhvtree") == 0);
+
+    std::istringstream istr(bytes, std::ios_base::binary);
+    CPPUNIT_ASSERT(StreamLeafIndex<float>::isIndexed(istr));
+    StreamLeafIndex<float> index;
+    index.read(istr);
+    CPPUNIT_ASSERT(index.size() == 4);
+    CPPUNIT_ASSERT(index.defaultValue() == 1.0f);
+
+    size_t cells = 0;
+    for (size_t n = 0; n < index.size(); ++n) {
+        if (index[n].type == LEAF_TYPE_CELL) {
+            CPPUNIT_ASSERT(index[n].size > 0);
+            ++cells;
+        } else {
+            CPPUNIT_ASSERT(index[n].size == 0);
+            CPPUNIT_ASSERT(index[n].fill_value == 3.0f);
+        }
+    }
+    CPPUNIT_ASSERT(cells == 3);
+
+    // the tree is read back up to its end
+    tree_type tree2;
+    istr.seekg(0);
+    tree2.read(istr);
+    CPPUNIT_ASSERT(tree == tree2);
+    std::string tail;
+    istr >> tail;
+    CPPUNIT_ASSERT(tail == "tail");
+
+    // streams that cannot seek are buffered
+    AppendBuf append;
+    std::ostream pipe(&append);
+    tree.write(pipe);
+    CPPUNIT_ASSERT(append.bytes() == bytes.substr(0, bytes.size() - 4));
+
+    LeafStreamBuf in(append.bytes().data(), append.bytes().size());
+    std::istream pipe_in(&in);
+    tree_type tree3;
+    tree3.read(pipe_in);
+    CPPUNIT_ASSERT(tree == tree3);
+
+    // streams written before the index was added, nodes one after the other
+    std::ostringstream legacy(std::ios_base::binary);
+    float default_value = 1.0f;
+    legacy.write((char*)&default_value, sizeof(float));
+    for (int i = 0; i < NUM_QUADRANTS; ++i) {
+        tree.m_root[i]->write(legacy);
+    }
+    std::istringstream legacy_in(legacy.str(), std::ios_base::binary);
+    CPPUNIT_ASSERT(!StreamLeafIndex<float>::isIndexed(legacy_in));
+    tree_type tree4;
+    tree4.read(legacy_in);
+    CPPUNIT_ASSERT(tree == tree4);
+
+    // truncated streams are rejected, leaving the tree as it was
+    std::istringstream truncated(bytes.substr(0, bytes.size() / 2), 
+                                 std::ios_base::binary);
+    CPPUNIT_ASSERT_THROW(tree4.read(truncated), Iex::IoExc);
+    CPPUNIT_ASSERT(tree == tree4);
+}
+
+//------------------------------------------------------------------------------
+
 void
 TestTree::testIOHDF5()
 {
@@ -1061,3 +1239,331 @@ TestTree::testWriteStampOrigin()
 
 //------------------------------------------------------------------------------
 
+void
+TestTree::testAccessorFillNode()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef Tree<Cell<float> > tree_type;
+
+    tree_type tree(2, 2, 1.0f);
+
+    delete tree.m_root[0];
+    tree.m_root[0] = new tree_type::node_type(1, 2, 2, 2.0f, true);
+
+    tree_type::accessor acc = tree.getAccessor();
+
+    // reads from a fill node return the fill value, no cell to cache
+    CPPUNIT_ASSERT(acc.get(3, 5, 7) == 2.0f);
+    CPPUNIT_ASSERT(!acc.isCached(3, 5, 7));
+
+    // writing the fill value keeps the node filled
+    acc.set(3, 5, 7, 2.0f);
+    CPPUNIT_ASSERT(tree.m_root[0]->isFill());
+
+    // writing another value splits the fill node
+    acc.set(3, 5, 7, 3.0f);
+    CPPUNIT_ASSERT(tree.m_root[0]->isBranching());
+    CPPUNIT_ASSERT(acc.isCached(3, 5, 7));
+    CPPUNIT_ASSERT(acc.get(3, 5, 7) == 3.0f);
+    CPPUNIT_ASSERT(acc.get(3, 5, 6) == 2.0f);
+    CPPUNIT_ASSERT(acc.get(15, 15, 15) == 2.0f);
+    CPPUNIT_ASSERT(acc.get(16, 0, 0) == 1.0f);
+
+    CPPUNIT_ASSERT(tree.get(3, 5, 7) == 3.0f);
+    CPPUNIT_ASSERT(tree.get(0, 0, 0) == 2.0f);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestTree::testPooledTree()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef PoolAllocator<float>                        alloc_type;
+    typedef Tree<Cell<float, alloc_type>, alloc_type>   pooled_tree_type;
+    typedef Tree<Cell<float> >                          tree_type;
+
+    pooled_tree_type pooled(2, 2, 1.0f);
+    tree_type tree(2, 2, 1.0f);
+
+    // nodes, cells and bitfields all come out of the tree's pool
+    CPPUNIT_ASSERT(pooled.m_pool->bytesInUse() > 0);
+    CPPUNIT_ASSERT(pooled.m_root[0]->m_allocator.pool() == pooled.m_pool);
+
+    for (i32 k = -20; k < 20; k += 3) {
+        for (i32 j = -20; j < 20; j += 2) {
+            for (i32 i = -20; i < 20; ++i) {
+                pooled.set(i, j, k, float(i + j + k));
+                tree.set(i, j, k, float(i + j + k));
+            }
+        }
+    }
+    size_t in_use = pooled.m_pool->bytesInUse();
+
+    for (i32 k = -22; k < 22; ++k) {
+        for (i32 j = -22; j < 22; ++j) {
+            for (i32 i = -22; i < 22; ++i) {
+                CPPUNIT_ASSERT(pooled.get(i, j, k) == tree.get(i, j, k));
+            }
+        }
+    }
+
+    // unsetting everything returns the cells to the pool
+    for (i32 k = -20; k < 20; k += 3) {
+        for (i32 j = -20; j < 20; j += 2) {
+            for (i32 i = -20; i < 20; ++i) {
+                pooled.unset(i, j, k);
+            }
+        }
+    }
+    CPPUNIT_ASSERT(pooled.m_pool->bytesInUse() < in_use);
+    CPPUNIT_ASSERT(pooled.get(0, 0, 0) == 1.0f);
+
+    // freed blocks are recycled before the pool grows
+    size_t reserved = pooled.m_pool->bytesReserved();
+    pooled.set(5, 5, 5, 2.0f);
+    pooled.unset(5, 5, 5);
+    CPPUNIT_ASSERT(pooled.m_pool->bytesReserved() == reserved);
+
+    // releasing hands back slabs but leaves the tree intact
+    pooled.releaseMemory();
+    CPPUNIT_ASSERT(pooled.m_pool->bytesReserved() < reserved);
+    CPPUNIT_ASSERT(pooled.m_pool->bytesReserved() >= 
+                   pooled.m_pool->bytesInUse());
+
+    pooled.set(-7, 3, 11, 4.0f);
+    CPPUNIT_ASSERT(pooled.get(-7, 3, 11) == 4.0f);
+    CPPUNIT_ASSERT(pooled.get(-7, 3, 12) == 1.0f);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestTree::testConcurrentFillSplit()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef Tree<Cell<float> > tree_type;
+
+    tree_type tree(2, 2, 1.0f);
+
+    delete tree.m_root[0];
+    tree.m_root[0] = new tree_type::node_type(1, 2, 2, 2.0f, true);
+
+    // every thread splits the same fill root on its first write
+    tree.beginConcurrentWrites();
+    boost::thread_group threads;
+    for (i32 t = 0; t < 4; ++t) {
+        void (tree_type::*set)(signed_index_type, signed_index_type, 
+                               signed_index_type, const float&) = 
+            &tree_type::set;
+        threads.create_thread(boost::bind(set, &tree, t * 4, t, 15 - t, 
+                                          float(10 + t)));
+    }
+    threads.join_all();
+    tree.endConcurrentWrites();
+
+    CPPUNIT_ASSERT(tree.m_root[0]->isBranching());
+    CPPUNIT_ASSERT(tree.m_retired.empty());
+    for (i32 t = 0; t < 4; ++t) {
+        CPPUNIT_ASSERT(tree.get(t * 4, t, 15 - t) == float(10 + t));
+    }
+    CPPUNIT_ASSERT(tree.get(1, 2, 3) == 2.0f);
+    CPPUNIT_ASSERT(tree.get(16, 0, 0) == 1.0f);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestTree::testConcurrentDensify()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef Tree<Cell<float> > tree_type;
+
+    tree_type tree(2, 2, 1.0f);
+    tree.set(1, 1, 1, 2.0f);
+    tree.set(40, 1, 1, 3.0f);
+    CPPUNIT_ASSERT(!tree.m_root[0]->isDense());
+
+    // nodes are left sparse until written through
+    tree.beginConcurrentWrites();
+    CPPUNIT_ASSERT(!tree.m_root[0]->isDense());
+
+    boost::thread_group threads;
+    for (i32 t = 0; t < 4; ++t) {
+        void (tree_type::*set)(signed_index_type, signed_index_type, 
+                               signed_index_type, const float&) = 
+            &tree_type::set;
+        threads.create_thread(boost::bind(set, &tree, 4 + t * 8, 1, 1, 
+                                          float(10 + t)));
+    }
+    threads.join_all();
+    CPPUNIT_ASSERT(tree.m_root[0]->isDense());
+    tree.endConcurrentWrites();
+
+    // and sparse again once the writes are done
+    CPPUNIT_ASSERT(!tree.m_root[0]->isDense());
+    CPPUNIT_ASSERT(tree.m_retired.empty());
+    CPPUNIT_ASSERT(tree.m_expanded.empty());
+    CPPUNIT_ASSERT(tree.get(1, 1, 1) == 2.0f);
+    CPPUNIT_ASSERT(tree.get(40, 1, 1) == 3.0f);
+    for (i32 t = 0; t < 4; ++t) {
+        CPPUNIT_ASSERT(tree.get(4 + t * 8, 1, 1) == float(10 + t));
+    }
+    CPPUNIT_ASSERT(tree.get(5, 1, 1) == 1.0f);
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestTree::testParallelForEachFillNode()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef Tree<Cell<float> > tree_type;
+
+    tree_type tree(2, 2, 1.0f);
+
+    delete tree.m_root[4];
+    tree.m_root[4] = new tree_type::node_type(1, 2, 2, 2.0f, true);
+
+    // read-only traversals see every voxel of the fill node, i in [-16, -1]
+    const tree_type &const_tree = tree;
+    std::vector<TreeSumVoxels> sums = 
+        const_tree.parallelForEach(TreeSumVoxels(), 4);
+    CPPUNIT_ASSERT(sums.size() == 1);
+    CPPUNIT_ASSERT(sums[0].count == 16 * 16 * 16);
+    CPPUNIT_ASSERT(sums[0].sum == 2.0 * 16 * 16 * 16);
+    CPPUNIT_ASSERT(sums[0].min.x == -16 && sums[0].max.x == -1);
+    CPPUNIT_ASSERT(tree.m_root[4]->isFill());
+
+    // writable traversals split it into cells
+    tree.parallelForEach(TreeOffsetVoxels(), 4);
+    CPPUNIT_ASSERT(tree.m_root[4]->isBranching());
+    CPPUNIT_ASSERT(tree.get(-1, 0, 0) == 1.0f);
+    CPPUNIT_ASSERT(tree.get(-16, 15, 15) == -14.0f);
+    CPPUNIT_ASSERT(tree.get(-17, 0, 0) == 1.0f);
+    CPPUNIT_ASSERT(tree.get(1, 0, 0) == 1.0f);
+}
+
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+
+void
+TestTree::testPrune()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef Tree<Cell<float> > tree_type;
+
+    // a uniform 32^3 block with a little noise, and a lone voxel elsewhere
+    tree_type tree(2, 2, 0.0f);
+    for (int k = 0; k < 32; ++k) {
+        for (int j = 0; j < 32; ++j) {
+            for (int i = 0; i < 32; ++i) {
+                tree.set(i, j, k, 3.0f + 0.25f * (i % 2));
+            }
+        }
+    }
+    tree.set(-5, 0, 0, 1.0f);
+    CPPUNIT_ASSERT(tree.height(0) == 2);
+
+    int size = tree.sizeOf();
+
+    // nothing is uniform without a tolerance
+    tree.prune();
+    CPPUNIT_ASSERT(tree.sizeOf() == size);
+    CPPUNIT_ASSERT(tree.get(1, 0, 0) == 3.25f);
+
+    tree.prune(0.5f);
+    CPPUNIT_ASSERT(tree.sizeOf() < size);
+
+    // the 16^3 children are fill nodes, the root is only partly set
+    const tree_type::node_type *root = tree.m_root[0];
+    CPPUNIT_ASSERT(root->isBranching());
+    CPPUNIT_ASSERT(root->getBranch(0).node->isFill());
+    CPPUNIT_ASSERT(root->getBranch(0).node->fillValue() == 3.0f);
+    CPPUNIT_ASSERT(tree.get(1, 0, 0) == 3.0f);
+    CPPUNIT_ASSERT(tree.get(31, 31, 31) == 3.0f);
+    CPPUNIT_ASSERT(tree.get(32, 0, 0) == 0.0f);
+    CPPUNIT_ASSERT(tree.get(-5, 0, 0) == 1.0f);
+
+    int count = 0;
+    for (tree_type::set_iterator iter = tree.setIterator(); iter(); ++iter) {
+        ++count;
+    }
+    CPPUNIT_ASSERT(count == 32 * 32 * 32 + 1);
+
+    // pruned trees survive a round trip
+    std::ostringstream ostr(std::ios_base::binary);
+    tree.write(ostr);
+    std::istringstream istr(ostr.str(), std::ios_base::binary);
+    tree_type tree2;
+    tree2.read(istr);
+    CPPUNIT_ASSERT(tree == tree2);
+
+    // and still take writes
+    tree.set(4, 4, 4, 7.0f);
+    tree.unset(5, 4, 4);
+    CPPUNIT_ASSERT(tree.get(4, 4, 4) == 7.0f);
+    CPPUNIT_ASSERT(tree.get(5, 4, 4) == 0.0f);
+    CPPUNIT_ASSERT(tree.get(6, 4, 4) == 3.0f);
+    CPPUNIT_ASSERT(!root->getBranch(0).node->isFill());
+}
+
+//------------------------------------------------------------------------------
+
+void
+TestTree::testAutoPrune()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef Tree<Cell<float> > tree_type;
+
+    tree_type tree(2, 2, 0.0f);
+    tree.setAutoPrune(true);
+    CPPUNIT_ASSERT(tree.isAutoPrune());
+
+    // cells turn into fill cells as they fill up, the root once all are
+    for (int k = 0; k < 16; ++k) {
+        for (int j = 0; j < 16; ++j) {
+            for (int i = 0; i < 16; ++i) {
+                tree.set(i, j, k, 2.0f);
+                if (i == 3 && j == 3 && k == 3) {
+                    const Cell<float> *cell = 
+                        tree.m_root[0]->getBranch(0).cell;
+                    CPPUNIT_ASSERT(cell->isFilled() && cell->isFull());
+                }
+            }
+        }
+    }
+    CPPUNIT_ASSERT(tree.m_root[0]->isFill());
+    CPPUNIT_ASSERT(tree.get(15, 15, 15) == 2.0f);
+
+    // non uniform writes split it again
+    tree.set(0, 0, 0, 4.0f);
+    CPPUNIT_ASSERT(tree.m_root[0]->isBranching());
+    CPPUNIT_ASSERT(tree.get(0, 0, 0) == 4.0f);
+    CPPUNIT_ASSERT(tree.get(1, 0, 0) == 2.0f);
+
+    // updates prune too
+    tree.update(0, 0, 0, -2.0f, TreeAddOp());
+    CPPUNIT_ASSERT(tree.m_root[0]->isFill());
+
+    // nothing happens with auto prune off
+    tree.setAutoPrune(false);
+    tree.set(0, 0, 0, 4.0f);
+    tree.set(0, 0, 0, 2.0f);
+    CPPUNIT_ASSERT(tree.m_root[0]->isBranching());
+}
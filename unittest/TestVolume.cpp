@@ -33,6 +33,12 @@
 // TestVolume.cpp
 //------------------------------------------------------------------------------
 
+#include <fstream>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <vector>
+
 #include <cppunit/TestFixture.h>
 #include <cppunit/extensions/HelperMacros.h>
 
@@ -54,6 +60,57 @@
 // class definition
 //------------------------------------------------------------------------------
 
+/**
+ * Gathers the set voxels.
+ */
+template <typename T>
+struct GatherVoxels
+{
+    void operator()(const NKHIVE_NS::signed_index_vec &coords, const T &value)
+    {
+        coords_list.push_back(coords);
+        values.push_back(value);
+    }
+
+    std::vector<NKHIVE_NS::signed_index_vec>    coords_list;
+    std::vector<T>                              values;
+};
+
+/**
+ * Counts the cells still pointing into a mapped file.
+ */
+template <typename V>
+struct CountMapped
+{
+    CountMapped() : 
+        mapped(0) 
+    {
+    }
+
+    void operator()(const typename V::const_leaf &leaf)
+    {
+        if (leaf.cell().isMapped()) ++mapped;
+    }
+
+    int mapped;
+};
+
+//------------------------------------------------------------------------------
+
+/**
+ * Order dependent update, checks that batches keep the order of writes.
+ */
+template <typename T>
+struct BatchShiftOp
+{
+    T operator()(const T &a, const T &b) const 
+    { 
+        return a * T(2) + b; 
+    }
+};
+
+//------------------------------------------------------------------------------
+
 template <typename T>
 class TestVolume : public CppUnit::TestFixture 
 {
@@ -65,9 +122,19 @@ class TestVolume : public CppUnit::TestFixture
     CPPUNIT_TEST(testAttributes);
     CPPUNIT_TEST(testIO);
     CPPUNIT_TEST(testIOHDF5);
+    CPPUNIT_TEST(testCompressionHDF5);
+    CPPUNIT_TEST(testMapNative);
+    CPPUNIT_TEST(testReadLazy);
+    CPPUNIT_TEST(testReadRegion);
+    CPPUNIT_TEST(testParallelWrite);
+    CPPUNIT_TEST(testParallelRead);
+    CPPUNIT_TEST(testWriteIncremental);
     CPPUNIT_TEST(testOperatorComparison);
     CPPUNIT_TEST(testSetIterator);
     CPPUNIT_TEST(testComputeSetBounds);
+    CPPUNIT_TEST(testSetBatch);
+    CPPUNIT_TEST(testUpdateBatch);
+    CPPUNIT_TEST(testMortonLayout);
     CPPUNIT_TEST_SUITE_END();
     
 public:
@@ -81,9 +148,19 @@ public:
     void testAttributes();
     void testIO();
     void testIOHDF5();
+    void testCompressionHDF5();
+    void testMapNative();
+    void testReadLazy();
+    void testReadRegion();
+    void testParallelWrite();
+    void testParallelRead();
+    void testWriteIncremental();
     void testOperatorComparison();
     void testSetIterator();
     void testComputeSetBounds();
+    void testSetBatch();
+    void testUpdateBatch();
+    void testMortonLayout();
 };
 
 //-----------------------------------------------------------------------------
@@ -416,10 +493,10 @@ TestVolume<T>::testIOHDF5()
     USING_NK_NS
     USING_NKHIVE_NS
 
-    #define IO_TEST(v) {                                            \
+    #define IO_LAYOUT_TEST(v, layout) {                             \
         remove("testingHDF5.hv");                                   \
         VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);   \
-        v.write(file.m_id);                                         \
+        v.write(file.m_id, layout);                                 \
         file.close();                                               \
         Volume<T> v2(3, 3, T(5));                                   \
         v2.set(0, 0, 0, T(10));                                     \
@@ -430,6 +507,12 @@ TestVolume<T>::testIOHDF5()
         file2.close();                                              \
         remove("testingHDF5.hv");                                   \
     } 
+
+    // leaf groups are the legacy layout and must stay readable
+    #define IO_TEST(v) {                                            \
+        IO_LAYOUT_TEST(v, HDF5_LAYOUT_LEAF_GROUPS);                 \
+        IO_LAYOUT_TEST(v, HDF5_LAYOUT_LEAF_TABLE);                  \
+    } 
         
     // register the string attribute.
     Attribute::clearAttributeRegistry();
@@ -453,14 +536,773 @@ TestVolume<T>::testIOHDF5()
     v.getAttributeCollection().insert("something", StringAttribute("test"));
     IO_TEST(v);
 
+    // uniform cells and subtrees are stored as fill leaves
+    for (i32 k = -8; k < 8; ++k) {
+        for (i32 j = -8; j < 8; ++j) {
+            for (i32 i = -8; i < 8; ++i) {
+                v.set(i, j, k, T(3));
+            }
+        }
+    }
+    v.prune();
+    IO_TEST(v);
+
+    // only the leaf table is tagged with a layout version
+    #define LAYOUT_CHECK(layout, has_version) {                     \
+        remove("testingHDF5.hv");                                   \
+        VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);   \
+        v.write(file.m_id, layout);                                 \
+        HDF5Group root;                                             \
+        HDF5Group::getRootGroup(file.m_id, kVolumeRootGroup, root); \
+        HDF5Group volume_group;                                     \
+        volume_group.open(root.id(), String("unknown"));            \
+        CPPUNIT_ASSERT(volume_group.isValid());                     \
+        CPPUNIT_ASSERT((H5Aexists(volume_group.id(),                \
+            kLayoutVersionAttr.c_str()) > 0) == has_version);       \
+        volume_group.close();                                       \
+        root.close();                                               \
+        file.close();                                               \
+        remove("testingHDF5.hv");                                   \
+    }
+
+    LAYOUT_CHECK(HDF5_LAYOUT_LEAF_GROUPS, false);
+    LAYOUT_CHECK(HDF5_LAYOUT_LEAF_TABLE, true);
+
     // clear the registry
     Attribute::clearAttributeRegistry();
 
+    #undef LAYOUT_CHECK
     #undef IO_TEST
+    #undef IO_LAYOUT_TEST
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void 
+TestVolume<T>::testCompressionHDF5()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+    Int32Attribute::registerAttributeType();
+
+    // a smooth field over a few dense cells
+    Volume<T> v(2, 3, T(0));
+    for (i32 k = -16; k < 16; ++k) {
+        for (i32 j = -16; j < 16; ++j) {
+            for (i32 i = -16; i < 16; ++i) {
+                v.set(i, j, k, T((i + 16) / 4 + (j + 16) / 8 + 1));
+            }
+        }
+    }
+    CPPUNIT_ASSERT(v.getCompression().filter == HDF5_FILTER_NONE);
+
+    long sizes[3];
+    const HDF5Filter filters[] = { HDF5_FILTER_NONE, HDF5_FILTER_DEFLATE,
+                                   HDF5_FILTER_SHUFFLE_DEFLATE };
+    for (int f = 0; f < 3; ++f) {
+        v.setCompression(filters[f], 4);
+        CPPUNIT_ASSERT(v.getCompression().filter == filters[f]);
+        CPPUNIT_ASSERT(v.getCompression().level == 4);
+
+        remove("testingHDF5.hv");
+        VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);
+        v.write(file.m_id);
+        file.close();
+
+        FILE *fp = fopen("testingHDF5.hv", "rb");
+        fseek(fp, 0, SEEK_END);
+        sizes[f] = ftell(fp);
+        fclose(fp);
+
+        // filters are recorded in the file, reading needs no options
+        Volume<T> v2(3, 3, T(5));
+        VolumeFile file2("testingHDF5.hv", VoidFile::READ_ONLY);
+        v2.read(file2.m_id);
+        CPPUNIT_ASSERT(v == v2);
+        CPPUNIT_ASSERT(v2.getCompression().filter == filters[f]);
+        file2.close();
+        remove("testingHDF5.hv");
+    }
+    CPPUNIT_ASSERT(sizes[1] < sizes[0]);
+    CPPUNIT_ASSERT(sizes[2] < sizes[0]);
+
+    CPPUNIT_ASSERT(filterFromName(filterName(HDF5_FILTER_DEFLATE)) == 
+                   HDF5_FILTER_DEFLATE);
+    CPPUNIT_ASSERT_THROW(filterFromName(String("lzf")), Iex::ArgExc);
+
+    Attribute::clearAttributeRegistry();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void 
+TestVolume<T>::testMapNative()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef Volume<T, MortonLayout> MortonVolume;
+
+    #define WRITE_NATIVE(v) {                                       \
+        std::ofstream os("testingNative.nkv", std::ios_base::binary); \
+        v.writeNative(os);                                          \
+        os.close();                                                 \
+    }
+
+    // mapped cells stay compressed, compare the set values
+    #define VALUE_CHECK(a, b) {                                     \
+        size_t count = 0;                                           \
+        for (BOOST_TYPEOF(a.setIterator()) sit = a.setIterator();   \
+             sit(); ++sit) {                                        \
+            i32 i, j, k;                                            \
+            sit.getCoordinates(i, j, k);                            \
+            CPPUNIT_ASSERT(*sit == b.get(i, j, k));                 \
+            ++count;                                                \
+        }                                                           \
+        for (BOOST_TYPEOF(b.setIterator()) sit = b.setIterator();   \
+             sit(); ++sit) {                                        \
+            --count;                                                \
+        }                                                           \
+        CPPUNIT_ASSERT(count == 0);                                 \
+        CPPUNIT_ASSERT(a.getDefault() == b.getDefault());           \
+    }
+
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+
+    Volume<T> v(2, 2, T(1));
+    v.set(0, 0, 0, T(2));
+    v.set(-1, -2, -4, T(3));
+    v.set(64, -64, 32, T(4));
+    for (i32 k = -8; k < 8; ++k) {
+        for (i32 j = -8; j < 8; ++j) {
+            for (i32 i = 16; i < 32; ++i) {
+                v.set(i, j, k, T(i + j + k));
+            }
+        }
+    }
+
+    // uniform regions are mapped as fill leaves
+    for (i32 k = -8; k < 8; ++k) {
+        for (i32 j = -8; j < 8; ++j) {
+            for (i32 i = -8; i < 8; ++i) {
+                v.set(i, j, k, T(7));
+            }
+        }
+    }
+    v.prune();
+    v.getAttributeCollection().insert("something", StringAttribute("test"));
+
+    remove("testingNative.nkv");
+    WRITE_NATIVE(v);
+
+    {
+        Volume<T> v2(3, 3, T(5));
+        v2.set(0, 0, 0, T(10));
+        v2.map("testingNative.nkv");
+        VALUE_CHECK(v, v2);
+        CPPUNIT_ASSERT(v2.getAttributeCollection() == 
+                       v.getAttributeCollection());
+
+        const Volume<T> &const_v2 = v2;
+        int mapped = const_v2.parallelForEachLeaf(
+                CountMapped<Volume<T> >(), 1)[0].mapped;
+        CPPUNIT_ASSERT(mapped > 0);
+
+        // writes copy the cell out of the file
+        v2.set(20, 0, 0, T(99));
+        v2.unset(21, 0, 0);
+        CPPUNIT_ASSERT(v2.get(20, 0, 0) == T(99));
+        CPPUNIT_ASSERT(v2.get(21, 0, 0) == T(1));
+        CPPUNIT_ASSERT(const_v2.parallelForEachLeaf(
+                CountMapped<Volume<T> >(), 1)[0].mapped == mapped - 1);
+        v2.set(21, 0, 0, v.get(21, 0, 0));
+        v2.set(20, 0, 0, v.get(20, 0, 0));
+        VALUE_CHECK(v, v2);
+    }
+
+    // the file is left untouched by the edits
+    {
+        Volume<T> v3(3, 3, T(5));
+        v3.map("testingNative.nkv");
+        VALUE_CHECK(v, v3);
+    }
+
+    // other layouts copy the cells on mapping
+    {
+        MortonVolume mv(3, 3, T(5));
+        mv.map("testingNative.nkv");
+        VALUE_CHECK(v, mv);
+        const MortonVolume &const_mv = mv;
+        CPPUNIT_ASSERT(const_mv.parallelForEachLeaf(
+                CountMapped<MortonVolume>(), 1)[0].mapped == 0);
+    }
+
+    // only native files of the right type are mapped
+    {
+        Volume<double> vd(2, 2, 0.0);
+        if (sizeof(T) == sizeof(double)) {
+            vd.map("testingNative.nkv");
+        } else {
+            CPPUNIT_ASSERT_THROW(vd.map("testingNative.nkv"), Iex::IoExc);
+        }
+
+        // same sized voxels of another type are rejected too
+        MappedFile::shared_ptr file(new MappedFile("testingNative.nkv"));
+        MappedLeafTable<T> table(file);
+        if (sizeof(T) == sizeof(u32)) {
+            CPPUNIT_ASSERT_THROW(MappedLeafTable<u32> other(file), 
+                                 Iex::IoExc);
+        } else if (sizeof(T) == sizeof(u64)) {
+            CPPUNIT_ASSERT_THROW(MappedLeafTable<u64> other(file), 
+                                 Iex::IoExc);
+        }
+    }
+    remove("testingNative.nkv");
+    CPPUNIT_ASSERT_THROW(v.map("testingNative.nkv"), Iex::IoExc);
+
+    Attribute::clearAttributeRegistry();
+
+    #undef VALUE_CHECK
+    #undef WRITE_NATIVE
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void 
+TestVolume<T>::testReadLazy()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef Volume<T, MortonLayout> MortonVolume;
+
+    #define VALUE_CHECK(a, b) {                                     \
+        for (i32 k = -4; k < 12; ++k) {                             \
+            for (i32 j = -8; j < 8; ++j) {                          \
+                for (i32 i = -32; i < 32; ++i) {                    \
+                    CPPUNIT_ASSERT(a.get(i, j, k) == b.get(i, j, k)); \
+                }                                                   \
+            }                                                       \
+        }                                                           \
+    }
+
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+
+    // distinct values over 32 cells, and a fill region
+    Volume<T> v(2, 3, T(1));
+    for (i32 k = -4; k < 12; ++k) {
+        for (i32 j = -8; j < 8; ++j) {
+            for (i32 i = -32; i < 32; i += 3) {
+                v.set(i, j, k, T((i + 40) + (j + 8) * 2 + k));
+            }
+        }
+    }
+    for (i32 k = 0; k < 8; ++k) {
+        for (i32 j = 0; j < 8; ++j) {
+            for (i32 i = 32; i < 40; ++i) {
+                v.set(i, j, k, T(7));
+            }
+        }
+    }
+    v.prune();
+
+    // cell sized budget, every cell is uncompressed in memory
+    const size_t cell_bytes = 512 * sizeof(T);
+    const size_t budget = 4 * cell_bytes;
+
+    remove("testingHDF5.hv");
+    {
+        VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);
+        file.write(v);
+        file.close();
+    }
+
+    {
+        VolumeFile file("testingHDF5.hv", VoidFile::READ_ONLY);
+        typename Volume<T>::shared_ptr lazy = 
+            file.template readLazy<Volume<T> >(budget);
+        file.close();
+
+        // only the leaf index is in memory
+        CellPagerStats stats = lazy->getPagerStats();
+        CPPUNIT_ASSERT(stats.misses == 0);
+        CPPUNIT_ASSERT(stats.resident_bytes == 0);
+        CPPUNIT_ASSERT(stats.budget_bytes == budget);
+        CPPUNIT_ASSERT(lazy->get(35, 3, 3) == T(7));
+
+        VALUE_CHECK(v, (*lazy));
+        stats = lazy->getPagerStats();
+        CPPUNIT_ASSERT(stats.misses > 0);
+        CPPUNIT_ASSERT(stats.hits > 0);
+        CPPUNIT_ASSERT(stats.evictions > 0);
+        CPPUNIT_ASSERT(stats.resident_bytes <= budget);
+
+        // repeated access to one cell hits
+        lazy->get(-32, 0, 0);
+        u64 misses = lazy->getPagerStats().misses;
+        lazy->get(-29, 0, 0);
+        CPPUNIT_ASSERT(lazy->getPagerStats().misses == misses);
+
+        // modified cells stay resident through evictions
+        lazy->set(-32, 0, 0, T(99));
+        v.set(-32, 0, 0, T(99));
+        VALUE_CHECK(v, (*lazy));
+        CPPUNIT_ASSERT(lazy->get(-32, 0, 0) == T(99));
+        CPPUNIT_ASSERT(v == (*lazy));
+        CPPUNIT_ASSERT(lazy->getPagerStats().resident_bytes <= budget);
+
+        // saving pages the cells in as they are written
+        remove("testingHDF5_2.hv");
+        VolumeFile file2("testingHDF5_2.hv", VoidFile::WRITE_TRUNC);
+        file2.write(*lazy);
+        file2.close();
+        VolumeFile file3("testingHDF5_2.hv", VoidFile::READ_ONLY);
+        CPPUNIT_ASSERT(v == *file3.template read<Volume<T> >());
+        file3.close();
+        remove("testingHDF5_2.hv");
+    }
+
+    // values are returned by copy and outlive the pages they came from
+    {
+        VolumeFile file("testingHDF5.hv", VoidFile::READ_ONLY);
+        typename Volume<T>::shared_ptr lazy = 
+            file.template readLazy<Volume<T> >(cell_bytes);
+        file.close();
+
+        const T &a = lazy->get(-29, 0, 0);
+        lazy->get(-23, 0, 0);
+        lazy->get(-14, 0, 0);
+        lazy->get(-5, 0, 0);
+        CPPUNIT_ASSERT(lazy->getPagerStats().evictions == 2);
+        CPPUNIT_ASSERT(a == v.get(-29, 0, 0));
+
+        const Volume<T> &const_lazy = *lazy;
+        typename Volume<T>::const_accessor accessor = 
+            const_lazy.getAccessor();
+        T b = accessor.get(-14, 0, 0);
+        accessor.get(-29, 0, 0);
+        accessor.get(-23, 0, 0);
+        CPPUNIT_ASSERT(b == v.get(-14, 0, 0));
+    }
+
+    // other layouts relayout the cells as they are paged in
+    {
+        VolumeFile file("testingHDF5.hv", VoidFile::READ_ONLY);
+        typename MortonVolume::shared_ptr lazy = 
+            file.template readLazy<MortonVolume>(budget);
+        file.close();
+        v.set(-32, 0, 0, T((-32 + 40) + 8 * 2));
+        lazy->set(-32, 0, 0, T((-32 + 40) + 8 * 2));
+        VALUE_CHECK(v, (*lazy));
+    }
+
+    // parallel traversals and batched updates share the pager
+    {
+        VolumeFile file("testingHDF5.hv", VoidFile::READ_ONLY);
+        typename Volume<T>::shared_ptr lazy = 
+            file.template readLazy<Volume<T> >(budget);
+        typename Volume<T>::shared_ptr expected = 
+            file.template read<Volume<T> >();
+        file.close();
+
+        const Volume<T> &const_lazy = *lazy;
+        std::vector< GatherVoxels<T> > gathers = 
+            const_lazy.parallelForEach(GatherVoxels<T>(), 4);
+        std::vector<signed_index_vec> coords;
+        std::vector<T> ones;
+        for (size_t n = 0; n < gathers.size(); ++n) {
+            coords.insert(coords.end(), gathers[n].coords_list.begin(), 
+                          gathers[n].coords_list.end());
+            for (size_t m = 0; m < gathers[n].values.size(); ++m) {
+                CPPUNIT_ASSERT(gathers[n].values[m] == 
+                               expected->get(gathers[n].coords_list[m]));
+            }
+        }
+        CPPUNIT_ASSERT(lazy->getPagerStats().resident_bytes <= budget);
+        ones.assign(coords.size(), T(1));
+
+        lazy->updateBatch(&coords[0], &ones[0], coords.size(), 
+                          std::plus<T>(), 4);
+        expected->updateBatch(&coords[0], &ones[0], coords.size(),
+                              std::plus<T>(), 1);
+        CPPUNIT_ASSERT((*expected) == (*lazy));
+        VALUE_CHECK((*expected), (*lazy));
+        CPPUNIT_ASSERT(lazy->getPagerStats().resident_bytes <= budget);
+    }
+
+    // the leaf groups layout has no index to read
+    {
+        remove("testingHDF5.hv");
+        VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);
+        file.write(v, HDF5_LAYOUT_LEAF_GROUPS);
+        file.close();
+        VolumeFile file2("testingHDF5.hv", VoidFile::READ_ONLY);
+        CPPUNIT_ASSERT_THROW(file2.template readLazy<Volume<T> >(budget), 
+                             Iex::IoExc);
+        file2.close();
+    }
+    remove("testingHDF5.hv");
+
+    Attribute::clearAttributeRegistry();
+
+    #undef VALUE_CHECK
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void 
+TestVolume<T>::testReadRegion()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+
+    // distinct values over all quadrants, and a fill node
+    Volume<T> v(2, 3, T(1));
+    for (i32 k = -16; k < 16; ++k) {
+        for (i32 j = -16; j < 16; ++j) {
+            for (i32 i = -32; i < 32; i += 3) {
+                v.set(i, j, k, T((i + 40) + (j + 16) * 2 + k));
+            }
+        }
+    }
+    for (i32 k = 0; k < 32; ++k) {
+        for (i32 j = 0; j < 32; ++j) {
+            for (i32 i = 32; i < 64; ++i) {
+                v.set(i, j, k, T(7));
+            }
+        }
+    }
+    v.prune();
+
+    // cuts cells of several quadrants and the fill node
+    signed_index_bounds roi(signed_index_vec(-5, -3, 2), 
+                            signed_index_vec(40, 6, 10));
+    signed_index_bounds cells(signed_index_vec(-8, -8, 0), 
+                              signed_index_vec(40, 8, 16));
+
+    String name("unknown");
+    for (int layout = 0; layout < 2; ++layout) {
+        remove("testingHDF5.hv");
+        {
+            VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);
+            file.write(v, layout ? HDF5_LAYOUT_LEAF_GROUPS 
+                                 : HDF5_LAYOUT_LEAF_TABLE);
+            file.close();
+        }
+
+        VolumeFile file("testingHDF5.hv", VoidFile::READ_ONLY);
+        typename Volume<T>::shared_ptr part = 
+            file.template read<Volume<T> >(name, roi);
+
+        // intersecting cells are whole, everything else is left out
+        for (i32 k = -16; k < 32; ++k) {
+            for (i32 j = -16; j < 32; ++j) {
+                for (i32 i = -32; i < 64; ++i) {
+                    signed_index_vec c(i, j, k);
+                    if (roi.inRange(c) || 
+                        (cells.inRange(c) && (i < 32 || i >= 40))) {
+                        CPPUNIT_ASSERT(part->get(i, j, k) == v.get(i, j, k));
+                    } else {
+                        CPPUNIT_ASSERT(part->get(i, j, k) == T(1));
+                    }
+                }
+            }
+        }
+
+        // a box around everything reads the whole volume
+        signed_index_bounds all(signed_index_vec(-64), signed_index_vec(64));
+        CPPUNIT_ASSERT(v == *file.template read<Volume<T> >(name, all));
+
+        // and an empty one nothing
+        signed_index_bounds none(signed_index_vec(4), signed_index_vec(4));
+        CPPUNIT_ASSERT(file.template read<Volume<T> >(name, none)->isEmpty());
+
+        file.close();
+    }
+    remove("testingHDF5.hv");
+
+    // indexed streams read the same part, and are left past the volume
+    std::ostringstream ostr(std::ios_base::binary);
+    v.write(ostr);
+    ostr << "tail";
+
+    std::istringstream istr(ostr.str(), std::ios_base::binary);
+    Volume<T> part(2, 3, T(0));
+    part.read(istr, roi);
+    for (i32 k = -16; k < 32; ++k) {
+        for (i32 j = -16; j < 32; ++j) {
+            for (i32 i = -32; i < 64; ++i) {
+                signed_index_vec c(i, j, k);
+                if (roi.inRange(c) || 
+                    (cells.inRange(c) && (i < 32 || i >= 40))) {
+                    CPPUNIT_ASSERT(part.get(i, j, k) == v.get(i, j, k));
+                } else {
+                    CPPUNIT_ASSERT(part.get(i, j, k) == T(1));
+                }
+            }
+        }
+    }
+    std::string tail;
+    istr >> tail;
+    CPPUNIT_ASSERT(tail == "tail");
+
+    Attribute::clearAttributeRegistry();
 }
 
 //------------------------------------------------------------------------------
 
+template <typename T>
+void 
+TestVolume<T>::testParallelWrite()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+
+    // enough subtrees in every quadrant to go around, and fill leaves
+    Volume<T> v(1, 2, T(1));
+    for (i32 k = -24; k < 24; k += 5) {
+        for (i32 j = -24; j < 24; j += 3) {
+            for (i32 i = -24; i < 24; ++i) {
+                v.set(i, j, k, T(i + j * 2 + k * 3));
+            }
+        }
+    }
+    for (i32 k = 0; k < 8; ++k) {
+        for (i32 j = 0; j < 8; ++j) {
+            for (i32 i = 32; i < 40; ++i) {
+                v.set(i, j, k, T(7));
+            }
+        }
+    }
+    v.prune();
+
+    // the leaves come out in the same order as a serial write
+    std::ostringstream serial;
+    v.writeNative(serial);
+    for (size_t threads = 0; threads < 5; ++threads) {
+        std::ostringstream parallel;
+        v.writeNative(parallel, threads);
+        CPPUNIT_ASSERT(parallel.str() == serial.str());
+    }
+
+    remove("testingHDF5.hv");
+    {
+        VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);
+        file.write(v, HDF5_LAYOUT_LEAF_TABLE, 4);
+        file.close();
+    }
+    {
+        VolumeFile file("testingHDF5.hv", VoidFile::READ_ONLY);
+        CPPUNIT_ASSERT(v == *file.template read<Volume<T> >());
+
+        // paged trees are written from the calling thread
+        typename Volume<T>::shared_ptr lazy = 
+            file.template readLazy<Volume<T> >(1024);
+        std::ostringstream paged;
+        lazy->writeNative(paged, 4);
+        CPPUNIT_ASSERT(paged.str() == serial.str());
+        file.close();
+    }
+    remove("testingHDF5.hv");
+
+    Attribute::clearAttributeRegistry();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestVolume<T>::testParallelRead()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+
+    // cells in every quadrant, some of them filled, and fill leaves
+    Volume<T> v(1, 2, T(1));
+    for (i32 k = -24; k < 24; k += 5) {
+        for (i32 j = -24; j < 24; j += 3) {
+            for (i32 i = -24; i < 24; ++i) {
+                v.set(i, j, k, T(i + j * 2 + k * 3));
+            }
+        }
+    }
+    for (i32 k = 0; k < 8; ++k) {
+        for (i32 j = 0; j < 8; ++j) {
+            for (i32 i = 32; i < 44; ++i) {
+                v.set(i, j, k, T(7));
+            }
+        }
+    }
+    v.prune();
+
+    // the trees read match a serial read leaf for leaf
+    std::ostringstream serial;
+    v.writeNative(serial);
+
+    std::ostringstream ostr(std::ios_base::binary);
+    v.write(ostr);
+    for (size_t threads = 0; threads < 5; ++threads) {
+        std::istringstream istr(ostr.str(), std::ios_base::binary);
+        Volume<T> stream(1, 2, T(0));
+        stream.read(istr, threads);
+        CPPUNIT_ASSERT(v == stream);
+
+        std::ostringstream native;
+        stream.writeNative(native);
+        CPPUNIT_ASSERT(native.str() == serial.str());
+    }
+
+    for (int layout = 0; layout < 2; ++layout) {
+        remove("testingHDF5.hv");
+        {
+            VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);
+            file.write(v, layout ? HDF5_LAYOUT_LEAF_GROUPS 
+                                 : HDF5_LAYOUT_LEAF_TABLE);
+            file.close();
+        }
+
+        VolumeFile file("testingHDF5.hv", VoidFile::READ_ONLY);
+        for (size_t threads = 0; threads < 5; ++threads) {
+            typename Volume<T>::shared_ptr read_volume = 
+                file.template read<Volume<T> >(0, threads);
+            CPPUNIT_ASSERT(v == *read_volume);
+
+            std::ostringstream native;
+            read_volume->writeNative(native);
+            CPPUNIT_ASSERT(native.str() == serial.str());
+        }
+        file.close();
+    }
+    remove("testingHDF5.hv");
+
+    Attribute::clearAttributeRegistry();
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestVolume<T>::testWriteIncremental()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+
+    // saves the volume incrementally, then checks it reads back and holds
+    // the same leaf groups as a full write
+    #define SAVE_TEST(v) {                                                  \
+        {                                                                   \
+            VolumeFile file("testingHDF5.hv", VoidFile::READ_WRITE);        \
+            file.writeIncremental(v);                                       \
+            file.close();                                                   \
+        }                                                                   \
+        {                                                                   \
+            VolumeFile file("testingHDF5Full.hv", VoidFile::WRITE_TRUNC);   \
+            file.write(v, HDF5_LAYOUT_LEAF_GROUPS);                         \
+            file.close();                                                   \
+        }                                                                   \
+        VolumeFile file("testingHDF5.hv", VoidFile::READ_ONLY);             \
+        VolumeFile full("testingHDF5Full.hv", VoidFile::READ_ONLY);         \
+        CPPUNIT_ASSERT(v == *file.template read<Volume<T> >());             \
+        HDF5Group root, group, full_root, full_group;                       \
+        HDF5Group::getRootGroup(file.m_id, kVolumeRootGroup, root);         \
+        HDF5Group::getRootGroup(full.m_id, kVolumeRootGroup, full_root);    \
+        group.open(root.id(), String("unknown"));                           \
+        full_group.open(full_root.id(), String("unknown"));                 \
+        CPPUNIT_ASSERT(group.numChildren() == full_group.numChildren());    \
+    }
+
+    Volume<T> v(1, 2, T(1));
+    for (i32 k = -24; k < 24; k += 5) {
+        for (i32 j = -24; j < 24; j += 3) {
+            for (i32 i = -24; i < 24; ++i) {
+                v.set(i, j, k, T(i + j * 2 + k * 3));
+            }
+        }
+    }
+    for (i32 k = 0; k < 8; ++k) {
+        for (i32 j = 0; j < 8; ++j) {
+            for (i32 i = 32; i < 40; ++i) {
+                v.set(i, j, k, T(7));
+            }
+        }
+    }
+    v.prune();
+
+    // a leaf table is replaced by leaf groups on the first save
+    remove("testingHDF5.hv");
+    {
+        VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);
+        file.write(v);
+        file.close();
+    }
+    SAVE_TEST(v);
+
+    // nothing changed
+    SAVE_TEST(v);
+
+    // modify a cell, split the fill node and add a cell
+    v.set(0, 0, 0, T(100));
+    v.unset(33, 1, 1);
+    v.set(100, 100, 100, T(5));
+    SAVE_TEST(v);
+
+    // remove the cells at the low end of x
+    for (i32 k = -24; k < 24; k += 5) {
+        for (i32 j = -24; j < 24; j += 3) {
+            for (i32 i = -24; i < -20; ++i) {
+                v.unset(i, j, k);
+            }
+        }
+    }
+    SAVE_TEST(v);
+
+    // merge the split fill node again
+    v.set(33, 1, 1, T(7));
+    v.prune();
+    CPPUNIT_ASSERT(v.get(33, 1, 1) == T(7));
+    SAVE_TEST(v);
+
+    // a volume read back only saves what changed after
+    {
+        VolumeFile file("testingHDF5.hv", VoidFile::READ_ONLY);
+        typename Volume<T>::shared_ptr read = 
+            file.template read<Volume<T> >();
+        file.close();
+
+        read->set(-1, -1, -1, T(11));
+        SAVE_TEST(*read);
+    }
+
+    remove("testingHDF5.hv");
+    remove("testingHDF5Full.hv");
+
+    #undef SAVE_TEST
+
+    Attribute::clearAttributeRegistry();
+}
+
+//------------------------------------------------------------------------------
 
 template <typename T>
 void
@@ -545,3 +1387,188 @@ TestVolume<T>::testComputeSetBounds()
 }
 
 //------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestVolume<T>::testSetBatch()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    // clustered and scattered coordinates in all quadrants, with repeats
+    std::vector<signed_index_vec> coords;
+    std::vector<T> values;
+    u32 seed = 3;
+    for (int n = 0; n < 5000; ++n) {
+        seed = seed * 1664525u + 1013904223u;
+        i32 spread = (n % 4) ? 12 : 3000;
+        signed_index_vec c(i32(seed % u32(2 * spread)) - spread,
+                           i32((seed >> 8) % u32(2 * spread)) - spread,
+                           i32((seed >> 16) % u32(2 * spread)) - spread);
+        coords.push_back(c);
+        values.push_back(T(n % 97));
+    }
+
+    Volume<T> serial(2, 2, T(0));
+    for (size_t n = 0; n < coords.size(); ++n) {
+        serial.set(coords[n], values[n]);
+    }
+
+    Volume<T> batch(2, 2, T(0));
+    batch.setBatch(&coords[0], &values[0], coords.size());
+    CPPUNIT_ASSERT(batch == serial);
+
+    Volume<T> threaded(2, 2, T(0));
+    threaded.setBatch(&coords[0], &values[0], coords.size(), 4);
+    CPPUNIT_ASSERT(threaded == serial);
+
+    // empty batches are fine
+    batch.setBatch(NULL, NULL, 0);
+    CPPUNIT_ASSERT(batch == serial);
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestVolume<T>::testUpdateBatch()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    // every voxel is hit several times, interleaved with other cells
+    std::vector<signed_index_vec> coords;
+    std::vector<T> values;
+    for (int pass = 0; pass < 3; ++pass) {
+        for (i32 k = -6; k < 6; k += 5) {
+            for (i32 j = -6; j < 6; j += 3) {
+                for (i32 i = -6; i < 6; ++i) {
+                    coords.push_back(signed_index_vec(i, j, k));
+                    values.push_back(T(pass + 1));
+                }
+            }
+        }
+    }
+
+    Volume<T> serial(2, 2, T(1));
+    for (size_t n = 0; n < coords.size(); ++n) {
+        serial.update(coords[n], values[n], BatchShiftOp<T>());
+    }
+
+    for (size_t threads = 1; threads <= 4; threads *= 2) {
+        Volume<T> batch(2, 2, T(1));
+        batch.updateBatch(&coords[0], &values[0], coords.size(), 
+                          BatchShiftOp<T>(), threads);
+        CPPUNIT_ASSERT(batch == serial);
+        // ((1 * 2 + 1) * 2 + 2) * 2 + 3
+        CPPUNIT_ASSERT(batch.get(-6, -6, -6) == T(19));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+template <typename T>
+void
+TestVolume<T>::testMortonLayout()
+{
+    USING_NK_NS
+    USING_NKHIVE_NS
+
+    typedef Volume<T, MortonLayout> MortonVolume;
+
+    Volume<T> v(2, 2, T(1));
+    MortonVolume mv(2, 2, T(1));
+
+    // edits land on the same voxels whatever the layout
+    for (i32 n = 0; n < 64; ++n) {
+        signed_index_vec c((n * 7) % 19 - 9, (n * 5) % 13 - 6, n % 11 - 5);
+        v.update(c, T(n % 5), BatchShiftOp<T>());
+        mv.update(c, T(n % 5), BatchShiftOp<T>());
+    }
+    v.set(64, -64, 32, T(2));
+    mv.set(64, -64, 32, T(2));
+    v.unset(-9, -6, -5);
+    mv.unset(-9, -6, -5);
+
+    #define COMPARE_VOXELS(a, b) {                                  \
+        for (i32 k = -8; k < 8; ++k) {                              \
+            for (i32 j = -8; j < 8; ++j) {                          \
+                for (i32 i = -10; i < 10; ++i) {                    \
+                    CPPUNIT_ASSERT(a.get(i, j, k) == b.get(i, j, k)); \
+                }                                                   \
+            }                                                       \
+        }                                                           \
+        CPPUNIT_ASSERT(a.get(64, -64, 32) == b.get(64, -64, 32));   \
+    }
+
+    COMPARE_VOXELS(v, mv);
+
+    // the set iterator visits the same voxels, in layout order
+    std::set<std::vector<i32> > row_set, morton_set;
+    for (typename Volume<T>::set_iterator sit = v.setIterator(); 
+         sit(); ++sit) {
+        std::vector<i32> c(4);
+        sit.getCoordinates(c[0], c[1], c[2]);
+        c[3] = i32(*sit);
+        row_set.insert(c);
+    }
+    for (typename MortonVolume::set_iterator sit = mv.setIterator(); 
+         sit(); ++sit) {
+        std::vector<i32> c(4);
+        sit.getCoordinates(c[0], c[1], c[2]);
+        c[3] = i32(*sit);
+        morton_set.insert(c);
+    }
+    CPPUNIT_ASSERT(!row_set.empty());
+    CPPUNIT_ASSERT(row_set == morton_set);
+
+    // files are row major, so volumes move between layouts
+    Attribute::clearAttributeRegistry();
+    StringAttribute::registerAttributeType();
+    {
+        std::ostringstream ostr(std::ios_base::binary);
+        mv.write(ostr);
+        std::istringstream istr(ostr.str(), std::ios_base::binary);
+        Volume<T> v2(3, 3, T(5));
+        v2.read(istr);
+        CPPUNIT_ASSERT(v2 == v);
+    }
+    {
+        std::ostringstream ostr(std::ios_base::binary);
+        v.write(ostr);
+        std::istringstream istr(ostr.str(), std::ios_base::binary);
+        MortonVolume mv2(3, 3, T(5));
+        mv2.read(istr);
+        CPPUNIT_ASSERT(mv2 == mv);
+        COMPARE_VOXELS(v, mv2);
+    }
+    {
+        remove("testingHDF5.hv");
+        VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);
+        mv.write(file.m_id);
+        file.close();
+        Volume<T> v2(3, 3, T(5));
+        VolumeFile file2("testingHDF5.hv", VoidFile::READ_ONLY);
+        v2.read(file2.m_id);
+        CPPUNIT_ASSERT(v2 == v);
+        file2.close();
+        remove("testingHDF5.hv");
+    }
+    {
+        remove("testingHDF5.hv");
+        VolumeFile file("testingHDF5.hv", VoidFile::WRITE_TRUNC);
+        v.write(file.m_id);
+        file.close();
+        MortonVolume mv2(3, 3, T(5));
+        VolumeFile file2("testingHDF5.hv", VoidFile::READ_ONLY);
+        mv2.read(file2.m_id);
+        CPPUNIT_ASSERT(mv2 == mv);
+        file2.close();
+        remove("testingHDF5.hv");
+    }
+    Attribute::clearAttributeRegistry();
+
+    #undef COMPARE_VOXELS
+}
+
+//------------------------------------------------------------------------------